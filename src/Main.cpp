@@ -4,7 +4,7 @@
  * Created:
  *   08/04/2021, 13:20:40
  * Last edited:
- *   25/05/2021, 18:14:13
+ *   16/10/2026, 01:02:51
  * Auto updated?
  *   Yes
  *
@@ -16,16 +16,26 @@
 #include <iostream>
 #include <cstring>
 #include <limits>
+#include <iomanip>
+#include <sstream>
+#include <memory>
 #include <CppDebugger.hpp>
 
+#include "tools/Profiler.hpp"
+
 #include "renderer/Renderer.hpp"
 
 #include "entities/Triangle.hpp"
 #include "entities/Sphere.hpp"
 #include "entities/Object.hpp"
+#include "entities/EntityPath.hpp"
+#include "entities/SceneGenerator.hpp"
 
 #include "camera/Camera.hpp"
+#include "camera/CameraPath.hpp"
 #include "camera/Frame.hpp"
+#include "camera/FrameSink.hpp"
+#include "camera/PngEncoder.hpp"
 
 using namespace std;
 using namespace RayTracer;
@@ -44,13 +54,45 @@ using namespace CppDebugger::SeverityValues;
 /***** ENUMS *****/
 enum class OutputType {
     png,
-    ppm
+    ppm,
+    pfm
 };
 
 // Maps the values of OutputType to a string
 unordered_map<OutputType, std::string> output_type_names = {
     { OutputType::png, "png" },
-    { OutputType::ppm, "ppm" }
+    { OutputType::ppm, "ppm" },
+    { OutputType::pfm, "pfm" }
+};
+
+enum class SinkType {
+    frame,
+    stream,
+    mmap
+};
+
+// Maps the values of SinkType to a string
+unordered_map<SinkType, std::string> sink_type_names = {
+    { SinkType::frame, "frame" },
+    { SinkType::stream, "stream" },
+    { SinkType::mmap, "mmap" }
+};
+
+enum class AnimationType {
+    turntable,
+    spin
+};
+
+// Maps the values of AnimationType to a string
+unordered_map<AnimationType, std::string> animation_type_names = {
+    { AnimationType::turntable, "turntable" },
+    { AnimationType::spin, "spin" }
+};
+
+// Maps the values of FrameLayout to a string
+unordered_map<FrameLayout, std::string> frame_layout_names = {
+    { FrameLayout::row_major, "row-major" },
+    { FrameLayout::tiled, "tiled" }
 };
 
 
@@ -64,19 +106,46 @@ struct CLIOptions {
     std::string output_path;
     /* Output type of the image. */
     OutputType output_type;
+    /* Where the renderer writes the pixels to while rendering. */
+    SinkType sink_type;
+    /* The order in which the in-memory frame stores its pixels. */
+    FrameLayout frame_layout;
 
     /* Width of the resulting frame. */
     uint32_t width;
     /* Height of the resulting frame. */
     uint32_t height;
+    /* The compression level of PNG frames. */
+    int compression;
+
+    /* The number of frames to render. If more than one, the output path contains a placeholder for the frame number. */
+    uint32_t n_frames;
+    /* How the scene moves between frames. */
+    AnimationType animation_type;
+
+    /* Whether to render a generated scene instead of the default one. */
+    bool generate_scene;
+    /* Describes the generated scene, if any. */
+    ECS::SceneSpec scene_spec;
+
+    /* Path to the JSON file that the render statistics are written to, or empty to not write them. */
+    std::string stats_path;
+    /* Path to the file that the samples of the profiler are written to as collapsed stacks, or empty to not profile. */
+    std::string profile_path;
 
 
     /* Default constructor for the CLIOptions class, which sets the values to default. */
     CLIOptions() :
         output_path(""),
         output_type(OutputType::png),
+        sink_type(SinkType::frame),
+        frame_layout(FrameLayout::row_major),
         width(800),
-        height(600)
+        height(600),
+        compression(PngEncoder::default_level),
+        n_frames(1),
+        animation_type(AnimationType::turntable),
+        generate_scene(false)
     {}
 };
 
@@ -85,6 +154,38 @@ struct CLIOptions {
 
 
 /***** HELPER FUNCTIONS *****/
+/* Checks whether the given output path contains exactly one frame number placeholder, i.e., '%d' or '%0<width>d'. If so, returns where it starts and stores its length and width; otherwise, returns std::string::npos. */
+size_t find_frame_placeholder(const std::string& path, size_t& length, uint32_t& width) {
+    size_t start = path.find('%');
+    if (start == std::string::npos || path.find('%', start + 1) != std::string::npos) { return std::string::npos; }
+
+    // Parse the optional (zero-padded) width
+    size_t end = start + 1;
+    if (end < path.size() && path[end] == '0') { ++end; }
+    width = 0;
+    while (end < path.size() && path[end] >= '0' && path[end] <= '9' && width < 16) {
+        width = 10 * width + (uint32_t) (path[end] - '0');
+        ++end;
+    }
+    if (end >= path.size() || path[end] != 'd') { return std::string::npos; }
+
+    // It's valid
+    length = end + 1 - start;
+    return start;
+}
+
+/* Returns the output path of the given frame, by replacing the placeholder in the given output path with its (zero-padded) number. */
+std::string get_frame_path(const std::string& path, uint32_t frame) {
+    size_t length;
+    uint32_t width;
+    size_t start = find_frame_placeholder(path, length, width);
+    if (start == std::string::npos) { return path; }
+
+    std::stringstream sstr;
+    sstr << path.substr(0, start) << std::setw(width) << std::setfill('0') << frame << path.substr(start + length);
+    return sstr.str();
+}
+
 /* Parses command line arguments. */
 int parse_cli(CLIOptions& options, int argc, const char** argv) {
     DENTER("parse_cli");
@@ -116,9 +217,17 @@ int parse_cli(CLIOptions& options, int argc, const char** argv) {
                 cout << "Usage: " << argv[0] << " [<options>] <output_path>" << endl << endl;
                 
                 cout << "Options:" << endl;
-                cout << "\t-f,--format\tThe format of the resulting frame. Supported formats are: 'png' and 'ppm' (default: png)." << endl;
+                cout << "\t-f,--format\tThe format of the resulting frame. Supported formats are: 'png', 'ppm' and 'pfm' (default: png)." << endl;
+                cout << "\t-s,--sink\tWhere the frame is written while rendering. 'frame' renders to memory and writes the file afterwards; 'stream' writes the file band by band and 'mmap' writes it through a memory-mapped file, which both keep only a small part of the frame in memory (ppm & pfm only) (default: frame)." << endl;
+                cout << "\t-l,--layout\tThe order in which the in-memory frame stores its pixels. 'tiled' keeps tiles of " << Frame::tile_size << "x" << Frame::tile_size << " pixels together, and is only converted to rows when the frame is written (default: row-major)." << endl;
                 cout << "\t-W,--width\tThe width of the resulting image, in pixels (default: 800)." << endl;
                 cout << "\t-H,--height\tThe height of th resulting image, in pixels (default: 600)." << endl;
+                cout << "\t-c,--compression\tThe compression level of PNG frames, from 0 (fastest) to 9 (smallest) (default: " << PngEncoder::default_level << ")." << endl;
+                cout << "\t-n,--frames\tThe number of frames to render. If more than one, the output path should contain a placeholder for the frame number like 'frame_%04d.png' (default: 1)." << endl;
+                cout << "\t-a,--animation\tHow the scene moves between frames. 'turntable' circles the camera around the scene once; 'spin' keeps the camera still and spins the object (or an entire generated scene) around once instead, and is only available with the Sequential or Threaded backends (default: turntable)." << endl;
+                cout << "\t--stats\tWrites statistics about pre-rendering and rendering (times, rays traced, intersection tests, BVH node visits and the busy & idle time per thread) as JSON to the given file." << endl;
+                cout << "\t--profile\tSamples where the time goes while pre-rendering and rendering, and writes it as collapsed stacks (for flamegraph tools) to the given file. Only available if compiled with PROFILER=Sampling." << endl;
+                cout << "\t-S,--scene\tRenders a generated scene instead of the default one, described as a comma-separated list of <key>=<value> pairs. The keys are 'spheres', 'triangles' and 'objects' for the number of each entity, 'resolution' for the meridians & parallels of the spheres (default: 16), 'object' for the file of the objects (default: bin/objects/teddy.obj), 'distribution' for how the entities are spread ('uniform', 'clustered' or 'nested', default: uniform), 'extent' for half the width of the scene (default: 2) and 'seed' (default: 42). For example: 'triangles=100000,spheres=100,distribution=clustered'." << endl;
 
                 cout << endl << "\t-h,--help\tShows this help menu, then exits." << endl << endl;
 
@@ -142,11 +251,61 @@ int parse_cli(CLIOptions& options, int argc, const char** argv) {
                     options.output_type = OutputType::png;
                 } else if (value == "ppm") {
                     options.output_type = OutputType::ppm;
+                } else if (value == "pfm") {
+                    options.output_type = OutputType::pfm;
                 } else {
                     cerr << "Unknown output format '" << value << "'" << endl;
                     DRETURN -1;
                 }
             
+            } else if (key == "-s" || key == "--sink") {
+                // Make sure a value is given
+                if (value.empty()) {
+                    // Be sure there are enough values
+                    if (i == argc - 1 || (accept_options && argv[i + 1][0] == '-')) {
+                        cerr << key << " has no value." << endl;
+                        DRETURN -1;
+                    }
+
+                    // Pop the value as sink's value
+                    value = argv[++i];
+                }
+
+                // Parse the value as sink type
+                if (value == "frame") {
+                    options.sink_type = SinkType::frame;
+                } else if (value == "stream") {
+                    options.sink_type = SinkType::stream;
+                } else if (value == "mmap") {
+                    options.sink_type = SinkType::mmap;
+                } else {
+                    cerr << "Unknown sink '" << value << "'" << endl;
+                    DRETURN -1;
+                }
+
+            } else if (key == "-l" || key == "--layout") {
+                // Make sure a value is given
+                if (value.empty()) {
+                    // Be sure there are enough values
+                    if (i == argc - 1 || (accept_options && argv[i + 1][0] == '-')) {
+                        cerr << key << " has no value." << endl;
+                        DRETURN -1;
+                    }
+
+                    // Pop the value as layout's value
+                    value = argv[++i];
+                }
+
+                // Parse the value as frame layout
+                if (value == "row-major") {
+                    options.frame_layout = FrameLayout::row_major;
+                } else if (value == "tiled") {
+                    options.frame_layout = FrameLayout::tiled;
+                } else {
+                    cerr << "Unknown frame layout '" << value << "'" << endl;
+                    DRETURN -1;
+                }
+
             } else if (key == "-W" || key == "--width") {
                 // Make sure a value is given
                 if (value.empty()) {
@@ -205,6 +364,149 @@ int parse_cli(CLIOptions& options, int argc, const char** argv) {
                     DRETURN -1;
                 }
 
+            } else if (key == "-c" || key == "--compression") {
+                // Make sure a value is given
+                if (value.empty()) {
+                    // Be sure there are enough values
+                    if (i == argc - 1 || (accept_options && argv[i + 1][0] == '-')) {
+                        cerr << key << " has no value." << endl;
+                        DRETURN -1;
+                    }
+
+                    // Pop the value as compression's value
+                    value = argv[++i];
+                }
+
+                // Parse as unsigned integer
+                try {
+                    unsigned long ivalue = stoul(value);
+                    if (ivalue > 9) {
+                        cerr << "Compression level should be 0-9, not '" + value + "'";
+                        DRETURN -1;
+                    }
+                    options.compression = (int) ivalue;
+                } catch (std::invalid_argument&) {
+                    cerr << "Invalid compression level '" + value + "'";
+                    DRETURN -1;
+                } catch (std::out_of_range&) {
+                    cerr << "Compression level should be 0-9, not '" + value + "'";
+                    DRETURN -1;
+                }
+
+            } else if (key == "-n" || key == "--frames") {
+                // Make sure a value is given
+                if (value.empty()) {
+                    // Be sure there are enough values
+                    if (i == argc - 1 || (accept_options && argv[i + 1][0] == '-')) {
+                        cerr << key << " has no value." << endl;
+                        DRETURN -1;
+                    }
+
+                    // Pop the value as frames' value
+                    value = argv[++i];
+                }
+
+                // Parse as unsigned integer
+                try {
+                    unsigned long ivalue = stoul(value);
+                    if (ivalue == 0 || ivalue > numeric_limits<uint32_t>::max()) {
+                        cerr << "Number of frames should be at least 1 and at most " << numeric_limits<uint32_t>::max() << ", not '" + value + "'";
+                        DRETURN -1;
+                    }
+                    options.n_frames = (uint32_t) ivalue;
+                } catch (std::invalid_argument&) {
+                    cerr << "Invalid number of frames '" + value + "'";
+                    DRETURN -1;
+                } catch (std::out_of_range&) {
+                    cerr << "Number of frames too large '" + value + "'";
+                    DRETURN -1;
+                }
+
+            } else if (key == "-a" || key == "--animation") {
+                // Make sure a value is given
+                if (value.empty()) {
+                    // Be sure there are enough values
+                    if (i == argc - 1 || (accept_options && argv[i + 1][0] == '-')) {
+                        cerr << key << " has no value." << endl;
+                        DRETURN -1;
+                    }
+
+                    // Pop the value as animation's value
+                    value = argv[++i];
+                }
+
+                // Parse the value as animation type
+                if (value == "turntable") {
+                    options.animation_type = AnimationType::turntable;
+                } else if (value == "spin") {
+                    #ifdef ENABLE_VULKAN
+                    cerr << "Animation 'spin' is only available if compiled with RENDERER_BACKEND=Sequential or RENDERER_BACKEND=Threaded." << endl;
+                    DRETURN -1;
+                    #endif
+                    options.animation_type = AnimationType::spin;
+                } else {
+                    cerr << "Unknown animation '" << value << "'" << endl;
+                    DRETURN -1;
+                }
+
+            } else if (key == "-S" || key == "--scene") {
+                // Make sure a value is given
+                if (value.empty()) {
+                    // Be sure there are enough values
+                    if (i == argc - 1 || (accept_options && argv[i + 1][0] == '-')) {
+                        cerr << key << " has no value." << endl;
+                        DRETURN -1;
+                    }
+
+                    // Pop the value as scene's value
+                    value = argv[++i];
+                }
+
+                // Parse the value as scene description
+                std::string error = ECS::SceneSpec::parse(value, options.scene_spec);
+                if (!error.empty()) {
+                    cerr << "Invalid scene '" << value << "': " << error << endl;
+                    DRETURN -1;
+                }
+                options.generate_scene = true;
+
+            } else if (key == "--stats") {
+                // Make sure a value is given
+                if (value.empty()) {
+                    // Be sure there are enough values
+                    if (i == argc - 1 || (accept_options && argv[i + 1][0] == '-')) {
+                        cerr << key << " has no value." << endl;
+                        DRETURN -1;
+                    }
+
+                    // Pop the value as stats' value
+                    value = argv[++i];
+                }
+
+                // Store it as path
+                options.stats_path = value;
+
+            } else if (key == "--profile") {
+                #ifndef ENABLE_PROFILER
+                cerr << key << " is only available if compiled with PROFILER=Sampling." << endl;
+                DRETURN -1;
+                #endif
+
+                // Make sure a value is given
+                if (value.empty()) {
+                    // Be sure there are enough values
+                    if (i == argc - 1 || (accept_options && argv[i + 1][0] == '-')) {
+                        cerr << key << " has no value." << endl;
+                        DRETURN -1;
+                    }
+
+                    // Pop the value as profile's value
+                    value = argv[++i];
+                }
+
+                // Store it as path
+                options.profile_path = value;
+
             } else {
                 // Show that this isn't a valid option
                 cerr << "Unknown option '" << argv[i] << "'" << endl << endl;
@@ -233,6 +535,23 @@ int parse_cli(CLIOptions& options, int argc, const char** argv) {
         cerr << "No output path given." << endl;
         DRETURN -1;
     }
+
+    // Only the uncompressed formats can be written while rendering, and only they can hold floats
+    if (options.output_type == OutputType::png && options.sink_type != SinkType::frame) {
+        cerr << "PNG frames can only be written from memory; use '--sink frame' or another format." << endl;
+        DRETURN -1;
+    } else if (options.output_type == OutputType::pfm && options.sink_type == SinkType::frame) {
+        cerr << "PFM frames can only be written while rendering; use '--sink stream' or '--sink mmap'." << endl;
+        DRETURN -1;
+    }
+
+    // Every frame of an animation needs its own file
+    size_t placeholder_length;
+    uint32_t placeholder_width;
+    if (options.n_frames > 1 && find_frame_placeholder(options.output_path, placeholder_length, placeholder_width) == std::string::npos) {
+        cerr << "The output path of an animation should contain one placeholder for the frame number, like 'frame_%04d." << output_type_names[options.output_type] << "'." << endl;
+        DRETURN -1;
+    }
  
     // Done
     DRETURN 1;
@@ -244,7 +563,7 @@ int parse_cli(CLIOptions& options, int argc, const char** argv) {
 
 /***** ENTRY POINT *****/
 int main(int argc, const char** argv) {
-    DSTART("main"); DENTER("main");
+    DSTART("main"); PENTER("main");
 
     // Parse the arguments
     CLIOptions options;
@@ -259,43 +578,141 @@ int main(int argc, const char** argv) {
     DLOG(auxillary, "Options:");
     DLOG(auxillary, " - Output file  : '" + options.output_path + "'");
     DLOG(auxillary, " - Output type  : " + output_type_names[options.output_type]);
+    DLOG(auxillary, " - Output sink  : " + sink_type_names[options.sink_type]);
+    DLOG(auxillary, " - Frame layout : " + frame_layout_names[options.frame_layout]);
     DLOG(auxillary, " - Frame width  : " + std::to_string(options.width));
     DLOG(auxillary, " - Frame height : " + std::to_string(options.height));
+    if (options.output_type == OutputType::png) {
+        DLOG(auxillary, " - Compression  : " + std::to_string(options.compression));
+    }
+    if (options.generate_scene) {
+        const ECS::SceneSpec& spec = options.scene_spec;
+        DLOG(auxillary, " - Scene        : " + std::to_string(spec.n_spheres) + " spheres, " + std::to_string(spec.n_triangles) + " triangles, " + std::to_string(spec.n_objects) + " objects (" + ECS::scene_distribution_names[spec.distribution] + ")");
+    }
+    DLOG(auxillary, " - Frames       : " + std::to_string(options.n_frames));
+    if (!options.stats_path.empty()) {
+        DLOG(auxillary, " - Statistics   : '" + options.stats_path + "'");
+    }
+    if (!options.profile_path.empty()) {
+        DLOG(auxillary, " - Profile      : '" + options.profile_path + "'");
+    }
+    if (options.n_frames > 1) {
+        DLOG(auxillary, " - Animation    : " + animation_type_names[options.animation_type]);
+    }
     DLOG(auxillary, "");
 
     try {
+        #ifdef ENABLE_PROFILER
+        // Start sampling right away, so everything from initializing to writing the last frame shows up
+        if (!options.profile_path.empty()) {
+            Tools::Profiler::start();
+        }
+        #endif
+
         // Initialize the renderer
         Renderer* renderer = initialize_renderer();
 
-        // Initialize the camera object
-        Camera cam;
-        cam.update(options.width, options.height, 2.0, ((float) options.width / (float) options.height) * 2.0f, 2.0f);
-        
-        
+        // Initialize the camera object. It's kept for the entire animation, so its frame is re-used
+        Camera cam(options.frame_layout);
 
         // Prerender the frame
         // Tools::Array<ECS::RenderEntity*> entities({ ECS::create_object("bin/objects/teddy.obj", {0.0, 0.0, -3.0}, 1.0 / 17.0, {1.0, 0.0, 0.0}) });
         // Tools::Array<ECS::RenderEntity*> entities({ ECS::create_sphere({ 0.0, 0.0, -3.0 }, 1.0, 8, 8, { 1.0, 0.0, 0.0 }) });
         // Tools::Array<ECS::RenderEntity*> entities({ ECS::create_triangle({ 1.0, 0.0, -3.0 }, { -1.0, 0.0, -3.0 }, { 0.0, 1.0, -3.0 }, { 1.0, 0.0, 0.0 }) });
-        Tools::Array<ECS::RenderEntity*> entities({
-            ECS::create_object("bin/objects/teddy.obj", {0.0f, 0.0f, -3.0f}, 1.0f / 17.0f, {1.0f, 0.0f, 0.0f}),
-            ECS::create_sphere({ -2.0f, 0.0f, -5.0f }, 1.0f, 8, 8, { 0.0f, 0.0f, 1.0f })
-        });
+        // The entities live in the scene arena, which frees them all at once when we're done
+        Tools::Arena scene_arena;
+        glm::vec3 scene_center;
+        Tools::Array<ECS::RenderEntity*> entities;
+        if (options.generate_scene) {
+            scene_center = options.scene_spec.center;
+            entities = ECS::generate_scene(options.scene_spec, &scene_arena);
+            DLOG(info, "Generated scene with " + std::to_string(entities.size()) + " entities and " + std::to_string(ECS::count_faces(entities)) + " faces");
+        } else {
+            scene_center = glm::vec3(0.0f, 0.0f, -3.0f);
+            entities = Tools::Array<ECS::RenderEntity*>({
+                ECS::create_object("bin/objects/teddy.obj", scene_center, 1.0f / 17.0f, {1.0f, 0.0f, 0.0f}, &scene_arena),
+                ECS::create_sphere({ -2.0f, 0.0f, -5.0f }, 1.0f, 8, 8, { 0.0f, 0.0f, 1.0f }, &scene_arena)
+            });
+        }
         renderer->prerender(entities);
-        renderer->render(cam);
-        for (size_t i = 0; i < entities.size(); i++) {
-            delete entities[i];
+
+        // Prepare the animation. Both start where the scene is without one, so a single frame is always the same
+        CameraPath camera_path = CameraPath::turntable(scene_center, glm::length(scene_center), 0.0f, 1.0f);
+        ECS::EntityPath spin_path = ECS::EntityPath::spin(scene_center, glm::vec3(0.0f, 1.0f, 0.0f), 1.0f);
+        // The default scene spins just the teddy, while generated scenes spin as a whole
+        uint32_t n_spinning = options.generate_scene ? (uint32_t) entities.size() : 1;
+
+        // Render all frames, overlapping the encoding of one PNG with rendering the next. The encoder is only needed for PNGs, and shares the renderer's threads if it has any
+        std::unique_ptr<PngEncoder> encoder;
+        if (options.sink_type == SinkType::frame && options.output_type == OutputType::png) {
+            Tools::ThreadPool* pool = renderer->get_pool();
+            encoder.reset(pool != nullptr ? new PngEncoder(*pool, options.compression) : new PngEncoder(options.compression));
+        }
+        for (uint32_t f = 0; f < options.n_frames; f++) {
+            // Move the scene to where it is at this frame; the last frame stops just short of where the first one was
+            float time = (float) f / (float) options.n_frames;
+            if (options.n_frames > 1) {
+                if (options.animation_type == AnimationType::turntable) {
+                    cam.set_pose(camera_path.at(time));
+                } else if (f > 0) {
+                    // The renderer moves the entities from where they were pre-rendered, so we give where they are at this time
+                    glm::mat4 transform = spin_path.at(time);
+                    Tools::Array<EntityTransform> transforms(n_spinning);
+                    for (uint32_t e = 0; e < n_spinning; e++) {
+                        transforms.push_back(EntityTransform({ e, transform }));
+                    }
+                    renderer->transform_entities(transforms);
+                }
+                DLOG(info, "Rendering frame " + std::to_string(f + 1) + "/" + std::to_string(options.n_frames) + "...");
+            }
+            cam.update(options.width, options.height, 2.0, ((float) options.width / (float) options.height) * 2.0f, 2.0f);
+            std::string output_path = get_frame_path(options.output_path, f);
+
+            if (options.sink_type == SinkType::frame) {
+                renderer->render(cam);
+
+                // With the queue idle for sure, copy the result buffer back to the staging buffer
+                DLOG(info, "Saving frame...");
+                const Frame& result = cam.get_frame();
+                // Choose which type to store
+                if (options.output_type == OutputType::png) {
+                    if (options.n_frames > 1) {
+                        encoder->encode_async(result, output_path);
+                    } else {
+                        encoder->encode(result, output_path, &cam.get_frame_arena());
+                    }
+                } else if (options.output_type == OutputType::ppm) {
+                    result.to_ppm(output_path);
+                }
+            } else {
+                // Let the renderer write the file while it renders, so the frame is never in memory all at once
+                ImageFormat format = options.output_type == OutputType::pfm ? ImageFormat::pfm : ImageFormat::ppm;
+                if (options.sink_type == SinkType::stream) {
+                    StreamSink sink(output_path, format);
+                    renderer->render(cam, sink);
+                } else {
+                    MappedSink sink(output_path, format);
+                    renderer->render(cam, sink);
+                }
+            }
+        }
+        if (encoder != nullptr) { encoder->wait(); }
+
+        // Write the statistics of everything the renderer did, if asked
+        if (!options.stats_path.empty()) {
+            const RenderStats& stats = renderer->get_stats();
+            stats.write_json(options.stats_path);
+            DLOG(info, "Rendered " + std::to_string(stats.frames) + " frame(s) at " + std::to_string(stats.mrays_per_second()) + " Mrays/s; statistics written to '" + options.stats_path + "'");
         }
 
-        // With the queue idle for sure, copy the result buffer back to the staging buffer
-        DLOG(info, "Saving frame...");
-        const Frame& result = cam.get_frame();
-        // Choose which type to store
-        if (options.output_type == OutputType::png) {
-            result.to_png(options.output_path);
-        } else if (options.output_type == OutputType::ppm) {
-            result.to_ppm(options.output_path);
+        #ifdef ENABLE_PROFILER
+        // Write where the time went, if asked
+        if (!options.profile_path.empty()) {
+            Tools::Profiler::stop();
+            uint64_t n_samples = Tools::Profiler::write_collapsed(options.profile_path);
+            DLOG(info, "Wrote " + std::to_string(n_samples) + " profiler samples to '" + options.profile_path + "'");
         }
+        #endif
 
 
 
@@ -0,0 +1,146 @@
+/* BAKE.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 01:14:37
+ * Last edited:
+ *   16/10/2026, 01:14:37
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Small tool that pre-bakes the mesh caches for object files, so the
+ *   RayTracer itself never has to parse them. Takes any number of object
+ *   files or directories, which are searched recursively for .obj files.
+**/
+
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cctype>
+#include <CppDebugger.hpp>
+
+#include "entities/Object.hpp"
+#include "entities/MeshCache.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** HELPER FUNCTIONS *****/
+/* Returns whether the given path looks like an object file, i.e., has the .obj extension (in any case). */
+static bool is_object_file(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char) std::tolower((unsigned char) c); });
+    return extension == ".obj";
+}
+
+/* Bakes the cache for the given object file, unless it is up-to-date already and force is false. Returns whether that succeeded. */
+static bool bake(const std::string& file_path, bool force) {
+    DENTER("bake");
+
+    // Throw out the old cache if we have to re-bake it regardless
+    std::string cache_path = ECS::MeshCache::path_for(file_path);
+    if (force) { std::remove(cache_path.c_str()); }
+
+    // Creating the object uses the cache if it's up-to-date, and writes one otherwise
+    ECS::Object* obj;
+    try {
+        obj = ECS::create_object(file_path, glm::vec3(0.0f), 1.0f, glm::vec3(1.0f));
+    } catch (CppDebugger::Fatal&) {
+        cerr << "  failed     " << file_path << endl;
+        DRETURN false;
+    }
+    bool up_to_date = obj->mesh->cache != nullptr;
+    uint32_t n_vertices = obj->pre_render_vertices, n_faces = obj->pre_render_faces;
+    delete obj;
+
+    // Check that the cache is actually usable now
+    if (!up_to_date) {
+        ECS::MeshCache* cache = ECS::MeshCache::open(cache_path, file_path);
+        if (cache == nullptr) {
+            cerr << "  failed     " << file_path << " (could not write '" << cache_path << "')" << endl;
+            DRETURN false;
+        }
+        delete cache;
+    }
+
+    cout << (up_to_date ? "  up-to-date " : "  baked      ") << file_path << " (" << n_vertices << " vertices, " << n_faces << " faces)" << endl;
+    DRETURN true;
+}
+
+
+
+
+
+/***** ENTRY POINT *****/
+int main(int argc, const char** argv) {
+    DSTART("main"); DENTER("main");
+
+    // Parse the arguments
+    bool force = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            cout << "Usage: " << argv[0] << " [<options>] <path> [<path> ...]" << endl << endl;
+
+            cout << "Bakes the mesh cache ('<file>" << ECS::mesh_cache_extension << "') of every given object file, and of every .obj file in the given directories (recursively)." << endl << endl;
+
+            cout << "Options:" << endl;
+            cout << "\t-f,--force\tRe-bakes caches even if they are up-to-date." << endl;
+            cout << endl << "\t-h,--help\tShows this help menu, then exits." << endl << endl;
+
+            DRETURN 0;
+        } else if (arg == "-f" || arg == "--force") {
+            force = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            cerr << "Unknown option '" << arg << "'" << endl;
+            DRETURN -1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        cerr << "No paths given; use '" << argv[0] << " --help' for usage." << endl;
+        DRETURN -1;
+    }
+
+    // Collect all object files first, so we bake them in a predictable order
+    std::vector<std::string> files;
+    for (size_t i = 0; i < paths.size(); i++) {
+        std::error_code error;
+        if (std::filesystem::is_directory(paths[i], error)) {
+            std::vector<std::string> found;
+            for (std::filesystem::recursive_directory_iterator it(paths[i], error), end; !error && it != end; it.increment(error)) {
+                if (it->is_regular_file(error) && is_object_file(it->path())) { found.push_back(it->path().string()); }
+            }
+            if (error) {
+                cerr << "Could not search directory '" << paths[i] << "': " << error.message() << endl;
+                DRETURN -1;
+            }
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        } else {
+            files.push_back(paths[i]);
+        }
+    }
+
+    // Bake them one by one; every object file is parsed in parallel already
+    cout << "Baking " << files.size() << " object file(s)..." << endl;
+    size_t n_failed = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!bake(files[i], force)) { ++n_failed; }
+    }
+    if (n_failed > 0) {
+        cerr << "Failed to bake " << n_failed << " of " << files.size() << " object file(s)." << endl;
+        DRETURN -1;
+    }
+
+    cout << "Done." << endl;
+    DRETURN 0;
+}
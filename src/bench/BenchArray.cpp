@@ -0,0 +1,126 @@
+/* BENCH ARRAY.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 10:12:48
+ * Last edited:
+ *   16/10/2026, 10:12:48
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Micro-benchmark that compares building a Tools::Array element by
+ *   element against doing the same with a std::vector, both for the
+ *   trivially copyable types the renderers use and for a type that has
+ *   to be moved properly.
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <limits>
+#include <CppDebugger.hpp>
+
+#include "glm/glm.hpp"
+#include "renderer/Vertex.hpp"
+#include "tools/Array.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** HELPER FUNCTIONS *****/
+/* @brief Times how long it takes to fill a new, empty container of the given type with the given number of elements, one at a time.
+ * @param n_elements The number of elements to add.
+ * @param repetitions The number of times to repeat the experiment.
+ * @param add Function that adds the i'th element to the given container.
+ * @return The best time of all repetitions, in seconds.
+ */
+template <class CONTAINER, class FUNC>
+static double time_fill(size_t n_elements, uint32_t repetitions, FUNC add) {
+    double best = std::numeric_limits<double>::max();
+    for (uint32_t r = 0; r < repetitions; r++) {
+        auto start = std::chrono::steady_clock::now();
+        {
+            CONTAINER container;
+            for (size_t i = 0; i < n_elements; i++) {
+                add(container, i);
+            }
+
+            // Make sure the compiler can't throw the work away
+            volatile size_t sink = container.size();
+            (void) sink;
+        }
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (time < best) { best = time; }
+    }
+    return best;
+}
+
+/* @brief Prints a single line of the results table.
+ * @param name The name of the experiment.
+ * @param array_time The time it took the Tools::Array, in seconds.
+ * @param vector_time The time it took the std::vector, in seconds.
+ * @param n_elements The number of elements that were added.
+ */
+static void print_result(const std::string& name, double array_time, double vector_time, size_t n_elements) {
+    cout << std::left << std::setw(29) << name << ": "
+         << std::right << std::setw(8) << std::fixed << std::setprecision(2) << array_time * 1e9 / n_elements << " ns/element (Array), "
+         << std::setw(8) << vector_time * 1e9 / n_elements << " ns/element (std::vector), "
+         << std::setprecision(2) << array_time / vector_time << "x" << endl;
+}
+
+
+
+
+
+/***** ENTRY POINT *****/
+int main(int argc, const char** argv) {
+    DSTART("main"); DENTER("main");
+
+    // Read the optional number of elements and repetitions
+    size_t n_elements = 1000000;
+    uint32_t repetitions = 5;
+    try {
+        if (argc > 1) { n_elements = (size_t) std::stoull(argv[1]); }
+        if (argc > 2) { repetitions = (uint32_t) std::stoul(argv[2]); }
+    } catch (std::exception&) {
+        cerr << "Usage: " << argv[0] << " [<n_elements> [<repetitions>]]" << endl;
+        DRETURN -1;
+    }
+    if (n_elements == 0 || repetitions == 0) {
+        cerr << "There should be at least one element and at least one repetition." << endl;
+        DRETURN -1;
+    }
+    cout << "Elements                     : " << n_elements << " (best of " << repetitions << ")" << endl;
+
+    // Vertices, the simplest trivially copyable type
+    auto add_vertex = [](auto& container, size_t i) { container.push_back(glm::vec4((float) i, 1.0f, 2.0f, 0.0f)); };
+    print_result("push_back(glm::vec4)", time_fill<Tools::Array<glm::vec4>>(n_elements, repetitions, add_vertex), time_fill<std::vector<glm::vec4>>(n_elements, repetitions, add_vertex), n_elements);
+
+    // Faces, which are much larger
+    auto push_face = [](auto& container, size_t i) {
+        GFace face;
+        face.v1 = (uint32_t) i; face.v2 = (uint32_t) i + 1; face.v3 = (uint32_t) i + 2;
+        face.normal = glm::vec3(0.0f, 1.0f, 0.0f); face.color = glm::vec3(1.0f);
+        container.push_back(face);
+    };
+    print_result("push_back(GFace)", time_fill<Tools::Array<GFace>>(n_elements, repetitions, push_face), time_fill<std::vector<GFace>>(n_elements, repetitions, push_face), n_elements);
+
+    // The same, but constructed in-place
+    auto emplace_face = [](auto& container, size_t i) {
+        GFace& face = container.emplace_back();
+        face.v1 = (uint32_t) i; face.v2 = (uint32_t) i + 1; face.v3 = (uint32_t) i + 2;
+        face.normal = glm::vec3(0.0f, 1.0f, 0.0f); face.color = glm::vec3(1.0f);
+    };
+    print_result("emplace_back(GFace)", time_fill<Tools::Array<GFace>>(n_elements, repetitions, emplace_face), time_fill<std::vector<GFace>>(n_elements, repetitions, emplace_face), n_elements);
+
+    // Strings, which have to be moved rather than copied bytewise. Long enough to live on the heap, so we only measure the containers themselves
+    auto emplace_string = [](auto& container, size_t i) { container.emplace_back(32, (char) ('a' + i % 26)); };
+    print_result("emplace_back(std::string)", time_fill<Tools::Array<std::string>>(n_elements, repetitions, emplace_string), time_fill<std::vector<std::string>>(n_elements, repetitions, emplace_string), n_elements);
+
+    DRETURN 0;
+}
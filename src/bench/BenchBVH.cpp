@@ -0,0 +1,146 @@
+/* BENCH BVH.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 14:36:02
+ * Last edited:
+ *   16/10/2026, 14:36:02
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Benchmark that compares rebuilding the entire BVH with refitting it
+ *   when only some entities of a scene move. The scene is a grid of
+ *   teddies, of which a few spin around every frame.
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <limits>
+#include <cmath>
+#include <CppDebugger.hpp>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "renderer/BVH.hpp"
+#include "entities/Object.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** HELPER FUNCTIONS *****/
+/* @brief Rotates the vertices of the given entity around the vertical axis through its center.
+ * @param vertices The vertex buffer of the scene.
+ * @param entity The entity whose vertices to rotate.
+ * @param angle The angle to rotate by, in radians.
+ */
+static void spin_entity(Tools::Array<glm::vec4>& vertices, const BVHEntity& entity, float angle) {
+    glm::vec3 center = entity.bounds.centroid();
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), center) * glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::translate(glm::mat4(1.0f), -center);
+    for (uint32_t v = entity.first_vertex; v < entity.first_vertex + entity.n_vertices; v++) {
+        vertices[v] = glm::vec4(glm::vec3(transform * glm::vec4(glm::vec3(vertices[v]), 1.0f)), vertices[v].w);
+    }
+}
+
+
+
+
+
+/***** ENTRY POINT *****/
+int main(int argc, const char** argv) {
+    DSTART("main"); DENTER("main");
+
+    // Read the optional scene size, number of moving entities and number of frames
+    uint32_t n_entities = 16, n_moving = 1, n_frames = 30;
+    try {
+        if (argc > 1) { n_entities = (uint32_t) std::stoul(argv[1]); }
+        if (argc > 2) { n_moving = (uint32_t) std::stoul(argv[2]); }
+        if (argc > 3) { n_frames = (uint32_t) std::stoul(argv[3]); }
+    } catch (std::exception&) {
+        cerr << "Usage: " << argv[0] << " [<entities> [<moving entities> [<frames>]]]" << endl;
+        DRETURN -1;
+    }
+    if (n_entities == 0 || n_moving > n_entities || n_frames == 0) {
+        cerr << "There should be at least one entity, at most as many moving entities as there are entities, and at least one frame." << endl;
+        DRETURN -1;
+    }
+
+    try {
+        // Lay the teddies out in a square grid, and pre-render them into one buffer the way the renderer does
+        Tools::Arena scene_arena;
+        uint32_t grid_size = (uint32_t) std::ceil(std::sqrt((float) n_entities));
+        Tools::Array<ECS::Object*> objects(n_entities);
+        Tools::Array<BVHEntity> entities(n_entities);
+        uint32_t n_faces = 0, n_vertices = 0;
+        for (uint32_t i = 0; i < n_entities; i++) {
+            glm::vec3 center(3.0f * (float) (i % grid_size), 3.0f * (float) (i / grid_size), -3.0f);
+            objects.push_back(ECS::create_object("bin/objects/teddy.obj", center, 1.0f / 17.0f, {1.0f, 0.0f, 0.0f}, &scene_arena));
+
+            BVHEntity entity{};
+            entity.first_face = n_faces;
+            entity.n_faces = objects[i]->pre_render_faces;
+            entity.first_vertex = n_vertices;
+            entity.n_vertices = objects[i]->pre_render_vertices;
+            n_faces += entity.n_faces;
+            n_vertices += entity.n_vertices;
+            entities.push_back(entity);
+        }
+        Tools::Array<GFace> faces(n_faces);
+        Tools::Array<glm::vec4> vertices(n_vertices);
+        Tools::Array<GSphere> spheres;
+        faces.wdata(n_faces);
+        vertices.wdata(n_vertices);
+        for (uint32_t i = 0; i < n_entities; i++) {
+            ECS::cpu_pre_render_object(faces.wdata() + entities[i].first_face, vertices.wdata() + entities[i].first_vertex, entities[i].first_vertex, objects[i]);
+        }
+        cout << "Scene                   : " << n_entities << " teddies (" << n_faces << " faces), of which " << n_moving << " spin" << endl;
+        cout << "Frames                  : " << n_frames << endl;
+
+        // The entities that move are spread over the grid
+        Tools::Array<uint32_t> moved(n_moving);
+        for (uint32_t i = 0; i < n_moving; i++) {
+            moved.push_back((uint32_t) ((uint64_t) i * n_entities / n_moving));
+        }
+
+        // First, rebuild the entire tree every frame
+        Tools::Arena scratch;
+        BVH bvh;
+        bvh.build(faces, vertices, spheres, entities, scratch);
+        double rebuild_time = 0.0;
+        for (uint32_t f = 0; f < n_frames; f++) {
+            for (uint32_t i = 0; i < moved.size(); i++) {
+                spin_entity(vertices, bvh.get_entities()[moved[i]], 0.1f);
+            }
+
+            scratch.reset();
+            auto start = std::chrono::steady_clock::now();
+            bvh.build(faces, vertices, spheres, entities, scratch);
+            rebuild_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        // Then, spin them back while only refitting
+        double refit_time = 0.0;
+        uint32_t n_full_rebuilds = 0;
+        for (uint32_t f = 0; f < n_frames; f++) {
+            for (uint32_t i = 0; i < moved.size(); i++) {
+                spin_entity(vertices, bvh.get_entities()[moved[i]], -0.1f);
+            }
+
+            scratch.reset();
+            auto start = std::chrono::steady_clock::now();
+            if (bvh.refit(faces, vertices, spheres, moved, scratch)) { ++n_full_rebuilds; }
+            refit_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        cout << "Full rebuild            : " << std::fixed << std::setprecision(3) << rebuild_time * 1e3 / n_frames << " ms/frame" << endl;
+        cout << "Refit                   : " << refit_time * 1e3 / n_frames << " ms/frame (" << n_full_rebuilds << " full rebuilds), " << std::setprecision(1) << rebuild_time / refit_time << "x faster" << endl;
+    } catch (CppDebugger::Fatal&) {
+        DRETURN -1;
+    }
+
+    DRETURN 0;
+}
@@ -0,0 +1,159 @@
+/* BENCH FRAME.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 12:58:30
+ * Last edited:
+ *   16/10/2026, 12:58:30
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Micro-benchmark that compares the row-major and tiled layouts of a
+ *   Frame, both for writing rendered tiles and bands into it and for
+ *   finalizing it, i.e., reading it back row by row the way the encoders
+ *   do.
+**/
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <limits>
+#include <CppDebugger.hpp>
+
+#include "glm/glm.hpp"
+#include "camera/Frame.hpp"
+#include "camera/FrameSink.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** CONSTANTS *****/
+/* The size of the tiles written to the frames, which is the same as the threaded renderer's. */
+static const constexpr uint32_t tile_size = 16;
+
+
+
+
+
+/***** HELPER FUNCTIONS *****/
+/* @brief Times how long the given experiment takes on a frame of the given layout.
+ * @param width The width of the frame.
+ * @param height The height of the frame.
+ * @param layout The layout of the frame.
+ * @param repetitions The number of times to repeat the experiment.
+ * @param experiment Function that does the experiment on the given frame.
+ * @return The best time of all repetitions, in seconds.
+ */
+template <class FUNC>
+static double time_frame(uint32_t width, uint32_t height, FrameLayout layout, uint32_t repetitions, FUNC experiment) {
+    // Allocate and touch the frame once up front, so we don't measure page faults
+    Frame frame(width, height, layout);
+    for (size_t i = 0; i < frame.size(); i++) { frame.d()[i] = (uint32_t) i; }
+
+    double best = std::numeric_limits<double>::max();
+    for (uint32_t r = 0; r < repetitions; r++) {
+        auto start = std::chrono::steady_clock::now();
+        experiment(frame);
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (time < best) { best = time; }
+    }
+    return best;
+}
+
+/* @brief Prints a single line of the results table.
+ * @param name The name of the experiment.
+ * @param row_major_time The time it took the row-major frame, in seconds.
+ * @param tiled_time The time it took the tiled frame, in seconds.
+ * @param n_pixels The number of pixels in the frame.
+ */
+static void print_result(const std::string& name, double row_major_time, double tiled_time, size_t n_pixels) {
+    cout << std::left << std::setw(24) << name << ": "
+         << std::right << std::setw(9) << std::fixed << std::setprecision(1) << n_pixels / row_major_time / 1e6 << " Mpixels/s (row-major), "
+         << std::setw(9) << n_pixels / tiled_time / 1e6 << " Mpixels/s (tiled), "
+         << std::setprecision(2) << row_major_time / tiled_time << "x" << endl;
+}
+
+
+
+
+
+/***** ENTRY POINT *****/
+int main(int argc, const char** argv) {
+    DSTART("main"); DENTER("main");
+
+    // Read the optional size and repetitions
+    uint32_t width = 4096, height = 4096;
+    uint32_t repetitions = 5;
+    try {
+        if (argc > 1) { width = (uint32_t) std::stoul(argv[1]); }
+        if (argc > 2) { height = (uint32_t) std::stoul(argv[2]); }
+        if (argc > 3) { repetitions = (uint32_t) std::stoul(argv[3]); }
+    } catch (std::exception&) {
+        cerr << "Usage: " << argv[0] << " [<width> [<height> [<repetitions>]]]" << endl;
+        DRETURN -1;
+    }
+    if (width == 0 || height == 0 || repetitions == 0) {
+        cerr << "The frame should be at least one pixel, and there should be at least one repetition." << endl;
+        DRETURN -1;
+    }
+    size_t n_pixels = (size_t) width * (size_t) height;
+    cout << "Frame                   : " << width << "x" << height << " (best of " << repetitions << ")" << endl;
+
+    // Some colors to write, enough for a full-width band
+    std::vector<glm::vec3> colors((size_t) width * tile_size);
+    for (size_t i = 0; i < colors.size(); i++) {
+        colors[i] = glm::vec3((float) (i % 256) / 255.0f, (float) (i % 7) / 7.0f, 0.5f);
+    }
+
+    // Writing tiles, in the order the threaded renderer hands them out
+    auto write_tiles = [&colors, width, height](Frame& frame) {
+        FrameBufferSink sink(frame);
+        sink.begin(width, height);
+        for (uint32_t y0 = 0; y0 < height; y0 += tile_size) {
+            for (uint32_t x0 = 0; x0 < width; x0 += tile_size) {
+                sink.write(x0, y0, std::min(x0 + tile_size, width), std::min(y0 + tile_size, height), colors.data(), tile_size);
+            }
+        }
+        sink.end();
+    };
+    print_result("write tiles (16x16)", time_frame(width, height, FrameLayout::row_major, repetitions, write_tiles), time_frame(width, height, FrameLayout::tiled, repetitions, write_tiles), n_pixels);
+
+    // Writing full-width bands, the way the sequential renderer does
+    auto write_bands = [&colors, width, height](Frame& frame) {
+        FrameBufferSink sink(frame);
+        sink.begin(width, height);
+        for (uint32_t y0 = 0; y0 < height; y0 += tile_size) {
+            sink.write(0, y0, width, std::min(y0 + tile_size, height), colors.data(), width);
+        }
+        sink.end();
+    };
+    print_result("write bands (16 rows)", time_frame(width, height, FrameLayout::row_major, repetitions, write_bands), time_frame(width, height, FrameLayout::tiled, repetitions, write_bands), n_pixels);
+
+    // Finalizing, i.e., reading the rows back and unpacking them to RGB like the encoders do
+    auto finalize = [width, height](Frame& frame) {
+        std::vector<uint32_t> row_buffer(width);
+        std::vector<unsigned char> rgb(3 * (size_t) width);
+        size_t checksum = 0;
+        for (uint32_t y = 0; y < height; y++) {
+            const uint32_t* row = frame.row(y, row_buffer.data());
+            for (uint32_t x = 0; x < width; x++) {
+                rgb[3 * (size_t) x    ] = (row[x] >> 24) & 0xFF;
+                rgb[3 * (size_t) x + 1] = (row[x] >> 16) & 0xFF;
+                rgb[3 * (size_t) x + 2] = (row[x] >>  8) & 0xFF;
+            }
+            checksum += rgb[(size_t) y % rgb.size()];
+        }
+
+        // Make sure the compiler can't throw the work away
+        volatile size_t sink = checksum;
+        (void) sink;
+    };
+    print_result("finalize (to rows)", time_frame(width, height, FrameLayout::row_major, repetitions, finalize), time_frame(width, height, FrameLayout::tiled, repetitions, finalize), n_pixels);
+
+    DRETURN 0;
+}
@@ -0,0 +1,145 @@
+/* BENCH TRACING.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   15/10/2026, 18:24:10
+ * Last edited:
+ *   15/10/2026, 18:24:10
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Benchmark that shows what the CppDebugger tracing costs on hot paths.
+ *   It first runs the same per-pixel kernel once with and once without
+ *   DENTER / DRETURN, and then times a full render of the default scene
+ *   with whichever TRACING mode the project was compiled with.
+**/
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <limits>
+#include <CppDebugger.hpp>
+
+#include "renderer/Renderer.hpp"
+
+#include "entities/Sphere.hpp"
+#include "entities/Object.hpp"
+
+#include "camera/Camera.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** KERNELS *****/
+/* Computes the color of the sky for the given pixel, registering itself with the debugger like the kernels do in the 'Full' tracing mode. */
+static glm::vec3 traced_kernel(float u, float v) {
+    DENTER("traced_kernel");
+    glm::vec3 direction = glm::normalize(glm::vec3(u - 0.5f, v - 0.5f, -1.0f));
+    float t = 0.5f * (direction.y + 1.0f);
+    DRETURN (1.0f - t) * glm::vec3(1.0f) + t * glm::vec3(0.5f, 0.7f, 1.0f);
+}
+
+/* Computes the color of the sky for the given pixel, without any tracing like the kernels do in the 'Stages' tracing mode. */
+static glm::vec3 untraced_kernel(float u, float v) {
+    glm::vec3 direction = glm::normalize(glm::vec3(u - 0.5f, v - 0.5f, -1.0f));
+    float t = 0.5f * (direction.y + 1.0f);
+    return (1.0f - t) * glm::vec3(1.0f) + t * glm::vec3(0.5f, 0.7f, 1.0f);
+}
+
+
+
+
+
+/***** HELPER FUNCTIONS *****/
+/* Runs the given kernel once for every pixel in a frame of the given size, and returns the best time of the given number of repetitions in seconds. The kernel is called through a volatile pointer, so the compiler can't inline it (and thereby hide the call overhead). */
+static double time_kernel(glm::vec3 (* volatile kernel)(float, float), uint32_t width, uint32_t height, uint32_t repetitions) {
+    double best = std::numeric_limits<double>::max();
+    for (uint32_t r = 0; r < repetitions; r++) {
+        glm::vec3 sum(0.0f);
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                sum += kernel((float) x / (float) width, (float) y / (float) height);
+            }
+        }
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (time < best) { best = time; }
+
+        // Make sure the compiler can't throw the work away
+        volatile float sink = sum.x + sum.y + sum.z;
+        (void) sink;
+    }
+    return best;
+}
+
+
+
+
+
+/***** ENTRY POINT *****/
+int main(int argc, const char** argv) {
+    DSTART("main"); DENTER("main");
+
+    // Read the optional width, height and number of repetitions
+    uint32_t width = 1280, height = 960, repetitions = 5;
+    try {
+        if (argc > 1) { width = (uint32_t) std::stoul(argv[1]); }
+        if (argc > 2) { height = (uint32_t) std::stoul(argv[2]); }
+        if (argc > 3) { repetitions = (uint32_t) std::stoul(argv[3]); }
+    } catch (std::exception&) {
+        cerr << "Usage: " << argv[0] << " [<width> [<height> [<repetitions>]]]" << endl;
+        DRETURN -1;
+    }
+    if (width < 2 || height < 2 || repetitions == 0) {
+        cerr << "Width and height should be at least 2, and there should be at least one repetition." << endl;
+        DRETURN -1;
+    }
+    uint64_t n_pixels = (uint64_t) width * (uint64_t) height;
+
+    #ifdef TRACE_KERNELS
+    cout << "Tracing mode                 : Full" << endl;
+    #else
+    cout << "Tracing mode                 : Stages" << endl;
+    #endif
+    cout << "Frame size                   : " << width << "x" << height << " (best of " << repetitions << ")" << endl;
+
+    // Time the kernels on their own
+    double traced = time_kernel(traced_kernel, width, height, repetitions);
+    double untraced = time_kernel(untraced_kernel, width, height, repetitions);
+    cout << "Traced kernel                : " << traced * 1e9 / n_pixels << " ns/pixel" << endl;
+    cout << "Untraced kernel              : " << untraced * 1e9 / n_pixels << " ns/pixel" << endl;
+    cout << "Tracing overhead             : " << (traced - untraced) * 1e9 / n_pixels << " ns/call" << endl;
+
+    try {
+        // Render the default scene in whatever mode we're compiled with
+        Renderer* renderer = initialize_renderer();
+        Camera cam;
+        cam.update(width, height, 2.0, ((float) width / (float) height) * 2.0f, 2.0f);
+        Tools::Array<ECS::RenderEntity*> entities({
+            ECS::create_object("bin/objects/teddy.obj", {0.0f, 0.0f, -3.0f}, 1.0f / 17.0f, {1.0f, 0.0f, 0.0f}),
+            ECS::create_sphere({ -2.0f, 0.0f, -5.0f }, 1.0f, 8, 8, { 0.0f, 0.0f, 1.0f })
+        });
+        renderer->prerender(entities);
+
+        double best = std::numeric_limits<double>::max();
+        for (uint32_t r = 0; r < repetitions; r++) {
+            auto start = std::chrono::steady_clock::now();
+            renderer->render(cam);
+            double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (time < best) { best = time; }
+        }
+        cout << "Render                       : " << best * 1e3 << " ms (" << best * 1e9 / n_pixels << " ns/pixel)" << endl;
+
+        for (size_t i = 0; i < entities.size(); i++) {
+            delete entities[i];
+        }
+        delete renderer;
+    } catch (CppDebugger::Fatal&) {
+        DRETURN -1;
+    }
+
+    DRETURN 0;
+}
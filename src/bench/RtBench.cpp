@@ -0,0 +1,594 @@
+/* RT BENCH.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 15:10:48
+ * Last edited:
+ *   16/10/2026, 01:15:08
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   The benchmark suite of the RayTracer. Times the intersection kernels
+ *   and BVH traversal (CPU backends only), pre-rendering per entity type,
+ *   OBJ parsing, rendering, PNG & PPM encoding and MemoryPool allocation
+ *   (Vulkan backends only) on reproducible scenes, and how rendering
+ *   scales with generated scenes of increasing size. Writes the results as
+ *   JSON so they can be tracked over time.
+**/
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <limits>
+#include <thread>
+#include <cstdio>
+#include <filesystem>
+#include <CppDebugger.hpp>
+
+#include "renderer/Renderer.hpp"
+#ifndef ENABLE_VULKAN
+#include "renderer/BVH.hpp"
+#include "renderer/WoopFaces.hpp"
+#include "renderer/SphereHit.hpp"
+#else
+#include "compute/Instance.hpp"
+#include "compute/GPU.hpp"
+#include "compute/MemoryPool.hpp"
+#include "compute/DescriptorSetLayout.hpp"
+#include "compute/Shader.hpp"
+#include "compute/Pipeline.hpp"
+#include "tools/Common.hpp"
+#endif
+
+#include "entities/Triangle.hpp"
+#include "entities/Sphere.hpp"
+#include "entities/Object.hpp"
+#include "entities/SceneGenerator.hpp"
+
+#include "camera/Camera.hpp"
+#include "camera/PngEncoder.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** CONSTANTS *****/
+/* The object file that is used as asset scene. */
+static const char* asset_path = "bin/objects/teddy.obj";
+/* The seed of the random number generator, so every run sees the same rays and scenes. */
+static const constexpr uint32_t seed = 42;
+/* The width of the rendered frame. */
+static const constexpr uint32_t frame_width = 640;
+/* The height of the rendered frame. */
+static const constexpr uint32_t frame_height = 480;
+/* The width of the frames rendered of generated scenes. */
+static const constexpr uint32_t scaling_width = 320;
+/* The height of the frames rendered of generated scenes. */
+static const constexpr uint32_t scaling_height = 240;
+/* The numbers of triangles in the generated scenes, if none is given. */
+static const uint32_t scaling_sizes[] = { 1000, 10000, 100000 };
+
+
+
+
+
+/***** STRUCTS *****/
+/* The BenchResult struct, which is the outcome of a single benchmark. */
+struct BenchResult {
+    /* The name of the benchmark, as <group>/<name>. */
+    std::string name;
+    /* The best time of all repetitions, in milliseconds. */
+    double ms;
+    /* The throughput of the benchmark, in the given unit. */
+    double rate;
+    /* The unit of the throughput. */
+    std::string unit;
+    /* The number of bytes involved (read, written or allocated), or 0 if that doesn't apply. */
+    size_t bytes;
+};
+
+
+
+
+
+/***** HELPER FUNCTIONS *****/
+/* @brief Generates the next number of a xorshift32 sequence, which (unlike the std distributions) gives the same numbers on every platform.
+ * @param state The state of the generator, which is updated.
+ * @return A random float in [0, 1).
+ */
+static inline float random_float(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (float) (state >> 8) / 16777216.0f;
+}
+
+/* @brief Runs the given experiment the given number of times.
+ * @param repetitions The number of times to run the experiment.
+ * @param experiment The function to time.
+ * @return The best time of all repetitions, in seconds.
+ */
+template <class FUNC>
+static double time_best(uint32_t repetitions, FUNC experiment) {
+    double best = std::numeric_limits<double>::max();
+    for (uint32_t r = 0; r < repetitions; r++) {
+        auto start = std::chrono::steady_clock::now();
+        experiment();
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (time < best) { best = time; }
+    }
+    return best;
+}
+
+/* @brief Stores the result of a benchmark, and prints it for whoever is watching.
+ * @param results The list of results to add it to.
+ * @param name The name of the benchmark.
+ * @param seconds The best time of the benchmark, in seconds.
+ * @param amount The amount of work done in that time, in millions of the given unit.
+ * @param unit The unit of the throughput.
+ * @param bytes The number of bytes involved, if any.
+ */
+static void add_result(std::vector<BenchResult>& results, const std::string& name, double seconds, double amount, const std::string& unit, size_t bytes = 0) {
+    results.push_back({ name, seconds * 1e3, amount / seconds, unit, bytes });
+    cout << std::left << std::setw(36) << name << ": " << std::right << std::setw(10) << std::fixed << std::setprecision(3) << seconds * 1e3 << " ms, " << std::setw(10) << std::setprecision(2) << amount / seconds << " " << unit << endl;
+}
+
+/* @brief Returns the name of the backend the benchmark is compiled with.
+ * @return The name, as given to RENDERER_BACKEND.
+ */
+static std::string backend_name() {
+    #if defined(ENABLE_ONLINE)
+    return "VulkanOnline";
+    #elif defined(ENABLE_VULKAN)
+    return "Vulkan";
+    #elif defined(ENABLE_THREADED)
+    return "Threaded";
+    #else
+    return "Sequential";
+    #endif
+}
+
+/* @brief Writes the results as a JSON document, together with the configuration they were measured with.
+ * @param h The stream to write to.
+ * @param results The results to write.
+ * @param repetitions The number of repetitions of every benchmark.
+ */
+static void write_json(std::ostream& h, const std::vector<BenchResult>& results, uint32_t repetitions) {
+    h << "{" << endl;
+    h << "    \"config\": {" << endl;
+    h << "        \"backend\": \"" << backend_name() << "\"," << endl;
+    h << "        \"packet_size\": " << PACKET_SIZE << "," << endl;
+    #ifdef BRUTE_FORCE
+    h << "        \"acceleration\": \"None\"," << endl;
+    #else
+    h << "        \"acceleration\": \"BVH\"," << endl;
+    #endif
+    #ifdef TRACE_KERNELS
+    h << "        \"tracing\": \"Full\"," << endl;
+    #else
+    h << "        \"tracing\": \"Stages\"," << endl;
+    #endif
+    h << "        \"hardware_threads\": " << std::thread::hardware_concurrency() << "," << endl;
+    h << "        \"frame\": [" << frame_width << ", " << frame_height << "]," << endl;
+    h << "        \"repetitions\": " << repetitions << "," << endl;
+    h << "        \"seed\": " << seed << endl;
+    h << "    }," << endl;
+    h << "    \"results\": [" << endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        h << "        { \"name\": \"" << result.name << "\", \"ms\": " << std::setprecision(6) << result.ms << ", \"rate\": " << result.rate << ", \"unit\": \"" << result.unit << "\", \"bytes\": " << result.bytes << " }" << (i < results.size() - 1 ? "," : "") << endl;
+    }
+    h << "    ]" << endl;
+    h << "}" << endl;
+}
+
+
+
+#ifndef ENABLE_VULKAN
+/* @brief Times the intersection kernels and the BVH traversal on the asset scene.
+ * @param results The list of results to add to.
+ * @param repetitions The number of times to repeat every benchmark.
+ */
+static void bench_kernels(std::vector<BenchResult>& results, uint32_t repetitions) {
+    DENTER("bench_kernels");
+
+    // Pre-render the teddy & a sphere the way the renderer does, and prepare them for intersection
+    Tools::Arena arena;
+    ECS::Object* teddy = ECS::create_object(asset_path, { 0.0f, 0.0f, -3.0f }, 1.0f / 17.0f, { 1.0f, 0.0f, 0.0f }, &arena);
+    Tools::Array<GFace> faces(teddy->pre_render_faces);
+    Tools::Array<glm::vec4> vertices(teddy->pre_render_vertices);
+    ECS::cpu_pre_render_object(faces.wdata(teddy->pre_render_faces), vertices.wdata(teddy->pre_render_vertices), 0, teddy);
+    Tools::Array<GSphere> spheres({ GSphere({ { -2.0f, 0.0f, -5.0f }, 1.0f, { 0.0f, 0.0f, 1.0f } }) });
+    Tools::Array<BVHEntity> entities(2);
+    BVHEntity teddy_entity{}, sphere_entity{};
+    teddy_entity.n_faces = (uint32_t) faces.size();
+    teddy_entity.n_vertices = (uint32_t) vertices.size();
+    sphere_entity.first_face = (uint32_t) faces.size();
+    sphere_entity.first_vertex = (uint32_t) vertices.size();
+    sphere_entity.n_spheres = 1;
+    entities.push_back(teddy_entity);
+    entities.push_back(sphere_entity);
+    Tools::Arena scratch;
+    BVH bvh;
+    bvh.build(faces, vertices, spheres, entities, scratch);
+    WoopFaces woop_faces;
+    woop_faces.build(faces, vertices);
+
+    // Shoot the rays from the camera's origin at random points in the part of the scene with geometry
+    const uint32_t n_rays = 1 << 18;
+    uint32_t state = seed;
+    std::vector<glm::vec3> directions(n_rays);
+    for (uint32_t i = 0; i < n_rays; i++) {
+        directions[i] = glm::normalize(glm::vec3(-3.5f + 5.0f * random_float(state), -1.5f + 3.0f * random_float(state), -3.0f));
+    }
+    glm::vec3 origin(0.0f);
+
+    // Ray/triangle: a subset of the rays against all faces of the teddy
+    const uint32_t n_triangle_rays = 1 << 10;
+    float checksum = 0.0f;
+    double time = time_best(repetitions, [&]() {
+        for (uint32_t r = 0; r < n_triangle_rays; r++) {
+            for (uint32_t i = 0; i < woop_faces.size(); i++) {
+                checksum += woop_faces.hit(i, origin, directions[r], 1e30f);
+            }
+        }
+    });
+    add_result(results, "kernel/ray_triangle", time, (double) n_triangle_rays * woop_faces.size() / 1e6, "Mtests/s");
+
+    // Ray/sphere: all rays against a row of spheres
+    std::vector<GSphere> test_spheres(64);
+    for (uint32_t i = 0; i < test_spheres.size(); i++) {
+        test_spheres[i] = GSphere({ { -4.0f + 8.0f * random_float(state), -2.0f + 4.0f * random_float(state), -6.0f + 3.0f * random_float(state) }, 0.25f + 0.5f * random_float(state), { 0.0f, 0.0f, 1.0f } });
+    }
+    time = time_best(repetitions, [&]() {
+        for (uint32_t r = 0; r < n_rays; r++) {
+            for (uint32_t i = 0; i < test_spheres.size(); i++) {
+                checksum += hit_sphere(test_spheres[i], origin, directions[r], 1e30f);
+            }
+        }
+    });
+    add_result(results, "kernel/ray_sphere", time, (double) n_rays * test_spheres.size() / 1e6, "Mtests/s");
+
+    // Traversal: all rays through the BVH, finding their closest hit
+    uint32_t n_faces = (uint32_t) woop_faces.size();
+    uint32_t n_hits = 0;
+    time = time_best(repetitions, [&]() {
+        for (uint32_t r = 0; r < n_rays; r++) {
+            const glm::vec3& direction = directions[r];
+            float min_t = 1e30f;
+            uint32_t hit = bvh.traverse(origin, direction, min_t, [&woop_faces, &spheres, n_faces, &origin, &direction, &min_t](uint32_t i) {
+                return i < n_faces ? woop_faces.hit(i, origin, direction, min_t) : hit_sphere(spheres[i - n_faces], origin, direction, min_t);
+            });
+            if (hit != std::numeric_limits<uint32_t>::max()) { ++n_hits; }
+        }
+    });
+    add_result(results, "kernel/traversal", time, (double) n_rays / 1e6, "Mrays/s", bvh.size());
+
+    // Make sure the compiler can't throw the work away
+    volatile float sink = checksum + (float) n_hits;
+    (void) sink;
+
+    DRETURN;
+}
+#endif
+
+/* @brief Times parsing the asset's OBJ file and pre-rendering every type of entity on the CPU.
+ * @param results The list of results to add to.
+ * @param repetitions The number of times to repeat every benchmark.
+ */
+static void bench_prerender(std::vector<BenchResult>& results, uint32_t repetitions) {
+    DENTER("bench_prerender");
+
+    // Parsing the object file (without any mesh cache)
+    Tools::Array<GFace> faces;
+    Tools::Array<glm::vec4> vertices;
+    size_t file_size = std::filesystem::file_size(asset_path);
+    double time = time_best(repetitions, [&]() {
+        ECS::load_object_file(asset_path, faces, vertices);
+    });
+    add_result(results, "parse/obj", time, (double) file_size / 1e6, "MB/s", file_size);
+
+    // Pre-rendering a lot of triangles, one at a time
+    Tools::Arena arena;
+    const uint32_t n_triangles = 1 << 16;
+    uint32_t state = seed;
+    std::vector<ECS::Triangle*> triangles(n_triangles);
+    for (uint32_t i = 0; i < n_triangles; i++) {
+        glm::vec3 p(-10.0f + 20.0f * random_float(state), -10.0f + 20.0f * random_float(state), -20.0f + 10.0f * random_float(state));
+        triangles[i] = ECS::create_triangle(p, p + glm::vec3(0.5f, 0.0f, 0.0f), p + glm::vec3(0.0f, 0.5f, 0.0f), { 0.0f, 1.0f, 0.0f }, &arena);
+    }
+    faces.resize(n_triangles);
+    vertices.resize(3 * n_triangles);
+    time = time_best(repetitions, [&]() {
+        for (uint32_t i = 0; i < n_triangles; i++) {
+            ECS::cpu_pre_render_triangle(faces.wdata() + i, vertices.wdata() + 3 * i, 3 * i, triangles[i]);
+        }
+    });
+    add_result(results, "prerender/triangle", time, (double) n_triangles / 1e6, "Mfaces/s", n_triangles * (sizeof(GFace) + 3 * sizeof(glm::vec4)));
+
+    // Pre-rendering a finely tessellated sphere
+    ECS::Sphere* sphere = ECS::create_sphere({ 0.0f, 0.0f, -5.0f }, 1.0f, 256, 256, { 0.0f, 0.0f, 1.0f }, &arena);
+    faces.resize(sphere->pre_render_faces);
+    vertices.resize(sphere->pre_render_vertices);
+    time = time_best(repetitions, [&]() {
+        ECS::cpu_pre_render_sphere(faces.wdata(), vertices.wdata(), 0, sphere);
+    });
+    add_result(results, "prerender/sphere", time, (double) sphere->pre_render_faces / 1e6, "Mfaces/s", sphere->pre_render_faces * sizeof(GFace) + sphere->pre_render_vertices * sizeof(glm::vec4));
+
+    // Pre-rendering the loaded object
+    ECS::Object* teddy = ECS::create_object(asset_path, { 0.0f, 0.0f, -3.0f }, 1.0f / 17.0f, { 1.0f, 0.0f, 0.0f }, &arena);
+    faces.resize(teddy->pre_render_faces);
+    vertices.resize(teddy->pre_render_vertices);
+    time = time_best(repetitions, [&]() {
+        ECS::cpu_pre_render_object(faces.wdata(), vertices.wdata(), 0, teddy);
+    });
+    add_result(results, "prerender/object", time, (double) teddy->pre_render_faces / 1e6, "Mfaces/s", teddy->pre_render_faces * sizeof(GFace) + teddy->pre_render_vertices * sizeof(glm::vec4));
+
+    DRETURN;
+}
+
+/* @brief Times pre-rendering and rendering the default scene with the renderer, and then encoding the result.
+ * @param results The list of results to add to.
+ * @param repetitions The number of times to repeat every benchmark.
+ */
+static void bench_render(std::vector<BenchResult>& results, uint32_t repetitions) {
+    DENTER("bench_render");
+
+    // Prepare the renderer & the scene
+    Renderer* renderer = initialize_renderer();
+    Camera cam;
+    cam.update(frame_width, frame_height, 2.0, ((float) frame_width / (float) frame_height) * 2.0f, 2.0f);
+    Tools::Arena arena;
+    Tools::Array<ECS::RenderEntity*> entities({
+        ECS::create_object(asset_path, { 0.0f, 0.0f, -3.0f }, 1.0f / 17.0f, { 1.0f, 0.0f, 0.0f }, &arena),
+        ECS::create_sphere({ -2.0f, 0.0f, -5.0f }, 1.0f, 8, 8, { 0.0f, 0.0f, 1.0f }, &arena)
+    });
+    uint32_t n_faces = entities[0]->pre_render_faces;
+    double n_pixels = (double) frame_width * (double) frame_height;
+
+    // Pre-render & render it
+    double time = time_best(repetitions, [&]() {
+        renderer->prerender(entities);
+    });
+    add_result(results, "render/prerender", time, (double) n_faces / 1e6, "Mfaces/s");
+    time = time_best(repetitions, [&]() {
+        renderer->render(cam);
+    });
+    add_result(results, "render/frame", time, n_pixels / 1e6, "Mrays/s");
+
+    // Encode the rendered frame, which has more realistic content than any pattern
+    const Frame& frame = cam.get_frame();
+    std::string png_path = (std::filesystem::temp_directory_path() / "rt_bench.png").string();
+    std::string ppm_path = (std::filesystem::temp_directory_path() / "rt_bench.ppm").string();
+    PngEncoder encoder;
+    time = time_best(repetitions, [&]() {
+        encoder.encode(frame, png_path);
+    });
+    add_result(results, "encode/png", time, n_pixels / 1e6, "Mpixels/s", std::filesystem::file_size(png_path));
+    time = time_best(repetitions, [&]() {
+        frame.to_ppm(ppm_path);
+    });
+    add_result(results, "encode/ppm", time, n_pixels / 1e6, "Mpixels/s", std::filesystem::file_size(ppm_path));
+    std::remove(png_path.c_str());
+    std::remove(ppm_path.c_str());
+
+    delete renderer;
+    DRETURN;
+}
+
+/* @brief Times pre-rendering and rendering generated scenes, to see how the renderer scales with their size and layout.
+ * @param results The list of results to add to.
+ * @param repetitions The number of times to repeat every benchmark.
+ * @param specs The scenes to generate.
+ */
+static void bench_scaling(std::vector<BenchResult>& results, uint32_t repetitions, const std::vector<ECS::SceneSpec>& specs) {
+    DENTER("bench_scaling");
+
+    Renderer* renderer = initialize_renderer();
+    Camera cam;
+    cam.update(scaling_width, scaling_height, 2.0, ((float) scaling_width / (float) scaling_height) * 2.0f, 2.0f);
+    double n_pixels = (double) scaling_width * (double) scaling_height;
+    for (size_t i = 0; i < specs.size(); i++) {
+        Tools::Arena arena;
+        Tools::Array<ECS::RenderEntity*> entities = ECS::generate_scene(specs[i], &arena);
+        uint64_t n_faces = ECS::count_faces(entities);
+        std::string name = "scene/" + ECS::scene_distribution_names[specs[i].distribution] + "/" + std::to_string(entities.size());
+
+        double time = time_best(repetitions, [&]() {
+            renderer->prerender(entities);
+        });
+        add_result(results, name + "/prerender", time, (double) n_faces / 1e6, "Mfaces/s");
+        time = time_best(repetitions, [&]() {
+            renderer->render(cam);
+        });
+        add_result(results, name + "/frame", time, n_pixels / 1e6, "Mrays/s");
+    }
+
+    delete renderer;
+    DRETURN;
+}
+
+#ifdef ENABLE_VULKAN
+/* @brief Times allocating buffers of various sizes in a MemoryPool and freeing them again in a different order.
+ * @param results The list of results to add to.
+ * @param repetitions The number of times to repeat every benchmark.
+ */
+static void bench_memory_pool(std::vector<BenchResult>& results, uint32_t repetitions) {
+    DENTER("bench_memory_pool");
+
+    // Prepare a pool on the GPU
+    Compute::Instance instance;
+    Compute::GPU gpu(instance);
+    const VkDeviceSize pool_size = 64 * 1024 * 1024;
+    uint32_t memory_type = Compute::MemoryPool::select_memory_type(gpu, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    Compute::MemoryPool pool(gpu, memory_type, pool_size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    // Decide on the sizes and the order in which they're freed up front
+    const uint32_t n_buffers = 512;
+    uint32_t state = seed;
+    std::vector<VkDeviceSize> sizes(n_buffers);
+    std::vector<uint32_t> order(n_buffers);
+    size_t total_size = 0;
+    for (uint32_t i = 0; i < n_buffers; i++) {
+        sizes[i] = 256 + (VkDeviceSize) (random_float(state) * 65280.0f);
+        order[i] = i;
+        total_size += sizes[i];
+    }
+    for (uint32_t i = n_buffers - 1; i > 0; i--) {
+        std::swap(order[i], order[(uint32_t) (random_float(state) * (float) (i + 1))]);
+    }
+
+    // Allocate them all, then free them all
+    std::vector<Compute::BufferHandle> handles(n_buffers);
+    double time = time_best(repetitions, [&]() {
+        for (uint32_t i = 0; i < n_buffers; i++) {
+            handles[i] = pool.allocate_buffer_h(sizes[i], VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        }
+        for (uint32_t i = 0; i < n_buffers; i++) {
+            pool.deallocate(handles[order[i]]);
+        }
+    });
+    add_result(results, "memory_pool/allocate_free", time, 2.0 * n_buffers / 1e6, "Mops/s", total_size);
+
+    // Keep half of them alive while the other half is freed and allocated again, so the pool has to work with fragmented memory
+    for (uint32_t i = 0; i < n_buffers; i++) {
+        handles[i] = pool.allocate_buffer_h(sizes[i], VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    }
+    time = time_best(repetitions, [&]() {
+        for (uint32_t i = 0; i < n_buffers; i += 2) {
+            pool.deallocate(handles[order[i]]);
+        }
+        for (uint32_t i = 0; i < n_buffers; i += 2) {
+            handles[order[i]] = pool.allocate_buffer_h(sizes[order[i]], VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        }
+    });
+    add_result(results, "memory_pool/churn", time, (double) n_buffers / 1e6, "Mops/s", pool.high_water_mark());
+    DLOG(info, "Memory pool after churn: " + std::to_string(pool.allocations()) + " buffers, " + std::to_string((int) (pool.fragmentation() * 100.0)) + "% of free memory fragmented");
+    for (uint32_t i = 0; i < n_buffers; i++) {
+        pool.deallocate(handles[i]);
+    }
+
+    DRETURN;
+}
+
+/* @brief Times creating the raytracer pipeline with an empty pipeline cache (i.e., compiling the shader from scratch) and with a warm one.
+ * @param results The list of results to add to.
+ * @param repetitions The number of times to repeat every benchmark.
+ */
+static void bench_pipeline(std::vector<BenchResult>& results, uint32_t repetitions) {
+    DENTER("bench_pipeline");
+
+    // Prepare the layout & constants the VulkanRenderer uses
+    Compute::Instance instance;
+    Compute::GPU gpu(instance);
+    Compute::DescriptorSetLayout layout(gpu);
+    layout.add_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    layout.add_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    layout.add_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    layout.add_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    layout.finalize();
+    uint32_t width = frame_width, height = frame_height;
+    std::unordered_map<uint32_t, std::tuple<uint32_t, void*>> constants({ { 0, std::make_tuple((uint32_t) sizeof(uint32_t), (void*) &width) }, { 1, std::make_tuple((uint32_t) sizeof(uint32_t), (void*) &height) } });
+    Compute::Shader shader(gpu, Tools::get_executable_path() + "/shaders/raytracer_v3.spv");
+
+    // Compile from scratch every time...
+    double time = time_best(repetitions, [&]() {
+        gpu.reset_pipeline_cache();
+        Compute::Pipeline pipeline(gpu, shader, Tools::Array<Compute::DescriptorSetLayout>({ layout }), constants);
+    });
+    add_result(results, "pipeline/create_cold", time, 1.0 / 1e6, "Mpipelines/s");
+
+    // ...or from the cache, which the cold runs left filled
+    time = time_best(repetitions, [&]() {
+        Compute::Pipeline pipeline(gpu, shader, Tools::Array<Compute::DescriptorSetLayout>({ layout }), constants);
+    });
+    add_result(results, "pipeline/create_cached", time, 1.0 / 1e6, "Mpipelines/s");
+
+    DRETURN;
+}
+#endif
+
+
+
+
+
+/***** ENTRY POINT *****/
+int main(int argc, const char** argv) {
+    DSTART("main"); DENTER("main");
+
+    // Read the optional output path, number of repetitions and scene
+    std::string output_path = "rt_bench.json";
+    uint32_t repetitions = 5;
+    std::vector<ECS::SceneSpec> scenes;
+    try {
+        if (argc > 1) { output_path = argv[1]; }
+        if (argc > 2) { repetitions = (uint32_t) std::stoul(argv[2]); }
+    } catch (std::exception&) {
+        cerr << "Usage: " << argv[0] << " [<output.json> [<repetitions> [<scene>]]]" << endl;
+        DRETURN -1;
+    }
+    if (argc > 3) {
+        // Only time the given scene
+        ECS::SceneSpec spec;
+        std::string error = ECS::SceneSpec::parse(argv[3], spec);
+        if (!error.empty()) {
+            cerr << "Invalid scene '" << argv[3] << "': " << error << endl;
+            DRETURN -1;
+        }
+        scenes.push_back(spec);
+    } else {
+        // Time mostly triangles, with some spheres & objects, in every distribution
+        for (uint32_t d = ECS::SceneDistribution::sd_uniform; d <= ECS::SceneDistribution::sd_nested; d++) {
+            for (uint32_t n_triangles : scaling_sizes) {
+                ECS::SceneSpec spec;
+                spec.n_triangles = n_triangles;
+                spec.n_spheres = n_triangles / 100;
+                spec.n_objects = n_triangles / 50000;
+                spec.distribution = (ECS::SceneDistribution) d;
+                spec.seed = seed;
+                scenes.push_back(spec);
+            }
+        }
+    }
+    if (repetitions == 0) {
+        cerr << "There should be at least one repetition." << endl;
+        DRETURN -1;
+    }
+
+    // Run all benchmarks
+    std::vector<BenchResult> results;
+    try {
+        #ifndef ENABLE_VULKAN
+        bench_kernels(results, repetitions);
+        #endif
+        bench_prerender(results, repetitions);
+        bench_render(results, repetitions);
+        bench_scaling(results, repetitions, scenes);
+        #ifdef ENABLE_VULKAN
+        bench_memory_pool(results, repetitions);
+        bench_pipeline(results, repetitions);
+        #endif
+    } catch (CppDebugger::Fatal&) {
+        DRETURN -1;
+    } catch (std::filesystem::filesystem_error& e) {
+        cerr << "Could not access benchmark files: " << e.what() << endl;
+        DRETURN -1;
+    }
+
+    // Write the results
+    std::ofstream h(output_path);
+    if (!h.is_open()) {
+        cerr << "Could not open '" << output_path << "' for writing." << endl;
+        DRETURN -1;
+    }
+    write_json(h, results, repetitions);
+    h.close();
+    cout << "Wrote " << results.size() << " results to '" << output_path << "'" << endl;
+
+    DRETURN 0;
+}
@@ -4,7 +4,7 @@
  * Created:
  *   28/04/2021, 20:08:23
  * Last edited:
- *   25/05/2021, 18:14:13
+ *   16/10/2026, 00:33:48
  * Auto updated?
  *   Yes
  *
@@ -24,8 +24,11 @@ using namespace CppDebugger::SeverityValues;
 
 
 /***** CAMERA CLASS *****/
-/* Constructor for the Camera class, */
-Camera::Camera() :
+/* Constructor for the Camera class, which takes the order in which its frames store their pixels. */
+Camera::Camera(FrameLayout frame_layout) :
+    width(0),
+    height(0),
+    frame_layout(frame_layout),
     frame(nullptr)
 {}
 
@@ -35,6 +38,10 @@ Camera::Camera(const Camera& other) :
     horizontal(other.horizontal),
     vertical(other.vertical),
     lower_left_corner(other.lower_left_corner),
+    pose(other.pose),
+    width(other.width),
+    height(other.height),
+    frame_layout(other.frame_layout),
     frame(other.frame)
 {
     DENTER("Camera::Camera(copy)");
@@ -54,7 +61,12 @@ Camera::Camera(Camera&& other)  :
     horizontal(other.horizontal),
     vertical(other.vertical),
     lower_left_corner(other.lower_left_corner),
-    frame(other.frame)
+    pose(other.pose),
+    width(other.width),
+    height(other.height),
+    frame_layout(other.frame_layout),
+    frame(other.frame),
+    frame_arena(std::move(other.frame_arena))
 {
     // Set the other pointers w/e to null to avoid deallocation
     other.frame = nullptr;
@@ -73,23 +85,31 @@ Camera::~Camera() {
 
 
 
-/* Computes new camera matrices for the given position and orientation. */
+/* Computes new camera matrices for the current pose and the given viewport, and starts a new frame. The internal frame is kept if its size doesn't change (and otherwise only re-allocated once it's needed), and everything in the frame arena is freed. */
 void Camera::update(uint32_t width, uint32_t height, float focal_length, float viewport_width, float viewport_height /* TBD */) {
     DENTER("Camera::update");
 
-    // If there already exists a frame, destroy it
-    if (this->frame != nullptr) {
+    // Throw out the temporaries of the previous frame
+    this->frame_arena.reset();
+
+    // Re-use the frame if we can; otherwise, throw it away so get_frame() allocates one of the proper size
+    if (this->frame != nullptr && (this->frame->w() != width || this->frame->h() != height)) {
         delete this->frame;
+        this->frame = nullptr;
     }
+    this->width = width;
+    this->height = height;
+
+    // Compute the camera's orthonormal basis: w points backwards, u to the right and v up
+    glm::vec3 w = glm::normalize(this->pose.position - this->pose.target);
+    glm::vec3 u = glm::normalize(glm::cross(this->pose.up, w));
+    glm::vec3 v = glm::cross(w, u);
 
-    // First, initialize the frame struct
-    this->frame = new Frame(width, height);
-    
     // Next, compute all new vectors
-    this->origin = glm::vec3(0.0, 0.0, 0.0);
-    this->horizontal = glm::vec3(viewport_width, 0.0, 0.0);
-    this->vertical = glm::vec3(0.0, viewport_height, 0.0);
-    this->lower_left_corner = this->origin - this->horizontal / glm::vec3(2.0) - this->vertical / glm::vec3(2.0) - glm::vec3(0.0, 0.0, focal_length);
+    this->origin = this->pose.position;
+    this->horizontal = viewport_width * u;
+    this->vertical = viewport_height * v;
+    this->lower_left_corner = this->origin - this->horizontal / glm::vec3(2.0) - this->vertical / glm::vec3(2.0) - focal_length * w;
 
     // Done
     DRETURN;
@@ -97,6 +117,16 @@ void Camera::update(uint32_t width, uint32_t height, float focal_length, float v
 
 
 
+/* Returns the internal frame, which holds the result of a render. Allocates it first if this is the first time it's needed since its size changed. */
+Frame& Camera::get_frame() {
+    if (this->frame == nullptr) {
+        this->frame = new Frame(this->width, this->height, this->frame_layout);
+    }
+    return *this->frame;
+}
+
+
+
 /* Swap operator for the Camera class. */
 void RayTracer::swap(Camera& c1, Camera& c2) {
     using std::swap;
@@ -106,5 +136,10 @@ void RayTracer::swap(Camera& c1, Camera& c2) {
     swap(c1.horizontal, c2.horizontal);
     swap(c1.vertical, c2.vertical);
     swap(c1.lower_left_corner, c2.lower_left_corner);
+    swap(c1.pose, c2.pose);
+    swap(c1.width, c2.width);
+    swap(c1.height, c2.height);
+    swap(c1.frame_layout, c2.frame_layout);
     swap(c1.frame, c2.frame);
+    swap(c1.frame_arena, c2.frame_arena);
 }
@@ -4,7 +4,7 @@
  * Created:
  *   28/04/2021, 20:08:29
  * Last edited:
- *   02/05/2021, 18:09:11
+ *   16/10/2026, 00:33:48
  * Auto updated?
  *   Yes
  *
@@ -17,10 +17,28 @@
 #define CAMERA_CAMERA_HPP
 
 #include "glm/glm.hpp"
+#include "tools/Arena.hpp"
 
 #include "Frame.hpp"
 
 namespace RayTracer {
+    /* The CameraPose struct, which describes where the camera is and where it looks at. */
+    struct CameraPose {
+        /* The position of the camera. */
+        glm::vec3 position;
+        /* The point that the camera looks at. */
+        glm::vec3 target;
+        /* The direction that is up for the camera. Doesn't have to be perpendicular to the viewing direction, but may not be parallel to it either. */
+        glm::vec3 up;
+
+        /* Default constructor for the CameraPose struct, which places the camera in the origin, looking down the negative z-axis. */
+        CameraPose(): position(0.0f, 0.0f, 0.0f), target(0.0f, 0.0f, -1.0f), up(0.0f, 1.0f, 0.0f) {}
+        /* Constructor for the CameraPose struct, which takes the position of the camera, the point it looks at and the direction that is up. */
+        CameraPose(const glm::vec3& position, const glm::vec3& target, const glm::vec3& up = glm::vec3(0.0f, 1.0f, 0.0f)): position(position), target(target), up(up) {}
+    };
+
+
+
     /* The Camera class, which computes the required camera matrices for each frame. */
     class Camera {
     public:
@@ -34,12 +52,22 @@ namespace RayTracer {
         glm::vec3 lower_left_corner;
 
     private:
-        /* The internal Frame that the result is rendered to. */
+        /* The position and orientation of the camera, which are used by the next update(). */
+        CameraPose pose;
+        /* The width (in pixels) of the frames rendered by the camera. */
+        uint32_t width;
+        /* The height (in pixels) of the frames rendered by the camera. */
+        uint32_t height;
+        /* The order in which the camera's frames store their pixels. */
+        FrameLayout frame_layout;
+        /* The internal Frame that the result is rendered to, which is only allocated once it's needed (so rendering to a FrameSink never allocates it). Is re-used as long as the size doesn't change. */
         Frame* frame;
+        /* The arena for temporary data that lives for one frame, which is reset on every update(). */
+        Tools::Arena frame_arena;
 
     public:
-        /* Constructor for the Camera class, */
-        Camera();
+        /* Constructor for the Camera class, which takes the order in which its frames store their pixels. */
+        Camera(FrameLayout frame_layout = FrameLayout::row_major);
         /* Copy constructor for the Camera class. */
         Camera(const Camera& other);
         /* Move constructor for the Camera class. */
@@ -47,15 +75,23 @@ namespace RayTracer {
         /* Destructor for the Camera class. */
         ~Camera();
 
-        /* Computes new camera matrices for the given position and orientation. */
+        /* Moves the camera to the given pose. Only takes effect on the next update(). */
+        inline void set_pose(const CameraPose& pose) { this->pose = pose; }
+        /* Computes new camera matrices for the current pose and the given viewport, and starts a new frame. The internal frame is kept if its size doesn't change (and otherwise only re-allocated once it's needed), and everything in the frame arena is freed. */
         void update(uint32_t width, uint32_t height, float focal_length, float viewport_width, float viewport_height);
 
-        /* Returns the width (in pixels) of the current camera frame. Will probably segfault if not set. */
-        inline uint32_t w() const { return this->frame->w(); }
-        /* Returns the height (in pixels) of the current camera frame. Will probably segfault if not set. */
-        inline uint32_t h() const { return this->frame->h(); }
-        /* Returns the result of a render as a constant reference to the internal frame. Should of course only be used once the rendering is done. */
-        inline const Frame& get_frame() const { return *this->frame; }
+        /* Returns the width (in pixels) of the current camera frame. Is 0 until the first update(). */
+        inline uint32_t w() const { return this->width; }
+        /* Returns the height (in pixels) of the current camera frame. Is 0 until the first update(). */
+        inline uint32_t h() const { return this->height; }
+        /* Returns the position and orientation of the camera. */
+        inline const CameraPose& get_pose() const { return this->pose; }
+        /* Returns the order in which the camera's frames store their pixels. */
+        inline FrameLayout layout() const { return this->frame_layout; }
+        /* Returns the internal frame, which holds the result of a render. Allocates it first if this is the first time it's needed since its size changed. */
+        Frame& get_frame();
+        /* Returns the arena for temporary data that only has to live until the next update(). */
+        inline Tools::Arena& get_frame_arena() { return this->frame_arena; }
 
         /* Copy assignment operator for the Camera class. */
         inline Camera& operator=(const Camera& other) { return *this = Camera(other); }
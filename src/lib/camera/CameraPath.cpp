@@ -0,0 +1,113 @@
+/* CAMERA PATH.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 13:40:16
+ * Last edited:
+ *   16/10/2026, 13:40:16
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the CameraPath class, which describes how the camera moves
+ *   during an animation as a list of keyframes. The position of the camera
+ *   is interpolated smoothly (Catmull-Rom) between them, while the point
+ *   it looks at is interpolated linearly.
+**/
+
+#include <cmath>
+#include <CppDebugger.hpp>
+
+#include "CameraPath.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** HELPER FUNCTIONS *****/
+/* @brief Interpolates between p1 and p2 along a uniform Catmull-Rom spline, which passes through all its control points.
+ * @param p0 The control point before p1.
+ * @param p1 The control point at the start of the segment.
+ * @param p2 The control point at the end of the segment.
+ * @param p3 The control point after p2.
+ * @param s How far along the segment to interpolate, from 0 (p1) to 1 (p2).
+ * @return The interpolated point.
+ */
+static inline glm::vec3 catmull_rom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float s) {
+    float s2 = s * s, s3 = s2 * s;
+    return 0.5f * (2.0f * p1 + (p2 - p0) * s + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * s2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * s3);
+}
+
+
+
+
+
+/***** CAMERAPATH CLASS *****/
+/* Default constructor for the CameraPath class, which initializes an empty path. */
+CameraPath::CameraPath() {}
+
+
+
+/* Adds a keyframe at the given time with the given pose. Keyframes have to be added in chronological order. */
+void CameraPath::add(float time, const CameraPose& pose) {
+    DENTER("CameraPath::add");
+
+    if (this->keyframes.size() > 0 && time <= this->keyframes[this->keyframes.size() - 1].time) {
+        DLOG(fatal, "Keyframe at time " + std::to_string(time) + " is not after the last keyframe at time " + std::to_string(this->keyframes[this->keyframes.size() - 1].time));
+    }
+    this->keyframes.push_back(CameraKeyframe({ time, pose }));
+
+    DRETURN;
+}
+
+/* Returns the pose of the camera at the given time. Before the first or after the last keyframe, the camera stays at that keyframe. */
+CameraPose CameraPath::at(float time) const {
+    DENTER("CameraPath::at");
+
+    size_t n_keyframes = this->keyframes.size();
+    if (n_keyframes == 0) {
+        DLOG(fatal, "Cannot compute the pose of an empty camera path");
+    }
+
+    // Clamp to the ends of the path
+    if (time <= this->keyframes[0].time) { DRETURN this->keyframes[0].pose; }
+    if (time >= this->keyframes[n_keyframes - 1].time) { DRETURN this->keyframes[n_keyframes - 1].pose; }
+
+    // Find the segment we're in
+    size_t k = 0;
+    while (time >= this->keyframes[k + 1].time) { ++k; }
+    const CameraPose& p1 = this->keyframes[k].pose;
+    const CameraPose& p2 = this->keyframes[k + 1].pose;
+    const CameraPose& p0 = this->keyframes[k > 0 ? k - 1 : k].pose;
+    const CameraPose& p3 = this->keyframes[k + 2 < n_keyframes ? k + 2 : k + 1].pose;
+    float s = (time - this->keyframes[k].time) / (this->keyframes[k + 1].time - this->keyframes[k].time);
+
+    // Interpolate the position smoothly, and the rest linearly
+    DRETURN CameraPose(
+        catmull_rom(p0.position, p1.position, p2.position, p3.position, s),
+        glm::mix(p1.target, p2.target, s),
+        glm::mix(p1.up, p2.up, s)
+    );
+}
+
+
+
+/* Creates a path that circles the camera once around the given center at the given radius and height in the given time, looking at the center all the way. The camera starts on the positive z-side of the center. */
+CameraPath CameraPath::turntable(const glm::vec3& center, float radius, float height, float duration, uint32_t n_keyframes) {
+    DENTER("CameraPath::turntable");
+
+    if (n_keyframes < 2) {
+        DLOG(fatal, "A turntable needs at least two keyframes");
+    }
+
+    // Place the keyframes on the circle; the last one coincides with the first, so the path is closed
+    CameraPath result;
+    for (uint32_t i = 0; i < n_keyframes; i++) {
+        float angle = 2.0f * (float) M_PI * (float) i / (float) (n_keyframes - 1);
+        glm::vec3 position = center + glm::vec3(radius * sinf(angle), height, radius * cosf(angle));
+        result.add(duration * (float) i / (float) (n_keyframes - 1), CameraPose(position, center));
+    }
+
+    DRETURN result;
+}
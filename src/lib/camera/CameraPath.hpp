@@ -0,0 +1,63 @@
+/* CAMERA PATH.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 13:40:12
+ * Last edited:
+ *   16/10/2026, 13:40:12
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the CameraPath class, which describes how the camera moves
+ *   during an animation as a list of keyframes. The position of the camera
+ *   is interpolated smoothly (Catmull-Rom) between them, while the point
+ *   it looks at is interpolated linearly.
+**/
+
+#ifndef CAMERA_CAMERA_PATH_HPP
+#define CAMERA_CAMERA_PATH_HPP
+
+#include "glm/glm.hpp"
+#include "tools/Array.hpp"
+
+#include "Camera.hpp"
+
+namespace RayTracer {
+    /* The CameraKeyframe struct, which describes the pose of the camera at a single moment in time. */
+    struct CameraKeyframe {
+        /* The moment in time of this keyframe. */
+        float time;
+        /* The pose of the camera at this moment. */
+        CameraPose pose;
+    };
+
+
+
+    /* The CameraPath class, which interpolates the pose of the camera between a list of keyframes. */
+    class CameraPath {
+    private:
+        /* The keyframes of the path, sorted on their time. */
+        Tools::Array<CameraKeyframe> keyframes;
+
+    public:
+        /* Default constructor for the CameraPath class, which initializes an empty path. */
+        CameraPath();
+
+        /* Adds a keyframe at the given time with the given pose. Keyframes have to be added in chronological order. */
+        void add(float time, const CameraPose& pose);
+        /* Returns the pose of the camera at the given time. Before the first or after the last keyframe, the camera stays at that keyframe. */
+        CameraPose at(float time) const;
+
+        /* Returns the keyframes of the path. */
+        inline const Tools::Array<CameraKeyframe>& get_keyframes() const { return this->keyframes; }
+        /* Returns whether or not the path has any keyframes. */
+        inline bool empty() const { return this->keyframes.size() == 0; }
+
+        /* Creates a path that circles the camera once around the given center at the given radius and height in the given time, looking at the center all the way. The camera starts on the positive z-side of the center. */
+        static CameraPath turntable(const glm::vec3& center, float radius, float height, float duration, uint32_t n_keyframes = 36);
+
+    };
+}
+
+#endif
@@ -4,25 +4,29 @@
  * Created:
  *   28/04/2021, 14:28:32
  * Last edited:
- *   25/05/2021, 18:14:13
+ *   16/10/2026, 01:02:51
  * Auto updated?
  *   Yes
  *
  * Description:
  *   Contains the Frame class, which is a wrapper around CPU & Vulkan
  *   buffers to provide a conceptually easy frame to fill with colour
- *   pixels on the GPU. Also contains code to easily write to PNG, using
- *   the LodePNG library.
+ *   pixels on the GPU. The pixels are stored either row by row or in
+ *   square tiles, which are only converted to rows when the frame is
+ *   written. Also contains code to easily write to PNG (using the
+ *   PngEncoder) and PPM.
 **/
 
 #include <fstream>
 #include <cstring>
 #include <cerrno>
 #include <limits>
+#include <vector>
 #include <CppDebugger.hpp>
 
-#include "LodePNG.hpp"
+#include "tools/Profiler.hpp"
 
+#include "PngEncoder.hpp"
 #include "Frame.hpp"
 
 using namespace std;
@@ -31,24 +35,37 @@ using namespace CppDebugger::SeverityValues;
 
 
 /***** FRAME CLASS *****/
-/* Constructor for the Frame class, which takes the dimension of the frame. */
-Frame::Frame(uint32_t width, uint32_t height) :
-    data(new uint32_t[width * height]),
+/* Constructor for the Frame class, which takes the dimension of the frame and the order in which it stores its pixels. */
+Frame::Frame(uint32_t width, uint32_t height, FrameLayout layout) :
     width(width),
-    height(height)
-{}
+    height(height),
+    pixel_layout(layout),
+    tiles_x((width + Frame::tile_size - 1) / Frame::tile_size)
+{
+    // Tiled frames are padded to whole tiles, so every tile is the same size
+    if (layout == FrameLayout::tiled) {
+        size_t tiles_y = (height + Frame::tile_size - 1) / Frame::tile_size;
+        this->n_pixels = (size_t) this->tiles_x * tiles_y * Frame::tile_size * Frame::tile_size;
+    } else {
+        this->n_pixels = (size_t) width * (size_t) height;
+    }
+    this->data = new uint32_t[this->n_pixels];
+}
 
 /* Copy constructor for the Frame class. */
 Frame::Frame(const Frame& other) :
     width(other.width),
-    height(other.height)
+    height(other.height),
+    pixel_layout(other.pixel_layout),
+    tiles_x(other.tiles_x),
+    n_pixels(other.n_pixels)
 {
     DENTER("Frame::Frame(copy)");
 
     // Allocate a new CPU-side buffer
-    this->data = new uint32_t[this->width * this->height];
+    this->data = new uint32_t[this->n_pixels];
     // Copy the entire memory in one go
-    memcpy(this->data, other.data, this->width * this->height * sizeof(uint32_t));
+    memcpy(this->data, other.data, this->n_pixels * sizeof(uint32_t));
 
     // Done
     DLEAVE;
@@ -58,7 +75,10 @@ Frame::Frame(const Frame& other) :
 Frame::Frame(Frame&& other) :
     data(other.data),
     width(other.width),
-    height(other.height)
+    height(other.height),
+    pixel_layout(other.pixel_layout),
+    tiles_x(other.tiles_x),
+    n_pixels(other.n_pixels)
 {
     // Set fields to nullptrs etc to avoid deallocation
     other.data = nullptr;
@@ -78,36 +98,34 @@ Frame::~Frame() {
 
 
 
-/* Writes the internal frame to disk as a PNG. Assumes that the CPU buffer is synchronized with the GPU one. */
-void Frame::to_png(const std::string& path) const {
-    DENTER("Frame::to_png");
+/* Returns a pointer to the given row of pixels in row-major order. If the frame isn't row-major, the row is gathered in the given buffer of (at least) width pixels first, and a pointer to that is returned. */
+const uint32_t* Frame::row(uint32_t y, uint32_t* buffer) const {
+    if (this->pixel_layout == FrameLayout::row_major) { return this->data + (size_t) y * this->width; }
 
-    // Use the internal CPU buffer to construct a 0-255, four channel vector
-    vector<unsigned char> raw_image;
-    raw_image.resize(4 * this->width * this->height);
-    for (uint32_t i = 0; i < this->width * this->height; i++) {
-        uint32_t pixel = this->data[i];
-
-        // Unpack the individual pixel values
-        raw_image[4 * i    ] = (pixel >> 24) & 0xFF; // r
-        raw_image[4 * i + 1] = (pixel >> 16) & 0xFF; // g
-        raw_image[4 * i + 2] = (pixel >>  8) & 0xFF; // b
-        raw_image[4 * i + 3] = 255;
+    // Copy the row of every tile in turn
+    for (uint32_t x = 0; x < this->width; x += Frame::tile_size) {
+        memcpy(buffer + x, this->data + this->index(x, y), this->run(x, this->width) * sizeof(uint32_t));
     }
+    return buffer;
+}
+
+
+
+/* Writes the internal frame to disk as a PNG. Assumes that the CPU buffer is synchronized with the GPU one. If an arena is given, the image is filtered in a buffer allocated there instead of on the heap. */
+void Frame::to_png(const std::string& path, Tools::Arena* scratch) const {
+    PENTER("Frame::to_png");
+
+    // Encode it at the default level on the encoders' shared pool, so repeated calls don't start threads every time; use a PngEncoder directly to pick the level or pool, or to encode in the background
+    PngEncoder encoder;
+    encoder.encode(*this, path, scratch);
 
-    // With the raw image created, we can send it to the file using lodepng
-    unsigned result = lodepng::encode(path.c_str(), raw_image, this->width, this->height);
-    if (result != 0) {
-        DLOG(fatal, "Could not write to PNG: " + std::string(lodepng_error_text(result)));
-    }
-    
     // Done
     DRETURN;
 }
 
 /* Writes the internal frame to disk as a PPM. Assumes that the CPU buffer is synchronized with the GPU one. */
 void Frame::to_ppm(const std::string& path) const {
-    DENTER("Frame::to_ppm");
+    PENTER("Frame::to_ppm");
 
     // Open a file handle
     std::ofstream h(path, ios::binary);
@@ -127,23 +145,26 @@ void Frame::to_ppm(const std::string& path) const {
     h << this->width << " " << this->height << endl;
     h << "255" << endl;
 
-    // Now we write the data
-    for (size_t i = 0; i < this->width * this->height; i++) {
-        // Unpack the integer
-        uint32_t pixel = this->data[i];
-        unsigned char r = (pixel >> 24) & 0xFF;
-        unsigned char g = (pixel >> 16) & 0xFF;
-        unsigned char b = (pixel >>  8) & 0xFF;
-        DLOG(info, "pixel: (" + std::to_string(r) + "," + std::to_string(g) + "," + std::to_string(b) + ")");
-
-        // Write to the file
-        h.write((const char*) &r, sizeof(unsigned char));
-        h.write((const char*) &g, sizeof(unsigned char));
-        h.write((const char*) &b, sizeof(unsigned char));
+    // Now we write the data, converting & writing one row at a time
+    std::vector<unsigned char> row(3 * (size_t) this->width);
+    std::vector<uint32_t> row_buffer(this->pixel_layout == FrameLayout::row_major ? 0 : this->width);
+    for (uint32_t y = 0; y < this->height; y++) {
+        const uint32_t* pixels = this->row(y, row_buffer.data());
+        for (uint32_t x = 0; x < this->width; x++) {
+            // Unpack the integer
+            uint32_t pixel = pixels[x];
+            row[3 * (size_t) x    ] = (pixel >> 24) & 0xFF; // r
+            row[3 * (size_t) x + 1] = (pixel >> 16) & 0xFF; // g
+            row[3 * (size_t) x + 2] = (pixel >>  8) & 0xFF; // b
+        }
+        h.write((const char*) row.data(), row.size());
     }
 
     // Alrighty! Looks good!
     h.close();
+    if (!h) {
+        DLOG(fatal, "Could not write to '" + path + "'");
+    }
     DRETURN;
 }
 
@@ -157,4 +178,7 @@ void RayTracer::swap(Frame& f1, Frame& f2) {
     swap(f1.data, f2.data);
     swap(f1.width, f2.width);
     swap(f1.height, f2.height);
+    swap(f1.pixel_layout, f2.pixel_layout);
+    swap(f1.tiles_x, f2.tiles_x);
+    swap(f1.n_pixels, f2.n_pixels);
 }
@@ -4,21 +4,27 @@
  * Created:
  *   28/04/2021, 14:28:35
  * Last edited:
- *   25/05/2021, 16:54:51
+ *   16/10/2026, 00:28:25
  * Auto updated?
  *   Yes
  *
  * Description:
  *   Contains the Frame class, which is a wrapper around CPU & Vulkan
  *   buffers to provide a conceptually easy frame to fill with colour
- *   pixels on the GPU. Also contains code to easily write to PNG, using
- *   the LodePNG library.
+ *   pixels on the GPU. The pixels are stored either row by row or in
+ *   square tiles, which are only converted to rows when the frame is
+ *   written. Also contains code to easily write to PNG (using the
+ *   PngEncoder) and PPM.
 **/
 
 #ifndef CAMERA_FRAME_HPP
 #define CAMERA_FRAME_HPP
 
+#include <string>
+#include <algorithm>
+
 #include "glm/glm.hpp"
+#include "tools/Arena.hpp"
 
 namespace RayTracer {
     /* The Pixel struct, which directly represents a single pixel. Can also be indexed by index. */
@@ -37,19 +43,39 @@ namespace RayTracer {
 
 
 
+    /* The layouts in which a Frame can store its pixels. */
+    enum class FrameLayout {
+        /* All pixels row by row, which is what the image formats expect. */
+        row_major,
+        /* Square tiles of Frame::tile_size pixels, stored row by row, with the pixels in every tile stored row by row as well. Keeps the pixels of a tile (and neighbouring pixels in general) close together, but has to be converted when the frame is written. */
+        tiled
+    };
+
+
+
     /* The Frame class, which represents a single image to be rendered by the RayTracer. */
     class Frame {
+    public:
+        /* The width & height (in pixels) of the tiles in the tiled layout. */
+        static const constexpr uint32_t tile_size = 16;
+
     private:
-        /* The actual frame buffer, tightly packed as 32-bit unsigned integers that represent RGBA. Note that the actual order is secretly BGRA. */
+        /* The actual frame buffer, tightly packed as 32-bit unsigned integers that represent RGBA. Note that the actual order is secretly BGRA. Should be indexed with 64-bit integers, since large frames have more than 2^32 pixels. */
         uint32_t* data;
         /* The width, in pixels, of the frame. */
         uint32_t width;
         /* The height, in pixels, of the frame. */
         uint32_t height;
+        /* The order in which the pixels are stored. */
+        FrameLayout pixel_layout;
+        /* The number of tiles in a row of tiles, if the frame is tiled. */
+        uint32_t tiles_x;
+        /* The number of pixels in the buffer, which includes the padding of partial tiles. */
+        size_t n_pixels;
 
     public:
-        /* Constructor for the Frame class, which takes the dimension of the frame. */
-        Frame(uint32_t width, uint32_t height);
+        /* Constructor for the Frame class, which takes the dimension of the frame and the order in which it stores its pixels. */
+        Frame(uint32_t width, uint32_t height, FrameLayout layout = FrameLayout::row_major);
         /* Copy constructor for the Frame class. */
         Frame(const Frame& other);
         /* Move constructor for the Frame class. */
@@ -57,8 +83,8 @@ namespace RayTracer {
         /* Desctructor for the Frame class. */
         ~Frame();
         
-        /* Writes the internal frame to disk as a PNG. Assumes that the CPU buffer is synchronized with the GPU one. */
-        void to_png(const std::string& path) const;
+        /* Writes the internal frame to disk as a PNG. Assumes that the CPU buffer is synchronized with the GPU one. If an arena is given, the image is filtered in a buffer allocated there instead of on the heap. */
+        void to_png(const std::string& path, Tools::Arena* scratch = nullptr) const;
         /* Writes the internal frame to disk as a PPM. Assumes that the CPU buffer is synchronized with the GPU one. */
         void to_ppm(const std::string& path) const;
 
@@ -66,9 +92,26 @@ namespace RayTracer {
         inline uint32_t w() const { return this->width; }
         /* Returns the height of the frame. */
         inline uint32_t h() const { return this->height; }
-        /* Allows access to the internal frame buffer. */
+        /* Returns the order in which the pixels are stored. */
+        inline FrameLayout layout() const { return this->pixel_layout; }
+        /* Returns the number of pixels in the internal frame buffer, which includes the padding of partial tiles. */
+        inline size_t size() const { return this->n_pixels; }
+        /* Allows access to the internal frame buffer. Use index() to find pixels in it. */
         inline uint32_t* d() const { return this->data; }
 
+        /* Returns the index of the given pixel in the internal frame buffer. */
+        inline size_t index(uint32_t x, uint32_t y) const {
+            if (this->pixel_layout == FrameLayout::row_major) { return (size_t) y * this->width + x; }
+            return ((size_t) (y / Frame::tile_size) * this->tiles_x + x / Frame::tile_size) * (Frame::tile_size * Frame::tile_size) + (y % Frame::tile_size) * Frame::tile_size + x % Frame::tile_size;
+        }
+        /* Returns the number of pixels from the given one that are stored one after another in the same row, up to (but not including) x1. */
+        inline uint32_t run(uint32_t x, uint32_t x1) const {
+            if (this->pixel_layout == FrameLayout::row_major) { return x1 - x; }
+            return std::min(x1, (x / Frame::tile_size + 1) * Frame::tile_size) - x;
+        }
+        /* Returns a pointer to the given row of pixels in row-major order. If the frame isn't row-major, the row is gathered in the given buffer of (at least) width pixels first, and a pointer to that is returned. */
+        const uint32_t* row(uint32_t y, uint32_t* buffer) const;
+
         /* Returns the pixel at the given index. */
         inline IPixel operator[](size_t index) { IPixel result; result.raw = this->data[index]; return result; }
         
@@ -0,0 +1,265 @@
+/* FRAME SINK.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 12:05:48
+ * Last edited:
+ *   16/10/2026, 01:02:51
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the FrameSink classes, which receive the tiles or bands of
+ *   rows of a frame as soon as a renderer has finished them. Besides a
+ *   sink that simply fills a Frame, there are sinks that write PPM or PFM
+ *   files while rendering, either incrementally or through a memory-mapped
+ *   file, so frames much larger than memory can be rendered.
+**/
+
+#include <cstring>
+#include <cerrno>
+#include <CppDebugger.hpp>
+
+#include "tools/Profiler.hpp"
+
+#include "FrameSink.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** HELPER FUNCTIONS *****/
+/* @brief Returns the number of bytes a single pixel takes in the given format.
+ * @param format The format of the file.
+ * @return The size of a pixel, in bytes.
+ */
+static inline size_t pixel_size(ImageFormat format) {
+    return format == ImageFormat::pfm ? 3 * sizeof(float) : 3;
+}
+
+/* @brief Returns the header of a file of the given format and size.
+ * @param format The format of the file.
+ * @param width The width of the frame, in pixels.
+ * @param height The height of the frame, in pixels.
+ * @return The header as a string, up to the first pixel.
+ */
+static std::string file_header(ImageFormat format, uint32_t width, uint32_t height) {
+    if (format == ImageFormat::pfm) {
+        // The sign of the scale tells whether the floats are little-endian (negative) or big-endian (positive)
+        uint32_t one = 1;
+        bool little_endian = *((unsigned char*) &one) == 1;
+        return "PF\n" + std::to_string(width) + " " + std::to_string(height) + "\n" + (little_endian ? "-1.0" : "1.0") + "\n";
+    } else {
+        return "P6\n# Image rendered by the RayTracer-3\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    }
+}
+
+/* @brief Returns the offset of the given pixel in a file of the given format. Note that PFM stores its rows bottom-to-top.
+ * @param format The format of the file.
+ * @param header_size The size of the file's header, in bytes.
+ * @param width The width of the frame, in pixels.
+ * @param height The height of the frame, in pixels.
+ * @param x The x-coordinate of the pixel.
+ * @param y The y-coordinate of the pixel, counted from the top.
+ * @return The offset of the pixel in the file, in bytes.
+ */
+static inline size_t pixel_offset(ImageFormat format, size_t header_size, uint32_t width, uint32_t height, uint32_t x, uint32_t y) {
+    size_t row = format == ImageFormat::pfm ? (size_t) (height - 1 - y) : (size_t) y;
+    return header_size + (row * width + x) * pixel_size(format);
+}
+
+/* @brief Converts a row of colors to the given format.
+ * @param format The format to convert to.
+ * @param colors The colors to convert.
+ * @param n_pixels The number of colors to convert.
+ * @param output The buffer to write the converted pixels to.
+ */
+static void convert_row(ImageFormat format, const glm::vec3* colors, size_t n_pixels, char* output) {
+    if (format == ImageFormat::pfm) {
+        memcpy(output, colors, n_pixels * sizeof(glm::vec3));
+    } else {
+        for (size_t i = 0; i < n_pixels; i++) {
+            // Round to bytes the same way as the frame does
+            uint32_t pixel = glm::packUnorm4x8(glm::vec4(colors[i].x, colors[i].y, colors[i].z, 1.0f));
+            output[3 * i    ] = (char) ((pixel      ) & 0xFF);
+            output[3 * i + 1] = (char) ((pixel >>  8) & 0xFF);
+            output[3 * i + 2] = (char) ((pixel >> 16) & 0xFF);
+        }
+    }
+}
+
+
+
+
+
+/***** FRAMEBUFFERSINK CLASS *****/
+/* Constructor for the FrameBufferSink class, which takes the frame to write to. */
+FrameBufferSink::FrameBufferSink(Frame& frame) :
+    frame(frame)
+{}
+
+/* Checks that the frame has the given size. */
+void FrameBufferSink::begin(uint32_t width, uint32_t height) {
+    DENTER("FrameBufferSink::begin");
+
+    if (width != this->frame.w() || height != this->frame.h()) {
+        DLOG(fatal, "Cannot render a " + std::to_string(width) + "x" + std::to_string(height) + " frame to a " + std::to_string(this->frame.w()) + "x" + std::to_string(this->frame.h()) + " frame buffer");
+    }
+
+    DRETURN;
+}
+
+/* Writes the colors of the pixels in the rectangle [x0, x1) x [y0, y1) to the frame. */
+void FrameBufferSink::write(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, const glm::vec3* colors, size_t stride) {
+    uint32_t* data = this->frame.d();
+    for (uint32_t y = y0; y < y1; y++) {
+        const glm::vec3* row = colors + (y - y0) * stride;
+
+        // Write the row in runs of pixels that are contiguous in the frame's layout
+        for (uint32_t x = x0; x < x1; ) {
+            uint32_t* pixels = data + this->frame.index(x, y);
+            uint32_t run = this->frame.run(x, x1);
+            for (uint32_t i = 0; i < run; i++) {
+                const glm::vec3& color = row[x - x0 + i];
+                pixels[i] = glm::packUnorm4x8(glm::vec4(1.0, color.z, color.y, color.x));
+            }
+            x += run;
+        }
+    }
+}
+
+/* Finishes the frame, which is a no-op for frames. */
+void FrameBufferSink::end() {}
+
+
+
+
+
+/***** STREAMSINK CLASS *****/
+/* Constructor for the StreamSink class, which takes the path of the file to write and its format. The file is only created once the frame begins. */
+StreamSink::StreamSink(const std::string& path, ImageFormat format) :
+    path(path),
+    format(format),
+    header_size(0),
+    width(0),
+    height(0)
+{}
+
+/* Creates the file and writes its header. */
+void StreamSink::begin(uint32_t width, uint32_t height) {
+    DENTER("StreamSink::begin");
+
+    // Open a file handle
+    this->h.open(this->path, ios::binary | ios::trunc);
+    if (!this->h.is_open()) {
+        #ifdef _WIN32
+        char buffer[BUFSIZ];
+        strerror_s(buffer, BUFSIZ, errno);
+        #else
+        char* buffer = strerror(errno);
+        #endif
+        DLOG(fatal, "Could not open '" + this->path + "': " + buffer);
+    }
+
+    // Write the header
+    std::string header = file_header(this->format, width, height);
+    this->h.write(header.data(), header.size());
+    this->header_size = header.size();
+    this->width = width;
+    this->height = height;
+
+    DRETURN;
+}
+
+/* Converts the given band of rows to the file's format and writes it to its place in the file. The rectangle has to span the entire width of the frame. */
+void StreamSink::write(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, const glm::vec3* colors, size_t stride) {
+    PENTER("StreamSink::write");
+
+    if (x0 != 0 || x1 != this->width) {
+        DLOG(fatal, "StreamSink can only write bands that span the entire width of the frame");
+    }
+    std::unique_lock<std::mutex> lock(this->lock);
+
+    // Convert all rows into one block. Since PFM stores its rows bottom-to-top, the rows of a band are contiguous in either format, but reversed in PFM
+    size_t row_size = this->width * pixel_size(this->format);
+    this->buffer.resize((y1 - y0) * row_size);
+    for (uint32_t y = y0; y < y1; y++) {
+        size_t row = this->format == ImageFormat::pfm ? (size_t) (y1 - 1 - y) : (size_t) (y - y0);
+        convert_row(this->format, colors + (y - y0) * stride, this->width, this->buffer.data() + row * row_size);
+    }
+
+    // Write it to its place in one go
+    uint32_t first_y = this->format == ImageFormat::pfm ? y1 - 1 : y0;
+    this->h.seekp(pixel_offset(this->format, this->header_size, this->width, this->height, 0, first_y));
+    this->h.write(this->buffer.data(), this->buffer.size());
+    if (!this->h) {
+        DLOG(fatal, "Could not write rows " + std::to_string(y0) + "-" + std::to_string(y1) + " to '" + this->path + "'");
+    }
+
+    DRETURN;
+}
+
+/* Closes the file. */
+void StreamSink::end() {
+    DENTER("StreamSink::end");
+
+    this->h.close();
+    if (!this->h) {
+        DLOG(fatal, "Could not write to '" + this->path + "'");
+    }
+
+    // Also free the band buffer, since the next frame may be much smaller
+    this->buffer = std::vector<char>();
+
+    DRETURN;
+}
+
+
+
+
+
+/***** MAPPEDSINK CLASS *****/
+/* Constructor for the MappedSink class, which takes the path of the file to write and its format. The file is only created once the frame begins. */
+MappedSink::MappedSink(const std::string& path, ImageFormat format) :
+    path(path),
+    format(format),
+    header_size(0),
+    width(0),
+    height(0)
+{}
+
+/* Creates the file with its final size, maps it and writes its header. */
+void MappedSink::begin(uint32_t width, uint32_t height) {
+    DENTER("MappedSink::begin");
+
+    // Create the file at its full size
+    std::string header = file_header(this->format, width, height);
+    this->header_size = header.size();
+    this->width = width;
+    this->height = height;
+    this->file = std::make_unique<Tools::MappedFile>(this->path, this->header_size + (size_t) width * (size_t) height * pixel_size(this->format));
+
+    // Write the header
+    memcpy(this->file->writable_data(), header.data(), header.size());
+
+    DRETURN;
+}
+
+/* Converts the pixels in the rectangle [x0, x1) x [y0, y1) to the file's format, straight into the mapping. */
+void MappedSink::write(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, const glm::vec3* colors, size_t stride) {
+    char* data = this->file->writable_data();
+    for (uint32_t y = y0; y < y1; y++) {
+        convert_row(this->format, colors + (y - y0) * stride, x1 - x0, data + pixel_offset(this->format, this->header_size, this->width, this->height, x0, y));
+    }
+}
+
+/* Writes the mapping back to disk and unmaps the file. */
+void MappedSink::end() {
+    DENTER("MappedSink::end");
+
+    this->file->flush();
+    this->file.reset();
+
+    DRETURN;
+}
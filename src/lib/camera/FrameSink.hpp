@@ -0,0 +1,159 @@
+/* FRAME SINK.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 12:05:44
+ * Last edited:
+ *   16/10/2026, 12:05:44
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the FrameSink classes, which receive the tiles or bands of
+ *   rows of a frame as soon as a renderer has finished them. Besides a
+ *   sink that simply fills a Frame, there are sinks that write PPM or PFM
+ *   files while rendering, either incrementally or through a memory-mapped
+ *   file, so frames much larger than memory can be rendered.
+**/
+
+#ifndef CAMERA_FRAME_SINK_HPP
+#define CAMERA_FRAME_SINK_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <fstream>
+#include <memory>
+
+#include "glm/glm.hpp"
+#include "tools/MappedFile.hpp"
+
+#include "Frame.hpp"
+
+namespace RayTracer {
+    /* The file formats that the file sinks can write. */
+    enum class ImageFormat {
+        /* Binary PPM (P6), with 8 bits per channel. */
+        ppm,
+        /* Portable FloatMap (PF), with a 32-bit float per channel. */
+        pfm
+    };
+
+
+
+    /* The FrameSink baseclass, which receives the rendered pixels of a frame as they are finished. */
+    class FrameSink {
+    public:
+        /* Virtual destructor for the FrameSink baseclass. */
+        virtual ~FrameSink() = default;
+
+        /* Prepares the sink for a frame of the given size. Is called once before any pixels are written. */
+        virtual void begin(uint32_t width, uint32_t height) = 0;
+        /* Writes the colors of the pixels in the rectangle [x0, x1) x [y0, y1), which are given row by row with stride pixels between the starts of two rows. May be called from multiple threads at once for disjoint rectangles. */
+        virtual void write(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, const glm::vec3* colors, size_t stride) = 0;
+        /* Finishes the frame, once all of its pixels have been written. */
+        virtual void end() = 0;
+
+        /* Returns whether the sink accepts any rectangle. If not, renderers may only give it full-width bands of rows. */
+        virtual bool accepts_tiles() const = 0;
+
+    };
+
+
+
+    /* The FrameBufferSink class, which simply writes the pixels to an in-memory Frame. */
+    class FrameBufferSink: public FrameSink {
+    private:
+        /* The frame to write to. */
+        Frame& frame;
+
+    public:
+        /* Constructor for the FrameBufferSink class, which takes the frame to write to. */
+        FrameBufferSink(Frame& frame);
+
+        /* Checks that the frame has the given size. */
+        virtual void begin(uint32_t width, uint32_t height);
+        /* Writes the colors of the pixels in the rectangle [x0, x1) x [y0, y1) to the frame. */
+        virtual void write(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, const glm::vec3* colors, size_t stride);
+        /* Finishes the frame, which is a no-op for frames. */
+        virtual void end();
+
+        /* Returns whether the sink accepts any rectangle, which it does. */
+        virtual bool accepts_tiles() const { return true; }
+
+    };
+
+
+
+    /* The StreamSink class, which writes the frame to a PPM or PFM file band by band, only keeping the band that's being written in memory. */
+    class StreamSink: public FrameSink {
+    private:
+        /* The path of the file to write to. */
+        std::string path;
+        /* The format of the file to write. */
+        ImageFormat format;
+        /* The handle to the file while the frame is written. */
+        std::ofstream h;
+        /* The size of the file's header, in bytes. */
+        size_t header_size;
+        /* The width of the frame. */
+        uint32_t width;
+        /* The height of the frame. */
+        uint32_t height;
+        /* Buffer for converting a band to the file's format, which is kept around for the next band. */
+        std::vector<char> buffer;
+        /* Lock that makes sure only one band is written at a time. */
+        std::mutex lock;
+
+    public:
+        /* Constructor for the StreamSink class, which takes the path of the file to write and its format. The file is only created once the frame begins. */
+        StreamSink(const std::string& path, ImageFormat format);
+
+        /* Creates the file and writes its header. */
+        virtual void begin(uint32_t width, uint32_t height);
+        /* Converts the given band of rows to the file's format and writes it to its place in the file. The rectangle has to span the entire width of the frame. */
+        virtual void write(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, const glm::vec3* colors, size_t stride);
+        /* Closes the file. */
+        virtual void end();
+
+        /* Returns whether the sink accepts any rectangle, which it doesn't; it needs full-width bands. */
+        virtual bool accepts_tiles() const { return false; }
+
+    };
+
+
+
+    /* The MappedSink class, which writes the frame to a PPM or PFM file that is mapped into memory, leaving it to the OS to page the pixels out to disk. */
+    class MappedSink: public FrameSink {
+    private:
+        /* The path of the file to write to. */
+        std::string path;
+        /* The format of the file to write. */
+        ImageFormat format;
+        /* The mapping of the file while the frame is written. */
+        std::unique_ptr<Tools::MappedFile> file;
+        /* The size of the file's header, in bytes. */
+        size_t header_size;
+        /* The width of the frame. */
+        uint32_t width;
+        /* The height of the frame. */
+        uint32_t height;
+
+    public:
+        /* Constructor for the MappedSink class, which takes the path of the file to write and its format. The file is only created once the frame begins. */
+        MappedSink(const std::string& path, ImageFormat format);
+
+        /* Creates the file with its final size, maps it and writes its header. */
+        virtual void begin(uint32_t width, uint32_t height);
+        /* Converts the pixels in the rectangle [x0, x1) x [y0, y1) to the file's format, straight into the mapping. */
+        virtual void write(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, const glm::vec3* colors, size_t stride);
+        /* Writes the mapping back to disk and unmaps the file. */
+        virtual void end();
+
+        /* Returns whether the sink accepts any rectangle, which it does. */
+        virtual bool accepts_tiles() const { return true; }
+
+    };
+}
+
+#endif
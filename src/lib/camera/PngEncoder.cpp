@@ -0,0 +1,463 @@
+/* PNG ENCODER.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 11:32:11
+ * Last edited:
+ *   16/10/2026, 01:02:51
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the PngEncoder class, which writes Frames to disk as PNGs.
+ *   The image is cut in bands of rows which are filtered and deflated in
+ *   parallel, after which the compressed bands are simply concatenated
+ *   into one IDAT stream. Can also encode in the background, so the next
+ *   frame can already be rendered while the last one is written.
+**/
+
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+#include <limits>
+#include <initializer_list>
+#include <utility>
+#include <zlib.h>
+#include <CppDebugger.hpp>
+
+#include "tools/Profiler.hpp"
+
+#include "PngEncoder.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** CONSTANTS *****/
+/* The number of bytes per pixel in the images we write (8-bit RGB). */
+static const constexpr size_t bytes_per_pixel = 3;
+/* The size of deflate's window, which is how much of the previous band every band may refer back to. */
+static const constexpr size_t window_size = 32768;
+/* The maximum number of bytes in a single band, so zlib's 32-bit lengths never overflow. */
+static const constexpr size_t max_band_size = 1 << 30;
+/* The largest width or height a PNG may have. */
+static const constexpr uint32_t max_png_size = 0x7FFFFFFF;
+
+/* The PNG file signature. */
+static const unsigned char png_signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+
+
+
+
+/***** HELPER FUNCTIONS *****/
+/* @brief Writes the given value to the given buffer as a big-endian 32-bit integer, which is how PNG stores them.
+ * @param buffer The buffer to write to, which should have room for at least four bytes.
+ * @param value The value to write.
+ */
+static inline void store_u32(unsigned char* buffer, uint32_t value) {
+    buffer[0] = (unsigned char) (value >> 24);
+    buffer[1] = (unsigned char) (value >> 16);
+    buffer[2] = (unsigned char) (value >>  8);
+    buffer[3] = (unsigned char) (value      );
+}
+
+/* @brief Writes a single PNG chunk to the given stream.
+ * @param h The stream to write to.
+ * @param type The four-character type of the chunk.
+ * @param parts The pieces of data (pointer & size) that together form the chunk's data, which are written back-to-back.
+ */
+static void write_chunk(std::ostream& h, const char* type, std::initializer_list<std::pair<const unsigned char*, size_t>> parts) {
+    // Write the length and the type
+    size_t size = 0;
+    for (const std::pair<const unsigned char*, size_t>& part : parts) { size += part.second; }
+    unsigned char header[8];
+    store_u32(header, (uint32_t) size);
+    memcpy(header + 4, type, 4);
+    h.write((const char*) header, sizeof(header));
+
+    // Write the data itself, computing the checksum over the type and the data as we go
+    uLong crc = crc32(0L, header + 4, 4);
+    for (const std::pair<const unsigned char*, size_t>& part : parts) {
+        h.write((const char*) part.first, part.second);
+        crc = crc32(crc, part.first, (uInt) part.second);
+    }
+
+    // Finally, write the checksum
+    unsigned char footer[4];
+    store_u32(footer, (uint32_t) crc);
+    h.write((const char*) footer, sizeof(footer));
+}
+
+/* @brief The Paeth predictor from the PNG specification, which predicts a byte from its left, upper and upper-left neighbours.
+ * @param a The byte to the left.
+ * @param b The byte above.
+ * @param c The byte to the upper left.
+ * @return Whichever of the three neighbours is closest to a + b - c.
+ */
+static inline unsigned char paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) { return (unsigned char) a; }
+    if (pb <= pc) { return (unsigned char) b; }
+    return (unsigned char) c;
+}
+
+/* @brief Unpacks the given row of frame pixels to tightly packed RGB bytes.
+ * @param pixels The pixels of the row, packed as in the Frame.
+ * @param width The number of pixels in the row.
+ * @param rgb The buffer to write the bytes to, which should have room for three bytes per pixel.
+ */
+static void unpack_row(const uint32_t* pixels, uint32_t width, unsigned char* rgb) {
+    for (uint32_t x = 0; x < width; x++) {
+        uint32_t pixel = pixels[x];
+        rgb[bytes_per_pixel * x    ] = (pixel >> 24) & 0xFF; // r
+        rgb[bytes_per_pixel * x + 1] = (pixel >> 16) & 0xFF; // g
+        rgb[bytes_per_pixel * x + 2] = (pixel >>  8) & 0xFF; // b
+    }
+}
+
+/* @brief Filters a single row with each of the five PNG filters, and copies the one that's most likely to compress best to the output.
+ * @param row The unfiltered bytes of the row.
+ * @param prev The unfiltered bytes of the row above it (all zeroes for the first row).
+ * @param n_bytes The number of bytes in a row.
+ * @param candidates Buffer with room for five filtered rows, used to try each filter.
+ * @param output The buffer to write the filter type byte and the filtered row to.
+ */
+static void filter_row(const unsigned char* row, const unsigned char* prev, size_t n_bytes, unsigned char* candidates, unsigned char* output) {
+    unsigned char* none = candidates;
+    unsigned char* sub = candidates + n_bytes;
+    unsigned char* up = candidates + 2 * n_bytes;
+    unsigned char* average = candidates + 3 * n_bytes;
+    unsigned char* paeth_row = candidates + 4 * n_bytes;
+
+    // Compute all filters at once
+    for (size_t i = 0; i < n_bytes; i++) {
+        int a = i >= bytes_per_pixel ? row[i - bytes_per_pixel] : 0;
+        int b = prev[i];
+        int c = i >= bytes_per_pixel ? prev[i - bytes_per_pixel] : 0;
+        none[i] = row[i];
+        sub[i] = (unsigned char) (row[i] - a);
+        up[i] = (unsigned char) (row[i] - b);
+        average[i] = (unsigned char) (row[i] - ((a + b) >> 1));
+        paeth_row[i] = (unsigned char) (row[i] - paeth(a, b, c));
+    }
+
+    // Pick the one with the smallest sum of absolute (signed) values, which is the heuristic the PNG specification recommends
+    uint32_t best = 0;
+    uint64_t best_score = std::numeric_limits<uint64_t>::max();
+    for (uint32_t f = 0; f < 5; f++) {
+        const unsigned char* filtered = candidates + f * n_bytes;
+        uint64_t score = 0;
+        for (size_t i = 0; i < n_bytes; i++) {
+            score += (uint64_t) std::abs((int) (signed char) filtered[i]);
+        }
+        if (score < best_score) {
+            best = f;
+            best_score = score;
+        }
+    }
+
+    // Write it
+    output[0] = (unsigned char) best;
+    memcpy(output + 1, candidates + best * n_bytes, n_bytes);
+}
+
+/* @brief Computes the second byte of the zlib header for the given compression level, which has to make the header a multiple of 31.
+ * @param level The compression level used.
+ * @return The FLG byte of the zlib header.
+ */
+static unsigned char zlib_flags(int level) {
+    // Only informative, but be honest about how hard we tried
+    unsigned char flevel = level <= 1 ? 0 : (level <= 5 ? 1 : (level == 6 ? 2 : 3));
+    unsigned char flags = (unsigned char) (flevel << 6);
+    return (unsigned char) (flags + (31 - (0x78 * 256 + flags) % 31) % 31);
+}
+
+
+
+
+
+/***** PNGENCODER CLASS *****/
+/* Constructor for the PngEncoder class, which takes the compression level (0-9). Encodes on the pool shared by all such encoders, which is only started when the first one is created. */
+PngEncoder::PngEncoder(int level) :
+    PngEncoder(PngEncoder::shared_pool(), level)
+{}
+
+/* Constructor for the PngEncoder class, which takes the pool to encode on (e.g., the renderer's, so no second set of threads competes with it) and the compression level (0-9). The pool should outlive the encoder. */
+PngEncoder::PngEncoder(Tools::ThreadPool& pool, int level) :
+    level(level),
+    pool(&pool)
+{
+    DENTER("PngEncoder::PngEncoder");
+
+    if (level < 0 || level > 9) {
+        DLOG(fatal, "Invalid PNG compression level " + std::to_string(level) + " (should be 0-9)");
+    }
+
+    DLEAVE;
+}
+
+/* Destructor for the PngEncoder class, which waits until any background encoding is done. */
+PngEncoder::~PngEncoder() {
+    DENTER("PngEncoder::~PngEncoder");
+
+    // Wait for the worker; any error it had is already logged, and we can't throw it from here
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+
+    DLEAVE;
+}
+
+
+
+/* Returns the pool that is shared by all encoders that aren't given one, starting it with one thread per hardware thread on the first call. */
+Tools::ThreadPool& PngEncoder::shared_pool() {
+    static Tools::ThreadPool pool;
+    return pool;
+}
+
+
+
+/* Returns the number of rows in each band for an image of the given size. */
+uint32_t PngEncoder::get_band_rows(uint32_t width, uint32_t height) const {
+    // Aim for a couple of bands per thread so the work balances out, but don't make them too small to compress well
+    size_t n_bands = 4 * (size_t) this->pool->size();
+    size_t band_rows = std::max((size_t) PngEncoder::min_band_rows, (height + n_bands - 1) / n_bands);
+
+    // Also never let a band grow too large for zlib
+    size_t row_size = 1 + bytes_per_pixel * (size_t) width;
+    band_rows = std::max((size_t) 1, std::min(band_rows, max_band_size / row_size));
+    return (uint32_t) band_rows;
+}
+
+/* Converts the given frame to RGB and filters every row of it, writing the result (including each row's filter type byte) to the given buffer. */
+void PngEncoder::filter(const Frame& frame, unsigned char* filtered, uint32_t band_rows) {
+    PENTER("PngEncoder::filter");
+
+    uint32_t width = frame.w(), height = frame.h();
+    size_t n_bytes = bytes_per_pixel * (size_t) width;
+    size_t n_bands = (height + band_rows - 1) / band_rows;
+    this->pool->run(n_bands, [this, &frame, filtered, band_rows, width, height, n_bytes](size_t band, uint32_t) {
+        // Every band unpacks the row above it itself, so the bands don't depend on each other
+        std::vector<unsigned char> buffer(7 * n_bytes);
+        std::vector<uint32_t> pixel_buffer(frame.layout() == FrameLayout::row_major ? 0 : width);
+        unsigned char* prev = buffer.data();
+        unsigned char* row = prev + n_bytes;
+        unsigned char* candidates = row + n_bytes;
+        uint32_t first = (uint32_t) band * band_rows;
+        uint32_t last = (uint32_t) std::min((size_t) height, (size_t) first + band_rows);
+        if (first > 0) {
+            unpack_row(frame.row(first - 1, pixel_buffer.data()), width, prev);
+        }
+
+        for (uint32_t y = first; y < last; y++) {
+            unsigned char* output = filtered + (size_t) y * (1 + n_bytes);
+            unpack_row(frame.row(y, pixel_buffer.data()), width, row);
+
+            // Without compression filtering doesn't pay off, so skip it altogether
+            if (this->level == 0) {
+                output[0] = 0;
+                memcpy(output + 1, row, n_bytes);
+            } else {
+                filter_row(row, prev, n_bytes, candidates, output);
+            }
+
+            std::swap(prev, row);
+        }
+    });
+
+    DRETURN;
+}
+
+/* Deflates the given filtered image in bands and writes the resulting PNG to the given path. */
+void PngEncoder::write(const std::string& path, const unsigned char* filtered, uint32_t width, uint32_t height, uint32_t band_rows) {
+    PENTER("PngEncoder::write");
+
+    size_t row_size = 1 + bytes_per_pixel * (size_t) width;
+    size_t n_bands = (height + band_rows - 1) / band_rows;
+
+    // Deflate all bands in parallel. Each is a raw deflate stream primed with the end of the previous band, and all but the last end on a byte boundary without closing the stream, so together they form a single stream
+    std::vector<std::vector<unsigned char>> bands(n_bands);
+    std::vector<uLong> checksums(n_bands);
+    this->pool->run(n_bands, [this, filtered, band_rows, height, row_size, n_bands, &bands, &checksums](size_t band, uint32_t) {
+        size_t start = (size_t) band * band_rows * row_size;
+        size_t size = (std::min((size_t) height, (size_t) (band + 1) * band_rows) - (size_t) band * band_rows) * row_size;
+        bool last = band == n_bands - 1;
+
+        // Prepare the stream
+        z_stream stream;
+        memset(&stream, 0, sizeof(z_stream));
+        if (deflateInit2(&stream, this->level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            DLOG(fatal, "Could not initialize zlib: " + std::string(stream.msg != nullptr ? stream.msg : "unknown error"));
+        }
+        if (band > 0) {
+            size_t dictionary_size = std::min(start, window_size);
+            deflateSetDictionary(&stream, filtered + start - dictionary_size, (uInt) dictionary_size);
+        }
+
+        // Compress it all in one go, growing the output if it somehow doesn't fit
+        std::vector<unsigned char>& output = bands[band];
+        output.resize(deflateBound(&stream, (uLong) size) + 16);
+        stream.next_in = (Bytef*) (filtered + start);
+        stream.avail_in = (uInt) size;
+        size_t written = 0;
+        while (true) {
+            stream.next_out = output.data() + written;
+            stream.avail_out = (uInt) (output.size() - written);
+            int result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+            written = output.size() - stream.avail_out;
+            if (result == Z_STREAM_ERROR) {
+                deflateEnd(&stream);
+                DLOG(fatal, "Could not compress band " + std::to_string(band));
+            }
+
+            // We're done once all input is consumed and everything is flushed
+            if (last ? result == Z_STREAM_END : (stream.avail_in == 0 && stream.avail_out != 0)) { break; }
+            output.resize(2 * output.size());
+        }
+        deflateEnd(&stream);
+        output.resize(written);
+
+        // Compute the checksum of the uncompressed band, which is combined with the others below
+        checksums[band] = adler32(adler32(0L, Z_NULL, 0), filtered + start, (uInt) size);
+    });
+
+    // Combine the checksums of all bands into the one for the entire stream
+    uLong checksum = adler32(0L, Z_NULL, 0);
+    for (size_t b = 0; b < n_bands; b++) {
+        size_t size = (std::min((size_t) height, (size_t) (b + 1) * band_rows) - (size_t) b * band_rows) * row_size;
+        checksum = adler32_combine(checksum, checksums[b], (z_off_t) size);
+    }
+
+    // Open a file handle
+    std::ofstream h(path, ios::binary);
+    if (!h.is_open()) {
+        #ifdef _WIN32
+        char buffer[BUFSIZ];
+        strerror_s(buffer, BUFSIZ, errno);
+        #else
+        char* buffer = strerror(errno);
+        #endif
+        DLOG(fatal, "Could not open '" + path + "': " + buffer);
+    }
+
+    // Write the signature and the header (8-bit RGB, no interlacing)
+    h.write((const char*) png_signature, sizeof(png_signature));
+    unsigned char header[13];
+    store_u32(header, width);
+    store_u32(header + 4, height);
+    header[8] = 8;
+    header[9] = 2;
+    header[10] = 0;
+    header[11] = 0;
+    header[12] = 0;
+    write_chunk(h, "IHDR", { { header, sizeof(header) } });
+
+    // Write every band as its own IDAT chunk, with the zlib header in front of the first and the checksum after the last
+    unsigned char zlib_header[2] = { 0x78, zlib_flags(this->level) };
+    unsigned char zlib_footer[4];
+    store_u32(zlib_footer, (uint32_t) checksum);
+    for (size_t b = 0; b < n_bands; b++) {
+        write_chunk(h, "IDAT", {
+            { zlib_header, b == 0 ? sizeof(zlib_header) : 0 },
+            { bands[b].data(), bands[b].size() },
+            { zlib_footer, b == n_bands - 1 ? sizeof(zlib_footer) : 0 }
+        });
+    }
+
+    // Close it off
+    write_chunk(h, "IEND", {});
+    h.close();
+    if (!h) {
+        DLOG(fatal, "Could not write to '" + path + "'");
+    }
+
+    DRETURN;
+}
+
+
+
+/* Writes the given frame to the given path as PNG, and returns once it's on disk. If an arena is given, the filtered image is stored there instead of on the heap. */
+void PngEncoder::encode(const Frame& frame, const std::string& path, Tools::Arena* scratch) {
+    PENTER("PngEncoder::encode");
+
+    // Make sure we're not competing with the background thread for the pool
+    this->wait();
+    if (frame.w() == 0 || frame.h() == 0 || frame.w() > max_png_size || frame.h() > max_png_size) {
+        DLOG(fatal, "Cannot write a frame of " + std::to_string(frame.w()) + "x" + std::to_string(frame.h()) + " pixels to PNG");
+    }
+
+    // Allocate the space for the filtered image
+    size_t filtered_size = (size_t) frame.h() * (1 + bytes_per_pixel * (size_t) frame.w());
+    std::vector<unsigned char> heap_filtered;
+    unsigned char* filtered;
+    if (scratch != nullptr) {
+        filtered = (unsigned char*) scratch->allocate(filtered_size);
+    } else {
+        heap_filtered.resize(filtered_size);
+        filtered = heap_filtered.data();
+    }
+
+    // Filter, then compress & write
+    uint32_t band_rows = this->get_band_rows(frame.w(), frame.h());
+    this->filter(frame, filtered, band_rows);
+    this->write(path, filtered, frame.w(), frame.h(), band_rows);
+
+    DRETURN;
+}
+
+/* Writes the given frame to the given path as PNG in the background. Only filtering happens before this returns, so the frame may be overwritten straight after. Waits for the previous background encoding first. */
+void PngEncoder::encode_async(const Frame& frame, const std::string& path) {
+    DENTER("PngEncoder::encode_async");
+
+    // Wait for the previous frame, since we re-use its buffer
+    this->wait();
+    if (frame.w() == 0 || frame.h() == 0 || frame.w() > max_png_size || frame.h() > max_png_size) {
+        DLOG(fatal, "Cannot write a frame of " + std::to_string(frame.w()) + "x" + std::to_string(frame.h()) + " pixels to PNG");
+    }
+
+    // Filter the frame straight away; the filtered image doubles as our own copy of the frame
+    uint32_t width = frame.w(), height = frame.h();
+    uint32_t band_rows = this->get_band_rows(width, height);
+    this->pending.resize((size_t) height * (1 + bytes_per_pixel * (size_t) width));
+    this->filter(frame, this->pending.data(), band_rows);
+
+    // Leave the rest to the background thread
+    this->worker = std::thread([this, path, width, height, band_rows]() {
+        DSTART("png encoder"); PENTER("PngEncoder::encode_async::worker");
+
+        try {
+            this->write(path, this->pending.data(), width, height, band_rows);
+        } catch (...) {
+            this->error = std::current_exception();
+        }
+
+        DLEAVE;
+    });
+
+    DRETURN;
+}
+
+/* Waits until the background encoding (if any) is done. If it failed, re-throws its error here. */
+void PngEncoder::wait() {
+    DENTER("PngEncoder::wait");
+
+    // Wait for the thread to finish
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+
+    // Pass any errors on to the caller
+    if (this->error) {
+        std::exception_ptr error = this->error;
+        this->error = nullptr;
+        std::rethrow_exception(error);
+    }
+
+    DRETURN;
+}
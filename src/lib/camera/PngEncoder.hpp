@@ -0,0 +1,93 @@
+/* PNG ENCODER.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 11:32:07
+ * Last edited:
+ *   16/10/2026, 11:32:07
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the PngEncoder class, which writes Frames to disk as PNGs.
+ *   The image is cut in bands of rows which are filtered and deflated in
+ *   parallel, after which the compressed bands are simply concatenated
+ *   into one IDAT stream. Can also encode in the background, so the next
+ *   frame can already be rendered while the last one is written.
+**/
+
+#ifndef CAMERA_PNG_ENCODER_HPP
+#define CAMERA_PNG_ENCODER_HPP
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <exception>
+
+#include "tools/ThreadPool.hpp"
+#include "tools/Arena.hpp"
+
+#include "Frame.hpp"
+
+namespace RayTracer {
+    /* The PngEncoder class, which filters and compresses Frames in parallel and writes them to disk as 8-bit RGB PNGs. */
+    class PngEncoder {
+    private:
+        /* The zlib compression level to use, from 0 (no compression, fastest) to 9 (smallest files, slowest). */
+        int level;
+        /* The threads that filter and deflate the bands, which are borrowed from elsewhere. */
+        Tools::ThreadPool* pool;
+
+        /* The background thread that compresses and writes the last frame given to encode_async(), if any. */
+        std::thread worker;
+        /* The error thrown by the background thread, if any. */
+        std::exception_ptr error;
+        /* The filtered image that the background thread works on, which is kept around for the next frame. */
+        std::vector<unsigned char> pending;
+
+        /* Returns the number of rows in each band for an image of the given size. */
+        uint32_t get_band_rows(uint32_t width, uint32_t height) const;
+        /* Converts the given frame to RGB and filters every row of it, writing the result (including each row's filter type byte) to the given buffer. */
+        void filter(const Frame& frame, unsigned char* filtered, uint32_t band_rows);
+        /* Deflates the given filtered image in bands and writes the resulting PNG to the given path. */
+        void write(const std::string& path, const unsigned char* filtered, uint32_t width, uint32_t height, uint32_t band_rows);
+
+    public:
+        /* The compression level used if none is given, which is zlib's default. */
+        static const constexpr int default_level = 6;
+        /* The minimum number of rows in a band, so that small images aren't cut in pieces too small to compress well. */
+        static const constexpr uint32_t min_band_rows = 16;
+
+        /* Constructor for the PngEncoder class, which takes the compression level (0-9). Encodes on the pool shared by all such encoders, which is only started when the first one is created. */
+        PngEncoder(int level = PngEncoder::default_level);
+        /* Constructor for the PngEncoder class, which takes the pool to encode on (e.g., the renderer's, so no second set of threads competes with it) and the compression level (0-9). The pool should outlive the encoder. */
+        PngEncoder(Tools::ThreadPool& pool, int level = PngEncoder::default_level);
+        /* Copy constructor for the PngEncoder class, which is deleted as we can't copy threads. */
+        PngEncoder(const PngEncoder& other) = delete;
+        /* Move constructor for the PngEncoder class, which is deleted as the background thread refers to the encoder. */
+        PngEncoder(PngEncoder&& other) = delete;
+        /* Destructor for the PngEncoder class, which waits until any background encoding is done. */
+        ~PngEncoder();
+
+        /* Writes the given frame to the given path as PNG, and returns once it's on disk. If an arena is given, the filtered image is stored there instead of on the heap. */
+        void encode(const Frame& frame, const std::string& path, Tools::Arena* scratch = nullptr);
+        /* Writes the given frame to the given path as PNG in the background. Only filtering happens before this returns, so the frame may be overwritten straight after. Waits for the previous background encoding first. */
+        void encode_async(const Frame& frame, const std::string& path);
+        /* Waits until the background encoding (if any) is done. If it failed, re-throws its error here. */
+        void wait();
+
+        /* Returns the pool that is shared by all encoders that aren't given one, starting it with one thread per hardware thread on the first call. */
+        static Tools::ThreadPool& shared_pool();
+
+        /* Returns the compression level used by the encoder. */
+        inline int get_level() const { return this->level; }
+
+        /* Copy assignment operator for the PngEncoder class, which is deleted. */
+        PngEncoder& operator=(const PngEncoder& other) = delete;
+        /* Move assignment operator for the PngEncoder class, which is deleted. */
+        PngEncoder& operator=(PngEncoder&& other) = delete;
+
+    };
+}
+
+#endif
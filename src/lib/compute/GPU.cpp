@@ -4,7 +4,7 @@
  * Created:
  *   16/04/2021, 17:21:49
  * Last edited:
- *   25/05/2021, 18:14:13
+ *   16/10/2026, 01:05:57
  * Auto updated?
  *   Yes
  *
@@ -14,9 +14,16 @@
  *   library.
 **/
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
 #include <CppDebugger.hpp>
 
 #include "compute/ErrorCodes.hpp"
+#include "tools/Common.hpp"
 
 #include "GPU.hpp"
 
@@ -338,6 +345,30 @@ SwapchainInfo::SwapchainInfo(VkPhysicalDevice vk_physical_device, VkSurfaceKHR v
 
 
 
+/***** PIPELINE CACHE HELPERS *****/
+/* @brief Checks whether the given pipeline cache data has been written by the given device, since some drivers don't take kindly to data they didn't write themselves.
+ * @param data The data to check.
+ * @param properties The properties of the device that should have written it.
+ * @return Whether the header of the data matches the device.
+ */
+static bool is_valid_pipeline_cache(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties) {
+    DENTER("is_valid_pipeline_cache");
+
+    // The header is made of the length of the header, its version, the vendor ID, the device ID and the pipeline cache UUID
+    uint32_t header[4];
+    if (data.size() < sizeof(header) + VK_UUID_SIZE) { DRETURN false; }
+    memcpy(header, data.data(), sizeof(header));
+    DRETURN header[0] >= sizeof(header) + VK_UUID_SIZE &&
+            header[1] == (uint32_t) VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            header[2] == properties.vendorID &&
+            header[3] == properties.deviceID &&
+            memcmp(data.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+
+
+
+
 /***** GPU CLASS *****/
 /* Constructor for the GPU class, which takes a list of required extensions to enable on the GPU. */
 GPU::GPU(const Instance& instance, const Tools::Array<const char*>& extensions) :
@@ -407,6 +438,12 @@ GPU::GPU(const Instance& instance, const Tools::Array<const char*>& extensions)
 
 
 
+    // Finally, load whatever pipelines earlier runs compiled on this device
+    DLOG(info, "Loading pipeline cache...");
+    this->create_pipeline_cache(true);
+
+
+
     // We're done initializing!
     DDEDENT;
     DLEAVE;
@@ -449,6 +486,9 @@ GPU::GPU(const GPU& other) :
         vkGetDeviceQueue(this->vk_device, this->vk_physical_device_queue_info.memory(), 0, &this->vk_memory_queue);
     }
 
+    // The new device gets its own pipeline cache, loaded from the same file
+    this->create_pipeline_cache(true);
+
     DLEAVE;
 }
 
@@ -463,10 +503,13 @@ GPU::GPU(GPU&& other) :
     vk_memory_queue(other.vk_memory_queue),
     vk_presentation_queue(other.vk_presentation_queue),
     vk_swapchain_info(other.vk_swapchain_info),
-    vk_extensions(other.vk_extensions)
+    vk_extensions(other.vk_extensions),
+    vk_pipeline_cache(other.vk_pipeline_cache),
+    pipeline_cache_size(other.pipeline_cache_size)
 {
-    // Set the device to a nullptr so the now useless object doesn't destruct it
+    // Set the device & its cache to a nullptr so the now useless object doesn't destruct them
     other.vk_device = nullptr;
+    other.vk_pipeline_cache = nullptr;
 }
 
 /* Destructor for the GPU class. */
@@ -475,7 +518,14 @@ GPU::~GPU() {
     DLOG(info, "Cleaning GPU...");
     DINDENT;
 
-    // Destroy them in reverse order: first, the logical device
+    // Destroy them in reverse order: first, the pipeline cache, which we save for the next run
+    if (this->vk_pipeline_cache != nullptr) {
+        DLOG(info, "Cleaning pipeline cache...");
+        this->save_pipeline_cache();
+        vkDestroyPipelineCache(this->vk_device, this->vk_pipeline_cache, nullptr);
+    }
+
+    // Then, the logical device
     if (this->vk_device != nullptr) {
         DLOG(info, "Cleaning logical device...");
         vkDestroyDevice(this->vk_device, nullptr);
@@ -518,6 +568,124 @@ void GPU::check_present(VkSurfaceKHR vk_surface) {
 
 
 
+/* Creates the pipeline cache of the device, filling it with the one stored on disk if load is true and there is a valid one. */
+void GPU::create_pipeline_cache(bool load) {
+    DENTER("Compute::GPU::create_pipeline_cache");
+
+    // Read the cache from disk, if there is one and it's ours
+    std::vector<char> data;
+    if (load) {
+        std::string path = this->pipeline_cache_path();
+        std::ifstream h(path, std::ios::binary | std::ios::ate);
+        if (h.is_open()) {
+            data.resize((size_t) h.tellg());
+            h.seekg(0);
+            h.read(data.data(), data.size());
+            if (!h || !is_valid_pipeline_cache(data, this->vk_physical_device_properties)) {
+                DLOG(warning, "Ignoring invalid pipeline cache '" + path + "'");
+                data.clear();
+            }
+        }
+    }
+
+    // Create the cache with that as initial data
+    VkPipelineCacheCreateInfo cache_info{};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_info.initialDataSize = data.size();
+    cache_info.pInitialData = data.empty() ? nullptr : data.data();
+    VkResult vk_result;
+    if ((vk_result = vkCreatePipelineCache(this->vk_device, &cache_info, nullptr, &this->vk_pipeline_cache)) != VK_SUCCESS) {
+        DLOG(fatal, "Could not create the pipeline cache: " + vk_error_map[vk_result]);
+    }
+    this->pipeline_cache_size = data.size();
+    DINDENT;
+    DLOG(auxillary, data.empty() ? std::string("Starting with an empty pipeline cache") : "Loaded " + Tools::bytes_to_string(data.size()) + " of cached pipelines");
+    DDEDENT;
+
+    DRETURN;
+}
+
+/* Returns the path of the file where the pipeline cache of this GPU is stored, which is unique to its vendor, device, driver version and pipeline cache UUID. */
+std::string GPU::pipeline_cache_path() const {
+    DENTER("Compute::GPU::pipeline_cache_path");
+
+    const VkPhysicalDeviceProperties& properties = this->vk_physical_device_properties;
+    std::stringstream sstr;
+    sstr << Tools::get_executable_path() << "/" << pipeline_cache_folder << "/pipelines_" << std::hex << std::setfill('0');
+    sstr << std::setw(8) << properties.vendorID << "_" << std::setw(8) << properties.deviceID << "_" << std::setw(8) << properties.driverVersion << "_";
+    for (uint32_t i = 0; i < VK_UUID_SIZE; i++) {
+        sstr << std::setw(2) << (uint32_t) properties.pipelineCacheUUID[i];
+    }
+    sstr << ".bin";
+
+    DRETURN sstr.str();
+}
+
+/* Writes the pipeline cache to disk if it has grown since it was loaded or last saved. Also done automatically when the GPU is destructed. */
+void GPU::save_pipeline_cache() {
+    DENTER("Compute::GPU::save_pipeline_cache");
+
+    // Only bother if there's something new in the cache
+    size_t size = 0;
+    VkResult vk_result;
+    if ((vk_result = vkGetPipelineCacheData(this->vk_device, this->vk_pipeline_cache, &size, nullptr)) != VK_SUCCESS) {
+        DLOG(warning, "Could not get the size of the pipeline cache: " + vk_error_map[vk_result]);
+        DRETURN;
+    }
+    if (size == 0 || size == this->pipeline_cache_size) { DRETURN; }
+    std::vector<char> data(size);
+    if ((vk_result = vkGetPipelineCacheData(this->vk_device, this->vk_pipeline_cache, &size, data.data())) != VK_SUCCESS) {
+        DLOG(warning, "Could not get the pipeline cache: " + vk_error_map[vk_result]);
+        DRETURN;
+    }
+
+    // Write it to a temporary file of our own first, so neither a crash halfway nor another process saving at the same time leaves a broken cache
+    std::string folder = Tools::get_executable_path() + "/" + pipeline_cache_folder;
+    if (!Tools::make_directory(folder)) {
+        DLOG(warning, "Could not create pipeline cache folder '" + folder + "'; not writing pipeline cache.");
+        DRETURN;
+    }
+    std::string path = this->pipeline_cache_path();
+    std::string temp_path = Tools::unique_temp_path(path);
+    std::ofstream h(temp_path, std::ios::binary | std::ios::trunc);
+    if (!h.is_open()) {
+        DLOG(warning, "Could not create pipeline cache '" + temp_path + "'; not writing pipeline cache.");
+        DRETURN;
+    }
+    h.write(data.data(), size);
+    h.close();
+    if (!h) {
+        std::remove(temp_path.c_str());
+        DLOG(warning, "Could not write pipeline cache '" + temp_path + "'; not writing pipeline cache.");
+        DRETURN;
+    }
+
+    // Move it in place. Windows won't rename over an existing file, so remove that first
+    #ifdef _WIN32
+    std::remove(path.c_str());
+    #endif
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        DLOG(warning, "Could not move pipeline cache '" + temp_path + "' to '" + path + "'; not writing pipeline cache.");
+        DRETURN;
+    }
+    this->pipeline_cache_size = size;
+
+    DRETURN;
+}
+
+/* Throws away the pipeline cache in memory (but not on disk), so the next pipelines are compiled from scratch. Mostly useful for benchmarking. */
+void GPU::reset_pipeline_cache() {
+    DENTER("Compute::GPU::reset_pipeline_cache");
+
+    vkDestroyPipelineCache(this->vk_device, this->vk_pipeline_cache, nullptr);
+    this->create_pipeline_cache(false);
+
+    DRETURN;
+}
+
+
+
 /* Swap operator for the GPU class. */
 void Compute::swap(GPU& g1, GPU& g2) {
     DENTER("Compute::swap(GPU)");
@@ -540,6 +708,8 @@ void Compute::swap(GPU& g1, GPU& g2) {
     swap(g1.vk_presentation_queue, g2.vk_presentation_queue);
     swap(g1.vk_swapchain_info, g2.vk_swapchain_info);
     swap(g1.vk_extensions, g2.vk_extensions);
+    swap(g1.vk_pipeline_cache, g2.vk_pipeline_cache);
+    swap(g1.pipeline_cache_size, g2.pipeline_cache_size);
 
     // Done
     DRETURN;
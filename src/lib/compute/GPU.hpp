@@ -4,7 +4,7 @@
  * Created:
  *   16/04/2021, 17:21:54
  * Last edited:
- *   10/05/2021, 14:21:06
+ *   16/10/2026, 01:05:57
  * Auto updated?
  *   Yes
  *
@@ -17,6 +17,7 @@
 #ifndef COMPUTE_GPU_HPP
 #define COMPUTE_GPU_HPP
 
+#include <string>
 #include <vulkan/vulkan.h>
 
 #include "Instance.hpp"
@@ -28,6 +29,8 @@ namespace RayTracer::Compute {
     const Tools::Array<const char*> device_extensions({
         // Nothing lmao
     });
+    /* The folder (relative to the executable) where the pipeline caches of all GPUs are stored. */
+    const std::string pipeline_cache_folder = "cache";
 
 
 
@@ -137,6 +140,14 @@ namespace RayTracer::Compute {
         /* The extensions enabled on the device. */
         Tools::Array<const char*> vk_extensions;
 
+        /* The pipeline cache of the device, which is loaded from disk so pipelines compiled in earlier runs don't have to be compiled again. */
+        VkPipelineCache vk_pipeline_cache;
+        /* The size (in bytes) of the pipeline cache when it was last loaded or saved, so we know when it's worth saving again. */
+        size_t pipeline_cache_size;
+
+        /* Creates the pipeline cache of the device, filling it with the one stored on disk if load is true and there is a valid one. */
+        void create_pipeline_cache(bool load);
+
     public:
         /* Constructor for the GPU class, which takes a list of required extensions to enable on the GPU. */
         GPU(const Instance& instance, const Tools::Array<const char*>& extensions = device_extensions);
@@ -155,6 +166,13 @@ namespace RayTracer::Compute {
         /* Updates the internal queue info on whether or not the GPU can present to the given surface. */
        void check_present(VkSurfaceKHR vk_surface);
 
+        /* Returns the path of the file where the pipeline cache of this GPU is stored, which is unique to its vendor, device, driver version and pipeline cache UUID. */
+        std::string pipeline_cache_path() const;
+        /* Writes the pipeline cache to disk if it has grown since it was loaded or last saved. Also done automatically when the GPU is destructed. */
+        void save_pipeline_cache();
+        /* Throws away the pipeline cache in memory (but not on disk), so the next pipelines are compiled from scratch. Mostly useful for benchmarking. */
+        void reset_pipeline_cache();
+
         /* Returns the name of the chosen GPU. */
         inline std::string name() const { return std::string(this->vk_physical_device_properties.deviceName); }
         /* Returns the queue information of the chosen GPU. */
@@ -170,6 +188,8 @@ namespace RayTracer::Compute {
         inline VkDevice device() const { return this->vk_device; }
         /* Implicitly provides (read-only) access to the internal vk_device object. */
         inline operator VkDevice() const { return this->vk_device; }
+        /* Explicitly provides (read-only) access to the internal vk_pipeline_cache object, which should be given to every pipeline created on this device. */
+        inline VkPipelineCache pipeline_cache() const { return this->vk_pipeline_cache; }
 
         /* Explicitly provides (read-only) access to the internal vk_compute_queue object. */
         inline VkQueue compute_queue() const { return this->vk_compute_queue; }
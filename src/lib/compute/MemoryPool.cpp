@@ -4,7 +4,7 @@
  * Created:
  *   25/04/2021, 11:36:42
  * Last edited:
- *   25/05/2021, 18:14:13
+ *   16/10/2026, 01:21:06
  * Auto updated?
  *   Yes
  *
@@ -14,6 +14,7 @@
 **/
 
 #include <limits>
+#include <algorithm>
 #include <CppDebugger.hpp>
 
 #include "ErrorCodes.hpp"
@@ -295,13 +296,16 @@ Image::Image(ImageHandle handle, VkImage image, VkExtent2D vk_extent, VkFormat v
 
 
 /***** MEMORYPOOL CLASS *****/
-/* Constructor for the MemoryPool class, which takes a device to allocate on, the type of memory we will allocate on and the total size of the allocated block. */
+/* Constructor for the MemoryPool class, which takes a device to allocate on, the type of memory we will allocate on and the size of its chunks. The pool starts with a single chunk, and adds more as they fill up. */
 MemoryPool::MemoryPool(const GPU& gpu, uint32_t memory_type, VkDeviceSize n_bytes, VkMemoryPropertyFlags memory_properties) :
     gpu(gpu),
     vk_memory_type(memory_type),
-    vk_memory_size(n_bytes),
+    vk_chunk_size(n_bytes),
+    vk_memory_size(0),
     vk_memory_properties(memory_properties),
-    vk_free_blocks({ MemoryPool::FreeBlock({ 0, this->vk_memory_size }) })
+    vk_used_size(0),
+    vk_high_water_size(0),
+    vk_used_blocks({ nullptr })
 {
     DENTER("Compute::MemoryPool::MemoryPool");
     DLOG(info, "Initializing MemoryPool...");
@@ -328,16 +332,9 @@ MemoryPool::MemoryPool(const GPU& gpu, uint32_t memory_type, VkDeviceSize n_byte
     
 
 
-    // Allocate the block of memory that we shall use
+    // Allocate the first chunk of memory that we shall use
     DLOG(info, "Allocating memory on device '" + gpu.name() + "'...");
-    VkMemoryAllocateInfo allocate_info;
-    populate_allocate_info(allocate_info, memory_type, n_bytes);
-
-    // Do the allocation
-    VkResult vk_result;
-    if ((vk_result = vkAllocateMemory(this->gpu, &allocate_info, nullptr, &this->vk_memory)) != VK_SUCCESS) {
-        DLOG(fatal, "Could not allocate memory on device: " + vk_error_map[vk_result]);
-    }
+    this->add_chunk(this->vk_chunk_size, false);
 
 
 
@@ -349,21 +346,17 @@ MemoryPool::MemoryPool(const GPU& gpu, uint32_t memory_type, VkDeviceSize n_byte
 MemoryPool::MemoryPool(const MemoryPool& other) :
     gpu(other.gpu),
     vk_memory_type(other.vk_memory_type),
-    vk_memory_size(other.vk_memory_size),
+    vk_chunk_size(other.vk_chunk_size),
+    vk_memory_size(0),
     vk_memory_properties(other.vk_memory_properties),
-    vk_free_blocks({ MemoryPool::FreeBlock({ 0, this->vk_memory_size }) })
+    vk_used_size(0),
+    vk_high_water_size(0),
+    vk_used_blocks({ nullptr })
 {
     DENTER("MemoryPool::MemoryPool(copy)");
 
-    // Allocate a new block of memory that we shall use, with the proper size
-    VkMemoryAllocateInfo allocate_info;
-    populate_allocate_info(allocate_info, this->vk_memory_type, this->vk_memory_size);
-
-    // Do the allocation
-    VkResult vk_result;
-    if ((vk_result = vkAllocateMemory(this->gpu, &allocate_info, nullptr, &this->vk_memory)) != VK_SUCCESS) {
-        DLOG(fatal, "Could not allocate memory on device: " + vk_error_map[vk_result]);
-    }
+    // Allocate a new first chunk of memory that we shall use, with the proper size
+    this->add_chunk(this->vk_chunk_size, false);
 
     // Do not copy handles with us, as that doesn't really make a whole lotta sense
 
@@ -373,16 +366,20 @@ MemoryPool::MemoryPool(const MemoryPool& other) :
 /* Move constructor for the MemoryPool class. */
 MemoryPool::MemoryPool(MemoryPool&& other):
     gpu(other.gpu),
-    vk_memory(other.vk_memory),
+    vk_chunks(std::move(other.vk_chunks)),
     vk_memory_type(other.vk_memory_type),
+    vk_chunk_size(other.vk_chunk_size),
     vk_memory_size(other.vk_memory_size),
     vk_memory_properties(other.vk_memory_properties),
+    vk_used_size(other.vk_used_size),
+    vk_high_water_size(other.vk_high_water_size),
     vk_used_blocks(std::move(other.vk_used_blocks)),
-    vk_free_blocks(std::move(other.vk_free_blocks))
+    vk_free_handles(std::move(other.vk_free_handles))
 {
-    // Set the other's memory to nullptr to avoid deallocation
-    other.vk_memory = nullptr;
-    other.vk_used_blocks.clear();
+    // Clear the other's chunks & blocks to avoid deallocation
+    other.vk_chunks.clear();
+    other.vk_used_blocks.assign(1, nullptr);
+    other.vk_free_handles.clear();
 }
 
 /* Destructor for the MemoryPool class. */
@@ -392,25 +389,29 @@ MemoryPool::~MemoryPool() {
     DINDENT;
 
     // Delete all buffers
-    if (this->vk_used_blocks.size() > 0) {
+    if (this->allocations() > 0) {
         DLOG(info, "Deallocating buffers...");
-        for (const std::pair<MemoryHandle, UsedBlock*>& p : this->vk_used_blocks) {
+        for (UsedBlock* block : this->vk_used_blocks) {
+            if (block == nullptr) { continue; }
+
             // Either destroy the buffer or the image
-            if (p.second->type == MemoryBlockType::buffer) {
-                vkDestroyBuffer(this->gpu, ((BufferBlock*) p.second)->vk_buffer, nullptr);
-            } else if (p.second->type == MemoryBlockType::image) {
-                vkDestroyImage(this->gpu, ((ImageBlock*) p.second)->vk_image, nullptr);
+            if (block->type == MemoryBlockType::buffer) {
+                vkDestroyBuffer(this->gpu, ((BufferBlock*) block)->vk_buffer, nullptr);
+            } else if (block->type == MemoryBlockType::image) {
+                vkDestroyImage(this->gpu, ((ImageBlock*) block)->vk_image, nullptr);
             }
 
             // Then destroy the block itself
-            delete p.second;
+            delete block;
         }
     }
 
     // Deallocate the allocated memory
-    if (this->vk_memory != nullptr) {
+    if (this->vk_chunks.size() > 0) {
         DLOG(info, "Deallocating device memory...");
-        vkFreeMemory(this->gpu, this->vk_memory, nullptr);
+        for (uint32_t i = 0; i < this->vk_chunks.size(); i++) {
+            if (this->vk_chunks[i] != nullptr) { this->release_chunk(i); }
+        }
     }
 
     DDEDENT;
@@ -419,88 +420,129 @@ MemoryPool::~MemoryPool() {
 
 
 
-/* Private helper function that actually performs memory allocation. Returns a reference to a UsedBlock that describes the block allocated. */
-MemoryHandle MemoryPool::allocate_memory(MemoryBlockType type, VkDeviceSize n_bytes, const VkMemoryRequirements& mem_requirements) {
-    DENTER("allocate_memory");
+/* Private helper function that returns the block behind the given handle, throwing errors if there's no such block. */
+MemoryPool::UsedBlock* MemoryPool::get_block(MemoryHandle handle) const {
+    DENTER("Compute::MemoryPool::get_block");
 
-    // Pick a suitable memory location for this block in the array of used blocks; either as a new block or use the location of a previously allocated one
-    MemoryHandle result = 0;
-    bool unique = false;
-    while (!unique) {
-        unique = true;
-        for (const std::pair<MemoryHandle, UsedBlock*>& p : this->vk_used_blocks) {
-            if (result == MemoryPool::NullHandle || result == p.first) {
-                // If result is the maximum value, then throw an error
-                if (result == std::numeric_limits<MemoryHandle>::max()) {
-                    DLOG(fatal, "Buffer handle overflow; cannot allocate more buffers.");
-                }
-
-                // Otherwise, increment and re-try
-                ++result;
-                unique = false;
-                break;
-            }
+    if (handle >= this->vk_used_blocks.size() || this->vk_used_blocks[handle] == nullptr) {
+        DLOG(fatal, "Object with handle '" + std::to_string(handle) + "' does not exist.");
+    }
+
+    DRETURN this->vk_used_blocks[handle];
+}
+
+/* Private helper function that allocates a new chunk of the given size on the GPU, returning its index. */
+uint32_t MemoryPool::add_chunk(VkDeviceSize n_bytes, bool dedicated) {
+    DENTER("Compute::MemoryPool::add_chunk");
+
+    // Do the allocation
+    VkMemoryAllocateInfo allocate_info;
+    populate_allocate_info(allocate_info, this->vk_memory_type, n_bytes);
+    VkResult vk_result;
+    VkDeviceMemory vk_memory;
+    if ((vk_result = vkAllocateMemory(this->gpu, &allocate_info, nullptr, &vk_memory)) != VK_SUCCESS) {
+        DLOG(fatal, "Could not allocate " + Tools::bytes_to_string(n_bytes) + " of memory on device (pool already has " + Tools::bytes_to_string(this->vk_memory_size) + "): " + vk_error_map[vk_result]);
+    }
+    this->vk_memory_size += n_bytes;
+
+    // Store it in the first unused spot (there are only ever a handful of chunks)
+    uint32_t result = 0;
+    while (result < this->vk_chunks.size() && this->vk_chunks[result] != nullptr) { ++result; }
+    if (result == this->vk_chunks.size()) { this->vk_chunks.push_back(nullptr); }
+    this->vk_chunks[result] = new Chunk({ vk_memory, dedicated, Tools::BlockAllocator(n_bytes) });
+
+    DRETURN result;
+}
+
+/* Private helper function that frees the chunk with the given index on the GPU. */
+void MemoryPool::release_chunk(uint32_t chunk) {
+    DENTER("Compute::MemoryPool::release_chunk");
+
+    Chunk* c = this->vk_chunks[chunk];
+    vkFreeMemory(this->gpu, c->vk_memory, nullptr);
+    this->vk_memory_size -= c->allocator.capacity();
+    delete c;
+    this->vk_chunks[chunk] = nullptr;
+
+    DRETURN;
+}
+
+/* Private helper function that finds a range for the given memory requirements in the regular chunks, adding a chunk if none has room. Returns the index of the chunk. */
+uint32_t MemoryPool::place_block(const VkMemoryRequirements& mem_requirements, Tools::BlockAllocator::Range& range) {
+    DENTER("Compute::MemoryPool::place_block");
+
+    // Large blocks get a chunk of their own, so they neither waste nor fragment the regular chunks
+    if (mem_requirements.size > this->vk_chunk_size / MemoryPool::dedicated_divisor) {
+        // ...unless the first chunk is still empty, which happens for pools that are sized for a single buffer
+        Chunk* first = this->vk_chunks[0];
+        if (first->allocator.allocations() == 0) {
+            range = first->allocator.allocate(mem_requirements.size, mem_requirements.alignment);
+            if (range != Tools::BlockAllocator::NullRange) { DRETURN 0; }
         }
+
+        uint32_t chunk = this->add_chunk(mem_requirements.size, true);
+        range = this->vk_chunks[chunk]->allocator.allocate(mem_requirements.size, mem_requirements.alignment);
+        DRETURN chunk;
     }
-    // Reserve space in our map
-    this->vk_used_blocks.insert(std::make_pair(result, type == MemoryBlockType::buffer ? (UsedBlock*) new BufferBlock() : (UsedBlock*) new ImageBlock()));
-    UsedBlock* block = this->vk_used_blocks.at(result);
+
+    // Otherwise, try the regular chunks in order, so the later ones can empty out and be released
+    for (uint32_t i = 0; i < this->vk_chunks.size(); i++) {
+        Chunk* c = this->vk_chunks[i];
+        if (c == nullptr || c->dedicated) { continue; }
+        range = c->allocator.allocate(mem_requirements.size, mem_requirements.alignment);
+        if (range != Tools::BlockAllocator::NullRange) { DRETURN i; }
+    }
+
+    // None had room, so grow the pool with another chunk, which always fits the block
+    DLOG(info, "Growing memory pool with another chunk of " + Tools::bytes_to_string(this->vk_chunk_size) + "...");
+    uint32_t chunk = this->add_chunk(this->vk_chunk_size, false);
+    range = this->vk_chunks[chunk]->allocator.allocate(mem_requirements.size, mem_requirements.alignment);
+    if (range == Tools::BlockAllocator::NullRange) {
+        DLOG(fatal, "Could not allocate new buffer: need " + std::to_string(mem_requirements.size) + " bytes with an alignment of " + std::to_string(mem_requirements.alignment) + ", which doesn't fit in a chunk of " + std::to_string(this->vk_chunk_size) + " bytes");
+    }
+    DRETURN chunk;
+}
+
+/* Private helper function that actually performs memory allocation. Returns a reference to a UsedBlock that describes the block allocated. */
+MemoryHandle MemoryPool::allocate_memory(MemoryBlockType type, VkDeviceSize n_bytes, const VkMemoryRequirements& mem_requirements) {
+    DENTER("allocate_memory");
 
     #ifndef NDEBUG
-    // Next, make sure the given memory requirements are aligning with our internal type
+    // First, make sure the given memory requirements are aligning with our internal type
     if (!(mem_requirements.memoryTypeBits & (1 << this->vk_memory_type))) {
         DLOG(fatal, "Buffer is not compatible with this memory pool.");
     }
     #endif
 
-    // Next, we find the first free block available of at least the required size
-    VkDeviceSize offset;
-    VkDeviceSize total_free = 0;
-    bool found = false;
-    for (size_t i = 0; i < this->vk_free_blocks.size(); i++) {
-        // Compute how many bytes of alignment we need to take into account when looking at where this block starts
-        VkDeviceSize align_bytes = mem_requirements.alignment - this->vk_free_blocks[i].start % mem_requirements.alignment;
-        if (align_bytes == mem_requirements.alignment) { align_bytes = 0; }
-
-        // Check if this block (aligned) is large enough
-        if (this->vk_free_blocks[i].length >= align_bytes + mem_requirements.size) {
-            // This block has enough memory; mark its starting position as the used one
-            offset = align_bytes + this->vk_free_blocks[i].start;
-
-            // Shrink the block to mark this spot as used
-            this->vk_free_blocks[i].start += align_bytes + mem_requirements.size;
-            this->vk_free_blocks[i].length -= align_bytes + mem_requirements.size;
-
-            // If the resulting space is no bytes, then remove the free block
-            if (this->vk_free_blocks[i].length == 0) {
-                this->vk_free_blocks.erase(i);
-            }
-
-            // Done
-            found = true;
-            break;
+    // Next, find a free range in one of the chunks that's large enough
+    Tools::BlockAllocator::Range range;
+    uint32_t chunk = this->place_block(mem_requirements, range);
+
+    // Pick a handle for the block; either a previously deallocated one or a new one at the end of the table
+    MemoryHandle result;
+    if (!this->vk_free_handles.empty()) {
+        result = this->vk_free_handles.back();
+        this->vk_free_handles.pop_back();
+    } else {
+        if (this->vk_used_blocks.size() > (size_t) std::numeric_limits<MemoryHandle>::max()) {
+            DLOG(fatal, "Buffer handle overflow; cannot allocate more buffers.");
         }
-
-        // Keep track of how many free bytes there are in total
-        total_free += this->vk_free_blocks[i].length;
-    }
-    if (!found) {
-        // No memory was available; is this due to memory or to bad fragmentation?
-        #ifdef NDEBUG
-        DLOG(fatal, "Could not allocate new buffer");
-        #else
-        if (mem_requirements.size > total_free) {
-            DLOG(fatal, "Could not allocate new buffer: not enough space left in pool (need " + std::to_string(mem_requirements.size) + " bytes, but " + std::to_string(total_free) + " bytes free)");
-        } else {
-            DLOG(fatal, "Could not allocate new buffer: no large enough block found, but we do have enough memory available; call defrag() first");
-        }
-        #endif
+        result = (MemoryHandle) this->vk_used_blocks.size();
+        this->vk_used_blocks.push_back(nullptr);
     }
+    UsedBlock* block = type == MemoryBlockType::buffer ? (UsedBlock*) new BufferBlock() : (UsedBlock*) new ImageBlock();
+    this->vk_used_blocks[result] = block;
 
     // Store the chosen parameters in the buffer for easy re-creation
-    block->start = offset;
+    block->start = this->vk_chunks[chunk]->allocator.offset(range);
     block->length = n_bytes;
     block->req_length = mem_requirements.size;
+    block->chunk = chunk;
+    block->range = range;
+
+    // Keep track of how much we use
+    this->vk_used_size += mem_requirements.size;
+    this->vk_high_water_size = std::max(this->vk_high_water_size, this->vk_used_size);
 
     // We're done, so return the block for further initialization of the image or buffer
     DRETURN result;
@@ -532,7 +574,7 @@ BufferHandle MemoryPool::allocate_buffer_h(VkDeviceSize n_bytes, VkBufferUsageFl
     BufferBlock* block = (BufferBlock*) this->vk_used_blocks.at(result);
 
     // With the block, bind the memory to the new buffer
-    if ((vk_result = vkBindBufferMemory(this->gpu, buffer, this->vk_memory, block->start)) != VK_SUCCESS) {
+    if ((vk_result = vkBindBufferMemory(this->gpu, buffer, this->vk_chunks[block->chunk]->vk_memory, block->start)) != VK_SUCCESS) {
         DLOG(fatal, "Could not bind buffer memory: " + vk_error_map[vk_result]);
     }
 
@@ -576,7 +618,7 @@ ImageHandle MemoryPool::allocate_image_h(uint32_t width, uint32_t height, VkForm
     ImageBlock* block = (ImageBlock*) this->vk_used_blocks.at(result);
 
     // Bind that memory to the image
-    if ((vk_result = vkBindImageMemory(this->gpu, image, this->vk_memory, block->start)) != VK_SUCCESS) {
+    if ((vk_result = vkBindImageMemory(this->gpu, image, this->vk_chunks[block->chunk]->vk_memory, block->start)) != VK_SUCCESS) {
         DLOG(fatal, "Could not bind image memory: " + vk_error_map[vk_result]);
     }
 
@@ -598,127 +640,28 @@ void MemoryPool::deallocate(MemoryHandle handle) {
     DENTER("Compute::MemoryPool::deallocate");
 
     // First, try to fetch the given buffer
-    std::unordered_map<MemoryHandle, UsedBlock*>::iterator iter = this->vk_used_blocks.find(handle);
-    if (iter == this->vk_used_blocks.end()) {
-        DLOG(fatal, "Object with handle '" + std::to_string(handle) + "' does not exist.");
-    }
+    UsedBlock* block = this->get_block(handle);
 
-    // Copy the block...
-    UsedBlock* block = (*iter).second;
-    // ...then safely delete it from the list
+    // Destroy the Vulkan object behind it
     if (block->type == MemoryBlockType::buffer) {
         vkDestroyBuffer(this->gpu, ((BufferBlock*) block)->vk_buffer, nullptr);
     } else if (block->type == MemoryBlockType::image) {
         vkDestroyImage(this->gpu, ((ImageBlock*) block)->vk_image, nullptr);
     }
-    this->vk_used_blocks.erase(iter);
-
-    // Get the start & offset of the buffer
-    VkDeviceSize buffer_start = block->start;
-    VkDeviceSize buffer_length = block->req_length;
-
-    // Generate a new free block for the memory released by this buffer. We insert it sorted.
-    bool inserted = false;
-    for (size_t i = 0; i < this->vk_free_blocks.size(); i++) {
-        // Get the start & offset for this free block
-        VkDeviceSize free_start = this->vk_free_blocks[i].start;
-        VkDeviceSize free_length = this->vk_free_blocks[i].length;
-
-        #ifndef NDEBUG
-        // Sanity check
-        if (free_start == buffer_start) {
-            DLOG(fatal, "Free block " + std::to_string(i) + " has same offset as previously allocated buffer");
-        }
-        #endif
 
-        // Check if we should insert it here
-        if (free_start > buffer_start) {
-            // It should become the new i'th block
+    // Give its memory back to the chunk, which merges it with any free neighbours
+    Chunk* chunk = this->vk_chunks[block->chunk];
+    chunk->allocator.deallocate(block->range);
+    this->vk_used_size -= block->req_length;
 
-            #ifndef NDEBUG
-
-            // Couple of more sanity checks
-            if (i > 0) {
-                // Sanity check the previous buffer as well
-                VkDeviceSize free_m1_start = this->vk_free_blocks[i - 1].start;
-                VkDeviceSize free_m1_length = this->vk_free_blocks[i - 1].length;
-
-                if (i > 0 && free_m1_start + free_m1_length > buffer_start) {
-                    DLOG(fatal, "Free block " + std::to_string(i - 1) + " overlaps with previously allocated buffer (previous neighbour)");
-                } else if (i > 0 && free_m1_start + free_m1_length > free_start) {
-                    DLOG(fatal, "Free blocks " + std::to_string(i - 1) + " and " + std::to_string(i) + " overlap");
-                }
-            }
-            // Sanity check the current buffer
-            if (buffer_start + buffer_length > free_start) {
-                DLOG(fatal, "Free block " + std::to_string(i) + " overlaps with previously allocated buffer (next neighbour)");
-            } 
-            
-            #endif
-
-            // However, first check if it makes more sense to merge with its neighbours first
-            if (i > 0) {
-                VkDeviceSize free_m1_start = this->vk_free_blocks[i - 1].start;
-                VkDeviceSize free_m1_length = this->vk_free_blocks[i - 1].length;
-
-                if (free_m1_start + free_m1_length == buffer_start && buffer_start + buffer_length == free_start) {
-                    // The buffer happens to precisely fill the gap between two blocks; merge all memory into one free block
-                    this->vk_free_blocks[i - 1].length += buffer_length + free_length;
-                    this->vk_free_blocks.erase(i);
-                    inserted = true;
-                } else if (free_m1_start + free_m1_length == buffer_start) {
-                    // The buffer is only mergeable with the previous block
-                    this->vk_free_blocks[i - 1].length += buffer_length;
-                    inserted = true;
-                }
-            }
-
-            // Examine the next block in its onesy 
-            if (buffer_start + buffer_length == free_start) {
-                // The buffer is only mergeable with the next block
-                this->vk_free_blocks[i].start -= buffer_length;
-                this->vk_free_blocks[i].length += buffer_length;
-                inserted = true;
-            }
-            
-            // If not yet inserted, then we want to add a new free block
-            if (!inserted) {
-                // Not mergeable; insert a new block by moving all blocks to the right
-                this->vk_free_blocks.resize(this->vk_free_blocks.size() + 1);
-                for (size_t j = i; j < this->vk_free_blocks.size() - 1; j++) {
-                    this->vk_free_blocks[j + 1] = this->vk_free_blocks[j];
-                }
-
-                // With space created, insert it
-                this->vk_free_blocks[i] = MemoryPool::FreeBlock({ buffer_start, buffer_length });
-                inserted = true;
-            }
-
-            // We always want to stop, though
-            break;
-        }
+    // Release the chunk if that made it empty, except for the first one so that a pool that's used on and off doesn't keep allocating memory
+    if (block->chunk > 0 && chunk->allocator.allocations() == 0) {
+        this->release_chunk(block->chunk);
     }
 
-    // If we did not insert, then append it as a free block at the end
-    if (!inserted) {
-        // If there is a previous block and its mergeable, do that
-        if (this->vk_free_blocks.size() > 0) {
-            VkDeviceSize free_start = this->vk_free_blocks[this->vk_free_blocks.size() - 1].start;
-            VkDeviceSize free_length = this->vk_free_blocks[this->vk_free_blocks.size() - 1].length;
-
-            if (free_start + free_length == buffer_start) {
-                // It matches; merge the old block
-                this->vk_free_blocks[this->vk_free_blocks.size() - 1].length += buffer_length;
-                inserted = true;
-            }
-        }
-
-        // If we didn't merge it, append it as a new block
-        if (!inserted) {
-            this->vk_free_blocks.push_back(MemoryPool::FreeBlock({ buffer_start, buffer_length }));
-            inserted = true;
-        }
-    }
+    // Free the handle so it can be reused
+    this->vk_used_blocks[handle] = nullptr;
+    this->vk_free_handles.push_back(handle);
 
     // Deallocate the block itself
     delete block;
@@ -729,17 +672,20 @@ void MemoryPool::deallocate(MemoryHandle handle) {
 
 
 
-/* Defragements the entire pool, aligning all buffers next to each other in memory to create a maximally sized free block. Note that existing handles will remain valid. */
+/* Defragements the entire pool, aligning all buffers next to each other in memory to create maximally sized free blocks and releasing the chunks that end up empty. Note that existing handles will remain valid, but the contents of the buffers are not. */
 void MemoryPool::defrag() {
     DENTER("Compute::MemoryPool::defrag");
 
-    // We loop through all internal blocks
+    // Start with all regular chunks free again; since they're then a single free range each, the blocks are placed next to each other in the first chunks
+    for (Chunk* chunk : this->vk_chunks) {
+        if (chunk != nullptr && !chunk->dedicated) { chunk->allocator.reset(); }
+    }
+
+    // We loop through all internal blocks, except those with a chunk of their own
     VkResult vk_result;
     VkMemoryRequirements mem_requirements;
-    VkDeviceSize offset = 0;
-    for (const std::pair<MemoryHandle, UsedBlock*>& p : this->vk_used_blocks) {
-        // Get a reference to the block
-        UsedBlock* block = this->vk_used_blocks.at(p.first);
+    for (UsedBlock* block : this->vk_used_blocks) {
+        if (block == nullptr || this->vk_chunks[block->chunk]->dedicated) { continue; }
 
         // Switch based on the type of block what to do next
         if (block->type == MemoryBlockType::buffer) {
@@ -761,13 +707,12 @@ void MemoryPool::defrag() {
             // Get the memory requirements for this new buffer
             vkGetBufferMemoryRequirements(this->gpu, bblock->vk_buffer, &mem_requirements);
 
-            // Be sure that we still make it; due to aligning we might get a different size
-            if (offset + mem_requirements.size > this->vk_memory_size) {
-                DLOG(fatal, "Could not defrag buffer: memory requirements changed (need " + std::to_string(mem_requirements.size) + " bytes, but " + std::to_string(this->vk_memory_size) + " bytes free)");
-            }
+            // Place it again; due to aligning we might get a different size, but that's fine as the pool grows if needed
+            block->chunk = this->place_block(mem_requirements, block->range);
+            block->start = this->vk_chunks[block->chunk]->allocator.offset(block->range);
 
             // Bind new memory for, at the start of this index.
-            if ((vk_result = vkBindBufferMemory(this->gpu, bblock->vk_buffer, this->vk_memory, offset)) != VK_SUCCESS) {
+            if ((vk_result = vkBindBufferMemory(this->gpu, bblock->vk_buffer, this->vk_chunks[block->chunk]->vk_memory, block->start)) != VK_SUCCESS) {
                 DLOG(fatal, "Could not re-bind memory to buffer: " + vk_error_map[vk_result]);
             }
             
@@ -790,30 +735,28 @@ void MemoryPool::defrag() {
             // Get the memory requirements for this new image
             vkGetImageMemoryRequirements(this->gpu, iblock->vk_image, &mem_requirements);
 
-            // Be sure that we still make it; due to aligning we might get a different size
-            if (offset + mem_requirements.size > this->vk_memory_size) {
-                DLOG(fatal, "Could not defrag image: memory requirements changed (need " + std::to_string(mem_requirements.size) + " bytes, but " + std::to_string(this->vk_memory_size) + " bytes free)");
-            }
+            // Place it again; due to aligning we might get a different size, but that's fine as the pool grows if needed
+            block->chunk = this->place_block(mem_requirements, block->range);
+            block->start = this->vk_chunks[block->chunk]->allocator.offset(block->range);
 
             // Bind new memory for, at the start of this index.
-            if ((vk_result = vkBindImageMemory(this->gpu, iblock->vk_image, this->vk_memory, offset)) != VK_SUCCESS) {
+            if ((vk_result = vkBindImageMemory(this->gpu, iblock->vk_image, this->vk_chunks[block->chunk]->vk_memory, block->start)) != VK_SUCCESS) {
                 DLOG(fatal, "Could not re-bind memory to image: " + vk_error_map[vk_result]);
             }
 
         }
 
-        // Finally, update the offset & possible size in the block
-        block->start = offset;
+        // Finally, update the possible size in the block
+        this->vk_used_size += mem_requirements.size - block->req_length;
+        this->vk_high_water_size = std::max(this->vk_high_water_size, this->vk_used_size);
         block->req_length = mem_requirements.size;
-
-        // Increment the offset for the next buffer
-        offset += mem_requirements.size;
     }
 
-    // Once done, re-initialize the list of free blocks
-    this->vk_free_blocks.clear();
-    if (offset < this->vk_memory_size) {
-        this->vk_free_blocks.push_back(MemoryPool::FreeBlock({ offset, this->vk_memory_size - offset }));
+    // Release the regular chunks that are now empty
+    for (uint32_t i = 1; i < this->vk_chunks.size(); i++) {
+        if (this->vk_chunks[i] != nullptr && this->vk_chunks[i]->allocator.allocations() == 0) {
+            this->release_chunk(i);
+        }
     }
 
     // Done
@@ -822,6 +765,36 @@ void MemoryPool::defrag() {
 
 
 
+/* Returns the number of chunks currently allocated on the GPU, including dedicated ones. */
+uint32_t MemoryPool::chunks() const {
+    uint32_t result = 0;
+    for (const Chunk* chunk : this->vk_chunks) {
+        if (chunk != nullptr) { ++result; }
+    }
+    return result;
+}
+
+/* Returns the size of the largest free block in the regular chunks, which is about the largest buffer that still fits without adding a chunk. */
+VkDeviceSize MemoryPool::largest_free_block() const {
+    VkDeviceSize result = 0;
+    for (const Chunk* chunk : this->vk_chunks) {
+        if (chunk != nullptr && !chunk->dedicated) { result = std::max(result, (VkDeviceSize) chunk->allocator.largest_free_range()); }
+    }
+    return result;
+}
+
+/* Returns how fragmented the free memory in the regular chunks is, as the fraction of it that's not in the largest free block. */
+double MemoryPool::fragmentation() const {
+    VkDeviceSize n_free = 0;
+    for (const Chunk* chunk : this->vk_chunks) {
+        if (chunk != nullptr && !chunk->dedicated) { n_free += chunk->allocator.capacity() - chunk->allocator.used(); }
+    }
+    if (n_free == 0) { return 0.0; }
+    return 1.0 - (double) this->largest_free_block() / (double) n_free;
+}
+
+
+
 /* Swap operator for the MemoryPool class. */
 void Compute::swap(MemoryPool& mp1, MemoryPool& mp2) {
     using std::swap;
@@ -836,12 +809,15 @@ void Compute::swap(MemoryPool& mp1, MemoryPool& mp2) {
     #endif
 
     // Swap EVERYTHING but the GPU
-    swap(mp1.vk_memory, mp2.vk_memory);
+    swap(mp1.vk_chunks, mp2.vk_chunks);
     swap(mp1.vk_memory_type, mp2.vk_memory_type);
+    swap(mp1.vk_chunk_size, mp2.vk_chunk_size);
     swap(mp1.vk_memory_size, mp2.vk_memory_size);
     swap(mp1.vk_memory_properties, mp2.vk_memory_properties),
+    swap(mp1.vk_used_size, mp2.vk_used_size);
+    swap(mp1.vk_high_water_size, mp2.vk_high_water_size);
     swap(mp1.vk_used_blocks, mp2.vk_used_blocks);
-    swap(mp1.vk_free_blocks, mp2.vk_free_blocks);
+    swap(mp1.vk_free_handles, mp2.vk_free_handles);
 
     DRETURN;
 }
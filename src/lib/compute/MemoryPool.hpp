@@ -4,7 +4,7 @@
  * Created:
  *   25/04/2021, 11:36:35
  * Last edited:
- *   23/05/2021, 20:37:45
+ *   16/10/2026, 01:19:07
  * Auto updated?
  *   Yes
  *
@@ -17,10 +17,11 @@
 #define COMPUTE_MEMORY_POOL_HPP
 
 #include <vulkan/vulkan.h>
-#include <unordered_map>
+#include <vector>
 
 #include "CommandPool.hpp"
 #include "tools/Array.hpp"
+#include "tools/BlockAllocator.hpp"
 
 #include "GPU.hpp"
 
@@ -210,6 +211,10 @@ namespace RayTracer::Compute {
             VkDeviceSize length;
             /* The actual size of the block, as reported by memsize.size. */
             VkDeviceSize req_length;
+            /* The chunk of the pool's memory that the block lives in. */
+            uint32_t chunk;
+            /* The range of the chunk that the block occupies. */
+            Tools::BlockAllocator::Range range;
 
             /* Constructor for the UsedBlock struct, which requires at least a type. */
             UsedBlock(MemoryBlockType type): type(type) {}
@@ -248,27 +253,35 @@ namespace RayTracer::Compute {
             /* Constructor for the ImageBlock struct. */
             ImageBlock(): UsedBlock(MemoryBlockType::image) {}
         };
-        /* Internal struct used to keep track of free memory blocks. */
-        struct FreeBlock {
-            /* Pointer to the start of the block. */
-            VkDeviceSize start;
-            /* Length of the free block, in bytes. */
-            VkDeviceSize length;  
+        /* Internal struct used to represent a single block of memory allocated on the GPU, which the pool hands out ranges of. */
+        struct Chunk {
+            /* The allocated memory on the GPU. */
+            VkDeviceMemory vk_memory;
+            /* Whether the chunk is dedicated to a single large buffer or image, in which case it's released together with it. */
+            bool dedicated;
+            /* Keeps track of which parts of the chunk are free, and hands them out in constant time. */
+            Tools::BlockAllocator allocator;
         };
 
-        /* The allocated memory on the GPU. */
-        VkDeviceMemory vk_memory;
+        /* The chunks of memory allocated on the GPU. Released chunks leave a nullptr, so the chunk indices in the blocks stay valid. */
+        std::vector<Chunk*> vk_chunks;
         /* The type of memory we allocated for this. */
         uint32_t vk_memory_type;
-        /* The total size of the allocated memory block. */
+        /* The size of the regular chunks, which is also the size of the first chunk. */
+        VkDeviceSize vk_chunk_size;
+        /* The total size of all chunks currently allocated. */
         VkDeviceSize vk_memory_size;
         /* The memory properties assigned to this buffer. */
         VkMemoryPropertyFlags vk_memory_properties;
+        /* The number of bytes currently allocated for buffers and images. */
+        VkDeviceSize vk_used_size;
+        /* The largest number of bytes ever allocated for buffers and images at once. */
+        VkDeviceSize vk_high_water_size;
 
-        /* List of all allocated buffers in this pool. */
-        std::unordered_map<MemoryHandle, UsedBlock*> vk_used_blocks;
-        /* List of pointers to each free memory block in the allocated space. */
-        Tools::Array<FreeBlock> vk_free_blocks;
+        /* Table of all blocks allocated in this pool, indexed by their handle. Handles that aren't in use (including the NullHandle) point to nullptr. */
+        std::vector<UsedBlock*> vk_used_blocks;
+        /* Handles that were deallocated and can be handed out again. */
+        std::vector<MemoryHandle> vk_free_handles;
 
 
         /* Private helper function that takes a BufferBlock, and uses it to initialize the given buffer. */
@@ -276,15 +289,25 @@ namespace RayTracer::Compute {
         /* Private helper function that takes a UsedBlock, and uses it to initialize the given buffer. */
         inline static Image init_image(ImageHandle handle, ImageBlock* block, VkDeviceMemory vk_memory, VkMemoryPropertyFlags memory_properties) { return Image(handle, block->vk_image, VkExtent2D({ block->vk_extent.width, block->vk_extent.height }), block->vk_format, block->vk_layout, block->vk_usage_flags, block->vk_sharing_mode, block->vk_create_flags, vk_memory, block->start, block->length, block->req_length, memory_properties); }
 
+        /* Private helper function that returns the block behind the given handle, throwing errors if there's no such block. */
+        UsedBlock* get_block(MemoryHandle handle) const;
+        /* Private helper function that allocates a new chunk of the given size on the GPU, returning its index. */
+        uint32_t add_chunk(VkDeviceSize n_bytes, bool dedicated);
+        /* Private helper function that frees the chunk with the given index on the GPU. */
+        void release_chunk(uint32_t chunk);
+        /* Private helper function that finds a range for the given memory requirements in the regular chunks, adding a chunk if none has room. Returns the index of the chunk. */
+        uint32_t place_block(const VkMemoryRequirements& mem_requirements, Tools::BlockAllocator::Range& range);
         /* Private helper function that actually performs memory allocation. Returns a reference to a UsedBlock that describes the block allocated. */
         MemoryHandle allocate_memory(MemoryBlockType type, VkDeviceSize n_bytes, const VkMemoryRequirements& mem_requirements);
 
     public:
         /* The null handle for the pool. */
         const static constexpr MemoryHandle NullHandle = 0;
+        /* Buffers and images that need more than the chunk size divided by this get a dedicated chunk of their own. */
+        const static constexpr VkDeviceSize dedicated_divisor = 2;
 
         
-        /* Constructor for the MemoryPool class, which takes a device to allocate on, the type of memory we will allocate on and the total size of the allocated block. */
+        /* Constructor for the MemoryPool class, which takes a device to allocate on, the type of memory we will allocate on and the size of its chunks. The pool starts with a single chunk, and adds more as they fill up. */
         MemoryPool(const GPU& gpu, uint32_t memory_type, VkDeviceSize n_bytes, VkMemoryPropertyFlags memory_properties = 0);
         /* Copy constructor for the MemoryPool class, which is deleted. */
         MemoryPool(const MemoryPool& other);
@@ -294,9 +317,9 @@ namespace RayTracer::Compute {
         ~MemoryPool();
 
         /* Returns a reference to the internal buffer with the given handle. Always performs out-of-bounds checking. */
-        inline Buffer deref_buffer(BufferHandle buffer) const { return init_buffer(buffer, (BufferBlock*) this->vk_used_blocks.at(buffer), this->vk_memory, this->vk_memory_properties); }
+        inline Buffer deref_buffer(BufferHandle buffer) const { BufferBlock* block = (BufferBlock*) this->get_block(buffer); return init_buffer(buffer, block, this->vk_chunks[block->chunk]->vk_memory, this->vk_memory_properties); }
         /* Returns a reference to the internal image with the given handle. Always performs out-of-bounds checking. */
-        inline Image deref_image(ImageHandle image) const { return init_image(image, (ImageBlock*) this->vk_used_blocks.at(image), this->vk_memory, this->vk_memory_properties); }
+        inline Image deref_image(ImageHandle image) const { ImageBlock* block = (ImageBlock*) this->get_block(image); return init_image(image, block, this->vk_chunks[block->chunk]->vk_memory, this->vk_memory_properties); }
 
         /* Tries to get a new buffer from the pool of the given size and with the given flags. Applies extra checks if NDEBUG is not defined. */
         inline Buffer allocate_buffer(VkDeviceSize n_bytes, VkBufferUsageFlags usage_flags, VkSharingMode sharing_mode = VK_SHARING_MODE_EXCLUSIVE, VkBufferCreateFlags create_flags = 0) { return this->deref_buffer(this->allocate_buffer_h(n_bytes, usage_flags, sharing_mode, create_flags)); }
@@ -317,9 +340,26 @@ namespace RayTracer::Compute {
         /* Deallocates the buffer or image with the given handle. Does not throw an error if the handle doesn't exist, unless NDEBUG is not defined. */
         void deallocate(MemoryHandle handle);
 
-        /* Defragements the entire pool, aligning all buffers next to each other in memory to create a maximally sized free block. Note that existing handles will remain valid. */
+        /* Defragements the entire pool, aligning all buffers next to each other in memory to create maximally sized free blocks and releasing the chunks that end up empty. Note that existing handles will remain valid, but the contents of the buffers are not. */
         void defrag();
 
+        /* Returns the total size of all chunks currently allocated on the GPU, in bytes. */
+        inline VkDeviceSize size() const { return this->vk_memory_size; }
+        /* Returns the size of the regular chunks of the pool, in bytes. */
+        inline VkDeviceSize chunk_size() const { return this->vk_chunk_size; }
+        /* Returns the number of chunks currently allocated on the GPU, including dedicated ones. */
+        uint32_t chunks() const;
+        /* Returns the number of bytes currently allocated in the pool. */
+        inline VkDeviceSize used() const { return this->vk_used_size; }
+        /* Returns the largest number of bytes ever allocated in the pool at once. */
+        inline VkDeviceSize high_water_mark() const { return this->vk_high_water_size; }
+        /* Returns the number of buffers and images currently allocated in the pool. */
+        inline uint32_t allocations() const { return (uint32_t) (this->vk_used_blocks.size() - 1 - this->vk_free_handles.size()); }
+        /* Returns the size of the largest free block in the regular chunks, which is about the largest buffer that still fits without adding a chunk. */
+        VkDeviceSize largest_free_block() const;
+        /* Returns how fragmented the free memory in the regular chunks is, as the fraction of it that's not in the largest free block. */
+        double fragmentation() const;
+
         /* Copy assignment operator for the MemoryPool class. */
         inline MemoryPool& operator=(const MemoryPool& other) { return *this = MemoryPool(other); }
         /* Move assignment operator for the MemoryPool class. */
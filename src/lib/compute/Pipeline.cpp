@@ -4,7 +4,7 @@
  * Created:
  *   27/04/2021, 14:44:19
  * Last edited:
- *   25/05/2021, 18:14:13
+ *   16/10/2026, 01:05:57
  * Auto updated?
  *   Yes
  *
@@ -212,8 +212,8 @@ Pipeline::Pipeline(const GPU& gpu, const Shader& shader, const Tools::Array<Desc
     VkComputePipelineCreateInfo compute_info;
     populate_compute_info(compute_info, this->vk_compute_pipeline_layout, shader_stage_info);
 
-    // Call the create function!
-    if ((vk_result = vkCreateComputePipelines(this->gpu, VK_NULL_HANDLE, 1, &compute_info, nullptr, &this->vk_compute_pipeline)) != VK_SUCCESS) {
+    // Call the create function! Going through the GPU's pipeline cache means shaders compiled before (in this run or an earlier one) aren't compiled again
+    if ((vk_result = vkCreateComputePipelines(this->gpu, this->gpu.pipeline_cache(), 1, &compute_info, nullptr, &this->vk_compute_pipeline)) != VK_SUCCESS) {
         DLOG(fatal, "Could not create compute pipeline: " + vk_error_map[vk_result]);
     }
 
@@ -0,0 +1,97 @@
+/* ENTITY PATH.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 13:58:45
+ * Last edited:
+ *   16/10/2026, 13:58:45
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the EntityPath class, which describes how an entity moves
+ *   during an animation as a list of keyframes of rigid transformations.
+ *   Translations are interpolated linearly and rotations spherically.
+**/
+
+#include <cmath>
+#include <CppDebugger.hpp>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "EntityPath.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace RayTracer::ECS;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** ENTITYPATH CLASS *****/
+/* Constructor for the EntityPath class, which takes the point (in world coordinates) around which the entity rotates. */
+EntityPath::EntityPath(const glm::vec3& pivot) :
+    pivot(pivot)
+{}
+
+
+
+/* Adds a keyframe at the given time with the given translation and rotation. Keyframes have to be added in chronological order. */
+void EntityPath::add(float time, const glm::vec3& translation, const glm::quat& rotation) {
+    DENTER("EntityPath::add");
+
+    if (this->keyframes.size() > 0 && time <= this->keyframes[this->keyframes.size() - 1].time) {
+        DLOG(fatal, "Keyframe at time " + std::to_string(time) + " is not after the last keyframe at time " + std::to_string(this->keyframes[this->keyframes.size() - 1].time));
+    }
+    this->keyframes.push_back(TransformKeyframe({ time, translation, rotation }));
+
+    DRETURN;
+}
+
+/* Returns the transformation of the entity at the given time, relative to where it was pre-rendered. Before the first or after the last keyframe, the entity stays at that keyframe. */
+glm::mat4 EntityPath::at(float time) const {
+    DENTER("EntityPath::at");
+
+    size_t n_keyframes = this->keyframes.size();
+    if (n_keyframes == 0) {
+        DLOG(fatal, "Cannot compute the transformation of an empty entity path");
+    }
+
+    // Find the translation & rotation at this time, clamping to the ends of the path
+    glm::vec3 translation;
+    glm::quat rotation;
+    if (time <= this->keyframes[0].time) {
+        translation = this->keyframes[0].translation;
+        rotation = this->keyframes[0].rotation;
+    } else if (time >= this->keyframes[n_keyframes - 1].time) {
+        translation = this->keyframes[n_keyframes - 1].translation;
+        rotation = this->keyframes[n_keyframes - 1].rotation;
+    } else {
+        size_t k = 0;
+        while (time >= this->keyframes[k + 1].time) { ++k; }
+        const TransformKeyframe& k1 = this->keyframes[k];
+        const TransformKeyframe& k2 = this->keyframes[k + 1];
+        float s = (time - k1.time) / (k2.time - k1.time);
+        translation = glm::mix(k1.translation, k2.translation, s);
+        rotation = glm::slerp(k1.rotation, k2.rotation, s);
+    }
+
+    // Rotate around the pivot first, then translate
+    DRETURN glm::translate(glm::mat4(1.0f), this->pivot + translation) * glm::mat4_cast(rotation) * glm::translate(glm::mat4(1.0f), -this->pivot);
+}
+
+
+
+/* Creates a path that spins the entity once around the given axis through the given pivot in the given time. */
+EntityPath EntityPath::spin(const glm::vec3& pivot, const glm::vec3& axis, float duration) {
+    DENTER("EntityPath::spin");
+
+    // Use three segments of a third of a turn each, since interpolating between rotations always takes the shortest way around
+    EntityPath result(pivot);
+    glm::vec3 unit_axis = glm::normalize(axis);
+    for (uint32_t i = 0; i <= 3; i++) {
+        float angle = 2.0f * (float) M_PI * (float) i / 3.0f;
+        result.add(duration * (float) i / 3.0f, glm::vec3(0.0f), glm::angleAxis(angle, unit_axis));
+    }
+
+    DRETURN result;
+}
@@ -0,0 +1,67 @@
+/* ENTITY PATH.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 13:58:41
+ * Last edited:
+ *   16/10/2026, 13:58:41
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the EntityPath class, which describes how an entity moves
+ *   during an animation as a list of keyframes of rigid transformations.
+ *   Translations are interpolated linearly and rotations spherically.
+**/
+
+#ifndef ENTITIES_ENTITY_PATH_HPP
+#define ENTITIES_ENTITY_PATH_HPP
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include "tools/Array.hpp"
+
+namespace RayTracer::ECS {
+    /* The TransformKeyframe struct, which describes how far an entity has moved from where it was pre-rendered at a single moment in time. */
+    struct TransformKeyframe {
+        /* The moment in time of this keyframe. */
+        float time;
+        /* The translation of the entity. */
+        glm::vec3 translation;
+        /* The rotation of the entity around the path's pivot. */
+        glm::quat rotation;
+    };
+
+
+
+    /* The EntityPath class, which interpolates the rigid transformation of an entity between a list of keyframes. */
+    class EntityPath {
+    private:
+        /* The point around which the entity rotates, in world coordinates. */
+        glm::vec3 pivot;
+        /* The keyframes of the path, sorted on their time. */
+        Tools::Array<TransformKeyframe> keyframes;
+
+    public:
+        /* Constructor for the EntityPath class, which takes the point (in world coordinates) around which the entity rotates. */
+        EntityPath(const glm::vec3& pivot = glm::vec3(0.0f));
+
+        /* Adds a keyframe at the given time with the given translation and rotation. Keyframes have to be added in chronological order. */
+        void add(float time, const glm::vec3& translation, const glm::quat& rotation);
+        /* Returns the transformation of the entity at the given time, relative to where it was pre-rendered. Before the first or after the last keyframe, the entity stays at that keyframe. */
+        glm::mat4 at(float time) const;
+
+        /* Returns the point around which the entity rotates. */
+        inline const glm::vec3& get_pivot() const { return this->pivot; }
+        /* Returns the keyframes of the path. */
+        inline const Tools::Array<TransformKeyframe>& get_keyframes() const { return this->keyframes; }
+        /* Returns whether or not the path has any keyframes. */
+        inline bool empty() const { return this->keyframes.size() == 0; }
+
+        /* Creates a path that spins the entity once around the given axis through the given pivot in the given time. */
+        static EntityPath spin(const glm::vec3& pivot, const glm::vec3& axis, float duration);
+
+    };
+}
+
+#endif
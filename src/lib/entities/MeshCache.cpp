@@ -0,0 +1,226 @@
+/* MESH CACHE.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 00:58:19
+ * Last edited:
+ *   16/10/2026, 01:02:51
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the MeshCache class, which maps a binary, pre-baked version
+ *   of an object file into memory. The vertices & faces are stored in
+ *   exactly the layout the renderers consume, so loading one is just a
+ *   matter of validating its header. Caches are baked on the first load
+ *   of an object file, and are keyed by the source file's size,
+ *   modification time and hash.
+**/
+
+#include <fstream>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <CppDebugger.hpp>
+
+#include "tools/Common.hpp"
+#include "tools/Profiler.hpp"
+
+#include "MeshCache.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace RayTracer::ECS;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** CONSTANTS *****/
+/* The magic bytes at the start of every mesh cache. */
+static const char mesh_cache_magic[8] = { 'R', 'T', 'M', 'E', 'S', 'H', '\0', '\0' };
+/* The alignment of the vertex & face arrays in the file, so they can be used straight from the mapping. */
+static const constexpr uint64_t mesh_cache_alignment = 16;
+
+
+
+
+
+/***** HELPER FUNCTIONS *****/
+/* @brief Rounds the given offset up to the next multiple of the cache's alignment. */
+static inline uint64_t align_offset(uint64_t offset) {
+    return (offset + mesh_cache_alignment - 1) / mesh_cache_alignment * mesh_cache_alignment;
+}
+
+/* @brief Checks whether the given cache header describes a cache we can read, and that fits in a file of the given size.
+ * @param header The header to check.
+ * @param file_size The size of the entire cache file.
+ * @return A description of what is wrong with the header, or an empty string if nothing is.
+ */
+static std::string check_header(const MeshCacheHeader& header, size_t file_size) {
+    if (memcmp(header.magic, mesh_cache_magic, sizeof(mesh_cache_magic)) != 0) { return "not a mesh cache"; }
+    if (header.version != mesh_cache_version) { return "version " + std::to_string(header.version) + " instead of " + std::to_string(mesh_cache_version); }
+    if (header.vertex_size != sizeof(glm::vec4) || header.face_size != sizeof(GFace)) { return "baked with a different struct layout"; }
+    if (header.vertices_offset % mesh_cache_alignment != 0 || header.faces_offset % mesh_cache_alignment != 0) { return "misaligned data"; }
+    if (header.vertices_offset + (uint64_t) header.n_vertices * sizeof(glm::vec4) > file_size || header.faces_offset + (uint64_t) header.n_faces * sizeof(GFace) > file_size) { return "truncated"; }
+    return "";
+}
+
+/* @brief Overwrites the source modification time in the header of the given cache, leaving the rest of the file untouched.
+ * @param cache_path The path of the cache to update.
+ * @param source_mtime The new modification time of the source.
+ * @return Whether the header could be updated.
+ */
+static bool write_source_mtime(const std::string& cache_path, int64_t source_mtime) {
+    std::fstream h(cache_path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!h.is_open()) { return false; }
+    h.seekp(offsetof(MeshCacheHeader, source_mtime));
+    h.write((const char*) &source_mtime, sizeof(int64_t));
+    h.close();
+    return !h.fail();
+}
+
+
+
+
+
+/***** MESHCACHE CLASS *****/
+/* Constructor for the MeshCache class, which maps the file at the given path. Use MeshCache::open() instead, which also validates it. */
+MeshCache::MeshCache(const std::string& cache_path) :
+    file(cache_path),
+    header((const MeshCacheHeader*) this->file.data())
+{}
+
+
+
+/* Opens the cache at the given path if it is a valid, up-to-date cache of the given object file. Returns nullptr (and leaves the file alone) if it isn't. The source may be missing, in which case the cache is trusted as-is. */
+MeshCache* MeshCache::open(const std::string& cache_path, const std::string& source_path) {
+    PENTER("ECS::MeshCache::open");
+
+    // If there is no cache at all, we're done quickly
+    uint64_t cache_size;
+    int64_t cache_mtime;
+    if (!Tools::get_file_info(cache_path, cache_size, cache_mtime)) {
+        DLOG(auxillary, "No mesh cache found at '" + cache_path + "'");
+        DRETURN nullptr;
+    }
+
+    // Map it and check that it's something we can use
+    MeshCache* result;
+    try {
+        result = new MeshCache(cache_path);
+    } catch (CppDebugger::Fatal&) {
+        DLOG(warning, "Could not open mesh cache '" + cache_path + "'; ignoring it.");
+        DRETURN nullptr;
+    }
+    if (result->file.size() < sizeof(MeshCacheHeader)) {
+        DLOG(warning, "Mesh cache '" + cache_path + "' is truncated; ignoring it.");
+        delete result;
+        DRETURN nullptr;
+    }
+    std::string error = check_header(*result->header, result->file.size());
+    if (!error.empty()) {
+        DLOG(warning, "Mesh cache '" + cache_path + "' is invalid (" + error + "); ignoring it.");
+        delete result;
+        DRETURN nullptr;
+    }
+
+    // Check that it's still up-to-date. If the size and modification time match we don't even have to read the source; otherwise, we compare the hash
+    uint64_t source_size;
+    int64_t source_mtime;
+    if (!Tools::get_file_info(source_path, source_size, source_mtime)) {
+        DLOG(auxillary, "Source '" + source_path + "' of mesh cache '" + cache_path + "' does not exist; using the cache as-is");
+        DRETURN result;
+    }
+    if (source_size != result->header->source_size) {
+        DLOG(auxillary, "Mesh cache '" + cache_path + "' is out-of-date");
+        delete result;
+        DRETURN nullptr;
+    }
+    if (source_mtime != result->header->source_mtime) {
+        Tools::MappedFile source(source_path);
+        if (Tools::hash_bytes(source.data(), source.size()) != result->header->source_hash) {
+            DLOG(auxillary, "Mesh cache '" + cache_path + "' is out-of-date");
+            delete result;
+            DRETURN nullptr;
+        }
+
+        // Only the time changed (e.g., after a checkout), so remember the new one to skip the hash next time. If we can't, we just hash again next time
+        if (!write_source_mtime(cache_path, source_mtime)) {
+            DLOG(auxillary, "Could not update the source modification time in mesh cache '" + cache_path + "'");
+        }
+    }
+
+    // Done
+    DLOG(auxillary, "Using mesh cache '" + cache_path + "' with " + std::to_string(result->n_vertices()) + " vertices and " + std::to_string(result->n_faces()) + " faces");
+    DRETURN result;
+}
+
+/* Writes a cache for the given object file to the given path, containing the given vertices & faces. The file is written under a temporary name first, so readers never see half a cache. Returns false (after logging a warning) if it couldn't be written. */
+bool MeshCache::write(const std::string& cache_path, const std::string& source_path, const Tools::Array<glm::vec4>& vertices, const Tools::Array<GFace>& faces) {
+    PENTER("ECS::MeshCache::write");
+    DLOG(info, "Writing mesh cache '" + cache_path + "'...");
+
+    // Prepare the header, keyed by the current state of the source. We get its size & time before reading it, so a concurrent change makes the cache stale rather than wrong
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(MeshCacheHeader));
+    memcpy(header.magic, mesh_cache_magic, sizeof(mesh_cache_magic));
+    header.version = mesh_cache_version;
+    header.vertex_size = sizeof(glm::vec4);
+    header.face_size = sizeof(GFace);
+    header.n_vertices = (uint32_t) vertices.size();
+    header.n_faces = (uint32_t) faces.size();
+    if (!Tools::get_file_info(source_path, header.source_size, header.source_mtime)) {
+        DLOG(warning, "Could not examine source '" + source_path + "'; not writing mesh cache.");
+        DRETURN false;
+    }
+    try {
+        Tools::MappedFile source(source_path);
+        header.source_hash = Tools::hash_bytes(source.data(), source.size());
+    } catch (CppDebugger::Fatal&) {
+        DLOG(warning, "Could not read source '" + source_path + "'; not writing mesh cache.");
+        DRETURN false;
+    }
+    header.vertices_offset = align_offset(sizeof(MeshCacheHeader));
+    header.faces_offset = align_offset(header.vertices_offset + (uint64_t) vertices.size() * sizeof(glm::vec4));
+
+    // Write everything to a temporary file of our own, so concurrent writers of the same cache never write to the same file
+    std::string temp_path = Tools::unique_temp_path(cache_path);
+    std::ofstream h(temp_path, std::ios::binary | std::ios::trunc);
+    if (!h.is_open()) {
+        DLOG(warning, "Could not create mesh cache '" + temp_path + "'; not writing mesh cache.");
+        DRETURN false;
+    }
+    const char padding[mesh_cache_alignment] = {};
+    h.write((const char*) &header, sizeof(MeshCacheHeader));
+    h.write(padding, header.vertices_offset - sizeof(MeshCacheHeader));
+    h.write((const char*) vertices.rdata(), vertices.size() * sizeof(glm::vec4));
+    h.write(padding, header.faces_offset - (header.vertices_offset + vertices.size() * sizeof(glm::vec4)));
+    for (size_t i = 0; i < faces.size(); i++) {
+        // Copy field-by-field, so the padding in the struct is always written as zeroes and the same mesh always gives the same file
+        GFace face;
+        memset(&face, 0, sizeof(GFace));
+        face.v1 = faces[i].v1;
+        face.v2 = faces[i].v2;
+        face.v3 = faces[i].v3;
+        face.normal = faces[i].normal;
+        face.color = faces[i].color;
+        h.write((const char*) &face, sizeof(GFace));
+    }
+    h.close();
+    if (!h) {
+        std::remove(temp_path.c_str());
+        DLOG(warning, "Could not write mesh cache '" + temp_path + "'; not writing mesh cache.");
+        DRETURN false;
+    }
+
+    // Move it in place. Windows won't rename over an existing file, so remove that first
+    #ifdef _WIN32
+    std::remove(cache_path.c_str());
+    #endif
+    if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        DLOG(warning, "Could not move mesh cache '" + temp_path + "' to '" + cache_path + "'; not writing mesh cache.");
+        DRETURN false;
+    }
+
+    DRETURN true;
+}
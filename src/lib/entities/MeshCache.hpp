@@ -0,0 +1,106 @@
+/* MESH CACHE.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 00:58:14
+ * Last edited:
+ *   16/10/2026, 00:58:14
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the MeshCache class, which maps a binary, pre-baked version
+ *   of an object file into memory. The vertices & faces are stored in
+ *   exactly the layout the renderers consume, so loading one is just a
+ *   matter of validating its header. Caches are baked on the first load
+ *   of an object file, and are keyed by the source file's size,
+ *   modification time and hash.
+**/
+
+#ifndef ENTITIES_MESH_CACHE_HPP
+#define ENTITIES_MESH_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "glm/glm.hpp"
+#include "renderer/Vertex.hpp"
+#include "tools/Array.hpp"
+#include "tools/MappedFile.hpp"
+
+namespace RayTracer::ECS {
+    /* The header at the start of every mesh cache file. The vertices and faces follow it at the given offsets. */
+    struct MeshCacheHeader {
+        /* Magic bytes that identify a mesh cache, always "RTMESH" followed by two zeroes. */
+        char magic[8];
+        /* The version of the format. Caches with a different version are re-baked. */
+        uint32_t version;
+        /* The size of a single vertex, which guards against compilers that lay out the structs differently. */
+        uint32_t vertex_size;
+        /* The size of a single face, which guards against compilers that lay out the structs differently. */
+        uint32_t face_size;
+        /* The number of vertices in the cache. */
+        uint32_t n_vertices;
+        /* The number of faces in the cache. */
+        uint32_t n_faces;
+        /* Padding to keep the rest of the header aligned. */
+        uint32_t reserved;
+
+        /* The size of the source file when the cache was baked. */
+        uint64_t source_size;
+        /* The modification time of the source file (in nanoseconds since the epoch) when the cache was baked. */
+        int64_t source_mtime;
+        /* The hash of the source file when the cache was baked, which is used if its size or modification time changed. */
+        uint64_t source_hash;
+
+        /* The offset (in bytes, from the start of the file) of the vertices. */
+        uint64_t vertices_offset;
+        /* The offset (in bytes, from the start of the file) of the faces. */
+        uint64_t faces_offset;
+    };
+
+    /* The current version of the mesh cache format. */
+    static const constexpr uint32_t mesh_cache_version = 1;
+    /* The extension that is appended to the path of an object file to get the path of its cache. */
+    static const std::string mesh_cache_extension = ".rtmesh";
+
+
+
+    /* The MeshCache class, which maps a baked mesh into memory. */
+    class MeshCache {
+    private:
+        /* The mapped cache file. */
+        Tools::MappedFile file;
+        /* The header of the cache, which points into the mapped file. */
+        const MeshCacheHeader* header;
+
+        /* Constructor for the MeshCache class, which maps the file at the given path. Use MeshCache::open() instead, which also validates it. */
+        MeshCache(const std::string& cache_path);
+
+    public:
+        /* Copy constructor for the MeshCache class, which is deleted as the mapping can't be shared. */
+        MeshCache(const MeshCache& other) = delete;
+
+        /* Returns the vertices in the cache, in the object's own coordinates. */
+        inline const glm::vec4* vertices() const { return (const glm::vec4*) (this->file.data() + this->header->vertices_offset); }
+        /* Returns the number of vertices in the cache. */
+        inline uint32_t n_vertices() const { return this->header->n_vertices; }
+        /* Returns the faces in the cache, with their normals already computed (but without color). */
+        inline const GFace* faces() const { return (const GFace*) (this->file.data() + this->header->faces_offset); }
+        /* Returns the number of faces in the cache. */
+        inline uint32_t n_faces() const { return this->header->n_faces; }
+
+        /* Returns the path of the cache that belongs to the given object file. */
+        static inline std::string path_for(const std::string& source_path) { return source_path + mesh_cache_extension; }
+        /* Opens the cache at the given path if it is a valid, up-to-date cache of the given object file. Returns nullptr (and leaves the file alone) if it isn't. The source may be missing, in which case the cache is trusted as-is. */
+        static MeshCache* open(const std::string& cache_path, const std::string& source_path);
+        /* Writes a cache for the given object file to the given path, containing the given vertices & faces. The file is written under a temporary name unique to this writer first, so readers never see half a cache, even if several processes write it at the same time. Returns false (after logging a warning) if it couldn't be written. */
+        static bool write(const std::string& cache_path, const std::string& source_path, const Tools::Array<glm::vec4>& vertices, const Tools::Array<GFace>& faces);
+
+        /* Copy assignment operator for the MeshCache class, which is deleted. */
+        MeshCache& operator=(const MeshCache& other) = delete;
+
+    };
+}
+
+#endif
@@ -4,22 +4,29 @@
  * Created:
  *   06/05/2021, 16:51:56
  * Last edited:
- *   25/05/2021, 18:14:13
+ *   16/10/2026, 01:02:51
  * Auto updated?
  *   Yes
  *
  * Description:
  *   File that contains an entity that loads object files. Does not yet
- *   load textures, just the normals and the geometries.
+ *   load textures, just the normals and the geometries. The files are
+ *   memory-mapped and parsed in a single pass, in parallel for large
+ *   files, using a hand-written number parser.
 **/
 
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <cstring>
-#include <cerrno>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <vector>
 #include <CppDebugger.hpp>
 
+#include "tools/MappedFile.hpp"
+#include "tools/ThreadPool.hpp"
+#include "tools/Profiler.hpp"
+
 #include "Object.hpp"
 
 using namespace std;
@@ -28,170 +35,481 @@ using namespace RayTracer::ECS;
 using namespace CppDebugger::SeverityValues;
 
 
-/***** MACROS *****/
-/* Shortcut for getting and checking a character in the tokenizer. */
-#define GET_CHAR(C, H) \
-    int ic = fgetc((H)); \
-    if (ic == EOF && feof((H))) { \
-        return Terminal::eof; \
-    } else if (ic == EOF && ferror((H))) { \
-        cerr << "ERROR: Could not read next character from input file: " << strerror(errno) << endl; \
-        return Terminal::unknown; \
-    } \
-    ++col; \
-    (C) = (char) ic;
+/***** CONSTANTS *****/
+/* Files smaller than this many bytes are parsed on the calling thread, as starting the workers would take longer than parsing the file. */
+static const constexpr size_t parallel_threshold = 1024 * 1024;
+/* The minimum number of bytes in a chunk when parsing in parallel. */
+static const constexpr size_t min_chunk_size = 256 * 1024;
+/* The number of chunks per worker thread, so the pool can balance chunks that happen to be slower to parse. */
+static const constexpr size_t chunks_per_worker = 4;
+
+/* Exact powers of ten that fit in a double, used to scale the parsed mantissas. */
+static const double powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+
+
 
-/* Checks if given character is a whitespace (space, tab, carriage return or newline). */
-#define IS_WHITESPACE(C) \
-    ((C) == ' ' || (C) == '\t' || (C) == '\r' || (C) == '\n')
+/***** HELPER STRUCTS *****/
+/* A triangle as it is parsed from the file, before the indices are resolved. */
+struct RawFace {
+    /* The indices of the three vertices. Either absolute and zero-based, or relative to the first vertex of the chunk if the matching bit in relative is set. */
+    int64_t v[3];
+    /* Bitmask that says which of the indices came from negative (i.e., relative) indices in the file. */
+    uint8_t relative;
+};
+
+/* A piece of the file that is parsed on its own, together with the results of parsing it. */
+struct ObjChunk {
+    /* The first character of the chunk, which is always the start of a line. */
+    const char* begin;
+    /* One past the last character of the chunk, which is always the end of a line (or of the file). */
+    const char* end;
+
+    /* The vertices defined in this chunk. */
+    Tools::Array<glm::vec4> vertices;
+    /* The (triangulated) faces defined in this chunk. */
+    Tools::Array<RawFace> faces;
+    /* The number of lines with statements we do not support (and thus skipped). */
+    size_t n_skipped;
+
+    /* Where in the file the first error was found, or nullptr if there was none. */
+    const char* error_pos;
+    /* Description of the first error. */
+    std::string error;
+
+    /* The index of the first vertex of this chunk in the entire file. */
+    size_t vertex_offset;
+    /* The index of the first face of this chunk in the entire file. */
+    size_t face_offset;
+};
+
+
+
+
+
+/***** PARSING FUNCTIONS *****/
+/* @brief Skips any spaces and tabs.
+ * @param p The current position in the file. Will be moved past the whitespace.
+ * @param end The end of the chunk.
+ */
+static inline void skip_spaces(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) { ++p; }
+}
+
+/* @brief Skips the remainder of the line, including the newline itself.
+ * @param p The current position in the file. Will be moved to the start of the next line.
+ * @param end The end of the chunk.
+ */
+static inline void skip_line(const char*& p, const char* end) {
+    while (p < end && *p != '\n') { ++p; }
+    if (p < end) { ++p; }
+}
+
+/* @brief Returns whether the given position is at the end of a token, i.e., at whitespace, the end of the line or the end of the chunk. */
+static inline bool at_separator(const char* p, const char* end) {
+    return p >= end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n';
+}
+
+/* @brief Parses a floating-point number in (signed) decimal or scientific notation.
+ * @param p The current position in the file. Will be moved past the number if successful.
+ * @param end The end of the chunk.
+ * @param result The parsed number.
+ * @return Whether a valid number was parsed.
+ */
+static inline bool parse_float(const char*& p, const char* end, float& result) {
+    const char* c = p;
+    bool negative = false;
+    if (c < end && (*c == '-' || *c == '+')) { negative = *c == '-'; ++c; }
+
+    // Collect up to 19 significant digits in an integer, which is exact, and keep track of the decimal exponent for the rest
+    uint64_t mantissa = 0;
+    int32_t exponent = 0;
+    uint32_t n_significant = 0;
+    bool any_digits = false;
+    for (; c < end && *c >= '0' && *c <= '9'; ++c) {
+        any_digits = true;
+        if (n_significant < 19) {
+            mantissa = 10 * mantissa + (uint64_t) (*c - '0');
+            if (mantissa > 0) { ++n_significant; }
+        } else {
+            ++exponent;
+        }
+    }
+    if (c < end && *c == '.') {
+        for (++c; c < end && *c >= '0' && *c <= '9'; ++c) {
+            any_digits = true;
+            if (n_significant < 19) {
+                mantissa = 10 * mantissa + (uint64_t) (*c - '0');
+                if (mantissa > 0) { ++n_significant; }
+                --exponent;
+            }
+        }
+    }
+    if (!any_digits) { return false; }
+
+    // Parse the optional exponent
+    if (c < end && (*c == 'e' || *c == 'E')) {
+        ++c;
+        bool negative_exponent = false;
+        if (c < end && (*c == '-' || *c == '+')) { negative_exponent = *c == '-'; ++c; }
+        if (c >= end || *c < '0' || *c > '9') { return false; }
+        int32_t value = 0;
+        for (; c < end && *c >= '0' && *c <= '9'; ++c) {
+            if (value < 10000) { value = 10 * value + (*c - '0'); }
+        }
+        exponent += negative_exponent ? -value : value;
+    }
+    if (!at_separator(c, end)) { return false; }
+
+    // Scale the mantissa by the exponent. Within the table this is a single correctly rounded operation
+    double value = (double) mantissa;
+    if (exponent < 0 && exponent >= -22) { value /= powers_of_ten[-exponent]; }
+    else if (exponent >= 0 && exponent <= 22) { value *= powers_of_ten[exponent]; }
+    else { value *= std::pow(10.0, (double) exponent); }
+
+    result = (float) (negative ? -value : value);
+    p = c;
+    return true;
+}
+
+/* @brief Parses a (signed) integer index as used in the face statements.
+ * @param p The current position in the file. Will be moved past the number if successful.
+ * @param end The end of the chunk.
+ * @param result The parsed index.
+ * @return Whether a valid, non-zero index was parsed.
+ */
+static inline bool parse_index(const char*& p, const char* end, int64_t& result) {
+    const char* c = p;
+    bool negative = false;
+    if (c < end && (*c == '-' || *c == '+')) { negative = *c == '-'; ++c; }
+    if (c >= end || *c < '0' || *c > '9') { return false; }
+
+    int64_t value = 0;
+    for (; c < end && *c >= '0' && *c <= '9'; ++c) {
+        if (value > (int64_t) 1 << 40) { return false; }
+        value = 10 * value + (*c - '0');
+    }
+    if (value == 0) { return false; }
+
+    result = negative ? -value : value;
+    p = c;
+    return true;
+}
+
+/* @brief Parses a single vertex reference in a face statement, i.e., 'v', 'v/vt', 'v//vn' or 'v/vt/vn'. Only the position index is kept.
+ * @param p The current position in the file. Will be moved past the reference if successful.
+ * @param end The end of the chunk.
+ * @param result The parsed position index.
+ * @return Whether a valid reference was parsed.
+ */
+static inline bool parse_vertex_ref(const char*& p, const char* end, int64_t& result) {
+    if (!parse_index(p, end, result)) { return false; }
+
+    // Skip the texture & normal indices, if any, but do check they're valid
+    int64_t ignored;
+    for (uint32_t i = 0; i < 2 && p < end && *p == '/'; i++) {
+        ++p;
+        if (i == 0 && p < end && *p == '/') { continue; }
+        if (!parse_index(p, end, ignored)) { return false; }
+    }
+    return at_separator(p, end);
+}
+
+/* @brief Returns whether the line at the given position starts with the given keyword, followed by whitespace. */
+static inline bool is_keyword(const char* p, const char* end, const char* keyword) {
+    for (; *keyword != '\0'; ++keyword, ++p) {
+        if (p >= end || *p != *keyword) { return false; }
+    }
+    return at_separator(p, end);
+}
+
+/* @brief Parses a single chunk of the file, storing the vertices & faces it contains in the chunk itself. Stops at the first error, which is also stored in the chunk.
+ * @param chunk The chunk to parse.
+ */
+static void parse_chunk(ObjChunk& chunk) {
+    const char* p = chunk.begin;
+    const char* end = chunk.end;
+    chunk.n_skipped = 0;
+    chunk.error_pos = nullptr;
+
+    // Reserve some space based on the size of the chunk, assuming there are about twice as many faces as vertices of around 30 characters each
+    size_t n_lines = (size_t) (end - p) / 30;
+    chunk.vertices.reserve(n_lines / 3 + 16);
+    chunk.faces.reserve(2 * n_lines / 3 + 16);
+
+    // Keep track of the vertices in the face we're parsing, to triangulate it as a fan
+    int64_t polygon[3];
+    uint8_t relative[3];
+
+    while (p < end) {
+        const char* line = p;
+        skip_spaces(p, end);
+
+        // Examine the statement on this line
+        if (p >= end || *p == '\n' || *p == '\r' || *p == '#') {
+            // Empty line or comment
+            skip_line(p, end);
+            continue;
+
+        } else if (is_keyword(p, end, "v")) {
+            // It's a vertex; we only keep the position, and ignore the optional w or color that may come after it
+            float x, y, z;
+            ++p;
+            skip_spaces(p, end);
+            if (!parse_float(p, end, x)) { chunk.error_pos = line; chunk.error = "Could not parse x-coordinate of vertex"; return; }
+            skip_spaces(p, end);
+            if (!parse_float(p, end, y)) { chunk.error_pos = line; chunk.error = "Could not parse y-coordinate of vertex"; return; }
+            skip_spaces(p, end);
+            if (!parse_float(p, end, z)) { chunk.error_pos = line; chunk.error = "Could not parse z-coordinate of vertex"; return; }
+            chunk.vertices.push_back(glm::vec4(x, y, z, 0.0f));
+            skip_line(p, end);
+
+        } else if (is_keyword(p, end, "f")) {
+            // It's a face; split polygons into a fan of triangles around the first vertex
+            ++p;
+            uint32_t n_refs = 0;
+            while (true) {
+                skip_spaces(p, end);
+                if (at_separator(p, end)) { break; }
+
+                int64_t index;
+                if (!parse_vertex_ref(p, end, index)) { chunk.error_pos = line; chunk.error = "Could not parse vertex reference " + std::to_string(n_refs + 1) + " of face"; return; }
+
+                // Positive indices are one-based and absolute, negative ones count back from the last vertex so far
+                uint8_t is_relative = index < 0;
+                index = is_relative ? (int64_t) chunk.vertices.size() + index : index - 1;
+
+                // Store it as part of the polygon, emitting a triangle for every vertex after the second
+                uint32_t slot = n_refs < 2 ? n_refs : 2;
+                polygon[slot] = index;
+                relative[slot] = is_relative;
+                if (n_refs >= 2) {
+                    chunk.faces.push_back(RawFace({ { polygon[0], polygon[1], polygon[2] }, (uint8_t) (relative[0] | (relative[1] << 1) | (relative[2] << 2)) }));
+                    polygon[1] = polygon[2];
+                    relative[1] = relative[2];
+                }
+                ++n_refs;
+            }
+            if (n_refs < 3) { chunk.error_pos = line; chunk.error = "Face has only " + std::to_string(n_refs) + " vertices"; return; }
+            skip_line(p, end);
+
+        } else if (is_keyword(p, end, "vn") || is_keyword(p, end, "vt") || is_keyword(p, end, "vp") ||
+                   is_keyword(p, end, "o") || is_keyword(p, end, "g") || is_keyword(p, end, "s") ||
+                   is_keyword(p, end, "usemtl") || is_keyword(p, end, "mtllib") || is_keyword(p, end, "l") || is_keyword(p, end, "p")) {
+            // Valid statements that we have no use for (yet)
+            skip_line(p, end);
+
+        } else {
+            // Statements we don't know at all
+            ++chunk.n_skipped;
+            skip_line(p, end);
+        }
+    }
+}
 
 
 
 
 
 /***** OBJECT FUNCTIONS *****/
-/* Creates a new Object struct based on the given properties. Note that the actual loading of the object is done during pre-rendering. */
-Object* ECS::create_object(const std::string& file_path, const glm::vec3& center, float scale, const glm::vec3& color) {
+/* Loads the geometry of the given object file. If there is an up-to-date mesh cache next to the file it is mapped instead, and otherwise one is written for next time. */
+std::shared_ptr<const ObjectMesh> ECS::load_object_mesh(const std::string& file_path) {
+    DENTER("ECS::load_object_mesh");
+
+    // Try to use the cache first
+    std::shared_ptr<ObjectMesh> result = std::make_shared<ObjectMesh>();
+    std::string cache_path = MeshCache::path_for(file_path);
+    result->cache = MeshCache::open(cache_path, file_path);
+    if (result->cache != nullptr) { DRETURN result; }
+
+    // Otherwise, load the file once, and bake it for the next time. If that fails (e.g., because the directory is read-only) we can just continue
+    load_object_file(file_path, result->faces, result->vertices);
+    MeshCache::write(cache_path, file_path, result->vertices, result->faces);
+
+    // Done!
+    DRETURN result;
+}
+
+/* Creates a new Object struct based on the given properties. Loads the object file immediately, so its vertices & faces are known before pre-rendering. If there is an up-to-date mesh cache next to the file it is mapped instead, and otherwise one is written for next time. If an arena is given, the object is allocated in it (and should not be deleted), and otherwise on the heap. */
+Object* ECS::create_object(const std::string& file_path, const glm::vec3& center, float scale, const glm::vec3& color, Tools::Arena* arena) {
+    DENTER("ECS::create_object");
+
+    // Load the mesh before allocating anything, so there's nothing to clean up if that fails
+    std::shared_ptr<const ObjectMesh> mesh = load_object_mesh(file_path);
+    DRETURN create_object(mesh, file_path, center, scale, color, arena);
+}
+
+/* Creates a new Object struct based on the given properties, which shares the given (already loaded) geometry of the given object file with other objects. If an arena is given, the object is allocated in it (and should not be deleted), and otherwise on the heap. */
+Object* ECS::create_object(const std::shared_ptr<const ObjectMesh>& mesh, const std::string& file_path, const glm::vec3& center, float scale, const glm::vec3& color, Tools::Arena* arena) {
     DENTER("ECS::create_object");
 
     // Allocate the struct
-    Object* result = new Object;
+    Object* result = arena != nullptr ? arena->create<Object>() : new Object;
 
     // Set the RenderEntity fields
     result->type = EntityType::et_object;
     result->pre_render_mode = EntityPreRenderModeFlags::eprmf_cpu;
     result->pre_render_operation = EntityPreRenderOperation::epro_load_object_file;
-    // Set the number of faces & vertices to 0 as we will read them later
-    result->pre_render_faces = 0;
-    result->pre_render_vertices = 0;
+    result->pre_render_faces = mesh->n_faces();
+    result->pre_render_vertices = mesh->n_vertices();
 
-    // Set the object file's path
+    // Set the object file's path & geometry
     result->file_path = file_path;
+    result->mesh = mesh;
 
     // Set the conceptual properties of the object
     result->center = center;
     result->scale = scale;
 
-    // Set the rendering properties of the sphere
+    // Set the rendering properties of the object
     result->color = color;
 
-    // Next, open the file to read how many faces & vertices we need
-    
-    // Try to open a file handle
-    std::ifstream h(file_path);
-    if (!h.is_open()) {
-        #ifdef _WIN32
-        char buffer[BUFSIZ];
-        strerror_s(buffer, BUFSIZ, errno);
-        #else
-        char* buffer = strerror(errno);
-        #endif
-        DLOG(fatal, "Could not open file: " + std::string(buffer));
-    }
-
-    // Start looping through it
-    size_t line_i = 1;
-    std::string line;
-    while(std::getline(h, line)) {
-        // First, try to parse the whole line as a triplet of floats with a character before it
-        std::stringstream sstr(line);
-        char type;
-        float v1, v2, v3;
-        if (!(sstr >> type >> v1 >> v2 >> v3)) {
-            DLOG(fatal, "Encountered unreadable line on line " + std::to_string(line_i));
-        }
-        (void) v1;
-        (void) v2;
-        (void) v3;
-
-        // Examine the correct mode
-        if (type == 'f') {
-            // It's a face
-            ++result->pre_render_faces;
-        } else if (type == 'v') {
-            // It's a vertex
-            ++result->pre_render_vertices;
-        }
-        // We ignore the warning since we'll pre-render it later anyway
-
-        // Increment the line to progress
-        line_i++;
-    }
-
-    // When done, close the file
-    h.close();
-
     // Done!
     DRETURN result;
 }
 
 
 
-/* Pre-renders the sphere on the CPU, single-threaded. Basically just loads the file given on creation. Since object files are usually indexed, so are we. */
-void ECS::cpu_pre_render_object(Tools::Array<GFace>& faces_buffer, Tools::Array<glm::vec4>& vertex_buffer, Object* obj) {
-    DENTER("ECS::cpu_pre_render_object");
-    DLOG(info, "Pre-rendering Object by loading file '" + obj->file_path + "'...");
-
-    // Try to open a file handle
-    std::ifstream h(obj->file_path);
-    if (!h.is_open()) {
-        #ifdef _WIN32
-        char buffer[BUFSIZ];
-        strerror_s(buffer, BUFSIZ, errno);
-        #else
-        char* buffer = strerror(errno);
-        #endif
-        DLOG(fatal, "Could not open file: " + std::string(buffer));
-    }
-
-    // Start looping through it
-    size_t line_i = 1;
-    size_t vertex_i = 0;
-    size_t faces_i = 0;
-    std::string line;
-    while(std::getline(h, line)) {
-        // First, try to parse the whole line as a triplet of floats with a character before it
-        std::stringstream sstr(line);
-        char type;
-        float v1, v2, v3;
-        if (!(sstr >> type >> v1 >> v2 >> v3)) {
-            DLOG(fatal, "Encountered unreadable line on line " + std::to_string(line_i));
+/* Loads the given Wavefront .obj file into the given buffers, overwriting whatever they contain. Supports the full vertex & face syntax (including texture / normal indices, negative indices and polygons, which are triangulated as fans), but only keeps the positions. Also computes the normals of the faces. Large files are parsed in parallel. */
+void ECS::load_object_file(const std::string& file_path, Tools::Array<GFace>& faces_buffer, Tools::Array<glm::vec4>& vertex_buffer) {
+    PENTER("ECS::load_object_file");
+    DLOG(info, "Loading object file '" + file_path + "'...");
+
+    // Map the file into memory
+    Tools::MappedFile file(file_path);
+    const char* data = file.data();
+    size_t size = file.size();
+
+    // Decide on the number of chunks to split the file in
+    uint32_t n_threads = size >= parallel_threshold ? std::thread::hardware_concurrency() : 1;
+    if (n_threads == 0) { n_threads = 1; }
+    size_t n_chunks = std::max((size_t) 1, std::min(n_threads * chunks_per_worker, size / min_chunk_size));
+
+    // Divide the file in chunks of roughly equal size, that each begin at the start of a line
+    std::vector<ObjChunk> chunks(n_chunks);
+    const char* file_end = data + size;
+    const char* chunk_begin = data;
+    for (size_t i = 0; i < n_chunks; i++) {
+        const char* chunk_end = i == n_chunks - 1 ? file_end : std::max(chunk_begin, data + size * (i + 1) / n_chunks);
+        while (chunk_end < file_end && chunk_end > data && *(chunk_end - 1) != '\n') { ++chunk_end; }
+        chunks[i].begin = chunk_begin;
+        chunks[i].end = chunk_end;
+        chunk_begin = chunk_end;
+    }
+
+    // Parse all chunks, which is where most of the time goes
+    Tools::ThreadPool* pool = nullptr;
+    if (n_chunks > 1) {
+        pool = new Tools::ThreadPool(n_threads);
+        pool->run(n_chunks, [&chunks](size_t i, uint32_t) { parse_chunk(chunks[i]); });
+    } else {
+        parse_chunk(chunks[0]);
+    }
+
+    // Report the first error in the file, if any, and add up where each chunk starts in the final buffers
+    size_t n_vertices = 0, n_faces = 0, n_skipped = 0;
+    for (size_t i = 0; i < n_chunks; i++) {
+        if (chunks[i].error_pos != nullptr) {
+            delete pool;
+            size_t line_i = 1 + (size_t) std::count(data, chunks[i].error_pos, '\n');
+            DLOG(fatal, "Could not load object file '" + file_path + "': " + chunks[i].error + " on line " + std::to_string(line_i));
         }
+        chunks[i].vertex_offset = n_vertices;
+        chunks[i].face_offset = n_faces;
+        n_vertices += chunks[i].vertices.size();
+        n_faces += chunks[i].faces.size();
+        n_skipped += chunks[i].n_skipped;
+    }
+    if (n_vertices > std::numeric_limits<uint32_t>::max() || n_faces > std::numeric_limits<uint32_t>::max()) {
+        delete pool;
+        DLOG(fatal, "Could not load object file '" + file_path + "': it has more vertices or faces than we can index.");
+    }
+    if (n_skipped > 0) {
+        DLOG(warning, "Skipped " + std::to_string(n_skipped) + " lines with unsupported statements in object file '" + file_path + "'.");
+    }
 
-        // Examine the correct mode
-        if (type == 'v') {
-            // Store as new vertex
-            vertex_buffer[vertex_i++] = glm::vec4(obj->center + obj->scale * glm::vec3(v1, v2, v3), 0.0);
-        } else if (type == 'f') {
-            // Store as new faces of indices
-            faces_buffer[faces_i++] = {
-                (uint32_t) v1, (uint32_t) v2, (uint32_t) v3,
-                glm::vec3(0.0, 0.0, 0.0),
-                obj->color
-            };
-        } else {
-            DLOG(warning, (std::string("Encountered line with unknown type '") += type) + "'");
+    // Copy every chunk to its own range in the final buffers, resolving the relative indices and computing the normals as we go. The vertices of a face may be in another chunk, so those are all copied first
+    vertex_buffer.clear();
+    faces_buffer.clear();
+    vertex_buffer.reserve(n_vertices);
+    faces_buffer.reserve(n_faces);
+    glm::vec4* vertices = vertex_buffer.wdata(n_vertices);
+    GFace* faces = faces_buffer.wdata(n_faces);
+    Tools::Array<int64_t> bad_index;
+    bad_index.resize(n_chunks);
+    auto copy_vertices = [&chunks, vertices](size_t i, uint32_t) {
+        const ObjChunk& chunk = chunks[i];
+        std::copy(chunk.vertices.rdata(), chunk.vertices.rdata() + chunk.vertices.size(), vertices + chunk.vertex_offset);
+    };
+    auto copy_faces = [&chunks, &bad_index, vertices, faces, n_vertices](size_t i, uint32_t) {
+        const ObjChunk& chunk = chunks[i];
+        bad_index[i] = -1;
+        for (size_t f = 0; f < chunk.faces.size(); f++) {
+            const RawFace& raw = chunk.faces[f];
+            uint32_t v[3];
+            bool valid = true;
+            for (uint32_t j = 0; j < 3; j++) {
+                int64_t index = raw.v[j] + ((raw.relative >> j) & 0x1 ? (int64_t) chunk.vertex_offset : 0);
+                if (index < 0 || index >= (int64_t) n_vertices) {
+                    if (bad_index[i] < 0) { bad_index[i] = (int64_t) (chunk.face_offset + f); }
+                    valid = false;
+                    index = 0;
+                }
+                v[j] = (uint32_t) index;
+            }
+
+            // Translation & uniform scaling don't change the normal, so we can compute it in the object's own coordinates already
+            glm::vec3 normal = !valid ? glm::vec3(0.0f) : glm::normalize(glm::cross(glm::vec3(vertices[v[2]]) - glm::vec3(vertices[v[0]]), glm::vec3(vertices[v[1]]) - glm::vec3(vertices[v[0]])));
+            faces[chunk.face_offset + f] = { v[0], v[1], v[2], normal, glm::vec3(0.0f) };
         }
+    };
+    if (pool != nullptr) {
+        pool->run(n_chunks, copy_vertices);
+        pool->run(n_chunks, copy_faces);
+        delete pool;
+    } else {
+        copy_vertices(0, 0);
+        copy_faces(0, 0);
+    }
 
-        // Increment the line to progress
-        line_i++;
+    // Faces that refer to vertices that don't exist can only be detected now that we know all vertices
+    for (size_t i = 0; i < n_chunks; i++) {
+        if (bad_index[i] >= 0) {
+            DLOG(fatal, "Could not load object file '" + file_path + "': face " + std::to_string(bad_index[i] + 1) + " refers to a vertex that does not exist.");
+        }
     }
 
-    // Find the index offset in case the indices aren't zero-indexed
-    uint32_t index_offset = numeric_limits<uint32_t>::max();
-    for (size_t i = 0; i < faces_buffer.size(); i++) {
-        if (faces_buffer[i].v1 < index_offset) { index_offset = faces_buffer[i].v1; }
-        if (faces_buffer[i].v2 < index_offset) { index_offset = faces_buffer[i].v2; }
-        if (faces_buffer[i].v3 < index_offset) { index_offset = faces_buffer[i].v3; }
+    DLOG(auxillary, "Loaded " + std::to_string(n_vertices) + " vertices and " + std::to_string(n_faces) + " faces in " + std::to_string(n_chunks) + " chunk(s)");
+    DRETURN;
+}
+
+
+
+/* Pre-renders the object on the CPU, single-threaded, directly into the given ranges of pre_render_faces faces and pre_render_vertices vertices. Basically just places the vertices & faces loaded (or mapped) on creation in the world. The indices in the faces are offset by vertex_offset, i.e., where the vertex range starts in the entire buffer. Only writes to its own ranges, so entities may be pre-rendered concurrently. */
+void ECS::cpu_pre_render_object(GFace* faces_buffer, glm::vec4* vertex_buffer, uint32_t vertex_offset, Object* obj) {
+    PENTER("ECS::cpu_pre_render_object");
+    DLOG(info, "Pre-rendering Object loaded from file '" + obj->file_path + "'...");
+
+    // Read the mesh straight from the mapped cache if we have one, or from what we loaded otherwise
+    const glm::vec4* vertices = obj->mesh->vertex_data();
+    const GFace* faces = obj->mesh->face_data();
+
+    // Move the vertices to the object's position
+    for (size_t i = 0; i < obj->pre_render_vertices; i++) {
+        vertex_buffer[i] = glm::vec4(obj->center + obj->scale * glm::vec3(vertices[i]), 0.0);
     }
 
-    // Then, scale the offsets and compute the normals / color
-    for (size_t i = 0; i < faces_buffer.size(); i++) {
-        faces_buffer[i].v1 -= index_offset;
-        faces_buffer[i].v2 -= index_offset;
-        faces_buffer[i].v3 -= index_offset;
-        faces_buffer[i].normal = glm::normalize(glm::cross(glm::vec3(vertex_buffer[faces_buffer[i].v3]) - glm::vec3(vertex_buffer[faces_buffer[i].v1]), glm::vec3(vertex_buffer[faces_buffer[i].v2]) - glm::vec3(vertex_buffer[faces_buffer[i].v1])));
-        faces_buffer[i].color *= glm::abs(glm::dot(faces_buffer[i].normal, glm::vec3(0.0, 0.0, -1.0)));
+    // Then, copy the faces to their place in the entire buffer and compute their color
+    for (size_t i = 0; i < obj->pre_render_faces; i++) {
+        faces_buffer[i] = faces[i];
+        faces_buffer[i].v1 += vertex_offset;
+        faces_buffer[i].v2 += vertex_offset;
+        faces_buffer[i].v3 += vertex_offset;
+        faces_buffer[i].color = shade_object_face(obj->color, faces_buffer[i].normal);
     }
 
     // We're done
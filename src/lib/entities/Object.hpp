@@ -4,7 +4,7 @@
  * Created:
  *   06/05/2021, 16:52:02
  * Last edited:
- *   19/05/2021, 17:27:20
+ *   16/10/2026, 00:13:41
  * Auto updated?
  *   Yes
  *
@@ -16,16 +16,50 @@
 #ifndef ENTITIES_OBJECT_HPP
 #define ENTITIES_OBJECT_HPP
 
+#include <memory>
 #include <string>
 
 #include "glm/glm.hpp"
 #include "renderer/Vertex.hpp"
 #include "tools/Array.hpp"
+#include "tools/Arena.hpp"
 
 #include "RenderEntity.hpp"
+#include "MeshCache.hpp"
 
 namespace RayTracer::ECS {
-    /* The Sphere struct, which builds on the RenderEntity struct in an entity-component-system way. */
+    /* The ObjectMesh struct, which holds the geometry of a single object file. Is shared between all objects created from it, so the file is only loaded (or mapped) once. */
+    struct ObjectMesh {
+        /* The mapped mesh cache of the object file, if there was an up-to-date one when loading. If so, the vertices & faces below are left empty. */
+        MeshCache* cache;
+        /* The vertices loaded from the object file, in the object's own coordinates. Loaded once, so pre-rendering doesn't have to touch the file again. */
+        Tools::Array<glm::vec4> vertices;
+        /* The (triangulated) faces loaded from the object file, with zero-based indices into the vertices and their normals. Their colors are only computed during pre-rendering. */
+        Tools::Array<GFace> faces;
+
+        /* Default constructor for the ObjectMesh struct, which initializes it to empty. */
+        ObjectMesh(): cache(nullptr) {}
+        /* Copy constructor for the ObjectMesh struct, which is deleted since it owns its cache. */
+        ObjectMesh(const ObjectMesh& other) = delete;
+        /* Destructor for the ObjectMesh struct, which unmaps its cache (if any). */
+        ~ObjectMesh() { delete this->cache; }
+
+        /* Returns the vertices of the mesh, either from the cache or from what was loaded. */
+        inline const glm::vec4* vertex_data() const { return this->cache != nullptr ? this->cache->vertices() : this->vertices.rdata(); }
+        /* Returns the number of vertices in the mesh. */
+        inline uint32_t n_vertices() const { return this->cache != nullptr ? this->cache->n_vertices() : (uint32_t) this->vertices.size(); }
+        /* Returns the faces of the mesh, either from the cache or from what was loaded. */
+        inline const GFace* face_data() const { return this->cache != nullptr ? this->cache->faces() : this->faces.rdata(); }
+        /* Returns the number of faces in the mesh. */
+        inline uint32_t n_faces() const { return this->cache != nullptr ? this->cache->n_faces() : (uint32_t) this->faces.size(); }
+
+        /* Copy assignment operator for the ObjectMesh struct, which is deleted since it owns its cache. */
+        ObjectMesh& operator=(const ObjectMesh& other) = delete;
+    };
+
+
+
+    /* The Object struct, which builds on the RenderEntity struct in an entity-component-system way. */
     struct Object: public RenderEntity {
         /* Path to the object file. */
         std::string file_path;
@@ -35,14 +69,25 @@ namespace RayTracer::ECS {
         float scale;
         /* The color of the object. */
         glm::vec3 color;
+
+        /* The geometry of the object file, which may be shared with other objects created from the same file. */
+        std::shared_ptr<const ObjectMesh> mesh;
     };
 
 
 
-    /* Creates a new Object struct based on the given properties. Note that the actual loading of the object is done during pre-rendering. */
-    Object* create_object(const std::string& file_path, const glm::vec3& center, float scale, const glm::vec3& color);
-    /* Pre-renders the sphere on the CPU, single-threaded. Basically just loads the file given on creation. Since object files are usually indexed, so are we. */
-    void cpu_pre_render_object(Tools::Array<GFace>& faces_buffer, Tools::Array<glm::vec4>& vertex_buffer, Object* obj);
+    /* Loads the geometry of the given object file. If there is an up-to-date mesh cache next to the file it is mapped instead, and otherwise one is written for next time. */
+    std::shared_ptr<const ObjectMesh> load_object_mesh(const std::string& file_path);
+    /* Creates a new Object struct based on the given properties. Loads the object file immediately, so its vertices & faces are known before pre-rendering. If there is an up-to-date mesh cache next to the file it is mapped instead, and otherwise one is written for next time. If an arena is given, the object is allocated in it (and should not be deleted), and otherwise on the heap. */
+    Object* create_object(const std::string& file_path, const glm::vec3& center, float scale, const glm::vec3& color, Tools::Arena* arena = nullptr);
+    /* Creates a new Object struct based on the given properties, which shares the given (already loaded) geometry of the given object file with other objects. If an arena is given, the object is allocated in it (and should not be deleted), and otherwise on the heap. */
+    Object* create_object(const std::shared_ptr<const ObjectMesh>& mesh, const std::string& file_path, const glm::vec3& center, float scale, const glm::vec3& color, Tools::Arena* arena = nullptr);
+    /* Loads the given Wavefront .obj file into the given buffers, overwriting whatever they contain. Supports the full vertex & face syntax (including texture / normal indices, negative indices and polygons, which are triangulated as fans), but only keeps the positions. Also computes the normals of the faces. Large files are parsed in parallel. */
+    void load_object_file(const std::string& file_path, Tools::Array<GFace>& faces_buffer, Tools::Array<glm::vec4>& vertex_buffer);
+    /* Returns the color of a face of an object with the given color, given the face's normal. Faces are lit as if the light comes from the default camera. */
+    inline glm::vec3 shade_object_face(const glm::vec3& color, const glm::vec3& normal) { return color * glm::abs(glm::dot(normal, glm::vec3(0.0f, 0.0f, -1.0f))); }
+    /* Pre-renders the object on the CPU, single-threaded, directly into the given ranges of pre_render_faces faces and pre_render_vertices vertices. Basically just places the vertices & faces loaded (or mapped) on creation in the world. The indices in the faces are offset by vertex_offset, i.e., where the vertex range starts in the entire buffer. Only writes to its own ranges, so entities may be pre-rendered concurrently. */
+    void cpu_pre_render_object(GFace* faces_buffer, glm::vec4* vertex_buffer, uint32_t vertex_offset, Object* obj);
 
 }
 
@@ -4,7 +4,7 @@
  * Created:
  *   30/04/2021, 13:08:59
  * Last edited:
- *   19/05/2021, 16:46:14
+ *   15/10/2026, 23:51:52
  * Auto updated?
  *   Yes
  *
@@ -86,6 +86,8 @@ namespace RayTracer::ECS {
         /* The number of vertices generated during pre-rendering for this entity. Note that we require this to be known _before_ pre-rendering starts. */
         uint32_t pre_render_vertices;
 
+        /* Virtual destructor for the RenderEntity struct, so entities that own data (like loaded objects) are cleaned up properly when deleted as a RenderEntity. */
+        virtual ~RenderEntity() = default;
     };
 }
 
@@ -0,0 +1,325 @@
+/* SCENE GENERATOR.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 15:41:12
+ * Last edited:
+ *   16/10/2026, 01:02:51
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the procedural scene generator, which fills a scene with a
+ *   given number of spheres, triangles and objects, spread uniformly, in
+ *   clusters or in clusters of clusters. The same description and seed
+ *   always give the same scene, so it can be used for scaling tests.
+**/
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <CppDebugger.hpp>
+
+#include "tools/Profiler.hpp"
+
+#include "Triangle.hpp"
+#include "Sphere.hpp"
+#include "Object.hpp"
+
+#include "SceneGenerator.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace RayTracer::ECS;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** CONSTANTS *****/
+/* The number of child clusters of every cluster in nested scenes. */
+static const constexpr uint32_t nested_branching = 8;
+/* The maximum depth of the cluster hierarchy in nested scenes. */
+static const constexpr uint32_t nested_max_depth = 6;
+/* How large a child cluster is relative to its parent in nested scenes. */
+static const constexpr float nested_child_scale = 0.3f;
+/* How large all clusters together are relative to the scene in clustered scenes, per axis. */
+static const constexpr float cluster_scale = 0.35f;
+
+
+
+
+
+/***** HELPER STRUCTS *****/
+/* A cubic part of the scene in which entities are placed. */
+struct SceneRegion {
+    /* The center of the region. */
+    glm::vec3 center;
+    /* Half the width of the region. */
+    float extent;
+};
+
+
+
+
+
+/***** HELPER FUNCTIONS *****/
+/* @brief Generates the next number of a xorshift32 sequence, which (unlike the std distributions) gives the same numbers on every platform.
+ * @param state The state of the generator, which is updated.
+ * @return A random float in [0, 1).
+ */
+static inline float random_float(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (float) (state >> 8) / 16777216.0f;
+}
+
+/* @brief Generates a random point in the cube from (-1, -1, -1) to (1, 1, 1).
+ * @param state The state of the generator, which is updated.
+ * @return The random point.
+ */
+static inline glm::vec3 random_in_cube(uint32_t& state) {
+    float x = 2.0f * random_float(state) - 1.0f;
+    float y = 2.0f * random_float(state) - 1.0f;
+    float z = 2.0f * random_float(state) - 1.0f;
+    return glm::vec3(x, y, z);
+}
+
+/* @brief Generates a random point in the cube from (-1, -1, -1) to (1, 1, 1) that's more likely to be near its center, by averaging three uniform points.
+ * @param state The state of the generator, which is updated.
+ * @return The random point.
+ */
+static inline glm::vec3 random_in_cube_centered(uint32_t& state) {
+    glm::vec3 a = random_in_cube(state);
+    glm::vec3 b = random_in_cube(state);
+    glm::vec3 c = random_in_cube(state);
+    return (a + b + c) / 3.0f;
+}
+
+/* @brief Generates a random, bright-ish color.
+ * @param state The state of the generator, which is updated.
+ * @return The random color.
+ */
+static inline glm::vec3 random_color(uint32_t& state) {
+    float r = 0.2f + 0.8f * random_float(state);
+    float g = 0.2f + 0.8f * random_float(state);
+    float b = 0.2f + 0.8f * random_float(state);
+    return glm::vec3(r, g, b);
+}
+
+/* @brief Divides the scene in the regions the entities are placed in, according to its distribution.
+ * @param spec The spec of the scene.
+ * @param state The state of the generator, which is updated.
+ * @return The regions, which all get about as many entities.
+ */
+static Tools::Array<SceneRegion> divide_scene(const SceneSpec& spec, uint32_t& state) {
+    DENTER("divide_scene");
+
+    uint32_t n_entities = spec.n_entities();
+    Tools::Array<SceneRegion> regions;
+    if (spec.distribution == SceneDistribution::sd_clustered) {
+        // Use about cbrt(n) clusters, which together fill a fixed part of the scene
+        uint32_t n_clusters = std::max(1U, (uint32_t) std::round(std::cbrt((float) n_entities)));
+        float cluster_extent = spec.extent * cluster_scale / std::cbrt((float) n_clusters);
+        regions.reserve(n_clusters);
+        for (uint32_t i = 0; i < n_clusters; i++) {
+            regions.push_back(SceneRegion({ spec.center + (spec.extent - cluster_extent) * random_in_cube(state), cluster_extent }));
+        }
+
+    } else if (spec.distribution == SceneDistribution::sd_nested) {
+        // Go deep enough that every leaf cluster gets at least a few entities
+        uint32_t depth = 1;
+        uint64_t n_leaves = nested_branching;
+        while (depth < nested_max_depth && n_leaves * nested_branching * 8 <= n_entities) {
+            ++depth;
+            n_leaves *= nested_branching;
+        }
+
+        // Place the children of every cluster in it, level by level
+        regions.push_back(SceneRegion({ spec.center, spec.extent }));
+        for (uint32_t d = 0; d < depth; d++) {
+            Tools::Array<SceneRegion> children(regions.size() * nested_branching);
+            for (size_t i = 0; i < regions.size(); i++) {
+                float child_extent = regions[i].extent * nested_child_scale;
+                for (uint32_t c = 0; c < nested_branching; c++) {
+                    children.push_back(SceneRegion({ regions[i].center + (regions[i].extent - child_extent) * random_in_cube(state), child_extent }));
+                }
+            }
+            regions = std::move(children);
+        }
+
+    } else {
+        regions.push_back(SceneRegion({ spec.center, spec.extent }));
+    }
+
+    DRETURN regions;
+}
+
+/* @brief Returns the radius of the bounding sphere (around the object's origin) of the given object mesh.
+ * @param mesh The mesh to measure.
+ * @return The radius, or 1 if the mesh has no vertices.
+ */
+static float object_radius(const ObjectMesh& mesh) {
+    const glm::vec4* vertices = mesh.vertex_data();
+    uint32_t n_vertices = mesh.n_vertices();
+
+    float max_length2 = 0.0f;
+    for (uint32_t i = 0; i < n_vertices; i++) {
+        glm::vec3 v(vertices[i]);
+        max_length2 = std::max(max_length2, glm::dot(v, v));
+    }
+    return max_length2 > 0.0f ? std::sqrt(max_length2) : 1.0f;
+}
+
+
+
+
+
+/***** SCENESPEC STRUCT *****/
+/* Default constructor for the SceneSpec struct, which describes an empty scene in front of the default camera. */
+SceneSpec::SceneSpec() :
+    n_spheres(0),
+    sphere_resolution(16),
+    n_triangles(0),
+    n_objects(0),
+    object_path("bin/objects/teddy.obj"),
+    distribution(SceneDistribution::sd_uniform),
+    center(0.0f, 0.0f, -6.0f),
+    extent(2.0f),
+    seed(42)
+{}
+
+
+
+/* Parses a comma-separated list of <key>=<value> pairs on top of the given spec, where the keys are 'spheres', 'resolution', 'triangles', 'objects', 'object', 'distribution', 'extent' and 'seed'. Returns an empty string on success, or a description of what's wrong otherwise. */
+std::string SceneSpec::parse(const std::string& text, SceneSpec& spec) {
+    DENTER("SceneSpec::parse");
+
+    std::stringstream sstr(text);
+    std::string pair;
+    while (std::getline(sstr, pair, ',')) {
+        if (pair.empty()) { continue; }
+
+        // Split the key from the value
+        size_t equals = pair.find('=');
+        if (equals == std::string::npos) {
+            DRETURN "Missing value for '" + pair + "' (expected <key>=<value>)";
+        }
+        std::string key = pair.substr(0, equals);
+        std::string value = pair.substr(equals + 1);
+
+        // Parse the value according to its key
+        try {
+            if (key == "spheres" || key == "resolution" || key == "triangles" || key == "objects" || key == "seed") {
+                unsigned long ivalue = std::stoul(value);
+                if (ivalue > std::numeric_limits<uint32_t>::max()) { DRETURN "Value of '" + key + "' is too large ('" + value + "')"; }
+                if (key == "spheres") { spec.n_spheres = (uint32_t) ivalue; }
+                else if (key == "resolution") {
+                    if (ivalue < 3) { DRETURN "Spheres need a resolution of at least 3, not '" + value + "'"; }
+                    spec.sphere_resolution = (uint32_t) ivalue;
+                }
+                else if (key == "triangles") { spec.n_triangles = (uint32_t) ivalue; }
+                else if (key == "objects") { spec.n_objects = (uint32_t) ivalue; }
+                else { spec.seed = (uint32_t) ivalue; }
+
+            } else if (key == "extent") {
+                float fvalue = std::stof(value);
+                if (!(fvalue > 0.0f)) { DRETURN "The extent of a scene should be positive, not '" + value + "'"; }
+                spec.extent = fvalue;
+
+            } else if (key == "object") {
+                if (value.empty()) { DRETURN "No object file given"; }
+                spec.object_path = value;
+
+            } else if (key == "distribution") {
+                if (value == scene_distribution_names[SceneDistribution::sd_uniform]) { spec.distribution = SceneDistribution::sd_uniform; }
+                else if (value == scene_distribution_names[SceneDistribution::sd_clustered]) { spec.distribution = SceneDistribution::sd_clustered; }
+                else if (value == scene_distribution_names[SceneDistribution::sd_nested]) { spec.distribution = SceneDistribution::sd_nested; }
+                else { DRETURN "Unknown distribution '" + value + "'"; }
+
+            } else {
+                DRETURN "Unknown scene property '" + key + "'";
+            }
+        } catch (std::invalid_argument&) {
+            DRETURN "Invalid value '" + value + "' for '" + key + "'";
+        } catch (std::out_of_range&) {
+            DRETURN "Value of '" + key + "' is too large ('" + value + "')";
+        }
+    }
+
+    DRETURN "";
+}
+
+
+
+
+
+/***** SCENE GENERATOR FUNCTIONS *****/
+/* Generates the scene described by the given spec. Its entities are sized such that they're about as far apart as they're large, whatever their number. If an arena is given, the entities are allocated in it (and should not be deleted), and otherwise on the heap. */
+Tools::Array<RenderEntity*> ECS::generate_scene(const SceneSpec& spec, Tools::Arena* arena) {
+    PENTER("ECS::generate_scene");
+
+    if (spec.n_spheres > 0 && spec.sphere_resolution < 3) {
+        DLOG(fatal, "Spheres need a resolution of at least 3, not " + std::to_string(spec.sphere_resolution));
+    }
+    uint32_t n_entities = spec.n_entities();
+    Tools::Array<RenderEntity*> result(n_entities);
+    if (n_entities == 0) { DRETURN result; }
+
+    // Make sure the generator never starts at the one state it can't leave
+    uint32_t state = spec.seed != 0 ? spec.seed : 0x9E3779B9;
+    Tools::Array<SceneRegion> regions = divide_scene(spec, state);
+
+    // Make the entities as large as the space they get in their region, halved so there's room between them
+    float region_entities = std::max(1.0f, (float) n_entities / (float) regions.size());
+    float base_radius = 0.25f * 2.0f * regions[0].extent / std::cbrt(region_entities);
+
+    // All objects come from the same file, so we load it only once and share it between them. We also only have to measure it once to know how to scale them
+    std::shared_ptr<const ObjectMesh> object_mesh;
+    float object_base_scale = 1.0f;
+    if (spec.n_objects > 0) {
+        object_mesh = load_object_mesh(spec.object_path);
+        object_base_scale = 1.0f / object_radius(*object_mesh);
+    }
+
+    // Every entity picks a random region and a random place within it
+    for (uint32_t i = 0; i < n_entities; i++) {
+        const SceneRegion& region = regions[std::min((size_t) (random_float(state) * (float) regions.size()), regions.size() - 1)];
+        glm::vec3 offset = spec.distribution == SceneDistribution::sd_clustered ? random_in_cube_centered(state) : random_in_cube(state);
+        glm::vec3 position = region.center + region.extent * offset;
+        float radius = base_radius * (0.5f + random_float(state));
+        glm::vec3 color = random_color(state);
+
+        if (i < spec.n_spheres) {
+            result.push_back(create_sphere(position, radius, spec.sphere_resolution, spec.sphere_resolution, color, arena));
+
+        } else if (i < spec.n_spheres + spec.n_triangles) {
+            // Make it an equilateral triangle in a random plane
+            glm::vec3 normal = random_in_cube(state);
+            if (glm::dot(normal, normal) < 1e-6f) { normal = glm::vec3(0.0f, 0.0f, 1.0f); }
+            normal = glm::normalize(normal);
+            glm::vec3 u = glm::normalize(glm::cross(std::fabs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f), normal));
+            glm::vec3 v = glm::cross(normal, u);
+            glm::vec3 points[3];
+            for (uint32_t p = 0; p < 3; p++) {
+                float angle = 2.0f * (float) M_PI * (float) p / 3.0f;
+                points[p] = position + radius * (cosf(angle) * u + sinf(angle) * v);
+            }
+            result.push_back(create_triangle(points[0], points[1], points[2], color, arena));
+
+        } else {
+            result.push_back(create_object(object_mesh, spec.object_path, position, radius * object_base_scale, color, arena));
+        }
+    }
+
+    DRETURN result;
+}
+
+/* Returns the total number of faces the given entities generate when pre-rendered. */
+uint64_t ECS::count_faces(const Tools::Array<RenderEntity*>& entities) {
+    uint64_t result = 0;
+    for (size_t i = 0; i < entities.size(); i++) {
+        result += entities[i]->pre_render_faces;
+    }
+    return result;
+}
@@ -0,0 +1,91 @@
+/* SCENE GENERATOR.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 15:41:07
+ * Last edited:
+ *   16/10/2026, 15:41:07
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the procedural scene generator, which fills a scene with a
+ *   given number of spheres, triangles and objects, spread uniformly, in
+ *   clusters or in clusters of clusters. The same description and seed
+ *   always give the same scene, so it can be used for scaling tests.
+**/
+
+#ifndef ENTITIES_SCENE_GENERATOR_HPP
+#define ENTITIES_SCENE_GENERATOR_HPP
+
+#include <string>
+
+#include "glm/glm.hpp"
+
+#include "RenderEntity.hpp"
+
+#include "tools/Array.hpp"
+#include "tools/Arena.hpp"
+
+namespace RayTracer::ECS {
+    /* The possible ways to spread the entities of a generated scene over its volume. */
+    enum SceneDistribution {
+        /* Spread all entities evenly over the volume. */
+        sd_uniform = 0,
+        /* Group the entities in a number of dense clusters, with empty space between them. */
+        sd_clustered = 1,
+        /* Group the entities in clusters of clusters of clusters, etc, so the scene is dense at every scale. */
+        sd_nested = 2
+    };
+    /* Maps a scene distribution to a string name. */
+    static const std::string scene_distribution_names[] = {
+        "uniform",
+        "clustered",
+        "nested"
+    };
+
+
+
+    /* The SceneSpec struct, which describes what kind of scene to generate. */
+    struct SceneSpec {
+        /* The number of spheres in the scene. */
+        uint32_t n_spheres;
+        /* The number of meridians & parallels of every sphere. */
+        uint32_t sphere_resolution;
+        /* The number of triangles in the scene. */
+        uint32_t n_triangles;
+        /* The number of objects in the scene. */
+        uint32_t n_objects;
+        /* The object file that all objects are loaded from. */
+        std::string object_path;
+
+        /* How the entities are spread over the volume of the scene. */
+        SceneDistribution distribution;
+        /* The center of the (cubic) volume of the scene. */
+        glm::vec3 center;
+        /* Half the width of the (cubic) volume of the scene. */
+        float extent;
+        /* The seed of the generator. */
+        uint32_t seed;
+
+
+        /* Default constructor for the SceneSpec struct, which describes an empty scene in front of the default camera. */
+        SceneSpec();
+
+        /* Returns the total number of entities in the scene. */
+        inline uint32_t n_entities() const { return this->n_spheres + this->n_triangles + this->n_objects; }
+
+        /* Parses a comma-separated list of <key>=<value> pairs on top of the given spec, where the keys are 'spheres', 'resolution', 'triangles', 'objects', 'object', 'distribution', 'extent' and 'seed'. Returns an empty string on success, or a description of what's wrong otherwise. */
+        static std::string parse(const std::string& text, SceneSpec& spec);
+    };
+
+
+
+    /* Generates the scene described by the given spec. Its entities are sized such that they're about as far apart as they're large, whatever their number. If an arena is given, the entities are allocated in it (and should not be deleted), and otherwise on the heap. */
+    Tools::Array<RenderEntity*> generate_scene(const SceneSpec& spec, Tools::Arena* arena = nullptr);
+    /* Returns the total number of faces the given entities generate when pre-rendered. */
+    uint64_t count_faces(const Tools::Array<RenderEntity*>& entities);
+
+}
+
+#endif
@@ -4,7 +4,7 @@
  * Created:
  *   01/05/2021, 12:45:50
  * Last edited:
- *   25/05/2021, 18:14:13
+ *   16/10/2026, 01:02:51
  * Auto updated?
  *   Yes
  *
@@ -29,6 +29,9 @@
 #include "tools/Common.hpp"
 #endif
 
+#include "tools/Tracing.hpp"
+#include "tools/Profiler.hpp"
+
 #include "Sphere.hpp"
 
 using namespace std;
@@ -67,7 +70,7 @@ struct SphereData {
 /***** HELPER FUNCTIONS *****/
 /* Computes the coordinates of a single point on the sphere. */
 static glm::vec3 compute_point(float fx, float fy, Sphere* sphere) {
-    DENTER("ECS::compute_point");
+    KENTER("ECS::compute_point");
 
     glm::vec3 result = sphere->center + sphere->radius * glm::vec3(
         sin(M_PI * (fy / (float) (sphere->n_parallels - 1))) * cos(2 * M_PI * (fx / (float) sphere->n_meridians)),
@@ -75,7 +78,7 @@ static glm::vec3 compute_point(float fx, float fy, Sphere* sphere) {
         sin(M_PI * (fy / (float) (sphere->n_parallels - 1))) * sin(2 * M_PI * (fx / (float) sphere->n_meridians))
     );
 
-    DRETURN result;
+    KRETURN result;
 }
 
 
@@ -83,12 +86,12 @@ static glm::vec3 compute_point(float fx, float fy, Sphere* sphere) {
 
 
 /***** SPHERE FUNCTIONS *****/
-/* Creates a new Sphere struct based on the given properties. */
-Sphere* ECS::create_sphere(const glm::vec3& center, float radius, uint32_t n_meridians, uint32_t n_parallels, const glm::vec3& color) {
+/* Creates a new Sphere struct based on the given properties. If an arena is given, the sphere is allocated in it (and should not be deleted), and otherwise on the heap. */
+Sphere* ECS::create_sphere(const glm::vec3& center, float radius, uint32_t n_meridians, uint32_t n_parallels, const glm::vec3& color, Tools::Arena* arena) {
     DENTER("ECS::create_sphere");
 
     // Allocate the struct
-    Sphere* result = new Sphere;
+    Sphere* result = arena != nullptr ? arena->create<Sphere>() : new Sphere;
 
     // Set the RenderEntity fields
     result->type = EntityType::et_sphere;
@@ -116,9 +119,9 @@ Sphere* ECS::create_sphere(const glm::vec3& center, float radius, uint32_t n_mer
 
 
 
-/* Pre-renders the sphere on the CPU, single-threaded, and returns a list of CPU-side buffers with the GFaces and the vertices. Assumes the given buffers contains irrelevant data, and already have the correct size. */
-void ECS::cpu_pre_render_sphere(Tools::Array<GFace>& faces_buffer, Tools::Array<glm::vec4>& vertex_buffer, Sphere* sphere) {
-    DENTER("ECS::cpu_pre_render_sphere");
+/* Pre-renders the sphere on the CPU, single-threaded, directly into the given ranges of pre_render_faces faces and pre_render_vertices vertices. The indices in the faces are offset by vertex_offset, i.e., where the vertex range starts in the entire buffer. Only writes to its own ranges, so entities may be pre-rendered concurrently. */
+void ECS::cpu_pre_render_sphere(GFace* faces_buffer, glm::vec4* vertex_buffer, uint32_t vertex_offset, Sphere* sphere) {
+    PENTER("ECS::cpu_pre_render_sphere");
     DLOG(info, "Pre-rendering sphere with " + std::to_string(sphere->n_meridians) + " meridians and " + std::to_string(sphere->n_parallels) + " parallels...");
     DINDENT;
 
@@ -346,14 +349,24 @@ void ECS::cpu_pre_render_sphere(Tools::Array<GFace>& faces_buffer, Tools::Array<
     //     });
     // }
 
+    // The faces above index the sphere's own vertices, so move them to where those are in the entire buffer
+    if (vertex_offset > 0) {
+        for (uint32_t i = 0; i < sphere->pre_render_faces; i++) {
+            faces_buffer[i].v1 += vertex_offset;
+            faces_buffer[i].v2 += vertex_offset;
+            faces_buffer[i].v3 += vertex_offset;
+        }
+    }
+
     // Done!
+    DDEDENT;
     DRETURN;
 }
 
 #ifdef ENABLE_VULKAN
 /* Pre-renders the sphere on the GPU using Vulkan compute shaders. Uses the given GPU-allocated buffers as target buffers, so we won't have to get the stuff back to the CPU. The given offsets specify from where the pre-rendering is safe to put its results, up until that offset plus the specified size in the Sphere. */
 void ECS::gpu_pre_render_sphere(const Compute::Buffer& faces_buffer, uint32_t faces_offset, const Compute::Buffer& vertex_buffer, uint32_t vertex_offset, Compute::Suite& gpu, Sphere* sphere) {
-    DENTER("ECS::gpu_pre_render_sphere");
+    PENTER("ECS::gpu_pre_render_sphere");
     DLOG(info, "Pre-rendering sphere with " + std::to_string(sphere->n_meridians) + " meridians and " + std::to_string(sphere->n_parallels) + " parallels...");
     DINDENT;
 
@@ -4,7 +4,7 @@
  * Created:
  *   01/05/2021, 11:59:00
  * Last edited:
- *   19/05/2021, 17:05:34
+ *   16/10/2026, 00:13:41
  * Auto updated?
  *   Yes
  *
@@ -22,6 +22,7 @@
 #include "RenderEntity.hpp"
 
 #include "tools/Array.hpp"
+#include "tools/Arena.hpp"
 
 #ifdef ENABLE_VULKAN
 #include <vulkan/vulkan.h>
@@ -46,11 +47,11 @@ namespace RayTracer::ECS {
 
 
 
-    /* Creates a new Sphere struct based on the given properties. */
-    Sphere* create_sphere(const glm::vec3& center, float radius, uint32_t n_meridians, uint32_t n_parallels, const glm::vec3& color);
+    /* Creates a new Sphere struct based on the given properties. If an arena is given, the sphere is allocated in it (and should not be deleted), and otherwise on the heap. */
+    Sphere* create_sphere(const glm::vec3& center, float radius, uint32_t n_meridians, uint32_t n_parallels, const glm::vec3& color, Tools::Arena* arena = nullptr);
 
-    /* Pre-renders the sphere on the CPU, single-threaded, and returns a list of CPU-side buffers with the GFaces and the vertices. Assumes the given buffers contains irrelevant data, and already have the correct size. */
-    void cpu_pre_render_sphere(Tools::Array<GFace>& faces_buffer, Tools::Array<glm::vec4>& vertex_buffer, Sphere* sphere);
+    /* Pre-renders the sphere on the CPU, single-threaded, directly into the given ranges of pre_render_faces faces and pre_render_vertices vertices. The indices in the faces are offset by vertex_offset, i.e., where the vertex range starts in the entire buffer. Only writes to its own ranges, so entities may be pre-rendered concurrently. */
+    void cpu_pre_render_sphere(GFace* faces_buffer, glm::vec4* vertex_buffer, uint32_t vertex_offset, Sphere* sphere);
     #ifdef ENABLE_VULKAN
     /* Pre-renders the sphere on the GPU using Vulkan compute shaders. Uses the given GPU-allocated buffers as target buffers, so we won't have to get the stuff back to the CPU. The given offsets specify from where the pre-rendering is safe to put its results, up until that offset plus the specified size in the Sphere. */
     void gpu_pre_render_sphere(const Compute::Buffer& faces_buffer, uint32_t faces_offset, const Compute::Buffer& vertex_buffer, uint32_t vertex_offset, Compute::Suite& gpu, Sphere* sphere);
@@ -4,7 +4,7 @@
  * Created:
  *   01/05/2021, 13:35:10
  * Last edited:
- *   25/05/2021, 18:14:13
+ *   16/10/2026, 01:02:51
  * Auto updated?
  *   Yes
  *
@@ -15,6 +15,8 @@
 #include <cmath>
 #include <CppDebugger.hpp>
 
+#include "tools/Profiler.hpp"
+
 #include "Triangle.hpp"
 
 using namespace std;
@@ -24,12 +26,12 @@ using namespace CppDebugger::SeverityValues;
 
 
 /***** SPHERE FUNCTIONS *****/
-/* Creates a new Triangle struct based on the given properties. */
-Triangle* ECS::create_triangle(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& color) {
+/* Creates a new Triangle struct based on the given properties. If an arena is given, the triangle is allocated in it (and should not be deleted), and otherwise on the heap. */
+Triangle* ECS::create_triangle(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& color, Tools::Arena* arena) {
     DENTER("ECS::create_triangle");
 
     // Allocate the struct
-    Triangle* result = new Triangle;
+    Triangle* result = arena != nullptr ? arena->create<Triangle>() : new Triangle;
 
     // Set the RenderEntity fields
     result->type = EntityType::et_triangle;
@@ -54,9 +56,9 @@ Triangle* ECS::create_triangle(const glm::vec3& p1, const glm::vec3& p2, const g
 
 
 
-/* Pre-renders the sphere on the CPU, single-threaded. */
-void ECS::cpu_pre_render_triangle(Tools::Array<GFace>& faces_buffer, Tools::Array<glm::vec4>& vertex_buffer, Triangle* triangle) {
-    DENTER("ECS::cpu_pre_render_triangle");
+/* Pre-renders the triangle on the CPU, single-threaded, directly into the given ranges of pre_render_faces faces and pre_render_vertices vertices. The indices in the faces are offset by vertex_offset, i.e., where the vertex range starts in the entire buffer. Only writes to its own ranges, so entities may be pre-rendered concurrently. */
+void ECS::cpu_pre_render_triangle(GFace* faces_buffer, glm::vec4* vertex_buffer, uint32_t vertex_offset, Triangle* triangle) {
+    PENTER("ECS::cpu_pre_render_triangle");
     DLOG(info, "Pre-rendering triangle...");
 
     // Copy the points
@@ -65,11 +67,11 @@ void ECS::cpu_pre_render_triangle(Tools::Array<GFace>& faces_buffer, Tools::Arra
     vertex_buffer[2] = glm::vec4(triangle->points[2], 0.0);
 
     // We set one vertex
-    faces_buffer = {{
-        0, 1, 2,
+    faces_buffer[0] = {
+        vertex_offset, vertex_offset + 1, vertex_offset + 2,
         triangle->normal,
         triangle->color
-    }};
+    };
 
     // Done!
     DRETURN;
@@ -4,7 +4,7 @@
  * Created:
  *   01/05/2021, 13:35:06
  * Last edited:
- *   19/05/2021, 17:27:31
+ *   16/10/2026, 00:13:41
  * Auto updated?
  *   Yes
  *
@@ -22,6 +22,7 @@
 #include "renderer/Vertex.hpp"
 
 #include "tools/Array.hpp"
+#include "tools/Arena.hpp"
 
 namespace RayTracer::ECS {
     /* The Triangle struct, which builds on the RenderEntity struct in an entity-component-system way. */
@@ -36,11 +37,11 @@ namespace RayTracer::ECS {
 
 
 
-    /* Creates a new Triangle struct based on the given properties. */
-    Triangle* create_triangle(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& color);
+    /* Creates a new Triangle struct based on the given properties. If an arena is given, the triangle is allocated in it (and should not be deleted), and otherwise on the heap. */
+    Triangle* create_triangle(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& color, Tools::Arena* arena = nullptr);
 
-    /* Pre-renders the sphere on the CPU, single-threaded. */
-    void cpu_pre_render_triangle(Tools::Array<GFace>& faces_buffer, Tools::Array<glm::vec4>& vertex_buffer, Triangle* triangle);
+    /* Pre-renders the triangle on the CPU, single-threaded, directly into the given ranges of pre_render_faces faces and pre_render_vertices vertices. The indices in the faces are offset by vertex_offset, i.e., where the vertex range starts in the entire buffer. Only writes to its own ranges, so entities may be pre-rendered concurrently. */
+    void cpu_pre_render_triangle(GFace* faces_buffer, glm::vec4* vertex_buffer, uint32_t vertex_offset, Triangle* triangle);
 
 }
 
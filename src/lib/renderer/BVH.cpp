@@ -0,0 +1,571 @@
+/* BVH.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   15/10/2026, 14:02:16
+ * Last edited:
+ *   16/10/2026, 01:02:51
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the BVH class, which is a bounding volume hierarchy over the
+ *   pre-rendered faces and analytic spheres of a scene. It is built in two
+ *   levels: first a subtree per entity, after which a top-level tree is
+ *   built over the bounds of those entities. Both levels use a binned
+ *   surface-area heuristic to decide where to split. When entities move,
+ *   the tree is refitted and only rebuilt where it has degraded too much.
+**/
+
+#include <algorithm>
+#include <CppDebugger.hpp>
+
+#include "tools/Tracing.hpp"
+#include "tools/Profiler.hpp"
+
+#include "BVH.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** CONSTANTS *****/
+/* The maximum number of primitives in a leaf for which we accept that the SAH can't find a better split. Larger leaves are split at the median instead. */
+static const constexpr uint32_t max_leaf_size = 8;
+/* The depth after which the top-level tree stops evaluating the SAH and simply splits at the median, to keep the total depth of the tree bounded. */
+static const constexpr uint32_t max_sah_entity_depth = 16;
+/* The maximum depth of an entity's subtree, if the top-level tree leaves enough room for it. */
+static const constexpr uint32_t max_primitive_depth = BVH::max_depth / 2;
+
+
+
+
+
+/***** HELPER FUNCTIONS *****/
+/* @brief Computes the maximum depth of the top-level tree over the given number of entities. It evaluates the SAH until max_sah_entity_depth, which may split off as little as a single entity per level, and then splits the rest at the median.
+ * @param n_entities The number of entities in the top-level tree.
+ * @return The depth of the deepest leaf the top-level tree can have.
+ */
+static inline uint32_t max_entity_depth(uint32_t n_entities) {
+    uint32_t median_depth = 0;
+    while (median_depth < 32 && (1ULL << median_depth) < n_entities) { ++median_depth; }
+    return max_sah_entity_depth + median_depth;
+}
+
+/* @brief Computes the bounding box of the given primitive.
+ * @param faces The list of faces in the scene.
+ * @param vertices The list of vertices referred to by the faces.
+ * @param spheres The list of spheres in the scene.
+ * @param i The index of the primitive, which is a face if it's smaller than the number of faces and a sphere otherwise.
+ * @return The bounding box of the primitive.
+ */
+static inline AABB primitive_box(const Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, const Tools::Array<GSphere>& spheres, uint32_t i) {
+    AABB box;
+    if (i < faces.size()) {
+        box.grow(glm::vec3(vertices[faces[i].v1]));
+        box.grow(glm::vec3(vertices[faces[i].v2]));
+        box.grow(glm::vec3(vertices[faces[i].v3]));
+    } else {
+        const GSphere& sphere = spheres[i - (uint32_t) faces.size()];
+        box = AABB(sphere.center - sphere.radius, sphere.center + sphere.radius);
+    }
+    return box;
+}
+
+/* @brief Computes the (unnormalized) SAH cost of a single node, i.e., its area times the cost of traversing it or intersecting its primitives.
+ * @param node The node to compute the cost of.
+ * @return The cost of the node.
+ */
+static inline float node_cost(const BVHNode& node) {
+    return AABB(node.min, node.max).area() * (node.is_leaf() ? (float) node.count : BVH::traversal_cost);
+}
+
+/* @brief Finds the best split for the given range of primitives using the binned surface-area heuristic.
+ * @param bounds The list of bounding boxes of all primitives.
+ * @param indices The list of indices into the bounds, of which we consider a range.
+ * @param first The first index in the range to consider.
+ * @param count The number of indices in the range to consider.
+ * @param centroid_bounds The bounds of the centroids of all primitives in the range.
+ * @param best_axis Is set to the axis along which to split.
+ * @param best_split Is set to the bin index: all primitives in a lower bin go left.
+ * @return The cost of the best split found, relative to intersecting a primitive, or 1e30 if no split could be found.
+ */
+static float find_split(const ScratchArray<AABB>& bounds, const ScratchArray<uint32_t>& indices, uint32_t first, uint32_t count, const AABB& centroid_bounds, uint32_t& best_axis, uint32_t& best_split) {
+    KENTER("find_split");
+
+    // Prepare the bins
+    struct Bin {
+        AABB bounds;
+        uint32_t count = 0;
+    };
+
+    float best_cost = 1e30f;
+    for (uint32_t a = 0; a < 3; a++) {
+        float cmin = centroid_bounds.min[a], cmax = centroid_bounds.max[a];
+        if (cmin == cmax) { continue; }
+
+        // Sort all primitives in the bins
+        Bin bins[BVH::n_bins];
+        float scale = (float) BVH::n_bins / (cmax - cmin);
+        for (uint32_t i = first; i < first + count; i++) {
+            const AABB& box = bounds[indices[i]];
+            uint32_t b = std::min(BVH::n_bins - 1, (uint32_t) ((box.centroid()[a] - cmin) * scale));
+            bins[b].count++;
+            bins[b].bounds.grow(box);
+        }
+
+        // Sweep from both sides to get the areas & counts left and right of each plane
+        float left_area[BVH::n_bins - 1], right_area[BVH::n_bins - 1];
+        uint32_t left_count[BVH::n_bins - 1], right_count[BVH::n_bins - 1];
+        AABB left_box, right_box;
+        uint32_t left_sum = 0, right_sum = 0;
+        for (uint32_t i = 0; i < BVH::n_bins - 1; i++) {
+            left_sum += bins[i].count;
+            left_count[i] = left_sum;
+            left_box.grow(bins[i].bounds);
+            left_area[i] = left_box.area();
+
+            right_sum += bins[BVH::n_bins - 1 - i].count;
+            right_count[BVH::n_bins - 2 - i] = right_sum;
+            right_box.grow(bins[BVH::n_bins - 1 - i].bounds);
+            right_area[BVH::n_bins - 2 - i] = right_box.area();
+        }
+
+        // Evaluate each plane
+        for (uint32_t i = 0; i < BVH::n_bins - 1; i++) {
+            if (left_count[i] == 0 || right_count[i] == 0) { continue; }
+            float cost = left_count[i] * left_area[i] + right_count[i] * right_area[i];
+            if (cost < best_cost) {
+                best_axis = a;
+                best_split = i + 1;
+                best_cost = cost;
+            }
+        }
+    }
+
+    // Done
+    KRETURN best_cost;
+}
+
+/* @brief Partitions the given range of indices, either at the given SAH split or, if none was given, at the median along the largest axis.
+ * @return The index of the first element in the right half.
+ */
+static uint32_t partition(const ScratchArray<AABB>& bounds, ScratchArray<uint32_t>& indices, uint32_t first, uint32_t count, const AABB& centroid_bounds, bool use_sah, uint32_t axis, uint32_t split) {
+    KENTER("partition");
+
+    uint32_t* begin = indices.wdata() + first;
+    uint32_t* end = begin + count;
+    if (use_sah) {
+        // Move everything left of the plane to the left
+        float cmin = centroid_bounds.min[axis];
+        float scale = (float) BVH::n_bins / (centroid_bounds.max[axis] - cmin);
+        uint32_t* middle = std::partition(begin, end, [&bounds, axis, split, cmin, scale](uint32_t i) {
+            return std::min(BVH::n_bins - 1, (uint32_t) ((bounds[i].centroid()[axis] - cmin) * scale)) < split;
+        });
+        KRETURN first + (uint32_t) (middle - begin);
+    }
+
+    // Otherwise, do the median along the largest axis
+    glm::vec3 extent = centroid_bounds.max - centroid_bounds.min;
+    axis = extent.x > extent.y && extent.x > extent.z ? 0 : (extent.y > extent.z ? 1 : 2);
+    uint32_t* middle = begin + count / 2;
+    std::nth_element(begin, middle, end, [&bounds, axis](uint32_t i1, uint32_t i2) {
+        return bounds[i1].centroid()[axis] < bounds[i2].centroid()[axis];
+    });
+    KRETURN first + count / 2;
+}
+
+
+
+
+
+/***** BVH CLASS *****/
+/* Default constructor for the BVH class, which initializes an empty tree. */
+BVH::BVH() :
+    top_cost(0.0f),
+    n_unused(0),
+    primitive_depth(max_primitive_depth)
+{}
+
+
+
+/* Builds a subtree (of at most the given depth) over the given range of primitives in the given node, appending any children to the given node list. The given list of primitive indices is reordered to match the leaves. */
+void BVH::build_primitives(ScratchArray<BVHNode>& nodes, uint32_t node_i, uint32_t depth, uint32_t max_depth, const ScratchArray<AABB>& primitive_bounds, ScratchArray<uint32_t>& indices, uint32_t first, uint32_t count) {
+    KENTER("BVH::build_primitives");
+
+    // Compute the bounds of the node and of the centroids in it
+    AABB bounds, centroid_bounds;
+    for (uint32_t i = first; i < first + count; i++) {
+        const AABB& box = primitive_bounds[indices[i]];
+        bounds.grow(box);
+        centroid_bounds.grow(box.centroid());
+    }
+    nodes[node_i].min = bounds.min;
+    nodes[node_i].max = bounds.max;
+
+    // Decide how to split the node, if at all
+    uint32_t axis = 0, split = 0;
+    float cost = count > 1 && depth < max_depth ? find_split(primitive_bounds, indices, first, count, centroid_bounds, axis, split) : 1e30f;
+    bool use_sah = cost < 1e30f && BVH::traversal_cost * bounds.area() + cost < count * bounds.area();
+    if (!use_sah && (count <= max_leaf_size || depth >= max_depth)) {
+        // Make it a leaf
+        nodes[node_i].left_first = first;
+        nodes[node_i].count = count;
+        KRETURN;
+    }
+
+    // Otherwise, split the node
+    uint32_t middle = partition(primitive_bounds, indices, first, count, centroid_bounds, use_sah, axis, split);
+    uint32_t left = (uint32_t) nodes.size();
+    nodes.push_back(BVHNode());
+    nodes.push_back(BVHNode());
+    nodes[node_i].left_first = left;
+    nodes[node_i].count = 0;
+
+    // Recurse into the children
+    build_primitives(nodes, left, depth + 1, max_depth, primitive_bounds, indices, first, middle - first);
+    build_primitives(nodes, left + 1, depth + 1, max_depth, primitive_bounds, indices, middle, first + count - middle);
+
+    KRETURN;
+}
+
+/* Builds the top-level tree over the given (list of indices of) entities, relocating their subtrees below it. */
+void BVH::build_entities(uint32_t node_i, uint32_t depth, const ScratchArray<BVHNode>& entity_nodes, const ScratchArray<uint32_t>& entity_sizes, const ScratchArray<AABB>& entity_bounds, ScratchArray<uint32_t>& indices, uint32_t first, uint32_t count) {
+    KENTER("BVH::build_entities");
+
+    // If there is only one entity left, move its subtree to this node
+    if (count == 1) {
+        BVHEntity& entity = this->entities[indices[first]];
+        uint32_t root = entity.root;
+        uint32_t n_nodes = entity_sizes[indices[first]];
+
+        // Copy the root to this node, and everything else to the end of the list
+        uint32_t base = (uint32_t) this->nodes.size();
+        for (uint32_t i = root; i < root + n_nodes; i++) {
+            // Relocate the child pointer of inner nodes
+            BVHNode node = entity_nodes[i];
+            if (!node.is_leaf()) { node.left_first = base + (node.left_first - root - 1); }
+
+            // Store it
+            if (i == root) {
+                this->nodes[node_i] = node;
+            } else {
+                this->nodes.push_back(node);
+            }
+        }
+        entity.root = node_i;
+        entity.first_node = base;
+        entity.n_nodes = n_nodes;
+
+        KRETURN;
+    }
+
+    // Compute the bounds of the node and of the centroids in it
+    AABB bounds, centroid_bounds;
+    for (uint32_t i = first; i < first + count; i++) {
+        const AABB& box = entity_bounds[indices[i]];
+        bounds.grow(box);
+        centroid_bounds.grow(box.centroid());
+    }
+    this->nodes[node_i].min = bounds.min;
+    this->nodes[node_i].max = bounds.max;
+
+    // Always split the node, but only evaluate the SAH while we're not too deep
+    uint32_t axis = 0, split = 0;
+    float cost = depth < max_sah_entity_depth ? find_split(entity_bounds, indices, first, count, centroid_bounds, axis, split) : 1e30f;
+    uint32_t middle = partition(entity_bounds, indices, first, count, centroid_bounds, cost < 1e30f, axis, split);
+    uint32_t left = (uint32_t) this->nodes.size();
+    this->nodes.push_back(BVHNode());
+    this->nodes.push_back(BVHNode());
+    this->nodes[node_i].left_first = left;
+    this->nodes[node_i].count = 0;
+    this->top_nodes.push_back(node_i);
+
+    // Recurse into the children
+    this->build_entities(left, depth + 1, entity_nodes, entity_sizes, entity_bounds, indices, first, middle - first);
+    this->build_entities(left + 1, depth + 1, entity_nodes, entity_sizes, entity_bounds, indices, middle, first + count - middle);
+
+    KRETURN;
+}
+
+
+
+/* Computes the SAH cost of the subtree of the given entity, relative to the area of its root. */
+float BVH::entity_cost(const BVHEntity& entity) const {
+    const BVHNode& root = this->nodes[entity.root];
+    float root_area = AABB(root.min, root.max).area();
+    if (root_area <= 0.0f) { return 0.0f; }
+
+    float cost = node_cost(root);
+    for (uint32_t i = entity.first_node; i < entity.first_node + entity.n_nodes - 1; i++) {
+        cost += node_cost(this->nodes[i]);
+    }
+    return cost / root_area;
+}
+
+/* Computes the SAH cost of the top-level tree (without the entities' subtrees), relative to the area of the root. */
+float BVH::top_level_cost() const {
+    if (this->top_nodes.size() == 0) { return 0.0f; }
+    float root_area = AABB(this->nodes[0].min, this->nodes[0].max).area();
+    if (root_area <= 0.0f) { return 0.0f; }
+
+    float cost = 0.0f;
+    for (size_t i = 0; i < this->top_nodes.size(); i++) {
+        cost += node_cost(this->nodes[this->top_nodes[i]]);
+    }
+    return cost / root_area;
+}
+
+/* Recomputes the bounds of every node in the subtree of the given entity from its primitives, bottom-up. */
+void BVH::refit_entity(BVHEntity& entity, const Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, const Tools::Array<GSphere>& spheres) {
+    KENTER("BVH::refit_entity");
+
+    // Children are always stored after their parents, so going backwards visits them first. The root is stored before everything else
+    for (uint32_t j = entity.n_nodes; j-- > 0; ) {
+        BVHNode& node = this->nodes[j == 0 ? entity.root : entity.first_node + j - 1];
+        if (node.is_leaf()) {
+            AABB box;
+            for (uint32_t i = node.left_first; i < node.left_first + node.count; i++) {
+                box.grow(primitive_box(faces, vertices, spheres, i));
+            }
+            node.min = box.min;
+            node.max = box.max;
+        } else {
+            const BVHNode& left = this->nodes[node.left_first];
+            const BVHNode& right = this->nodes[node.left_first + 1];
+            node.min = glm::min(left.min, right.min);
+            node.max = glm::max(left.max, right.max);
+        }
+    }
+    entity.bounds = AABB(this->nodes[entity.root].min, this->nodes[entity.root].max);
+
+    KRETURN;
+}
+
+/* Rebuilds the subtree of the given entity from scratch, re-ordering its faces or spheres to match. Re-uses the nodes of the old subtree if the new one fits, and appends it to the node list otherwise. */
+void BVH::rebuild_entity(BVHEntity& entity, Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, Tools::Array<GSphere>& spheres, Tools::Arena& scratch) {
+    PENTER("BVH::rebuild_entity");
+
+    // Collect the bounds of the entity's primitives only
+    uint32_t first_primitive = entity.n_faces > 0 ? entity.first_face : (uint32_t) faces.size() + entity.first_sphere;
+    uint32_t count = entity.n_faces > 0 ? entity.n_faces : entity.n_spheres;
+    Tools::ArenaAllocator allocator(scratch);
+    ScratchArray<AABB> primitive_bounds(count, allocator);
+    ScratchArray<uint32_t> indices(count, allocator);
+    for (uint32_t i = 0; i < count; i++) {
+        primitive_bounds.push_back(primitive_box(faces, vertices, spheres, first_primitive + i));
+        indices.push_back(i);
+    }
+
+    // Build the new subtree separately, with its primitives counted from the start of the entity's range
+    ScratchArray<BVHNode> subtree_nodes(2 * count, allocator);
+    subtree_nodes.push_back(BVHNode());
+    build_primitives(subtree_nodes, 0, 0, this->primitive_depth, primitive_bounds, indices, 0, count);
+
+    // Store it in place of the old one if it fits, or at the end otherwise. The root stays where it is, so the top-level tree needn't know
+    uint32_t n_nodes = (uint32_t) subtree_nodes.size();
+    bool fits = n_nodes <= entity.n_nodes;
+    uint32_t base = fits ? entity.first_node : (uint32_t) this->nodes.size();
+    this->n_unused += fits ? entity.n_nodes - n_nodes : entity.n_nodes - 1;
+    for (uint32_t j = 0; j < n_nodes; j++) {
+        BVHNode node = subtree_nodes[j];
+        if (node.is_leaf()) {
+            node.left_first += first_primitive;
+        } else {
+            node.left_first = base + node.left_first - 1;
+        }
+
+        if (j == 0) {
+            this->nodes[entity.root] = node;
+        } else if (fits) {
+            this->nodes[base + j - 1] = node;
+        } else {
+            this->nodes.push_back(node);
+        }
+    }
+    entity.first_node = base;
+    entity.n_nodes = n_nodes;
+    entity.bounds = AABB(this->nodes[entity.root].min, this->nodes[entity.root].max);
+    entity.cost = this->entity_cost(entity);
+
+    // Finally, reorder the faces or spheres in the entity's range to match the leaves
+    if (entity.n_faces > 0) {
+        ScratchArray<GFace> unordered_faces(count, allocator);
+        for (uint32_t i = 0; i < count; i++) {
+            unordered_faces.push_back(faces[entity.first_face + i]);
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            faces[entity.first_face + i] = unordered_faces[indices[i]];
+        }
+    } else {
+        ScratchArray<GSphere> unordered_spheres(count, allocator);
+        for (uint32_t i = 0; i < count; i++) {
+            unordered_spheres.push_back(spheres[entity.first_sphere + i]);
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            spheres[entity.first_sphere + i] = unordered_spheres[indices[i]];
+        }
+    }
+
+    DRETURN;
+}
+
+
+
+/* Builds the tree over the given faces & vertices and spheres. The given list of entities describes which ranges of faces or spheres belong to which entities, and each entity gets its own subtree. Note that the faces and spheres are re-ordered within each entity's range to match the leaves of the tree. Any temporary memory is allocated in the given arena, which may be reset once this returns. */
+void BVH::build(Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, Tools::Array<GSphere>& spheres, const Tools::Array<BVHEntity>& entities, Tools::Arena& scratch) {
+    PENTER("BVH::build");
+    DLOG(info, "Building BVH over " + std::to_string(faces.size()) + " faces and " + std::to_string(spheres.size()) + " spheres in " + std::to_string(entities.size()) + " entities...");
+    DINDENT;
+
+    // Throw out the old tree
+    this->nodes.clear();
+    this->top_nodes.clear();
+    this->n_unused = 0;
+    this->entities = entities;
+
+    // Compute the bounds of all primitives (faces first, then spheres), and initialize the index list to the identity
+    uint32_t n_primitives = (uint32_t) (faces.size() + spheres.size());
+    Tools::ArenaAllocator allocator(scratch);
+    ScratchArray<AABB> primitive_bounds(n_primitives, allocator);
+    ScratchArray<uint32_t> indices(n_primitives, allocator);
+    for (uint32_t i = 0; i < n_primitives; i++) {
+        primitive_bounds.push_back(primitive_box(faces, vertices, spheres, i));
+        indices.push_back(i);
+    }
+
+    // Every entity's subtree ends up below a leaf of the top-level tree, so together they may not be deeper than the traversal stack
+    uint32_t n_filled = 0;
+    for (uint32_t i = 0; i < entities.size(); i++) {
+        if (entities[i].n_faces > 0 || entities[i].n_spheres > 0) { ++n_filled; }
+    }
+    uint32_t entity_depth = max_entity_depth(n_filled);
+    if (entity_depth >= BVH::max_depth) {
+        DLOG(fatal, "Cannot build a BVH over " + std::to_string(n_filled) + " entities, since its top-level tree may be " + std::to_string(entity_depth) + " nodes deep, while at most " + std::to_string(BVH::max_depth) + " is supported.");
+    }
+    this->primitive_depth = std::min(max_primitive_depth, BVH::max_depth - entity_depth);
+
+    // Build the subtree for each entity in a separate list, to be relocated later
+    ScratchArray<BVHNode> entity_nodes(2 * n_primitives, allocator);
+    ScratchArray<uint32_t> entity_sizes(entities.size(), allocator);
+    ScratchArray<AABB> entity_bounds(entities.size(), allocator);
+    ScratchArray<uint32_t> entity_indices(entities.size(), allocator);
+    for (uint32_t i = 0; i < this->entities.size(); i++) {
+        BVHEntity& entity = this->entities[i];
+        if (entity.n_faces == 0 && entity.n_spheres == 0) {
+            entity.root = std::numeric_limits<uint32_t>::max();
+            entity.first_node = 0;
+            entity.n_nodes = 0;
+            entity.cost = 0.0f;
+            entity_sizes.push_back(0);
+            entity_bounds.push_back(AABB());
+            continue;
+        }
+
+        // Build the subtree
+        entity.root = (uint32_t) entity_nodes.size();
+        entity_nodes.push_back(BVHNode());
+        if (entity.n_faces > 0) {
+            build_primitives(entity_nodes, entity.root, 0, this->primitive_depth, primitive_bounds, indices, entity.first_face, entity.n_faces);
+        } else {
+            build_primitives(entity_nodes, entity.root, 0, this->primitive_depth, primitive_bounds, indices, (uint32_t) faces.size() + entity.first_sphere, entity.n_spheres);
+        }
+        entity.bounds = AABB(entity_nodes[entity.root].min, entity_nodes[entity.root].max);
+        entity_sizes.push_back((uint32_t) entity_nodes.size() - entity.root);
+        entity_bounds.push_back(entity.bounds);
+
+        // Mark that this entity should appear in the top-level tree
+        entity_indices.push_back(i);
+    }
+
+    // Next, build the top-level tree over all entities with primitives
+    if (entity_indices.size() > 0) {
+        this->nodes.reserve(entity_nodes.size() + 2 * entity_indices.size());
+        this->nodes.push_back(BVHNode());
+        this->build_entities(0, 0, entity_nodes, entity_sizes, entity_bounds, entity_indices, 0, (uint32_t) entity_indices.size());
+    }
+
+    // Remember how good all trees are, so we know when refitting has made them too bad
+    for (uint32_t i = 0; i < entity_indices.size(); i++) {
+        BVHEntity& entity = this->entities[entity_indices[i]];
+        entity.cost = this->entity_cost(entity);
+    }
+    this->top_cost = this->top_level_cost();
+
+    // Finally, reorder the faces and spheres so the leaves can refer to them directly. Since entities never mix the two, faces stay among faces and spheres among spheres. We reorder from a scratch copy, so the buffers themselves stay where they are
+    ScratchArray<GFace> unordered_faces(faces.size(), allocator);
+    for (uint32_t i = 0; i < faces.size(); i++) {
+        unordered_faces.push_back(faces[i]);
+    }
+    for (uint32_t i = 0; i < faces.size(); i++) {
+        faces[i] = unordered_faces[indices[i]];
+    }
+    ScratchArray<GSphere> unordered_spheres(spheres.size(), allocator);
+    for (uint32_t i = 0; i < spheres.size(); i++) {
+        unordered_spheres.push_back(spheres[i]);
+    }
+    for (uint32_t i = 0; i < spheres.size(); i++) {
+        spheres[i] = unordered_spheres[indices[faces.size() + i] - faces.size()];
+    }
+
+    DLOG(info, "Built BVH with " + std::to_string(this->nodes.size()) + " nodes (" + std::to_string(this->size()) + " bytes)");
+    DDEDENT;
+    DRETURN;
+}
+
+/* Updates the tree after the primitives of the given entities have moved. Their subtrees are refitted bottom-up, and only those whose SAH cost grew by more than the given factor are rebuilt (which re-orders their faces or spheres). If the top-level tree degrades too much as well, everything is rebuilt. Returns whether that happened, in which case the faces and spheres of all entities may have been re-ordered. */
+bool BVH::refit(Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, Tools::Array<GSphere>& spheres, const Tools::Array<uint32_t>& moved, Tools::Arena& scratch, float threshold) {
+    PENTER("BVH::refit");
+
+    // First, update the subtrees of the entities that moved
+    uint32_t n_rebuilt = 0;
+    for (size_t i = 0; i < moved.size(); i++) {
+        if (moved[i] >= this->entities.size()) {
+            DLOG(fatal, "Cannot refit entity " + std::to_string(moved[i]) + ", since the BVH only has " + std::to_string(this->entities.size()) + " entities.");
+        }
+        BVHEntity& entity = this->entities[moved[i]];
+        if (entity.root == std::numeric_limits<uint32_t>::max()) { continue; }
+
+        // Refitting keeps the tree's topology, which only works as long as the primitives didn't move too much relative to each other
+        this->refit_entity(entity, faces, vertices, spheres);
+        if (this->entity_cost(entity) > threshold * entity.cost) {
+            this->rebuild_entity(entity, faces, vertices, spheres, scratch);
+            ++n_rebuilt;
+        }
+    }
+
+    // Next, refit the top-level tree. Going through its inner nodes backwards visits all children before their parents
+    for (size_t i = this->top_nodes.size(); i-- > 0; ) {
+        BVHNode& node = this->nodes[this->top_nodes[i]];
+        const BVHNode& left = this->nodes[node.left_first];
+        const BVHNode& right = this->nodes[node.left_first + 1];
+        node.min = glm::min(left.min, right.min);
+        node.max = glm::max(left.max, right.max);
+    }
+
+    // If the entities have moved so much that the top-level tree is bad now, or if rebuilding subtrees has left too many nodes unused, start over
+    if (this->top_level_cost() > threshold * this->top_cost || this->n_unused > this->nodes.size() / 2) {
+        DLOG(info, "Top-level tree has degraded too much; rebuilding the entire BVH...");
+        Tools::Array<BVHEntity> entities(this->entities);
+        this->build(faces, vertices, spheres, entities, scratch);
+        DRETURN true;
+    }
+
+    DLOG(info, "Refitted " + std::to_string(moved.size()) + " entities, of which " + std::to_string(n_rebuilt) + " had to be rebuilt");
+    DRETURN false;
+}
+
+/* Clears the tree. */
+void BVH::clear() {
+    DENTER("BVH::clear");
+
+    this->nodes.clear();
+    this->entities.clear();
+    this->top_nodes.clear();
+    this->top_cost = 0.0f;
+    this->n_unused = 0;
+    this->primitive_depth = max_primitive_depth;
+
+    DRETURN;
+}
@@ -0,0 +1,321 @@
+/* BVH.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   15/10/2026, 14:02:11
+ * Last edited:
+ *   16/10/2026, 00:57:51
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the BVH class, which is a bounding volume hierarchy over the
+ *   pre-rendered faces and analytic spheres of a scene. It is built in two
+ *   levels: first a subtree per entity, after which a top-level tree is
+ *   built over the bounds of those entities. Both levels use a binned
+ *   surface-area heuristic to decide where to split. When entities move,
+ *   the tree is refitted and only rebuilt where it has degraded too much.
+**/
+
+#ifndef RENDERER_BVH_HPP
+#define RENDERER_BVH_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include "glm/glm.hpp"
+
+#include "tools/Array.hpp"
+#include "tools/Arena.hpp"
+
+#include "Vertex.hpp"
+#include "RayPacket.hpp"
+
+namespace RayTracer {
+    /* The AABB struct, which represents a single axis-aligned bounding box. */
+    struct AABB {
+        /* The lower corner of the box. */
+        glm::vec3 min;
+        /* The upper corner of the box. */
+        glm::vec3 max;
+
+        /* Default constructor for the AABB struct, which initializes it to an empty (inverted) box. */
+        AABB(): min(1e30f), max(-1e30f) {}
+        /* Constructor for the AABB struct, which takes the two corners of the box. */
+        AABB(const glm::vec3& min, const glm::vec3& max): min(min), max(max) {}
+
+        /* Grows the box to include the given point. */
+        inline void grow(const glm::vec3& point) { this->min = glm::min(this->min, point); this->max = glm::max(this->max, point); }
+        /* Grows the box to include the given box. */
+        inline void grow(const AABB& other) { this->min = glm::min(this->min, other.min); this->max = glm::max(this->max, other.max); }
+        /* Returns the center point of the box. */
+        inline glm::vec3 centroid() const { return 0.5f * (this->min + this->max); }
+        /* Returns (half) the surface area of the box, which is all the SAH needs. Returns 0 for empty boxes. */
+        inline float area() const { glm::vec3 e = this->max - this->min; return e.x < 0.0f ? 0.0f : e.x * e.y + e.y * e.z + e.z * e.x; }
+    };
+
+
+
+    /* The BVHNode struct, which is a single node in the BVH. Is padded to exactly 32 bytes so two nodes fit in a single cache line. */
+    struct BVHNode {
+        /* The lower corner of the node's bounding box. */
+        glm::vec3 min;
+        /* For inner nodes, the index of the left child (the right child is always at left_first + 1). For leaves, the index of the first primitive in the leaf. */
+        uint32_t left_first;
+        /* The upper corner of the node's bounding box. */
+        glm::vec3 max;
+        /* The number of primitives in this node if it is a leaf, or 0 if it is an inner node. */
+        uint32_t count;
+
+        /* Returns whether or not this node is a leaf. */
+        inline bool is_leaf() const { return this->count > 0; }
+    };
+
+    /* The BVHEntity struct, which describes the range of faces & vertices or the range of spheres that a single entity has been pre-rendered to. An entity has either faces or spheres, never both. */
+    struct BVHEntity {
+        /* The index of the first face of this entity in the global faces buffer. */
+        uint32_t first_face;
+        /* The number of faces that belong to this entity. */
+        uint32_t n_faces;
+        /* The index of the first vertex of this entity in the global vertex buffer. */
+        uint32_t first_vertex;
+        /* The number of vertices that belong to this entity. */
+        uint32_t n_vertices;
+        /* The index of the first sphere of this entity in the global sphere buffer. */
+        uint32_t first_sphere;
+        /* The number of spheres that belong to this entity. */
+        uint32_t n_spheres;
+
+        /* The index of the node in the BVH that is the root of this entity's subtree. Set by the BVH during building. */
+        uint32_t root;
+        /* The index of the node where the rest of this entity's subtree starts, which is stored contiguously. Set by the BVH during building. */
+        uint32_t first_node;
+        /* The number of nodes in this entity's subtree, including its root. Set by the BVH during building. */
+        uint32_t n_nodes;
+        /* The SAH cost of this entity's subtree when it was last built, which tells how much refitting has degraded it. Set by the BVH during building. */
+        float cost;
+        /* The bounding box of the entire entity. Set by the BVH during building. */
+        AABB bounds;
+    };
+
+
+
+    /* Shorthand for the temporary arrays used while building a BVH, which are allocated in a scratch arena. */
+    template <class T>
+    using ScratchArray = Tools::Array<T, Tools::ArenaAllocator>;
+
+
+
+    /* The BVH class, which is a bounding volume hierarchy over a list of (indexed) faces and spheres. Both are referred to as primitives, where primitive i is face i if i is smaller than the number of faces, and sphere i minus the number of faces otherwise. */
+    class BVH {
+    public:
+        /* The number of bins used per axis when evaluating the surface-area heuristic. */
+        static const constexpr uint32_t n_bins = 16;
+        /* The (relative) cost of traversing a single node, as used by the surface-area heuristic. Intersecting a face is considered to cost 1.0. */
+        static const constexpr float traversal_cost = 1.0f;
+        /* The maximum depth of the tree. Is also the size of the traversal stack, so building a deeper tree is an error. */
+        static const constexpr uint32_t max_depth = 64;
+        /* The factor by which refitting may increase the SAH cost of a subtree before it is rebuilt instead. */
+        static const constexpr float max_degradation = 1.3f;
+
+    private:
+        /* The list of nodes in the tree. The first node is always the root. */
+        Tools::Array<BVHNode> nodes;
+        /* The list of entities in the tree, including the node where their subtree starts. */
+        Tools::Array<BVHEntity> entities;
+        /* The inner nodes of the top-level tree, in the order they were created (so parents come before their children). */
+        Tools::Array<uint32_t> top_nodes;
+        /* The SAH cost of the top-level tree when it was last built. */
+        float top_cost;
+        /* The number of nodes that are no longer part of the tree, because an entity's subtree was rebuilt elsewhere. */
+        uint32_t n_unused;
+        /* The maximum depth of the entities' subtrees, which is whatever the top-level tree leaves of max_depth. */
+        uint32_t primitive_depth;
+
+        /* Builds a subtree (of at most the given depth) over the given range of primitives in the given node, appending any children to the given node list. The given list of primitive indices is reordered to match the leaves. */
+        static void build_primitives(ScratchArray<BVHNode>& nodes, uint32_t node_i, uint32_t depth, uint32_t max_depth, const ScratchArray<AABB>& primitive_bounds, ScratchArray<uint32_t>& indices, uint32_t first, uint32_t count);
+        /* Builds the top-level tree over the given (list of indices of) entities in the given node, relocating their subtrees (of the given sizes) from the given list of entity nodes to below it. */
+        void build_entities(uint32_t node_i, uint32_t depth, const ScratchArray<BVHNode>& entity_nodes, const ScratchArray<uint32_t>& entity_sizes, const ScratchArray<AABB>& entity_bounds, ScratchArray<uint32_t>& indices, uint32_t first, uint32_t count);
+        /* Computes the SAH cost of the subtree of the given entity, relative to the area of its root. */
+        float entity_cost(const BVHEntity& entity) const;
+        /* Computes the SAH cost of the top-level tree (without the entities' subtrees), relative to the area of the root. */
+        float top_level_cost() const;
+        /* Recomputes the bounds of every node in the subtree of the given entity from its primitives, bottom-up. */
+        void refit_entity(BVHEntity& entity, const Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, const Tools::Array<GSphere>& spheres);
+        /* Rebuilds the subtree of the given entity from scratch, re-ordering its faces or spheres to match. Re-uses the nodes of the old subtree if the new one fits, and appends it to the node list otherwise. */
+        void rebuild_entity(BVHEntity& entity, Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, Tools::Array<GSphere>& spheres, Tools::Arena& scratch);
+
+    public:
+        /* Default constructor for the BVH class, which initializes an empty tree. */
+        BVH();
+
+        /* Builds the tree over the given faces & vertices and spheres. The given list of entities describes which ranges of faces or spheres belong to which entities, and each entity gets its own subtree. Note that the faces and spheres are re-ordered within each entity's range to match the leaves of the tree. Any temporary memory is allocated in the given arena, which may be reset once this returns. */
+        void build(Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, Tools::Array<GSphere>& spheres, const Tools::Array<BVHEntity>& entities, Tools::Arena& scratch);
+        /* Updates the tree after the primitives of the given entities have moved. Their subtrees are refitted bottom-up, and only those whose SAH cost grew by more than the given factor are rebuilt (which re-orders their faces or spheres). If the top-level tree degrades too much as well, everything is rebuilt. Returns whether that happened, in which case the faces and spheres of all entities may have been re-ordered. */
+        bool refit(Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, Tools::Array<GSphere>& spheres, const Tools::Array<uint32_t>& moved, Tools::Arena& scratch, float threshold = BVH::max_degradation);
+        /* Clears the tree. */
+        void clear();
+
+        /* Traverses the tree with the given ray, calling the given hit function for every primitive in a leaf whose box is hit before the closest hit found so far. The hit function takes the index of a primitive and returns its distance (or a negative value / value >= min_t if it isn't hit). Returns the index of the closest primitive hit, and stores its distance in min_t. If nothing is hit, returns std::numeric_limits<uint32_t>::max() and leaves min_t untouched. If compiled with COUNT_RAYS and n_visited is given, adds the number of nodes visited to it. */
+        template <class HIT_FUNC>
+        inline uint32_t traverse(const glm::vec3& origin, const glm::vec3& direction, float& min_t, HIT_FUNC hit_primitive, uint64_t* n_visited = nullptr) const;
+        #if PACKET_SIZE > 1
+        /* Traverses the tree with the given packet of rays, calling the given hit function for every primitive in a leaf whose box may be hit by any ray in the packet. The hit function takes the index of a primitive and the packet, and should update the packet's min_t and hit for every ray that hits the primitive closer than before. Nodes are culled for the packet as a whole first, and only then tested per ray. If compiled with COUNT_RAYS and n_visited is given, adds the number of nodes visited by the packet to it. */
+        template <class HIT_FUNC>
+        inline void traverse(RayPacket& packet, HIT_FUNC hit_primitive, uint64_t* n_visited = nullptr) const;
+        #endif
+
+        /* Returns the list of entities in the tree, including their bounding boxes. */
+        inline const Tools::Array<BVHEntity>& get_entities() const { return this->entities; }
+        /* Returns the list of nodes in the tree. */
+        inline const Tools::Array<BVHNode>& get_nodes() const { return this->nodes; }
+        /* Returns the size of the tree in bytes. */
+        inline size_t size() const { return this->nodes.size() * sizeof(BVHNode); }
+        /* Returns whether or not the tree is empty. */
+        inline bool empty() const { return this->nodes.size() == 0; }
+
+    };
+
+
+
+    /* Computes the distance along the given ray (with precomputed inverse direction) where it enters the given box, or 1e30 if it doesn't hit the box before max_t. */
+    inline float hit_box(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& inv_direction, float max_t) {
+        glm::vec3 t1 = (min - origin) * inv_direction;
+        glm::vec3 t2 = (max - origin) * inv_direction;
+        glm::vec3 tmin = glm::min(t1, t2);
+        glm::vec3 tmax = glm::max(t1, t2);
+        float t_enter = glm::max(glm::max(tmin.x, tmin.y), tmin.z);
+        float t_exit = glm::min(glm::min(tmax.x, tmax.y), tmax.z);
+        return t_exit >= t_enter && t_exit >= 0.0f && t_enter < max_t ? t_enter : 1e30f;
+    }
+
+    /* Traverses the tree with the given ray, calling the given hit function for every primitive in a leaf whose box is hit before the closest hit found so far. The hit function takes the index of a primitive and returns its distance (or a negative value / value >= min_t if it isn't hit). Returns the index of the closest primitive hit, and stores its distance in min_t. If nothing is hit, returns std::numeric_limits<uint32_t>::max() and leaves min_t untouched. If compiled with COUNT_RAYS and n_visited is given, adds the number of nodes visited to it. */
+    template <class HIT_FUNC>
+    inline uint32_t BVH::traverse(const glm::vec3& origin, const glm::vec3& direction, float& min_t, HIT_FUNC hit_primitive, uint64_t* n_visited) const {
+        #ifndef COUNT_RAYS
+        (void) n_visited;
+        #endif
+        uint32_t min_i = std::numeric_limits<uint32_t>::max();
+        if (this->nodes.size() == 0) { return min_i; }
+
+        // Precompute the inverse direction for the slab tests
+        glm::vec3 inv_direction = 1.0f / direction;
+
+        // Traverse the tree depth-first, nearest child first
+        struct { const BVHNode* node; float t; } stack[BVH::max_depth];
+        uint32_t stack_size = 0;
+        const BVHNode* node = &this->nodes[0];
+        if (hit_box(node->min, node->max, origin, inv_direction, min_t) >= 1e30f) { return min_i; }
+        while (true) {
+            #ifdef COUNT_RAYS
+            if (n_visited != nullptr) { ++*n_visited; }
+            #endif
+            if (node->is_leaf()) {
+                // Test all primitives in the leaf
+                for (uint32_t i = node->left_first; i < node->left_first + node->count; i++) {
+                    float t = hit_primitive(i);
+                    if (t >= 0 && t < min_t) {
+                        min_i = i;
+                        min_t = t;
+                    }
+                }
+            } else {
+                // Test both children, and visit the closest one first
+                const BVHNode* child1 = &this->nodes[node->left_first];
+                const BVHNode* child2 = &this->nodes[node->left_first + 1];
+                float t1 = hit_box(child1->min, child1->max, origin, inv_direction, min_t);
+                float t2 = hit_box(child2->min, child2->max, origin, inv_direction, min_t);
+                if (t1 > t2) {
+                    std::swap(t1, t2);
+                    std::swap(child1, child2);
+                }
+                if (t1 < 1e30f) {
+                    // Push the far child (if hit) and continue with the near one
+                    if (t2 < 1e30f) {
+                        assert(stack_size < BVH::max_depth);
+                        stack[stack_size++] = { child2, t2 };
+                    }
+                    node = child1;
+                    continue;
+                }
+            }
+
+            // Pop the next node from the stack, skipping those that are further away than what we've already hit
+            do {
+                if (stack_size == 0) { return min_i; }
+                --stack_size;
+            } while (stack[stack_size].t >= min_t);
+            node = stack[stack_size].node;
+        }
+    }
+
+    #if PACKET_SIZE > 1
+    /* Traverses the tree with the given packet of rays, calling the given hit function for every primitive in a leaf whose box may be hit by any ray in the packet. The hit function takes the index of a primitive and the packet, and should update the packet's min_t and hit for every ray that hits the primitive closer than before. Nodes are culled for the packet as a whole first, and only then tested per ray. If compiled with COUNT_RAYS and n_visited is given, adds the number of nodes visited by the packet to it. */
+    template <class HIT_FUNC>
+    inline void BVH::traverse(RayPacket& packet, HIT_FUNC hit_primitive, uint64_t* n_visited) const {
+        #ifndef COUNT_RAYS
+        (void) n_visited;
+        #endif
+        if (this->nodes.size() == 0) { return; }
+
+        // Nodes further away than max_t are further away than the closest hit of every ray, and can thus be skipped
+        float max_t = hmax(packet.min_t);
+
+        // Traverse the tree depth-first, nearest child first
+        struct { const BVHNode* node; float t; } stack[BVH::max_depth];
+        uint32_t stack_size = 0;
+        const BVHNode* node = &this->nodes[0];
+        floatp t_enter;
+        if (!packet_may_hit_box(node->min, node->max, packet, max_t) || !any(packet_hit_box(node->min, node->max, packet, t_enter))) { return; }
+        while (true) {
+            #ifdef COUNT_RAYS
+            if (n_visited != nullptr) { ++*n_visited; }
+            #endif
+            if (node->is_leaf()) {
+                // Test all primitives in the leaf
+                for (uint32_t i = node->left_first; i < node->left_first + node->count; i++) {
+                    hit_primitive(i, packet);
+                }
+                max_t = hmax(packet.min_t);
+            } else {
+                // Test both children, first for the packet as a whole and then per ray, and visit the closest one first
+                const BVHNode* child1 = &this->nodes[node->left_first];
+                const BVHNode* child2 = &this->nodes[node->left_first + 1];
+                float t1 = 1e30f, t2 = 1e30f;
+                if (packet_may_hit_box(child1->min, child1->max, packet, max_t)) {
+                    intp mask = packet_hit_box(child1->min, child1->max, packet, t_enter);
+                    t1 = hmin(t_enter, mask);
+                }
+                if (packet_may_hit_box(child2->min, child2->max, packet, max_t)) {
+                    intp mask = packet_hit_box(child2->min, child2->max, packet, t_enter);
+                    t2 = hmin(t_enter, mask);
+                }
+                if (t1 > t2) {
+                    std::swap(t1, t2);
+                    std::swap(child1, child2);
+                }
+                if (t1 < 1e30f) {
+                    // Push the far child (if hit) and continue with the near one
+                    if (t2 < 1e30f) {
+                        assert(stack_size < BVH::max_depth);
+                        stack[stack_size++] = { child2, t2 };
+                    }
+                    node = child1;
+                    continue;
+                }
+            }
+
+            // Pop the next node from the stack, skipping those that are further away than what all rays have already hit
+            do {
+                if (stack_size == 0) { return; }
+                --stack_size;
+            } while (stack[stack_size].t >= max_t);
+            node = stack[stack_size].node;
+        }
+    }
+    #endif
+}
+
+#endif
@@ -0,0 +1,202 @@
+/* RAY PACKET.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   15/10/2026, 16:20:05
+ * Last edited:
+ *   15/10/2026, 23:47:32
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the RayPacket struct, which bundles PACKET_SIZE coherent rays
+ *   with a shared origin in structure-of-arrays form, so they can be traced
+ *   together using SIMD instructions. The lanes are GCC / Clang vector
+ *   types, which the compiler maps onto SSE, AVX2 or AVX-512 registers
+ *   depending on the target architecture.
+**/
+
+#ifndef RENDERER_RAY_PACKET_HPP
+#define RENDERER_RAY_PACKET_HPP
+
+#include <cstdint>
+#include <cmath>
+
+#include "glm/glm.hpp"
+
+/* The number of rays per packet. If 1, the renderers trace single rays instead. */
+#ifndef PACKET_SIZE
+#define PACKET_SIZE 1
+#endif
+
+#if PACKET_SIZE != 1 && PACKET_SIZE != 4 && PACKET_SIZE != 8 && PACKET_SIZE != 16
+#error "PACKET_SIZE must be 1, 4, 8 or 16"
+#endif
+
+#if PACKET_SIZE > 1
+
+#if defined(__SSE__) || defined(__AVX__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace RayTracer {
+    /* The number of rays in a single packet. */
+    static const constexpr uint32_t packet_size = PACKET_SIZE;
+    /* The width (in pixels) of the block of pixels covered by a single packet. */
+    static const constexpr uint32_t packet_width = PACKET_SIZE == 4 ? 2 : 4;
+    /* The height (in pixels) of the block of pixels covered by a single packet. */
+    static const constexpr uint32_t packet_height = PACKET_SIZE / packet_width;
+
+    /* A single float per ray in the packet. */
+    typedef float floatp __attribute__((vector_size(PACKET_SIZE * sizeof(float))));
+    /* A single (signed) integer per ray in the packet. Comparisons between floatps result in this type, with all bits set for lanes where the comparison is true. */
+    typedef int32_t intp __attribute__((vector_size(PACKET_SIZE * sizeof(int32_t))));
+
+    /* Returns a floatp with all lanes set to the given value. */
+    inline floatp broadcast(float value) { floatp result = {}; return result + value; }
+    /* Returns an intp with all lanes set to the given value. */
+    inline intp broadcast(int32_t value) { intp result = {}; return result + value; }
+    /* Returns, per lane, the value of a if the mask is set or the value of b if it isn't. */
+    inline floatp select(intp mask, floatp a, floatp b) { return (floatp) ((mask & (intp) a) | (~mask & (intp) b)); }
+    /* Returns, per lane, the value of a if the mask is set or the value of b if it isn't. */
+    inline intp select(intp mask, intp a, intp b) { return (mask & a) | (~mask & b); }
+    /* Returns the per-lane minimum of the two given values. */
+    inline floatp vmin(floatp a, floatp b) { return select(a < b, a, b); }
+    /* Returns the per-lane maximum of the two given values. */
+    inline floatp vmax(floatp a, floatp b) { return select(a > b, a, b); }
+    /* Returns the per-lane square root of the given value. Uses a single sqrt instruction if the instruction set for this packet size is available. */
+    inline floatp vsqrt(floatp value) {
+        #if PACKET_SIZE == 4 && defined(__SSE__)
+        return (floatp) _mm_sqrt_ps((__m128) value);
+        #elif PACKET_SIZE == 8 && defined(__AVX__)
+        return (floatp) _mm256_sqrt_ps((__m256) value);
+        #elif PACKET_SIZE == 16 && defined(__AVX512F__)
+        return (floatp) _mm512_sqrt_ps((__m512) value);
+        #else
+        for (uint32_t i = 0; i < packet_size; i++) { value[i] = std::sqrt(value[i]); }
+        return value;
+        #endif
+    }
+    /* Returns whether any lane in the given mask is set. Uses a single movemask instruction if the instruction set for this packet size is available. */
+    inline bool any(intp mask) {
+        #if PACKET_SIZE == 4 && defined(__SSE__)
+        return _mm_movemask_ps((__m128) mask) != 0;
+        #elif PACKET_SIZE == 8 && defined(__AVX__)
+        return _mm256_movemask_ps((__m256) mask) != 0;
+        #elif PACKET_SIZE == 16 && defined(__AVX512F__)
+        return _mm512_test_epi32_mask((__m512i) mask, (__m512i) mask) != 0;
+        #else
+        int32_t result = 0;
+        for (uint32_t i = 0; i < packet_size; i++) { result |= mask[i]; }
+        return result != 0;
+        #endif
+    }
+    /* Returns the smallest value of all lanes where the given mask is set, or 1e30 if none is. */
+    inline float hmin(floatp value, intp mask) {
+        value = select(mask, value, broadcast(1e30f));
+        float result = value[0];
+        for (uint32_t i = 1; i < packet_size; i++) { result = value[i] < result ? value[i] : result; }
+        return result;
+    }
+    /* Returns the largest value of all lanes. */
+    inline float hmax(floatp value) {
+        float result = value[0];
+        for (uint32_t i = 1; i < packet_size; i++) { result = value[i] > result ? value[i] : result; }
+        return result;
+    }
+
+
+
+    /* The RayPacket struct, which represents PACKET_SIZE rays with the same origin. */
+    struct RayPacket {
+        /* The origin shared by all rays. */
+        glm::vec3 origin;
+        /* The x-components of the directions of the rays. */
+        floatp dx;
+        /* The y-components of the directions of the rays. */
+        floatp dy;
+        /* The z-components of the directions of the rays. */
+        floatp dz;
+        /* The x-components of the inverse directions of the rays. */
+        floatp inv_dx;
+        /* The y-components of the inverse directions of the rays. */
+        floatp inv_dy;
+        /* The z-components of the inverse directions of the rays. */
+        floatp inv_dz;
+
+        /* The distance to the closest hit per ray so far. */
+        floatp min_t;
+        /* The index of the closest face hit per ray so far, or -1 if there isn't any. */
+        intp hit;
+
+        /* The smallest inverse direction over all rays, per axis. Only meaningful for axes that are coherent. */
+        glm::vec3 inv_min;
+        /* The largest inverse direction over all rays, per axis. Only meaningful for axes that are coherent. */
+        glm::vec3 inv_max;
+        /* Whether all rays point in the same (non-zero) direction along each axis. Only coherent axes are used to cull the packet as a whole. */
+        bool coherent[3];
+
+        /* Computes the inverse directions and the packet-wide bounds from the directions, and resets the hits. Call after setting the origin and directions. */
+        inline void prepare() {
+            this->inv_dx = 1.0f / this->dx;
+            this->inv_dy = 1.0f / this->dy;
+            this->inv_dz = 1.0f / this->dz;
+            this->min_t = broadcast(1e30f);
+            this->hit = broadcast((int32_t) -1);
+
+            const floatp* d[3] = { &this->dx, &this->dy, &this->dz };
+            const floatp* inv_d[3] = { &this->inv_dx, &this->inv_dy, &this->inv_dz };
+            for (uint32_t a = 0; a < 3; a++) {
+                bool positive = (*d[a])[0] > 0.0f;
+                this->coherent[a] = true;
+                this->inv_min[a] = (*inv_d[a])[0];
+                this->inv_max[a] = (*inv_d[a])[0];
+                for (uint32_t i = 0; i < packet_size; i++) {
+                    float value = (*d[a])[i];
+                    if (value == 0.0f || (value > 0.0f) != positive) { this->coherent[a] = false; }
+                    this->inv_min[a] = glm::min(this->inv_min[a], (*inv_d[a])[i]);
+                    this->inv_max[a] = glm::max(this->inv_max[a], (*inv_d[a])[i]);
+                }
+            }
+        }
+
+        /* Returns the direction of the ray in the given lane. */
+        inline glm::vec3 direction(uint32_t i) const { return glm::vec3(this->dx[i], this->dy[i], this->dz[i]); }
+    };
+
+
+
+    /* Returns whether the given box may be hit by any of the rays in the packet before their closest hit so far. Uses interval arithmetic over the packet's coherent axes, so it is conservative: it may return true for boxes that no ray hits, but never false for boxes that some ray does hit. */
+    inline bool packet_may_hit_box(const glm::vec3& min, const glm::vec3& max, const RayPacket& packet, float max_t) {
+        float t_enter = -1e30f, t_exit = 1e30f;
+        for (uint32_t a = 0; a < 3; a++) {
+            if (!packet.coherent[a]) { continue; }
+
+            // Since all rays point the same way, they all enter through the same plane
+            bool positive = packet.inv_min[a] > 0.0f;
+            float near_plane = (positive ? min[a] : max[a]) - packet.origin[a];
+            float far_plane = (positive ? max[a] : min[a]) - packet.origin[a];
+
+            // Bound the distances over the range of inverse directions
+            float near1 = near_plane * packet.inv_min[a], near2 = near_plane * packet.inv_max[a];
+            float far1 = far_plane * packet.inv_min[a], far2 = far_plane * packet.inv_max[a];
+            t_enter = glm::max(t_enter, glm::min(near1, near2));
+            t_exit = glm::min(t_exit, glm::max(far1, far2));
+        }
+        return t_enter <= t_exit && t_exit >= 0.0f && t_enter < max_t;
+    }
+
+    /* Computes, per ray in the packet, the distance where it enters the given box. Returns a mask of the rays that hit the box before their closest hit so far. */
+    inline intp packet_hit_box(const glm::vec3& min, const glm::vec3& max, const RayPacket& packet, floatp& t_enter) {
+        floatp tx1 = (min.x - packet.origin.x) * packet.inv_dx, tx2 = (max.x - packet.origin.x) * packet.inv_dx;
+        floatp ty1 = (min.y - packet.origin.y) * packet.inv_dy, ty2 = (max.y - packet.origin.y) * packet.inv_dy;
+        floatp tz1 = (min.z - packet.origin.z) * packet.inv_dz, tz2 = (max.z - packet.origin.z) * packet.inv_dz;
+        t_enter = vmax(vmax(vmin(tx1, tx2), vmin(ty1, ty2)), vmin(tz1, tz2));
+        floatp t_exit = vmin(vmin(vmax(tx1, tx2), vmax(ty1, ty2)), vmax(tz1, tz2));
+        return (t_exit >= t_enter) & (t_exit >= 0.0f) & (t_enter < packet.min_t);
+    }
+}
+
+#endif
+
+#endif
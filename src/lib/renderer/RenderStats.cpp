@@ -0,0 +1,151 @@
+/* RENDER STATS.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 16:05:27
+ * Last edited:
+ *   16/10/2026, 16:05:27
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the RenderStats struct, which collects what a renderer did
+ *   and how long it took: pre-rendering per entity type, building the
+ *   acceleration structures, and the rays, intersection tests and node
+ *   visits of every thread while rendering. Can be written as JSON.
+**/
+
+#include <fstream>
+#include <algorithm>
+#include <CppDebugger.hpp>
+
+#include "RenderStats.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** HELPER FUNCTIONS *****/
+/* @brief Writes the given counter to the given stream, or null if the counter isn't counted.
+ * @param os The stream to write to.
+ * @param value The value of the counter.
+ * @param counted Whether the counter is counted at all.
+ */
+static inline void write_counter(std::ostream& os, uint64_t value, bool counted) {
+    if (counted) { os << value; }
+    else { os << "null"; }
+}
+
+
+
+
+
+/***** RENDERSTATS STRUCT *****/
+/* Constructor for the RenderStats struct, which takes the number of threads that do work for the renderer. */
+RenderStats::RenderStats(uint32_t n_threads) {
+    this->reset(n_threads);
+}
+
+
+
+/* Throws away all statistics so far, optionally changing the number of threads. */
+void RenderStats::reset(uint32_t n_threads) {
+    for (size_t t = 0; t < n_entity_types; t++) {
+        this->prerender_entities[t] = 0;
+        this->prerender_faces[t] = 0;
+    }
+    this->prerender_time = 0.0;
+    this->acceleration_time = 0.0;
+    this->acceleration_bytes = 0;
+    this->frames = 0;
+    this->pixels = 0;
+    this->render_time = 0.0;
+    // Only the CPU kernels count their tests & visits
+    #if defined(COUNT_RAYS) && !defined(ENABLE_VULKAN)
+    this->counted = true;
+    #else
+    this->counted = false;
+    #endif
+
+    // Zero the threads, keeping their number unless told otherwise
+    size_t size = n_threads > 0 ? n_threads : std::max((size_t) 1, this->threads.size());
+    this->threads.assign(size, ThreadStats{});
+}
+
+
+
+/* Returns the sum of the statistics of all threads. */
+ThreadStats RenderStats::total() const {
+    ThreadStats result{};
+    for (size_t i = 0; i < this->threads.size(); i++) {
+        for (size_t t = 0; t < n_entity_types; t++) {
+            result.prerender_time[t] += this->threads[i].prerender_time[t];
+        }
+        result.rays += this->threads[i].rays;
+        result.intersection_tests += this->threads[i].intersection_tests;
+        result.node_visits += this->threads[i].node_visits;
+        result.busy_time += this->threads[i].busy_time;
+    }
+    return result;
+}
+
+/* Returns the number of rays traced per second of rendering, in millions. */
+double RenderStats::mrays_per_second() const {
+    return this->render_time > 0.0 ? (double) this->total().rays / this->render_time / 1e6 : 0.0;
+}
+
+
+
+/* Writes the statistics as a JSON document to the given stream. */
+void RenderStats::write_json(std::ostream& os) const {
+    ThreadStats total = this->total();
+
+    os << "{" << endl;
+    os << "    \"prerender\": {" << endl;
+    os << "        \"time_ms\": " << this->prerender_time * 1e3 << "," << endl;
+    os << "        \"entities\": {" << endl;
+    for (size_t t = 1; t < n_entity_types; t++) {
+        os << "            \"" << ECS::entity_type_names[t] << "\": { \"count\": " << this->prerender_entities[t] << ", \"faces\": " << this->prerender_faces[t] << ", \"time_ms\": " << total.prerender_time[t] * 1e3 << " }" << (t < n_entity_types - 1 ? "," : "") << endl;
+    }
+    os << "        }" << endl;
+    os << "    }," << endl;
+    os << "    \"acceleration\": {" << endl;
+    os << "        \"time_ms\": " << this->acceleration_time * 1e3 << "," << endl;
+    os << "        \"bytes\": " << this->acceleration_bytes << endl;
+    os << "    }," << endl;
+    os << "    \"render\": {" << endl;
+    os << "        \"frames\": " << this->frames << "," << endl;
+    os << "        \"pixels\": " << this->pixels << "," << endl;
+    os << "        \"time_ms\": " << this->render_time * 1e3 << "," << endl;
+    os << "        \"rays\": " << total.rays << "," << endl;
+    os << "        \"intersection_tests\": "; write_counter(os, total.intersection_tests, this->counted); os << "," << endl;
+    os << "        \"node_visits\": "; write_counter(os, total.node_visits, this->counted); os << "," << endl;
+    os << "        \"mrays_per_second\": " << this->mrays_per_second() << endl;
+    os << "    }," << endl;
+    os << "    \"threads\": [" << endl;
+    for (size_t i = 0; i < this->threads.size(); i++) {
+        const ThreadStats& thread = this->threads[i];
+        os << "        { \"busy_ms\": " << thread.busy_time * 1e3 << ", \"idle_ms\": " << std::max(0.0, this->render_time - thread.busy_time) * 1e3 << ", \"rays\": " << thread.rays << ", \"intersection_tests\": ";
+        write_counter(os, thread.intersection_tests, this->counted);
+        os << ", \"node_visits\": ";
+        write_counter(os, thread.node_visits, this->counted);
+        os << " }" << (i < this->threads.size() - 1 ? "," : "") << endl;
+    }
+    os << "    ]" << endl;
+    os << "}" << endl;
+}
+
+/* Writes the statistics as a JSON document to the file at the given path. */
+void RenderStats::write_json(const std::string& path) const {
+    DENTER("RenderStats::write_json");
+
+    std::ofstream h(path);
+    if (!h.is_open()) {
+        DLOG(fatal, "Could not open '" + path + "' to write the statistics to");
+    }
+    this->write_json(h);
+    h.close();
+
+    DRETURN;
+}
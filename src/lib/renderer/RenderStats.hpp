@@ -0,0 +1,106 @@
+/* RENDER STATS.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 16:05:22
+ * Last edited:
+ *   16/10/2026, 16:05:22
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the RenderStats struct, which collects what a renderer did
+ *   and how long it took: pre-rendering per entity type, building the
+ *   acceleration structures, and the rays, intersection tests and node
+ *   visits of every thread while rendering. Can be written as JSON.
+**/
+
+#ifndef RENDERER_RENDER_STATS_HPP
+#define RENDERER_RENDER_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ostream>
+
+#include "entities/RenderEntity.hpp"
+
+/* Adds the given amount to the given counter, but only if the kernels are compiled with counters (COUNT_RAYS). */
+#ifdef COUNT_RAYS
+#define STATS_COUNT(COUNTER, AMOUNT) \
+    ((COUNTER) += (AMOUNT))
+#else
+#define STATS_COUNT(COUNTER, AMOUNT) \
+    ((void) (COUNTER))
+#endif
+
+namespace RayTracer {
+    /* The number of entity types that the statistics keep apart. */
+    static const constexpr size_t n_entity_types = ECS::EntityType::et_object + 1;
+
+
+
+    /* The ThreadStats struct, which holds the statistics that a single thread collects. Every thread only ever writes its own, and they're aligned to a cache line to avoid false sharing, so no counter needs to be atomic. */
+    struct alignas(64) ThreadStats {
+        /* The time (in seconds) spent pre-rendering entities of each type. */
+        double prerender_time[n_entity_types];
+        /* The number of rays traced. */
+        uint64_t rays;
+        /* The number of ray/primitive intersection tests (zero if compiled without COUNT_RAYS). */
+        uint64_t intersection_tests;
+        /* The number of BVH nodes visited, per ray or per packet of rays (zero if compiled without COUNT_RAYS). */
+        uint64_t node_visits;
+        /* The time (in seconds) spent tracing rays. */
+        double busy_time;
+    };
+
+    /* The RenderStats struct, which collects the statistics of a renderer from the last time they were reset. */
+    struct RenderStats {
+        /* The number of entities of each type that were pre-rendered. */
+        uint64_t prerender_entities[n_entity_types];
+        /* The number of faces generated for entities of each type. */
+        uint64_t prerender_faces[n_entity_types];
+        /* The wall-clock time (in seconds) spent pre-rendering, excluding building the acceleration structures. */
+        double prerender_time;
+        /* The wall-clock time (in seconds) spent building and refitting the acceleration structures. */
+        double acceleration_time;
+        /* The number of bytes taken up by the current acceleration structures. */
+        size_t acceleration_bytes;
+        /* The number of frames rendered. */
+        uint32_t frames;
+        /* The number of pixels rendered over all frames. */
+        uint64_t pixels;
+        /* The wall-clock time (in seconds) spent rendering, including writing to the frame or sink. */
+        double render_time;
+        /* Whether the renderer counts intersection tests and node visits, which only the CPU backends compiled with COUNT_RAYS do. */
+        bool counted;
+        /* The statistics of every thread that does work for the renderer. */
+        std::vector<ThreadStats> threads;
+
+
+        /* Constructor for the RenderStats struct, which takes the number of threads that do work for the renderer. */
+        RenderStats(uint32_t n_threads = 1);
+
+        /* Throws away all statistics so far, optionally changing the number of threads. */
+        void reset(uint32_t n_threads = 0);
+
+        /* Returns the sum of the statistics of all threads. */
+        ThreadStats total() const;
+        /* Returns the number of rays traced per second of rendering, in millions. */
+        double mrays_per_second() const;
+
+        /* Writes the statistics as a JSON document to the given stream. */
+        void write_json(std::ostream& os) const;
+        /* Writes the statistics as a JSON document to the file at the given path. */
+        void write_json(const std::string& path) const;
+    };
+
+
+
+    /* Returns the number of seconds passed since the given moment. */
+    inline double seconds_since(const std::chrono::steady_clock::time_point& start) { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+}
+
+#endif
@@ -4,7 +4,7 @@
  * Created:
  *   30/04/2021, 13:17:35
  * Last edited:
- *   25/05/2021, 18:14:13
+ *   16/10/2026, 01:02:51
  * Auto updated?
  *   Yes
  *
@@ -17,8 +17,12 @@
 **/
 
 #include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include <CppDebugger.hpp>
 
+#include "tools/Profiler.hpp"
+
 #include "Renderer.hpp"
 
 using namespace std;
@@ -69,16 +73,14 @@ Renderer::Renderer() {
 }
 
 /* Copy constructor for the Renderer baseclass. */
-Renderer::Renderer(const Renderer& other) {
-    /* Does nothing */
-    (void) other;
-}
+Renderer::Renderer(const Renderer& other) :
+    stats(other.stats)
+{}
 
 /* Move constructor for the Renderer baseclass. */
-Renderer::Renderer(Renderer&& other) {
-    /* Does nothing */
-    (void) other;
-}
+Renderer::Renderer(Renderer&& other) :
+    stats(std::move(other.stats))
+{}
 
 /* Virtual destructor for the Renderer baseclass. */
 Renderer::~Renderer() {
@@ -87,9 +89,51 @@ Renderer::~Renderer() {
 
 
 
+/* Renders the internal list of vertices, w/e using the given Camera object, and writes the result to the given sink instead of to the camera's frame. By default this renders to the camera's frame first and then copies it to the sink band by band; backends that can should override it to give the sink their tiles as soon as they're done. */
+void Renderer::render(Camera& camera, FrameSink& sink) const {
+    PENTER("Renderer::render(sink)");
+
+    // Render as usual
+    this->render(camera);
+
+    // Copy the frame to the sink in bands of rows, which every sink accepts
+    const uint32_t band_size = 16;
+    const Frame& frame = camera.get_frame();
+    uint32_t width = frame.w(), height = frame.h();
+    std::vector<glm::vec3> band((size_t) width * band_size);
+    std::vector<uint32_t> row_buffer(width);
+    sink.begin(width, height);
+    for (uint32_t y0 = 0; y0 < height; y0 += band_size) {
+        uint32_t y1 = std::min(y0 + band_size, height);
+        for (uint32_t y = y0; y < y1; y++) {
+            const uint32_t* row = frame.row(y, row_buffer.data());
+            for (uint32_t x = 0; x < width; x++) {
+                // Unpack it the way the CPU renderers pack it (alpha, blue, green, red from the lowest byte up)
+                glm::vec4 pixel = glm::unpackUnorm4x8(row[x]);
+                band[(size_t) (y - y0) * width + x] = glm::vec3(pixel.w, pixel.z, pixel.y);
+            }
+        }
+        sink.write(0, y0, width, y1, band.data(), width);
+    }
+    sink.end();
+
+    DRETURN;
+}
+
+/* Moves the given pre-rendered entities by applying their transformation to what they were pre-rendered to, so animations don't have to pre-render the scene again for every frame. Every entity may appear at most once. By default this isn't supported, and derived classes should override it if they can. */
+void Renderer::transform_entities(const Tools::Array<EntityTransform>& transforms) {
+    PENTER("Renderer::transform_entities");
+
+    (void) transforms;
+    DLOG(fatal, "Moving pre-rendered entities is not supported by this back-end.");
+
+    DRETURN;
+}
+
+
+
 /* Swap operator for the Renderer baseclass. */
 void RayTracer::swap(Renderer& r1, Renderer& r2) {
     using std::swap;
-    (void) r1;
-    (void) r2;
+    swap(r1.stats, r2.stats);
 }
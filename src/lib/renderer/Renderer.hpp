@@ -4,7 +4,7 @@
  * Created:
  *   30/04/2021, 13:21:29
  * Last edited:
- *   19/05/2021, 17:51:57
+ *   16/10/2026, 00:57:51
  * Auto updated?
  *   Yes
  *
@@ -22,17 +22,33 @@
 #include "glm/glm.hpp"
 
 #include "camera/Camera.hpp"
+#include "camera/FrameSink.hpp"
 
 #include "entities/RenderEntity.hpp"
 
 #include "tools/Array.hpp"
+#include "tools/ThreadPool.hpp"
 
 #include "Vertex.hpp"
+#include "RenderStats.hpp"
 
 namespace RayTracer {
+    /* The EntityTransform struct, which describes where a single pre-rendered entity is at some frame. */
+    struct EntityTransform {
+        /* The index of the entity in the list that was pre-rendered. */
+        uint32_t entity;
+        /* The transformation from where the entity was pre-rendered to where it is now, regardless of any earlier moves. Should be rigid (rotation & translation only), since spheres can't be scaled or skewed. */
+        glm::mat4 transform;
+    };
+
+
+
     /* The Renderer baseclass, which can be used to render a list of RenderEntities to a frame. Derived classes can determine if the renderer uses Vulkan, CUDA, the CPU, w/e. */
     class Renderer {
     protected:
+        /* The statistics collected since they were last reset. Is mutable, since rendering doesn't change the renderer itself but does add to its statistics. */
+        mutable RenderStats stats;
+
         /* Protected constructor for the Renderer Baseclass, which is used by derived classes to initialize the base elements. */
         Renderer();
         
@@ -48,6 +64,17 @@ namespace RayTracer {
         virtual void prerender(const Tools::Array<ECS::RenderEntity*>& entities) = 0;
         /* Uses the chosen backend to render the internal list of vertices, indices, w/e using the given Camera object. The resulting frame can then be retrieved from the Camera. */
         virtual void render(Camera& camera) const = 0;
+        /* Renders the internal list of vertices, w/e using the given Camera object, and writes the result to the given sink instead of to the camera's frame. By default this renders to the camera's frame first and then copies it to the sink band by band; backends that can should override it to give the sink their tiles as soon as they're done. */
+        virtual void render(Camera& camera, FrameSink& sink) const;
+        /* Moves the given pre-rendered entities by applying their transformation to what they were pre-rendered to, so animations don't have to pre-render the scene again for every frame. Every entity may appear at most once. By default this isn't supported, and derived classes should override it if they can. */
+        virtual void transform_entities(const Tools::Array<EntityTransform>& transforms);
+        /* Returns the pool of worker threads that the renderer runs on, so other work (e.g., encoding PNGs) can share it instead of starting threads of its own. Returns nullptr if the renderer has none. */
+        virtual Tools::ThreadPool* get_pool() const { return nullptr; }
+
+        /* Returns the statistics collected since they were last reset. */
+        inline const RenderStats& get_stats() const { return this->stats; }
+        /* Throws away the statistics collected so far. */
+        inline void reset_stats() { this->stats.reset(); }
 
         /* Swap operator for the Renderer baseclass. */
         friend void swap(Renderer& r1, Renderer& r2);
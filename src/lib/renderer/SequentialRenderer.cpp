@@ -4,7 +4,7 @@
  * Created:
  *   03/05/2021, 15:25:06
  * Last edited:
- *   25/05/2021, 20:16:38
+ *   16/10/2026, 01:02:51
  * Auto updated?
  *   Yes
  *
@@ -13,12 +13,19 @@
  *   frame sequentially on the CPU, no fancy strings attached.
 **/
 
+#include <limits>
+#include <vector>
+#include <algorithm>
 #include <CppDebugger.hpp>
 
+#include "tools/Tracing.hpp"
+#include "tools/Profiler.hpp"
+
 #include "entities/Triangle.hpp"
 #include "entities/Sphere.hpp"
 #include "entities/Object.hpp"
 
+#include "SphereHit.hpp"
 #include "SequentialRenderer.hpp"
 
 using namespace std;
@@ -27,86 +34,112 @@ using namespace RayTracer::ECS;
 using namespace CppDebugger::SeverityValues;
 
 
-/***** MACROS *****/
-/* Macro that implements a very fast dot-product between two vec3 vectors. */
-#define dot3(V1, V2) \
-    ((V1).x * (V2).x + (V1).y * (V2).y + (V1).z * (V2).z)
-
-
-
-
-
 /***** RAYTRACING FUNCTIONS *****/
-/* @brief Computes the color of a pixel, as if a ray was shot out of it and it could have hit any of the faces in our mesh.
+/* @brief Computes the color of the sky for a ray that doesn't hit anything.
+ * @param direction The direction of the ray.
+ * @return The color as a three-dimensional vector.
+ */
+static inline glm::vec3 sky_color(const glm::vec3& direction) {
+    glm::vec3 unit_direction = direction / length(direction);
+    float t = 0.5 * (unit_direction.y + 1.0);
+    return glm::vec3((1.0f - t) * glm::vec3(1.0) + t * glm::vec3(0.5, 0.7, 1.0));
+}
+
+/* @brief Computes the color of a pixel, as if a ray was shot out of it and it could have hit any of the faces or spheres in our scene.
  * @param faces The list of faces against we may hit.
- * @param vertices The list of vertices referenced by the faces.
+ * @param woop_faces The same faces as unit-triangle transformations, which is what is actually intersected.
+ * @param spheres The list of spheres we may hit.
+ * @param bvh The bounding volume hierarchy over the faces and spheres. Is ignored if we're compiled with BRUTE_FORCE.
  * @param origin The origin of the ray.
  * @param direction The (normalized) direction of the ray.
+ * @param n_tests The number of intersection tests, which is increased by the tests of this ray if we're compiled with COUNT_RAYS.
+ * @param n_visits The number of BVH nodes visited, which is increased by the visits of this ray if we're compiled with COUNT_RAYS.
  * @return The color as a three-dimensional vector.
  */
-static glm::vec3 ray_color(const Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, glm::vec3 origin, glm::vec3 direction) {
-    DENTER("ray_color");
+static glm::vec3 ray_color(const Tools::Array<GFace>& faces, const WoopFaces& woop_faces, const Tools::Array<GSphere>& spheres, const BVH& bvh, glm::vec3 origin, glm::vec3 direction, uint64_t& n_tests, uint64_t& n_visits) {
+    KENTER("ray_color");
 
-    // Loop through the vertices so find any one we hit
-    uint min_i = 0;
+    // Find the closest primitive we hit. Like in the BVH, the spheres come after the faces
     float min_t = 1e99;
-    for (size_t i = 0; i < faces.size(); i++) {
-        // First, check if the ray happens to be perpendicular to the triangle's plane
-        glm::vec3 normal = faces[i].normal;
-        if (dot3(direction, normal) == 0) {
-            // No intersection for sure
-            continue;
-        }
-
-        // Otherwise, fetch the points from the point list
-        glm::vec3 p1 = vertices[faces[i].v1];
-        glm::vec3 p2 = vertices[faces[i].v2];
-        glm::vec3 p3 = vertices[faces[i].v3];
-
-        // Otherwise, compute the distance point of the plane
-        float plane_distance = dot3(normal, p1);
-
-        // Use that to compute the distance the ray travels before it hits the plane
-        float t = (dot3(normal, origin) + plane_distance) / dot3(normal, direction);
-        if (t < 0 || t >= min_t) {
-            // Negative t (the face is behind us) or a t further than one we already found, so no need in doing the close check
-            continue;
-        }
-
-        // Now, compute the actual point where we hit the plane
-        glm::vec3 hitpoint = origin + t * direction;
-
-        // We now perform the inside-out test to see if the triangle is hit within the plane
-        // General idea: https://www.scratchapixel.com/lessons/3d-basic-rendering/ray-tracing-rendering-a-triangle/barycentric-coordinates
-        // First, compute various cross products
-        glm::vec3 a = glm::cross(p2 - p1, hitpoint - p1);
-        glm::vec3 b = glm::cross(p3 - p2, hitpoint - p2);
-        glm::vec3 c = glm::cross(p1 - p3, hitpoint - p3);
-
-        // Use them to check if the hitpoint is in the area
-        if (-dot3(normal, a) >= 0.0 &&
-            -dot3(normal, b) >= 0.0 &&
-            -dot3(normal, c) >= 0.0)
-        {
+    uint32_t n_faces = woop_faces.size();
+    #ifdef BRUTE_FORCE
+    // Loop through all the faces and spheres to find any one we hit
+    (void) bvh;
+    (void) n_visits;
+    STATS_COUNT(n_tests, n_faces + spheres.size());
+    uint32_t min_i = std::numeric_limits<uint32_t>::max();
+    for (uint32_t i = 0; i < n_faces + spheres.size(); i++) {
+        float t = i < n_faces ? woop_faces.hit(i, origin, direction, min_t) : hit_sphere(spheres[i - n_faces], origin, direction, min_t);
+        if (t >= 0) {
             // It's a hit! Store it as the closest t so far
             min_i = i;
             min_t = t;
-            continue;
         }
-
-        // Otherwise, no hit
     }
-
-    // If we hit a vertex, return its color
-    if (min_t < 1e99) {
-        DRETURN faces[min_i].color;
+    #else
+    // Let the BVH find the primitives worth checking
+    uint32_t min_i = bvh.traverse(origin, direction, min_t, [&woop_faces, &spheres, n_faces, &origin, &direction, &min_t, &n_tests](uint32_t i) {
+        STATS_COUNT(n_tests, 1);
+        return i < n_faces ? woop_faces.hit(i, origin, direction, min_t) : hit_sphere(spheres[i - n_faces], origin, direction, min_t);
+    }, &n_visits);
+    #endif
+
+    // If we hit something, return its color
+    if (min_i != std::numeric_limits<uint32_t>::max()) {
+        KRETURN min_i < n_faces ? faces[min_i].color : spheres[min_i - n_faces].color;
     } else {
         // Return the blue sky
-        glm::vec3 unit_direction = direction / length(direction);
-        float t = 0.5 * (unit_direction.y + 1.0);
-        DRETURN glm::vec3((1.0f - t) * glm::vec3(1.0) + t * glm::vec3(0.5, 0.7, 1.0));
+        KRETURN sky_color(direction);
+    }
+}
+
+#if PACKET_SIZE > 1
+/* @brief Computes the colors of all rays in the given packet, as if they could have hit any of the faces or spheres in our scene.
+ * @param faces The list of faces against we may hit.
+ * @param woop_faces The same faces as unit-triangle transformations, which is what is actually intersected.
+ * @param spheres The list of spheres we may hit.
+ * @param bvh The bounding volume hierarchy over the faces and spheres. Is ignored if we're compiled with BRUTE_FORCE.
+ * @param packet The packet of rays to trace. Its origin and directions should be prepared already.
+ * @param colors The list of PACKET_SIZE colors to write the result to, one per ray.
+ * @param n_tests The number of intersection tests, which is increased by the tests of every ray in this packet if we're compiled with COUNT_RAYS.
+ * @param n_visits The number of BVH nodes visited, which is increased by the visits of this packet if we're compiled with COUNT_RAYS.
+ */
+static void packet_color(const Tools::Array<GFace>& faces, const WoopFaces& woop_faces, const Tools::Array<GSphere>& spheres, const BVH& bvh, RayPacket& packet, glm::vec3* colors, uint64_t& n_tests, uint64_t& n_visits) {
+    KENTER("packet_color");
+
+    // Find the closest primitives we hit. Like in the BVH, the spheres come after the faces
+    uint32_t n_faces = woop_faces.size();
+    #ifdef BRUTE_FORCE
+    // Loop through all the faces and spheres to find any one we hit
+    (void) bvh;
+    (void) n_visits;
+    STATS_COUNT(n_tests, (n_faces + spheres.size()) * packet_size);
+    for (uint32_t i = 0; i < n_faces; i++) {
+        woop_faces.hit(i, packet);
     }
+    for (uint32_t i = 0; i < spheres.size(); i++) {
+        hit_sphere_packet(spheres[i], n_faces + i, packet);
+    }
+    #else
+    // Let the BVH find the primitives worth checking
+    bvh.traverse(packet, [&woop_faces, &spheres, n_faces, &n_tests](uint32_t i, RayPacket& packet) {
+        STATS_COUNT(n_tests, packet_size);
+        if (i < n_faces) { woop_faces.hit(i, packet); }
+        else { hit_sphere_packet(spheres[i - n_faces], i, packet); }
+    }, &n_visits);
+    #endif
+
+    // Return the color of the primitive or the sky for each ray
+    for (uint32_t i = 0; i < packet_size; i++) {
+        int32_t hit = packet.hit[i];
+        if (hit < 0) { colors[i] = sky_color(packet.direction(i)); }
+        else if ((uint32_t) hit < n_faces) { colors[i] = faces[hit].color; }
+        else { colors[i] = spheres[hit - n_faces].color; }
+    }
+
+    KRETURN;
 }
+#endif
 
 /* @brief Debug algorithm, that prints dots on the given vertices instead of rendering the faces.
  * @param faces The list of faces we thus don't render, and is here only for compatibility with ray_color. Not actually used.
@@ -116,7 +149,7 @@ static glm::vec3 ray_color(const Tools::Array<GFace>& faces, const Tools::Array<
  * @return The color of the ray/pixel as a three-dimensional vector.
  */
 static glm::vec3 ray_dot(const Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, glm::vec3 origin, glm::vec3 direction) {
-    DENTER("ray_dot");
+    KENTER("ray_dot");
     (void) faces;    
 
     // Determines the radius for all dots
@@ -145,12 +178,12 @@ static glm::vec3 ray_dot(const Tools::Array<GFace>& faces, const Tools::Array<gl
 
     // If we found a t, return the (possibly darker) pixel
     if (min_t < 1e99) {
-        DRETURN std::max(1.0f - min_t / black_distance, 0.0f) * glm::vec3(1.0, 0.0, 0.0);
+        KRETURN std::max(1.0f - min_t / black_distance, 0.0f) * glm::vec3(1.0, 0.0, 0.0);
     } else {
         // Return the background
         glm::vec3 unit_direction = direction / length(direction);
         float t = 0.5 * (unit_direction.y + 1.0);
-        DRETURN glm::vec3((1.0f - t) * glm::vec3(1.0) + t * glm::vec3(0.5, 0.7, 1.0));
+        KRETURN glm::vec3((1.0f - t) * glm::vec3(1.0) + t * glm::vec3(0.5, 0.7, 1.0));
     }
 }
 
@@ -170,88 +203,107 @@ SequentialRenderer::SequentialRenderer() :
 
 
 
-/* Helper function that merges the given newly pre-rendered faces & vertex buffers and inserts them in the global buffers. */
-void SequentialRenderer::transfer_entity(Tools::Array<GFace>& faces_buffer, Tools::Array<glm::vec4>& vertex_buffer, const Tools::Array<GFace>& new_faces_buffer, const Tools::Array<glm::vec4>& new_vertex_buffer) {
-    DENTER("SequentialRenderer::transfer_entity");
-
-    // Loop to add the faces, with new offsets
-    uint32_t offset = vertex_buffer.size();
-    faces_buffer.reserve(faces_buffer.size() + new_faces_buffer.size());
-    for (size_t i = 0; i < new_faces_buffer.size(); i++) {
-        // Push to the back of the global buffer
-        faces_buffer.push_back(new_faces_buffer[i]);
-
-        // Offset the indices in the faces buffer
-        faces_buffer[faces_buffer.size() - 1].v1 += offset;
-        faces_buffer[faces_buffer.size() - 1].v2 += offset;
-        faces_buffer[faces_buffer.size() - 1].v3 += offset;
+/* Runs the given job once for every index in [0, n_jobs), one after another. Derived renderers may override this to run them in parallel. */
+void SequentialRenderer::run_jobs(size_t n_jobs, const Tools::ThreadPool::Job& job) const {
+    for (size_t i = 0; i < n_jobs; i++) {
+        job(i, 0);
     }
-
-    // We can append the vertex buffer immediately
-    vertex_buffer += new_vertex_buffer;
-
-    // Done!
-    DRETURN;
 }
 
 
 
-/* Pre-renders the given list of RenderEntities, not accelerated in any way lmao. */
+/* Pre-renders the given list of RenderEntities straight into the final buffers, one job per entity. */
 void SequentialRenderer::prerender(const Tools::Array<ECS::RenderEntity*>& entities) {
-    DENTER("SequentialRenderer::prerender");
+    PENTER("SequentialRenderer::prerender");
     DLOG(info, "Pre-rendering entities...");
     DINDENT;
+    auto start = std::chrono::steady_clock::now();
 
     // We start by throwing out any old vertices we might have
     this->entity_faces.clear();
     this->entity_vertices.clear();
-
-    // Prepare the buffers for the per-entity vertices
-    Tools::Array<GFace> entity_faces;
-    Tools::Array<glm::vec4> entity_vertices;
-
-    // Next, loop through all entities to render them
+    this->entity_spheres.clear();
+    this->entity_ranges.clear();
+    this->entity_shading.clear();
+    this->rest_vertices.clear();
+    this->rest_spheres.clear();
+    this->bvh.clear();
+    this->woop_faces.clear();
+
+    // Decide where every entity goes in the final buffers. Since all entities know how much they produce, this also tells us how large the buffers become
+    Tools::Array<BVHEntity>& entity_ranges = this->entity_ranges;
+    entity_ranges.reserve(entities.size());
+    this->entity_shading.reserve(entities.size());
+    uint32_t n_faces = 0, n_vertices = 0;
     for (size_t i = 0; i < entities.size(); i++) {
-        // Select the proper pre-render mode (only CPU is supported)
-        if (entities[i]->pre_render_mode & EntityPreRenderModeFlags::eprmf_cpu) {
-            // Clear the buffers and set them to the correct size
-            entity_faces.clear();
-            entity_vertices.clear();
-            entity_faces.resize(entities[i]->pre_render_faces);
-            entity_vertices.resize(entities[i]->pre_render_vertices);
-            
-            // Determine the type of pre-rendering operation we need to do
-            switch (entities[i]->pre_render_operation) {
-                case EntityPreRenderOperation::epro_generate_triangle:
-                    /* Call the generate triangle CPU function. */
-                    cpu_pre_render_triangle(entity_faces, entity_vertices, (Triangle*) entities[i]);
-                    break;
-
-                case EntityPreRenderOperation::epro_generate_sphere:
-                    /* Call the generate sphere CPU function. */
-                    cpu_pre_render_sphere(entity_faces, entity_vertices, (Sphere*) entities[i]);
-                    break;
-                
-                case EntityPreRenderOperation::epro_load_object_file:
-                    /* Call the load object file CPU function. */
-                    cpu_pre_render_object(entity_faces, entity_vertices, (Object*) entities[i]);
-                    break;
-
-                default:
-                    DLOG(fatal, "Entity " + std::to_string(i) + " wants to be pre-rendered on the CPU using unsupported operation '" + entity_pre_render_operation_names[entities[i]->pre_render_operation] + "'.");
+        BVHEntity range{};
+        range.first_face = n_faces;
+        range.first_vertex = n_vertices;
+        range.first_sphere = (uint32_t) this->entity_spheres.size();
 
+        // Select the proper pre-render mode (only CPU is supported)
+        if (entities[i]->pre_render_operation == EntityPreRenderOperation::epro_generate_sphere) {
+            // Spheres aren't tessellated on the CPU, but intersected analytically instead
+            Sphere* sphere = (Sphere*) entities[i];
+            range.n_spheres = 1;
+            this->entity_spheres.push_back(GSphere({ sphere->center, sphere->radius, sphere->color }));
+            this->entity_shading.push_back(EntityShading({ sphere->color, false }));
+
+        } else if (entities[i]->pre_render_mode & EntityPreRenderModeFlags::eprmf_cpu) {
+            // Make sure we can actually pre-render it before we start
+            if (entities[i]->pre_render_operation != EntityPreRenderOperation::epro_generate_triangle && entities[i]->pre_render_operation != EntityPreRenderOperation::epro_load_object_file) {
+                DLOG(fatal, "Entity " + std::to_string(i) + " wants to be pre-rendered on the CPU using unsupported operation '" + entity_pre_render_operation_names[entities[i]->pre_render_operation] + "'.");
             }
-
-            // Once done, merge them in the general lists
-            this->transfer_entity(this->entity_faces, this->entity_vertices, entity_faces, entity_vertices);      
+            range.n_faces = entities[i]->pre_render_faces;
+            range.n_vertices = entities[i]->pre_render_vertices;
+            if (entities[i]->pre_render_operation == EntityPreRenderOperation::epro_load_object_file) {
+                this->entity_shading.push_back(EntityShading({ ((Object*) entities[i])->color, true }));
+            } else {
+                this->entity_shading.push_back(EntityShading({ ((Triangle*) entities[i])->color, false }));
+            }
+            n_faces += range.n_faces;
+            n_vertices += range.n_vertices;
 
         } else {
             DLOG(fatal, "Entity " + std::to_string(i) + " of type " + entity_type_names[entities[i]->type] + " with the sequential back-end.");
         }
 
-        // No need to insert again, as transfer_entity does this for us now
+        entity_ranges.push_back(range);
+        ++this->stats.prerender_entities[entities[i]->type];
+        this->stats.prerender_faces[entities[i]->type] += range.n_faces;
     }
 
+    // Allocate the final buffers once. Their elements are left uninitialized, as every one of them is written by exactly one entity
+    this->entity_faces.reserve(n_faces);
+    this->entity_vertices.reserve(n_vertices);
+    GFace* faces = this->entity_faces.wdata(n_faces);
+    glm::vec4* vertices = this->entity_vertices.wdata(n_vertices);
+
+    // Let every entity pre-render itself straight into its own range of the buffers, possibly in parallel
+    RenderStats& stats = this->stats;
+    this->run_jobs(entities.size(), [&entities, &entity_ranges, faces, vertices, &stats](size_t i, uint32_t thread) {
+        auto job_start = std::chrono::steady_clock::now();
+        const BVHEntity& range = entity_ranges[i];
+        switch (entities[i]->pre_render_operation) {
+            case EntityPreRenderOperation::epro_generate_triangle:
+                /* Call the generate triangle CPU function. */
+                cpu_pre_render_triangle(faces + range.first_face, vertices + range.first_vertex, range.first_vertex, (Triangle*) entities[i]);
+                break;
+
+            case EntityPreRenderOperation::epro_load_object_file:
+                /* Call the load object file CPU function. */
+                cpu_pre_render_object(faces + range.first_face, vertices + range.first_vertex, range.first_vertex, (Object*) entities[i]);
+                break;
+
+            default:
+                /* Spheres are already done */
+                break;
+
+        }
+        stats.threads[thread].prerender_time[entities[i]->type] += seconds_since(job_start);
+    });
+    this->stats.prerender_time += seconds_since(start);
+
     // cout << "Faces:" << endl;
     // for (size_t i = 0; i < this->entity_faces.size(); i++) {
     //     glm::vec3 v1 = this->entity_vertices[this->entity_faces[i].v1];
@@ -260,31 +312,160 @@ void SequentialRenderer::prerender(const Tools::Array<ECS::RenderEntity*>& entit
     //     cout << "    x: {" << v1.x << "," << v1.y << "," << v1.z << "}" << " | y: {" << v2.x << "," << v2.y << "," << v2.z << "} | z: {" << v3.x << "," << v3.y << "," << v3.z << "}" << endl;
     // }
 
+    // With all faces & spheres known, build the acceleration structures over them
+    this->build_acceleration();
+
     // We're done! We pre-rendered all objects!
     DDEDENT;
     DRETURN;
 }
 
-/* Renders the internal list of vertices to a frame using the given camera position. */
-void SequentialRenderer::render(Camera& camera) const {
-    DENTER("SequentialRenderer::render");
-    // Print some info
-    DLOG(info, "Rendering for camera:");
-    DINDENT;
-    DLOG(auxillary, "Camera origin            : (" + std::to_string(camera.origin.x) + "," + std::to_string(camera.origin.y) + "," + std::to_string(camera.origin.z) + ")");
-    DLOG(auxillary, "Camera horizontal        : (" + std::to_string(camera.horizontal.x) + "," + std::to_string(camera.horizontal.y) + "," + std::to_string(camera.horizontal.z) + ")");
-    DLOG(auxillary, "Camera vertical          : (" + std::to_string(camera.vertical.x) + "," + std::to_string(camera.vertical.y) + "," + std::to_string(camera.vertical.z) + ")");
-    DLOG(auxillary, "Camera lower_left_corner : (" + std::to_string(camera.lower_left_corner.x) + "," + std::to_string(camera.lower_left_corner.y) + "," + std::to_string(camera.lower_left_corner.z) + ")");
-    DDEDENT;
+/* (Re)builds the acceleration structures over the current faces and spheres, i.e., the BVH (unless compiled with BRUTE_FORCE) and the faces' unit-triangle transformations. Resets the scene arena. */
+void SequentialRenderer::build_acceleration() {
+    PENTER("SequentialRenderer::build_acceleration");
+    auto start = std::chrono::steady_clock::now();
 
-    // Loop through all pixels to render
-    // Due to unsignedness, we use this funky operator which is '(y--) > 0'
-    DLOG(info, "Rendering...");
-    DINDENT;
+    // Nothing but the build's temporaries lives in the arena, so we can throw out those of the last build
+    this->scene_arena.reset();
+
+    // First, build the BVH
+    #ifndef BRUTE_FORCE
+    this->bvh.build(this->entity_faces, this->entity_vertices, this->entity_spheres, this->entity_ranges, this->scene_arena);
+    #endif
+
+    // Since the BVH has put the faces in their final order, we can now precompute the data we need to intersect them
+    this->woop_faces.build(this->entity_faces, this->entity_vertices);
+
+    this->stats.acceleration_time += seconds_since(start);
+    this->stats.acceleration_bytes = this->bvh.size() + this->woop_faces.bytes();
+    DRETURN;
+}
+
+/* Moves the given pre-rendered entities by transforming their pre-rendered vertices and spheres, after which their normals and colors are recomputed, the BVH is refitted and only their part of the faces' unit-triangle transformations is recomputed. */
+void SequentialRenderer::transform_entities(const Tools::Array<EntityTransform>& transforms) {
+    PENTER("SequentialRenderer::transform_entities");
+
+    // Make sure all entities exist and appear only once before we touch anything, since every entity is transformed by its own job
+    Tools::Array<bool> seen(this->entity_ranges.size());
+    seen.resize(this->entity_ranges.size());
+    for (size_t i = 0; i < this->entity_ranges.size(); i++) { seen[i] = false; }
+    for (size_t i = 0; i < transforms.size(); i++) {
+        if (transforms[i].entity >= this->entity_ranges.size()) {
+            DLOG(fatal, "Cannot transform entity " + std::to_string(transforms[i].entity) + ", since only " + std::to_string(this->entity_ranges.size()) + " entities are pre-rendered.");
+        }
+        if (seen[transforms[i].entity]) {
+            DLOG(fatal, "Cannot transform entity " + std::to_string(transforms[i].entity) + " more than once at the same time.");
+        }
+        seen[transforms[i].entity] = true;
+    }
+
+    // On the first move, remember where everything was pre-rendered
+    if (this->rest_vertices.size() != this->entity_vertices.size() || this->rest_spheres.size() != this->entity_spheres.size()) {
+        this->rest_vertices = this->entity_vertices;
+        this->rest_spheres = this->entity_spheres;
+    }
+
+    // Transform every entity from where it was pre-rendered into its own ranges of the buffers, possibly in parallel. The BVH may have reordered the faces, but only within their entity's range
+    GFace* faces = this->entity_faces.wdata();
+    glm::vec4* vertices = this->entity_vertices.wdata();
+    GSphere* spheres = this->entity_spheres.wdata();
+    const glm::vec4* rest_vertices = this->rest_vertices.rdata();
+    const GSphere* rest_spheres = this->rest_spheres.rdata();
+    const Tools::Array<BVHEntity>& entity_ranges = this->entity_ranges;
+    const Tools::Array<EntityShading>& entity_shading = this->entity_shading;
+    this->run_jobs(transforms.size(), [&transforms, &entity_ranges, &entity_shading, faces, vertices, spheres, rest_vertices, rest_spheres](size_t i, uint32_t) {
+        const BVHEntity& range = entity_ranges[transforms[i].entity];
+        const EntityShading& shading = entity_shading[transforms[i].entity];
+        const glm::mat4& transform = transforms[i].transform;
+        for (uint32_t v = range.first_vertex; v < range.first_vertex + range.n_vertices; v++) {
+            vertices[v] = glm::vec4(glm::vec3(transform * glm::vec4(glm::vec3(rest_vertices[v]), 1.0f)), rest_vertices[v].w);
+        }
+        for (uint32_t f = range.first_face; f < range.first_face + range.n_faces; f++) {
+            // All CPU-rendered faces compute their normals the same way, so we can do that again from the moved vertices. Degenerate faces are never hit, so they can keep theirs
+            glm::vec3 p1(vertices[faces[f].v1]);
+            glm::vec3 normal = glm::cross(glm::vec3(vertices[faces[f].v3]) - p1, glm::vec3(vertices[faces[f].v2]) - p1);
+            float length = glm::length(normal);
+            if (length > 0.0f) { faces[f].normal = normal / length; }
+            if (shading.by_normal) { faces[f].color = shade_object_face(shading.color, faces[f].normal); }
+        }
+        for (uint32_t s = range.first_sphere; s < range.first_sphere + range.n_spheres; s++) {
+            spheres[s].center = glm::vec3(transform * glm::vec4(rest_spheres[s].center, 1.0f));
+        }
+    });
+
+    // Refit the BVH for the entities that moved, which only rebuilds what it must
+    auto start = std::chrono::steady_clock::now();
+    bool rebuilt = false;
+    #ifndef BRUTE_FORCE
+    Tools::Array<uint32_t> moved(transforms.size());
+    for (size_t i = 0; i < transforms.size(); i++) {
+        moved.push_back(transforms[i].entity);
+    }
+    this->scene_arena.reset();
+    rebuilt = this->bvh.refit(this->entity_faces, this->entity_vertices, this->entity_spheres, moved, this->scene_arena);
+    #endif
+
+    // Then recompute the intersection data of the moved faces, which are in their final order now. If the entire BVH was rebuilt, any face may have moved
+    if (rebuilt) {
+        this->woop_faces.build(this->entity_faces, this->entity_vertices);
+    } else {
+        const Tools::Array<GFace>& entity_faces = this->entity_faces;
+        const Tools::Array<glm::vec4>& entity_vertices = this->entity_vertices;
+        WoopFaces& woop_faces = this->woop_faces;
+        this->run_jobs(transforms.size(), [&transforms, &entity_ranges, &entity_faces, &entity_vertices, &woop_faces](size_t i, uint32_t) {
+            const BVHEntity& range = entity_ranges[transforms[i].entity];
+            woop_faces.update(entity_faces, entity_vertices, range.first_face, range.n_faces);
+        });
+    }
+    this->stats.acceleration_time += seconds_since(start);
+    this->stats.acceleration_bytes = this->bvh.size() + this->woop_faces.bytes();
+
+    DRETURN;
+}
+
+/* Renders the pixels in the rectangle [x0, x1) x [y0, y1) of the given camera's frame, and writes their colors row by row to the given buffer with stride pixels between the starts of two rows. Doesn't touch the camera itself, so disjoint tiles may be rendered in parallel. */
+void SequentialRenderer::render_tile(const Camera& camera, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, glm::vec3* colors, size_t stride, ThreadStats& thread_stats) const {
+    KENTER("SequentialRenderer::render_tile"); PSCOPE("SequentialRenderer::render_tile");
+    auto start = std::chrono::steady_clock::now();
+
+    // Count locally, so the kernels don't have to go through memory for every test
+    uint64_t n_tests = 0, n_visits = 0;
     uint32_t width = camera.w(), height = camera.h();
-    uint32_t i = 0;
-    for (uint32_t y = height - 1; y --> 0 ;) {
-        for (uint32_t x = 0; x < width; x++) {
+    #if PACKET_SIZE > 1
+    // Trace the tile in blocks of packet_width x packet_height pixels
+    RayPacket packet;
+    packet.origin = camera.origin;
+    glm::vec3 packet_colors[packet_size];
+    for (uint32_t y = y0; y < y1; y += packet_height) {
+        for (uint32_t x = x0; x < x1; x += packet_width) {
+            // Compute the rays in the packet. Lanes that fall outside of the tile just repeat the pixels at its edge, which keeps the packet coherent
+            for (uint32_t i = 0; i < packet_size; i++) {
+                uint32_t px = std::min(x + i % packet_width, x1 - 1);
+                uint32_t py = std::min(y + i / packet_width, y1 - 1);
+                float u = float(px) / (float(width) - 1.0);
+                float v = float(height - 1 - py) / (float(height) - 1.0);
+                glm::vec3 ray = camera.lower_left_corner + u * camera.horizontal + v * camera.vertical - camera.origin;
+                packet.dx[i] = ray.x;
+                packet.dy[i] = ray.y;
+                packet.dz[i] = ray.z;
+            }
+            packet.prepare();
+
+            // Trace it, and write the colors of the lanes that are actually in the tile
+            packet_color(this->entity_faces, this->woop_faces, this->entity_spheres, this->bvh, packet, packet_colors, n_tests, n_visits);
+            for (uint32_t i = 0; i < packet_size; i++) {
+                uint32_t px = x + i % packet_width, py = y + i / packet_width;
+                if (px < x1 && py < y1) {
+                    colors[(py - y0) * stride + (px - x0)] = packet_colors[i];
+                }
+            }
+        }
+    }
+    (void) ray_color;
+    (void) ray_dot;
+    #else
+    for (uint32_t y = y0; y < y1; y++) {
+        for (uint32_t x = x0; x < x1; x++) {
             // Compute the u & v, which is basically the ray's coordinates as a float
             float u = float(x) / (float(width) - 1.0);
             float v = float(height - 1 - y) / (float(height) - 1.0);
@@ -293,16 +474,72 @@ void SequentialRenderer::render(Camera& camera) const {
             glm::vec3 ray = camera.lower_left_corner + u * camera.horizontal + v * camera.vertical - camera.origin;
 
             // Compute the ray's color and store it as a vector
-            glm::vec3 result = ray_color(this->entity_faces, this->entity_vertices, camera.origin, ray);
-            camera.get_frame().d()[y * width + x] = glm::packUnorm4x8(glm::vec4(1.0, result.z, result.y, result.x));
+            colors[(y - y0) * stride + (x - x0)] = ray_color(this->entity_faces, this->woop_faces, this->entity_spheres, this->bvh, camera.origin, ray, n_tests, n_visits);
             (void) ray_dot;
-
-            if (i % 1000 == 0) { DLOG(info, "Rendered ray " + std::to_string(i) + "/" + std::to_string(width * height)); }
-            i++;
         }
     }
+    #endif
+
+    // Only the pixels in the tile count as rays, not the repeated lanes at its edges
+    thread_stats.rays += (uint64_t) (x1 - x0) * (y1 - y0);
+    STATS_COUNT(thread_stats.intersection_tests, n_tests);
+    STATS_COUNT(thread_stats.node_visits, n_visits);
+    thread_stats.busy_time += seconds_since(start);
+    KRETURN;
+}
+
+/* Prints the properties of the given camera to the debugger. */
+void SequentialRenderer::log_camera(const Camera& camera) const {
+    DENTER("SequentialRenderer::log_camera");
+
+    DLOG(info, "Rendering for camera:");
+    DINDENT;
+    DLOG(auxillary, "Camera origin            : (" + std::to_string(camera.origin.x) + "," + std::to_string(camera.origin.y) + "," + std::to_string(camera.origin.z) + ")");
+    DLOG(auxillary, "Camera horizontal        : (" + std::to_string(camera.horizontal.x) + "," + std::to_string(camera.horizontal.y) + "," + std::to_string(camera.horizontal.z) + ")");
+    DLOG(auxillary, "Camera vertical          : (" + std::to_string(camera.vertical.x) + "," + std::to_string(camera.vertical.y) + "," + std::to_string(camera.vertical.z) + ")");
+    DLOG(auxillary, "Camera lower_left_corner : (" + std::to_string(camera.lower_left_corner.x) + "," + std::to_string(camera.lower_left_corner.y) + "," + std::to_string(camera.lower_left_corner.z) + ")");
+    DDEDENT;
+
+    DRETURN;
+}
+
+/* Renders the internal list of vertices to a frame using the given camera position. */
+void SequentialRenderer::render(Camera& camera) const {
+    PENTER("SequentialRenderer::render");
+
+    // Simply render to the camera's frame
+    FrameBufferSink sink(camera.get_frame());
+    this->render(camera, sink);
+
+    DRETURN;
+}
+
+/* Renders the internal list of vertices using the given camera position, and gives every band of rows to the given sink as soon as it's done. */
+void SequentialRenderer::render(Camera& camera, FrameSink& sink) const {
+    PENTER("SequentialRenderer::render(sink)");
+    // Print some info
+    this->log_camera(camera);
+
+    // Loop through all rows to render. Only one band is kept in memory at a time
+    DLOG(info, "Rendering...");
+    DINDENT;
+    auto start = std::chrono::steady_clock::now();
+    uint32_t width = camera.w(), height = camera.h();
+    std::vector<glm::vec3> band((size_t) width * SequentialRenderer::band_size);
+    sink.begin(width, height);
+    for (uint32_t y = 0; y < height; y += SequentialRenderer::band_size) {
+        uint32_t y1 = std::min(y + SequentialRenderer::band_size, height);
+        this->render_tile(camera, 0, y, width, y1, band.data(), width, this->stats.threads[0]);
+        sink.write(0, y, width, y1, band.data(), width);
+        DLOG(info, "Rendered row " + std::to_string(y) + "/" + std::to_string(height));
+    }
+    sink.end();
     DDEDENT;
 
+    ++this->stats.frames;
+    this->stats.pixels += (uint64_t) width * height;
+    this->stats.render_time += seconds_since(start);
+
     // Done!
     DRETURN;
 }
@@ -312,6 +549,7 @@ void SequentialRenderer::render(Camera& camera) const {
 
 
 /***** FACTORY METHOD *****/
+#ifndef ENABLE_THREADED
 Renderer* RayTracer::initialize_renderer() {
     DENTER("initialize_renderer");
 
@@ -321,3 +559,4 @@ Renderer* RayTracer::initialize_renderer() {
     // Done, return
     DRETURN (Renderer*) result;
 }
+#endif
@@ -4,7 +4,7 @@
  * Created:
  *   03/05/2021, 15:25:09
  * Last edited:
- *   19/05/2021, 17:52:34
+ *   16/10/2026, 00:57:51
  * Auto updated?
  *   Yes
  *
@@ -17,30 +17,75 @@
 #define RENDERER_SEQUENTIAL_RENDERER_HPP
 
 #include "glm/glm.hpp"
+#include "tools/ThreadPool.hpp"
+#include "tools/Arena.hpp"
 
 #include "Vertex.hpp"
+#include "BVH.hpp"
+#include "WoopFaces.hpp"
+#include "RenderStats.hpp"
 #include "Renderer.hpp"
 
 namespace RayTracer {
+    /* The EntityShading struct, which remembers how the faces of a pre-rendered entity are colored, so they can be colored again when it moves. */
+    struct EntityShading {
+        /* The color of the entity. */
+        glm::vec3 color;
+        /* Whether the color of its faces depends on their normals (as for objects), or is just the entity's color (as for triangles). */
+        bool by_normal;
+    };
+
+
+
     /* The SequentialRenderer class, which implements the standard Renderer as simple as possible. */
     class SequentialRenderer: public Renderer {
-    private:
+    public:
+        /* The number of rows that are rendered at once. Should be a multiple of the packet height if tracing in packets. */
+        static const constexpr uint32_t band_size = 16;
+
+    protected:
         /* The pre-rendered list of (GPU-optimised) vertices, which we can send to the GPU. */
         Tools::Array<GFace> entity_faces;
         /* The pre-rendered list of (GPU-optimised) points referred to by the vertices, which we can send to the GPU. */
         Tools::Array<glm::vec4> entity_vertices;
+        /* The spheres in the scene, which aren't pre-rendered to faces but intersected analytically instead. */
+        Tools::Array<GSphere> entity_spheres;
+        /* The bounding volume hierarchy over the pre-rendered faces and spheres, which is built at the end of pre-rendering. Remains empty if the renderer is compiled with BRUTE_FORCE. */
+        BVH bvh;
+        /* The pre-rendered faces as unit-triangle transformations, with the data needed to intersect them precomputed. Is built after the BVH, so it follows the same order. */
+        WoopFaces woop_faces;
+        /* The ranges of faces, vertices and spheres that every pre-rendered entity occupies, which are kept so entities can be moved later. */
+        Tools::Array<BVHEntity> entity_ranges;
+        /* How the faces of every pre-rendered entity are colored. */
+        Tools::Array<EntityShading> entity_shading;
+        /* The vertices as they were pre-rendered, which every move starts from so moves never build on each other's rounding errors. Only copied on the first move, since vertices are never reordered. */
+        Tools::Array<glm::vec4> rest_vertices;
+        /* The spheres as they were pre-rendered, copied on the first move like the vertices. Every entity has at most one sphere, so the BVH can't reorder them. */
+        Tools::Array<GSphere> rest_spheres;
+        /* The arena for temporary data while pre-rendering a scene, which is reset at the start of every prerender() but keeps its memory for the next one. */
+        Tools::Arena scene_arena;
         
-        /* Helper function that merges the given newly pre-rendered faces & vertex buffers and inserts them in the global buffers. */
-        void transfer_entity(Tools::Array<GFace>& faces_buffer, Tools::Array<glm::vec4>& vertex_buffer, const Tools::Array<GFace>& new_faces_buffer, const Tools::Array<glm::vec4>& new_vertex_buffer);
+        /* Runs the given job once for every index in [0, n_jobs), one after another. Derived renderers may override this to run them in parallel. */
+        virtual void run_jobs(size_t n_jobs, const Tools::ThreadPool::Job& job) const;
+        /* (Re)builds the acceleration structures over the current faces and spheres, i.e., the BVH (unless compiled with BRUTE_FORCE) and the faces' unit-triangle transformations. Resets the scene arena. */
+        void build_acceleration();
+        /* Renders the pixels in the rectangle [x0, x1) x [y0, y1) of the given camera's frame, and writes their colors row by row to the given buffer with stride pixels between the starts of two rows. Adds what it traced and how long that took to the given thread's statistics. Doesn't touch the camera itself, so disjoint tiles may be rendered in parallel. */
+        void render_tile(const Camera& camera, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, glm::vec3* colors, size_t stride, ThreadStats& thread_stats) const;
+        /* Prints the properties of the given camera to the debugger. */
+        void log_camera(const Camera& camera) const;
 
     public:
         /* Constructor for the SequentialRenderer class. */
         SequentialRenderer();
         
-        /* Pre-renders the given list of RenderEntities, accelerated using Vulkan compute shaders. */
+        /* Pre-renders the given list of RenderEntities straight into the final buffers, one job per entity. */
         virtual void prerender(const Tools::Array<ECS::RenderEntity*>& entities);
+        /* Moves the given pre-rendered entities by transforming their pre-rendered vertices and spheres, after which their normals and colors are recomputed, the BVH is refitted and only their part of the faces' unit-triangle transformations is recomputed. */
+        virtual void transform_entities(const Tools::Array<EntityTransform>& transforms);
         /* Renders the internal list of vertices to a frame using the given camera position. */
         virtual void render(Camera& camera) const;
+        /* Renders the internal list of vertices using the given camera position, and gives every band of rows to the given sink as soon as it's done. */
+        virtual void render(Camera& camera, FrameSink& sink) const;
 
     };
 }
@@ -0,0 +1,69 @@
+/* SPHERE HIT.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 15:02:37
+ * Last edited:
+ *   16/10/2026, 15:02:37
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the functions that intersect rays and packets of rays with
+ *   the analytic spheres of a scene. They live in a header so that the
+ *   CPU renderers and the benchmarks use the exact same kernels.
+**/
+
+#ifndef RENDERER_SPHERE_HIT_HPP
+#define RENDERER_SPHERE_HIT_HPP
+
+#include <cmath>
+
+#include "glm/glm.hpp"
+
+#include "Vertex.hpp"
+#include "RayPacket.hpp"
+
+namespace RayTracer {
+    /* Computes where the given ray hits the given sphere by solving the quadratic equation for the distance along the ray. Returns that distance, or a negative number if the ray misses the sphere or hits it after min_t. */
+    inline float hit_sphere(const GSphere& sphere, const glm::vec3& origin, const glm::vec3& direction, float min_t) {
+        // Solve the abc-formula, using half of b to save some multiplications
+        glm::vec3 oc = origin - sphere.center;
+        float a = glm::dot(direction, direction);
+        float half_b = glm::dot(oc, direction);
+        float c = glm::dot(oc, oc) - sphere.radius * sphere.radius;
+        float D = half_b * half_b - a * c;
+        if (D < 0) { return -1.0f; }
+
+        // Take the closest root in front of the ray, which is the far one if we're inside the sphere
+        float sqrt_D = sqrtf(D);
+        float t = (-half_b - sqrt_D) / a;
+        if (t < 0) { t = (-half_b + sqrt_D) / a; }
+        return t < min_t ? t : -1.0f;
+    }
+
+    #if PACKET_SIZE > 1
+    /* Intersects all rays in the given packet with the given sphere, and updates the closest hits of the rays that hit it first. The sphere's index in the BVH's primitive space is what's stored as hit. */
+    inline void hit_sphere_packet(const GSphere& sphere, uint32_t primitive_i, RayPacket& packet) {
+        // Since all rays share the origin, the parts of the abc-formula that only depend on it are scalar
+        glm::vec3 oc = packet.origin - sphere.center;
+        float c = glm::dot(oc, oc) - sphere.radius * sphere.radius;
+        floatp a = packet.dx * packet.dx + packet.dy * packet.dy + packet.dz * packet.dz;
+        floatp half_b = oc.x * packet.dx + oc.y * packet.dy + oc.z * packet.dz;
+        floatp D = half_b * half_b - a * c;
+
+        // Take the closest root in front of each ray; lanes with a negative D are masked out, so their square root doesn't matter
+        floatp sqrt_D = vsqrt(vmax(D, broadcast(0.0f)));
+        floatp t_near = (-half_b - sqrt_D) / a;
+        floatp t_far = (-half_b + sqrt_D) / a;
+        floatp t = select(t_near >= 0.0f, t_near, t_far);
+
+        // Update the lanes that hit this sphere first
+        intp mask = (D >= 0.0f) & (t >= 0.0f) & (t < packet.min_t);
+        packet.min_t = select(mask, t, packet.min_t);
+        packet.hit = select(mask, broadcast((int32_t) primitive_i), packet.hit);
+    }
+    #endif
+}
+
+#endif
@@ -0,0 +1,112 @@
+/* THREADED RENDERER.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   15/10/2026, 15:42:21
+ * Last edited:
+ *   16/10/2026, 01:02:51
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Derived class of the SequentialRenderer, which renders on all CPU
+ *   cores at once. The frame is split into tiles, which are handed to a
+ *   pool of worker threads that steal tiles from each other whenever they
+ *   run out.
+**/
+
+#include <algorithm>
+#include <vector>
+#include <CppDebugger.hpp>
+
+#include "tools/Profiler.hpp"
+
+#include "ThreadedRenderer.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** THREADEDRENDERER CLASS *****/
+/* Constructor for the ThreadedRenderer class, which takes the number of threads to render with. If 0, uses one thread per hardware thread. */
+ThreadedRenderer::ThreadedRenderer(uint32_t n_threads) :
+    SequentialRenderer(),
+    pool(n_threads)
+{
+    DENTER("ThreadedRenderer::ThreadedRenderer");
+    // Every worker keeps its own statistics
+    this->stats.reset(this->pool.size());
+    DLOG(info, "Initializing the threaded renderer with " + std::to_string(this->pool.size()) + " worker threads...");
+    DLEAVE;
+}
+
+
+
+/* Runs the given job once for every index in [0, n_jobs) on the worker threads. */
+void ThreadedRenderer::run_jobs(size_t n_jobs, const Tools::ThreadPool::Job& job) const {
+    this->pool.run(n_jobs, job);
+}
+
+/* Renders the internal list of vertices using the given camera position and all worker threads, and gives every tile (or band of tiles, if the sink needs full-width bands) to the given sink as soon as it's done. */
+void ThreadedRenderer::render(Camera& camera, FrameSink& sink) const {
+    PENTER("ThreadedRenderer::render(sink)");
+    // Print some info
+    this->log_camera(camera);
+
+    // Split the frame in tiles, rounding up at the edges
+    uint32_t width = camera.w(), height = camera.h();
+    uint32_t tiles_x = (width + ThreadedRenderer::tile_size - 1) / ThreadedRenderer::tile_size;
+    uint32_t tiles_y = (height + ThreadedRenderer::tile_size - 1) / ThreadedRenderer::tile_size;
+    DLOG(info, "Rendering " + std::to_string((size_t) tiles_x * tiles_y) + " tiles on " + std::to_string(this->pool.size()) + " threads...");
+    auto start = std::chrono::steady_clock::now();
+
+    sink.begin(width, height);
+    if (sink.accepts_tiles()) {
+        // Let the pool render them, each tile going to the sink as soon as it's done. The tiles are numbered row-major, so the workers start with neighbouring bands of the frame
+        this->pool.run((size_t) tiles_x * tiles_y, [this, &camera, &sink, width, height, tiles_x](size_t tile, uint32_t thread) {
+            glm::vec3 colors[ThreadedRenderer::tile_size * ThreadedRenderer::tile_size];
+            uint32_t x0 = (uint32_t) (tile % tiles_x) * ThreadedRenderer::tile_size;
+            uint32_t y0 = (uint32_t) (tile / tiles_x) * ThreadedRenderer::tile_size;
+            uint32_t x1 = std::min(x0 + ThreadedRenderer::tile_size, width), y1 = std::min(y0 + ThreadedRenderer::tile_size, height);
+            this->render_tile(camera, x0, y0, x1, y1, colors, ThreadedRenderer::tile_size, this->stats.threads[thread]);
+            sink.write(x0, y0, x1, y1, colors, ThreadedRenderer::tile_size);
+        });
+
+    } else {
+        // Render one row of tiles at a time straight into a band, and give that to the sink once it's complete
+        std::vector<glm::vec3> band((size_t) width * ThreadedRenderer::tile_size);
+        for (uint32_t y0 = 0; y0 < height; y0 += ThreadedRenderer::tile_size) {
+            uint32_t y1 = std::min(y0 + ThreadedRenderer::tile_size, height);
+            this->pool.run(tiles_x, [this, &camera, &band, width, y0, y1](size_t tile, uint32_t thread) {
+                uint32_t x0 = (uint32_t) tile * ThreadedRenderer::tile_size;
+                this->render_tile(camera, x0, y0, std::min(x0 + ThreadedRenderer::tile_size, width), y1, band.data() + x0, width, this->stats.threads[thread]);
+            });
+            sink.write(0, y0, width, y1, band.data(), width);
+        }
+
+    }
+    sink.end();
+
+    ++this->stats.frames;
+    this->stats.pixels += (uint64_t) width * height;
+    this->stats.render_time += seconds_since(start);
+
+    // Done!
+    DRETURN;
+}
+
+
+
+
+
+/***** FACTORY METHOD *****/
+Renderer* RayTracer::initialize_renderer() {
+    DENTER("initialize_renderer");
+
+    // Initialize a new object
+    ThreadedRenderer* result = new ThreadedRenderer();
+
+    // Done, return
+    DRETURN (Renderer*) result;
+}
@@ -0,0 +1,54 @@
+/* THREADED RENDERER.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   15/10/2026, 15:42:18
+ * Last edited:
+ *   16/10/2026, 00:25:49
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Derived class of the SequentialRenderer, which renders on all CPU
+ *   cores at once. The frame is split into tiles, which are handed to a
+ *   pool of worker threads that steal tiles from each other whenever they
+ *   run out.
+**/
+
+#ifndef RENDERER_THREADED_RENDERER_HPP
+#define RENDERER_THREADED_RENDERER_HPP
+
+#include "tools/ThreadPool.hpp"
+
+#include "SequentialRenderer.hpp"
+
+namespace RayTracer {
+    /* The ThreadedRenderer class, which renders the frame in tiles on multiple CPU threads. */
+    class ThreadedRenderer: public SequentialRenderer {
+    public:
+        /* The width & height (in pixels) of a single tile. */
+        static const constexpr uint32_t tile_size = 16;
+
+    private:
+        /* The pool of worker threads that render the tiles and pre-render the entities. Is mutable since rendering doesn't change the renderer itself, just the pool's queues. */
+        mutable Tools::ThreadPool pool;
+
+    protected:
+        /* Runs the given job once for every index in [0, n_jobs) on the worker threads. */
+        virtual void run_jobs(size_t n_jobs, const Tools::ThreadPool::Job& job) const;
+
+    public:
+        /* Constructor for the ThreadedRenderer class, which takes the number of threads to render with. If 0, uses one thread per hardware thread. */
+        ThreadedRenderer(uint32_t n_threads = 0);
+
+        /* Rendering to the camera's frame simply renders to a sink that writes to it. */
+        using SequentialRenderer::render;
+        /* Renders the internal list of vertices using the given camera position and all worker threads, and gives every tile (or band of tiles, if the sink needs full-width bands) to the given sink as soon as it's done. */
+        virtual void render(Camera& camera, FrameSink& sink) const;
+        /* Returns the pool of worker threads that render the tiles, so other work can share it. */
+        virtual Tools::ThreadPool* get_pool() const { return &this->pool; }
+
+    };
+}
+
+#endif
@@ -4,7 +4,7 @@
  * Created:
  *   02/05/2021, 15:45:39
  * Last edited:
- *   06/05/2021, 17:01:17
+ *   15/10/2026, 23:47:32
  * Auto updated?
  *   Yes
  *
@@ -50,6 +50,16 @@ namespace RayTracer {
         alignas(16) glm::vec3 color;
     };
 
+    /* The GPU-compatible Sphere struct, which is a sphere that is intersected analytically instead of being pre-rendered to faces. Matches the Sphere struct in raytracer_v4.glsl. */
+    struct GSphere {
+        /* The center of the sphere. */
+        alignas(16) glm::vec3 center;
+        /* The radius of the sphere. */
+        alignas(4) float radius;
+        /* The color of the sphere. */
+        alignas(16) glm::vec3 color;
+    };
+
 }
 
 #endif
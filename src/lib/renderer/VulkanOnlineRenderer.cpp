@@ -4,7 +4,7 @@
  * Created:
  *   09/05/2021, 18:30:34
  * Last edited:
- *   25/05/2021, 20:23:02
+ *   16/10/2026, 01:19:07
  * Auto updated?
  *   Yes
  *
@@ -25,6 +25,7 @@
 #include "compute/Swapchain.hpp"
 #include "compute/ErrorCodes.hpp"
 #include "tools/Common.hpp"
+#include "tools/Profiler.hpp"
 
 #include "VulkanOnlineRenderer.hpp"
 
@@ -358,8 +359,8 @@ VulkanOnlineRenderer::VulkanOnlineRenderer() :
     uint32_t stage_memory_type = MemoryPool::select_memory_type(*this->gpu, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 
     // Next, initialize all  pools
-    this->device_memory_pool = new MemoryPool(*this->gpu, device_memory_type, VulkanOnlineRenderer::device_memory_size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    this->stage_memory_pool = new MemoryPool(*this->gpu, stage_memory_type, VulkanOnlineRenderer::stage_memory_size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    this->device_memory_pool = new MemoryPool(*this->gpu, device_memory_type, VulkanOnlineRenderer::device_chunk_size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    this->stage_memory_pool = new MemoryPool(*this->gpu, stage_memory_type, VulkanOnlineRenderer::stage_chunk_size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 
     this->descriptor_pool = new DescriptorPool(
         *this->gpu,
@@ -438,7 +439,7 @@ VulkanOnlineRenderer::~VulkanOnlineRenderer() {
 
 /* Renders the internal list of vertices to a window using the given camera position. Renders the entire simulation, including update steps, and returns a blackened frame since the output is unreachable and simultaneously not interesting. */
 void VulkanOnlineRenderer::render(Camera& cam) const {
-    DENTER("VulkanOnlineRenderer::render");
+    PENTER("VulkanOnlineRenderer::render");
     uint32_t width = cam.w(), height = cam.h();
 
     /* Step 1: Initialize the window we'll be rendering to and get a surface. */
@@ -634,14 +635,17 @@ void VulkanOnlineRenderer::render(Camera& cam) const {
     uint32_t current_frame = 0;
     unsigned int fps_count = 0;
     std::chrono::system_clock::time_point last_fps = chrono::system_clock::now();
+    std::chrono::steady_clock::time_point render_start = std::chrono::steady_clock::now();
+    uint64_t frame_pixels = (uint64_t) swapchain_extent.width * swapchain_extent.height;
     while (!glfwWindowShouldClose(glfw_window)) {
         // Let's handle the window events
         glfwPollEvents();
 
 
 
-        // First, we wait until the current frame is available
+        // First, we wait until the current frame is available (which doesn't count as busy)
         vkWaitForFences(*this->gpu, 1, &frame_in_flight_fences[current_frame], VK_TRUE, UINT64_MAX);
+        std::chrono::steady_clock::time_point frame_start = std::chrono::steady_clock::now();
 
         
 
@@ -719,6 +723,10 @@ void VulkanOnlineRenderer::render(Camera& cam) const {
 
         // Once done, advance to the next frame in flight
         current_frame = (current_frame + 1) % VulkanOnlineRenderer::max_frames_in_flight;
+        ++this->stats.frames;
+        this->stats.pixels += frame_pixels;
+        this->stats.threads[0].rays += frame_pixels;
+        this->stats.threads[0].busy_time += seconds_since(frame_start);
 
 
 
@@ -737,6 +745,7 @@ void VulkanOnlineRenderer::render(Camera& cam) const {
 
     // Before we continue, wait until the device is idle tho
     vkDeviceWaitIdle(*this->gpu);
+    this->stats.render_time += seconds_since(render_start);
 
 
 
@@ -4,7 +4,7 @@
  * Created:
  *   09/05/2021, 18:30:37
  * Last edited:
- *   24/05/2021, 16:36:37
+ *   16/10/2026, 01:19:07
  * Auto updated?
  *   Yes
  *
@@ -30,10 +30,10 @@ namespace RayTracer {
     public:
         /* Constant that determines how many frames are in flight during rendering. */
         static const constexpr uint32_t max_frames_in_flight = 2;
-        /* Constant that determines the pool size of the device-local memory. */
-        static const constexpr VkDeviceSize device_memory_size = 1024 * 1024 * 1024;
-        /* Constant that determines the pool size of the transfer memory. */
-        static const constexpr VkDeviceSize stage_memory_size = 1024 * 1024 * 1024;
+        /* Constant that determines the size of the chunks that the pool of device-local memory starts with and grows by. */
+        static const constexpr VkDeviceSize device_chunk_size = 64 * 1024 * 1024;
+        /* Constant that determines the size of the chunks that the pool of transfer memory starts with and grows by. */
+        static const constexpr VkDeviceSize stage_chunk_size = 32 * 1024 * 1024;
         /* The maximum number of descriptor sets in the desriptor pool. */
         static const constexpr uint32_t max_descriptor_sets = max_frames_in_flight;
 
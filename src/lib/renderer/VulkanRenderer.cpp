@@ -4,7 +4,7 @@
  * Created:
  *   30/04/2021, 13:34:23
  * Last edited:
- *   25/05/2021, 18:14:13
+ *   16/10/2026, 01:22:26
  * Auto updated?
  *   Yes
  *
@@ -18,6 +18,8 @@
 #endif
 
 #include <functional>
+#include <algorithm>
+#include <cstring>
 #include <CppDebugger.hpp>
 
 #include "compute/Pipeline.hpp"
@@ -28,6 +30,7 @@
 #include "entities/Object.hpp"
 
 #include "tools/Common.hpp"
+#include "tools/Profiler.hpp"
 
 #include "VulkanRenderer.hpp"
 
@@ -38,6 +41,26 @@ using namespace RayTracer::ECS;
 using namespace CppDebugger::SeverityValues;
 
 
+/***** HELPER FUNCTIONS *****/
+/* Populates a given VkFenceCreateInfo struct. */
+static void populate_fence_info(VkFenceCreateInfo& fence_info) {
+    DENTER("populate_fence_info");
+
+    // First, set the default stuff
+    fence_info = {};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    // The staging batches create their fences before they submit anything, so they start unsignalled
+    fence_info.flags = 0;
+
+    // And that's it already!
+    DRETURN;
+}
+
+
+
+
+
 /***** VULKANRENDERER CLASS *****/
 /* Constructor for the VulkanRenderer class. */
 VulkanRenderer::VulkanRenderer() :
@@ -60,19 +83,20 @@ VulkanRenderer::VulkanRenderer() :
     uint32_t stage_memory_type = MemoryPool::select_memory_type(*this->gpu, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 
     // Next, initialize all  pools
-    this->device_memory_pool = new MemoryPool(*this->gpu, device_memory_type, VulkanRenderer::device_memory_size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    this->stage_memory_pool = new MemoryPool(*this->gpu, stage_memory_type, VulkanRenderer::stage_memory_size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    this->device_memory_pool = new MemoryPool(*this->gpu, device_memory_type, VulkanRenderer::device_chunk_size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    this->stage_memory_pool = new MemoryPool(*this->gpu, stage_memory_type, VulkanRenderer::stage_chunk_size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 
     this->descriptor_pool = new DescriptorPool(
         *this->gpu,
         Tools::Array<std::tuple<VkDescriptorType, uint32_t>>({
-            std::make_tuple(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1),
-            std::make_tuple(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4)
+            std::make_tuple(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VulkanRenderer::max_descriptor_sets),
+            std::make_tuple(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VulkanRenderer::max_descriptor_sets * VulkanRenderer::max_descriptors)
         }),
         VulkanRenderer::max_descriptor_sets
     );
 
-    this->compute_command_pool = new CommandPool(*this->gpu, this->gpu->queue_info().compute());
+    // The compute buffers may be reset, so the render context can re-record its command buffer
+    this->compute_command_pool = new CommandPool(*this->gpu, this->gpu->queue_info().compute(), VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
     this->memory_command_pool = new CommandPool(*this->gpu, this->gpu->queue_info().memory(), VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 
     // Initialize the descriptor set layout for the raytrace call
@@ -129,6 +153,8 @@ VulkanRenderer::VulkanRenderer(const VulkanRenderer& other) :
     // And copy command buffers
     this->staging_cb_h = this->memory_command_pool->allocate();
 
+    // The render context isn't copied, but re-created on the first render; the same goes for the staging ring and prerender()
+
     // Copy the entity buffers, if any
     if (other.vk_entity_faces != MemoryPool::NullHandle) {
         this->vk_entity_faces = this->device_memory_pool->allocate_buffer_h(other.device_memory_pool->deref_buffer(other.vk_entity_faces));
@@ -154,7 +180,9 @@ VulkanRenderer::VulkanRenderer(VulkanRenderer&& other) :
     raytrace_dsl(other.raytrace_dsl),
     staging_cb_h(other.staging_cb_h),
     vk_entity_faces(other.vk_entity_faces),
-    vk_entity_vertices(other.vk_entity_vertices)
+    vk_entity_vertices(other.vk_entity_vertices),
+    context(other.context),
+    ring(other.ring)
 {
     // Set the other's deallocateable pointers to nullptrs to avoid just that
     other.instance = nullptr;
@@ -165,6 +193,8 @@ VulkanRenderer::VulkanRenderer(VulkanRenderer&& other) :
     other.compute_command_pool = nullptr;
     other.memory_command_pool = nullptr;
     other.raytrace_dsl = nullptr;
+    other.context = RenderContext();
+    other.ring = StagingRing();
 }
 
 /* Destructor for the VulkanRenderer class. */
@@ -173,6 +203,10 @@ VulkanRenderer::~VulkanRenderer() {
     DLOG(info, "Cleaning renderer...");
     DINDENT;
 
+    // Release the render context and the staging ring first, since they live in the pools
+    this->release_context(true);
+    this->release_ring();
+
     if (this->raytrace_dsl != nullptr) {
         delete this->raytrace_dsl;
     }
@@ -206,57 +240,329 @@ VulkanRenderer::~VulkanRenderer() {
 
 
 
-/* Helper function that takes a GPU-allocated faces & vertex buffer and inserts the data from the CPU-side faces & vertex at the given offsets. */
-void VulkanRenderer::transfer_entity(const Compute::Buffer& vk_faces_buffer, uint32_t vk_faces_offset, const Compute::Buffer& vk_vertex_buffer, uint32_t vk_vertex_offset, const Tools::Array<GFace>& faces_buffer, const Tools::Array<glm::vec4>& vertex_buffer, Compute::Suite& suite) {
-    DENTER("VulkanRenderer::transfer_entity");
+/* Creates the staging ring if it doesn't exist yet. */
+void VulkanRenderer::prepare_ring() {
+    DENTER("VulkanRenderer::prepare_ring");
+
+    if (this->ring.memory_pool == nullptr) {
+        DLOG(info, "Creating staging ring of " + Tools::bytes_to_string(VulkanRenderer::staging_ring_size) + "...");
+
+        // Like the render context's host buffer, the ring gets a coherent pool of its own so it can stay mapped without flushing
+        VkMemoryPropertyFlags ring_properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        uint32_t ring_memory_type = MemoryPool::select_memory_type(*this->gpu, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, ring_properties);
+        this->ring.memory_pool = new MemoryPool(*this->gpu, ring_memory_type, VulkanRenderer::staging_ring_size, ring_properties);
+        this->ring.buffer = this->ring.memory_pool->allocate_buffer_h(VulkanRenderer::staging_ring_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+        this->ring.memory_pool->deref_buffer(this->ring.buffer).map(*this->gpu, (void**) &this->ring.map);
+
+        // Every batch gets its own command buffer & fence; the fences start unsignalled, since nothing is in flight yet
+        VkFenceCreateInfo fence_info;
+        populate_fence_info(fence_info);
+        VkResult vk_result;
+        for (uint32_t i = 0; i < VulkanRenderer::staging_ring_batches; i++) {
+            this->ring.cb_h[i] = this->memory_command_pool->allocate_h();
+            if ((vk_result = vkCreateFence(*this->gpu, &fence_info, nullptr, &this->ring.fences[i])) != VK_SUCCESS) {
+                DLOG(fatal, "Could not create fence for staging batch " + std::to_string(i) + ": " + vk_error_map[vk_result]);
+            }
+            this->ring.in_flight[i] = false;
+        }
+        this->ring.batch = 0;
+        this->ring.used = 0;
+        this->ring.recording = false;
+    }
+
+    DRETURN;
+}
+
+/* Waits until the staging ring is idle and destroys it. */
+void VulkanRenderer::release_ring() {
+    DENTER("VulkanRenderer::release_ring");
+
+    if (this->ring.memory_pool != nullptr) {
+        // Make sure no copy still reads from the ring
+        this->flush_ring();
+
+        for (uint32_t i = 0; i < VulkanRenderer::staging_ring_batches; i++) {
+            vkDestroyFence(*this->gpu, this->ring.fences[i], nullptr);
+            this->memory_command_pool->deallocate(this->ring.cb_h[i]);
+        }
+
+        this->ring.memory_pool->deref_buffer(this->ring.buffer).unmap(*this->gpu);
+        this->ring.memory_pool->deallocate(this->ring.buffer);
+        delete this->ring.memory_pool;
 
-    // First, allocate a staging buffer large enough to transfer both the faces and the vertices
-    uint32_t faces_size = (uint32_t) (faces_buffer.size() * sizeof(GFace));
-    uint32_t vertex_size = (uint32_t) (vertex_buffer.size() * sizeof(glm::vec4));
-    uint32_t staging_size = std::max({ faces_size, vertex_size });
-    Buffer staging = suite.stage_memory_pool.allocate_buffer(staging_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+        this->ring = StagingRing();
+    }
+
+    DRETURN;
+}
+
+/* Reserves room for (a part of) an upload of n_bytes to the given offset in the destination in the staging ring, and schedules its copy. The room is a multiple of unit bytes, which n_staged is set to; returns where to write it. */
+void* VulkanRenderer::stage_upload(const Compute::Buffer& destination, VkDeviceSize offset, VkDeviceSize n_bytes, VkDeviceSize unit, VkDeviceSize& n_staged) {
+    DENTER("VulkanRenderer::stage_upload");
+
+    // If the current batch can't hold a single unit anymore, send it off and continue with the next
+    const VkDeviceSize batch_size = VulkanRenderer::staging_ring_size / VulkanRenderer::staging_ring_batches;
+    if (this->ring.recording && batch_size - this->ring.used < unit) {
+        this->submit_batch();
+    }
+    if (unit > batch_size) {
+        DLOG(fatal, "Cannot stage units of " + Tools::bytes_to_string(unit) + " in batches of " + Tools::bytes_to_string(batch_size));
+    }
+
+    // Start recording the batch if we haven't yet, which means waiting until the ring has wrapped past its last copies
+    uint32_t batch = this->ring.batch;
+    CommandBuffer cb = (*this->memory_command_pool)[this->ring.cb_h[batch]];
+    if (!this->ring.recording) {
+        if (this->ring.in_flight[batch]) {
+            vkWaitForFences(*this->gpu, 1, &this->ring.fences[batch], VK_TRUE, UINT64_MAX);
+            this->ring.in_flight[batch] = false;
+        }
+        vkResetFences(*this->gpu, 1, &this->ring.fences[batch]);
+        cb.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        this->ring.used = 0;
+        this->ring.recording = true;
+    }
+
+    // Take as many whole units as fit
+    n_staged = std::min(n_bytes, batch_size - this->ring.used) / unit * unit;
+    VkDeviceSize ring_offset = batch * batch_size + this->ring.used;
+
+    // Schedule the copy already; the data only has to be there once the batch is submitted
+    VkBufferCopy copy_region{};
+    copy_region.srcOffset = ring_offset;
+    copy_region.dstOffset = offset;
+    copy_region.size = n_staged;
+    vkCmdCopyBuffer(cb, this->ring.memory_pool->deref_buffer(this->ring.buffer), destination, 1, &copy_region);
+
+    // Keep the next upload 16-byte aligned, so the CPU can write vectors to it efficiently
+    this->ring.used = std::min(batch_size, (this->ring.used + n_staged + 15) & ~((VkDeviceSize) 15));
+
+    DRETURN (void*) (this->ring.map + ring_offset);
+}
+
+/* Submits the batch that's currently being filled, if any, and moves on to the next one. */
+void VulkanRenderer::submit_batch() {
+    DENTER("VulkanRenderer::submit_batch");
+
+    if (this->ring.recording) {
+        uint32_t batch = this->ring.batch;
+        CommandBuffer cb = (*this->memory_command_pool)[this->ring.cb_h[batch]];
+        cb.end();
+
+        // Submit it with its fence, but don't wait; the ring is coherent, and the submit itself makes the host writes visible
+        VkResult vk_result;
+        VkSubmitInfo submit_info = cb.get_submit_info();
+        if ((vk_result = vkQueueSubmit(this->gpu->memory_queue(), 1, &submit_info, this->ring.fences[batch])) != VK_SUCCESS) {
+            DLOG(fatal, "Could not submit staging batch to queue: " + vk_error_map[vk_result]);
+        }
+        this->ring.in_flight[batch] = true;
+
+        this->ring.batch = (batch + 1) % VulkanRenderer::staging_ring_batches;
+        this->ring.recording = false;
+    }
+
+    DRETURN;
+}
+
+/* Submits whatever is still in the staging ring and waits until all its copies are done. */
+void VulkanRenderer::flush_ring() {
+    DENTER("VulkanRenderer::flush_ring");
+
+    this->submit_batch();
+    for (uint32_t i = 0; i < VulkanRenderer::staging_ring_batches; i++) {
+        if (this->ring.in_flight[i]) {
+            vkWaitForFences(*this->gpu, 1, &this->ring.fences[i], VK_TRUE, UINT64_MAX);
+            this->ring.in_flight[i] = false;
+        }
+    }
 
-    // Next, we copy the faces
-    {
-        // First, map the memory
-        GFace* mapped_memory;
-        staging.map(suite.gpu, (void**) &mapped_memory);
+    DRETURN;
+}
 
-        // Then, copy the CPU buffer over - all the while while we add the vertex offset to the indices
-        for (size_t i = 0; i < faces_buffer.size(); i++) {
-            mapped_memory[i] = faces_buffer[i];
-            mapped_memory[i].v1 += vk_vertex_offset;
-            mapped_memory[i].v2 += vk_vertex_offset;
-            mapped_memory[i].v3 += vk_vertex_offset;
+/* Helper function that takes a GPU-allocated faces & vertex buffer and inserts the data from the CPU-side faces & vertex at the given offsets (in faces & vertices, respectively). The data is copied asynchronously; call flush_ring() before using the buffers. */
+void VulkanRenderer::transfer_entity(const Compute::Buffer& vk_faces_buffer, uint32_t vk_faces_offset, const Compute::Buffer& vk_vertex_buffer, uint32_t vk_vertex_offset, const Tools::Array<GFace>& faces_buffer, const Tools::Array<glm::vec4>& vertex_buffer) {
+    PENTER("VulkanRenderer::transfer_entity");
+
+    // First, stage the faces, in as many parts as the ring needs, adding the vertex offset to the indices along the way
+    size_t i = 0;
+    while (i < faces_buffer.size()) {
+        VkDeviceSize n_staged;
+        GFace* staged = (GFace*) this->stage_upload(vk_faces_buffer, (VkDeviceSize) (vk_faces_offset + i) * sizeof(GFace), (VkDeviceSize) (faces_buffer.size() - i) * sizeof(GFace), sizeof(GFace), n_staged);
+        size_t n_faces = n_staged / sizeof(GFace);
+        for (size_t f = 0; f < n_faces; f++) {
+            staged[f] = faces_buffer[i + f];
+            staged[f].v1 += vk_vertex_offset;
+            staged[f].v2 += vk_vertex_offset;
+            staged[f].v3 += vk_vertex_offset;
         }
+        i += n_faces;
+    }
+
+    // Then, stage the vertices, which can be copied as-is
+    i = 0;
+    while (i < vertex_buffer.size()) {
+        VkDeviceSize n_staged;
+        void* staged = this->stage_upload(vk_vertex_buffer, (VkDeviceSize) (vk_vertex_offset + i) * sizeof(glm::vec4), (VkDeviceSize) (vertex_buffer.size() - i) * sizeof(glm::vec4), sizeof(glm::vec4), n_staged);
+        memcpy(staged, vertex_buffer.rdata() + i, n_staged);
+        i += n_staged / sizeof(glm::vec4);
+    }
+
+    // The copies are in flight (or will be once the batch fills up), so we're done
+    DRETURN;
+}
+
+
+
+/* Makes sure the render context is created for frames of the given size, and that its descriptor set & command buffer point to the current entity buffers. */
+void VulkanRenderer::prepare_context(uint32_t width, uint32_t height) const {
+    PENTER("VulkanRenderer::prepare_context");
+
+    // The shader and the descriptor set don't depend on anything, so they're only created once
+    if (this->context.shader == nullptr) {
+        DLOG(info, "Loading raytrace shader...");
+        this->context.shader = new Shader(*this->gpu, Tools::get_executable_path() + "/shaders/raytracer_v3.spv");
+    }
+    if (this->context.descriptor_set == nullptr) {
+        this->context.descriptor_set = new DescriptorSet(this->descriptor_pool->allocate(*this->raytrace_dsl));
+    }
 
-        // Unmap and then flush the staging area
-        staging.unmap(suite.gpu);
-        staging.flush(suite.gpu);
+    // The camera sits at the start of the host buffer, and the frame right after it
+    VkDeviceSize camera_size = sizeof(GCameraData);
+    VkDeviceSize frame_size = (VkDeviceSize) width * (VkDeviceSize) height * sizeof(uint32_t);
+
+    // Re-create everything that depends on the frame size if it changed
+    if (this->context.width != width || this->context.height != height) {
+        this->release_context(false);
+        DLOG(info, "Creating render context for " + std::to_string(width) + "x" + std::to_string(height) + " frames...");
+
+        // The pipeline has the frame size baked in as specialization constants
+        DINDENT;
+        this->context.pipeline = new Pipeline(
+            *this->gpu,
+            *this->context.shader,
+            Tools::Array<DescriptorSetLayout>({ *this->raytrace_dsl }),
+            std::unordered_map<uint32_t, std::tuple<uint32_t, void*>>({ { 0, std::make_tuple((uint32_t) sizeof(uint32_t), (void*) &width) }, { 1, std::make_tuple((uint32_t) sizeof(uint32_t), (void*) &height) } })
+        );
+        DDEDENT;
+
+        // Allocate the GPU-side buffers
+        this->context.camera = this->device_memory_pool->allocate_buffer_h(camera_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+        this->context.frame = this->device_memory_pool->allocate_buffer_h(frame_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+        // The host buffer gets a host-coherent pool of its own, so it can stay mapped for as long as the context lives and the camera & frame can be copied through it without flushing. It's sized for just the buffer; the pool grows in the rare case that alignment needs more
+        VkMemoryPropertyFlags host_properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        uint32_t host_memory_type = MemoryPool::select_memory_type(*this->gpu, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, host_properties);
+        this->context.host_memory_pool = new MemoryPool(*this->gpu, host_memory_type, camera_size + frame_size, host_properties);
+        this->context.host = this->context.host_memory_pool->allocate_buffer_h(camera_size + frame_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+        this->context.host_memory_pool->deref_buffer(this->context.host).map(*this->gpu, &this->context.host_map);
+
+        // Finally, get a command buffer to record the frame in
+        this->context.cb_h = this->compute_command_pool->allocate_h();
+        this->context.width = width;
+        this->context.height = height;
+        this->context.recorded = false;
+    }
 
-        // Copy the data over, but make sure to only copy to the given offset in the target buffer
-        staging.copyto(suite.staging_cb, suite.gpu.memory_queue(), vk_faces_buffer, (VkDeviceSize) faces_size, (VkDeviceSize) vk_faces_offset);
+    // Point the descriptor set to the current buffers and record the frame if the buffers changed since the last time
+    if (!this->context.recorded) {
+        DLOG(info, "Recording render command buffer...");
+
+        // Fetch the internal handles as buffers
+        Buffer camera = this->device_memory_pool->deref_buffer(this->context.camera);
+        Buffer frame = this->device_memory_pool->deref_buffer(this->context.frame);
+        Buffer host = this->context.host_memory_pool->deref_buffer(this->context.host);
+        Buffer vk_entity_faces = this->device_memory_pool->deref_buffer(this->vk_entity_faces);
+        Buffer vk_entity_vertices = this->device_memory_pool->deref_buffer(this->vk_entity_vertices);
+
+        // Set all bindings
+        const DescriptorSet& descriptor_set = *this->context.descriptor_set;
+        descriptor_set.set(*this->gpu, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, Tools::Array<Buffer>({ frame }));
+        descriptor_set.set(*this->gpu, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, Tools::Array<Buffer>({ camera }));
+        descriptor_set.set(*this->gpu, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, Tools::Array<Buffer>({ vk_entity_faces }));
+        descriptor_set.set(*this->gpu, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3, Tools::Array<Buffer>({ vk_entity_vertices }));
+
+        // Record the entire frame: copy the camera in, render and copy the frame out. Since the copies read the host buffer when they run, the recording can be re-submitted for every new camera
+        CommandBuffer cb_compute = (*this->compute_command_pool)[this->context.cb_h];
+        cb_compute.begin();
+
+        VkBufferCopy camera_region{};
+        camera_region.srcOffset = 0;
+        camera_region.dstOffset = 0;
+        camera_region.size = camera_size;
+        vkCmdCopyBuffer(cb_compute, host, camera, 1, &camera_region);
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_UNIFORM_READ_BIT;
+        vkCmdPipelineBarrier(cb_compute, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        this->context.pipeline->bind(cb_compute);
+        descriptor_set.bind(cb_compute, this->context.pipeline->layout());
+        vkCmdDispatch(cb_compute, (width / 32) + 1, (height / 32) + 1, 1);
+
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(cb_compute, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        VkBufferCopy frame_region{};
+        frame_region.srcOffset = 0;
+        frame_region.dstOffset = camera_size;
+        frame_region.size = frame_size;
+        vkCmdCopyBuffer(cb_compute, frame, host, 1, &frame_region);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(cb_compute, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        cb_compute.end();
+        this->context.recorded = true;
     }
 
-    // Then, we copy the vertices
-    {
-        // First, map the memory
-        void* mapped_memory;
-        staging.map(suite.gpu, &mapped_memory);
+    DRETURN;
+}
+
+/* Destroys the size-dependent parts of the render context (or all of it if full is true). */
+void VulkanRenderer::release_context(bool full) const {
+    DENTER("VulkanRenderer::release_context");
+
+    // Every render waits until the GPU is done, so nothing here is still in use
+    if (this->context.width > 0) {
+        this->compute_command_pool->deallocate(this->context.cb_h);
+
+        this->context.host_memory_pool->deref_buffer(this->context.host).unmap(*this->gpu);
+        this->context.host_memory_pool->deallocate(this->context.host);
+        delete this->context.host_memory_pool;
 
-        // Then, copy the CPU buffer over
-        memcpy(mapped_memory, vertex_buffer.rdata(), vertex_size);
+        this->device_memory_pool->deallocate(this->context.frame);
+        this->device_memory_pool->deallocate(this->context.camera);
 
-        // Unmap and then flush the staging area
-        staging.unmap(suite.gpu);
-        staging.flush(suite.gpu);
+        delete this->context.pipeline;
 
-        // Copy the data over, but make sure to only copy to the given offset in the target buffer
-        staging.copyto(suite.staging_cb, suite.gpu.memory_queue(), vk_vertex_buffer, (VkDeviceSize) vertex_size, (VkDeviceSize) vk_vertex_offset);
+        this->context.width = 0;
+        this->context.height = 0;
+        this->context.pipeline = nullptr;
+        this->context.camera = MemoryPool::NullHandle;
+        this->context.frame = MemoryPool::NullHandle;
+        this->context.host_memory_pool = nullptr;
+        this->context.host = MemoryPool::NullHandle;
+        this->context.host_map = nullptr;
+        this->context.recorded = false;
+    }
+
+    // Only throw away the parts that don't depend on the size if asked
+    if (full) {
+        if (this->context.descriptor_set != nullptr) {
+            this->descriptor_pool->deallocate(*this->context.descriptor_set);
+            delete this->context.descriptor_set;
+            this->context.descriptor_set = nullptr;
+        }
+        if (this->context.shader != nullptr) {
+            delete this->context.shader;
+            this->context.shader = nullptr;
+        }
     }
 
-    // Deallocate the staging buffer and we're done
-    suite.stage_memory_pool.deallocate(staging);
     DRETURN;
 }
 
@@ -264,9 +570,10 @@ void VulkanRenderer::transfer_entity(const Compute::Buffer& vk_faces_buffer, uin
         
 /* Pre-renders the given list of RenderEntities, accelerated using Vulkan compute shaders. */
 void VulkanRenderer::prerender(const Tools::Array<ECS::RenderEntity*>& entities) {
-    DENTER("VulkanRenderer::prerender");
+    PENTER("VulkanRenderer::prerender");
     DLOG(info, "Pre-rendering entities...");
     DINDENT;
+    auto start = std::chrono::steady_clock::now();
 
     // First, if any, deallocate the old buffers
     if (this->vk_entity_faces != MemoryPool::NullHandle) {
@@ -291,9 +598,15 @@ void VulkanRenderer::prerender(const Tools::Array<ECS::RenderEntity*>& entities)
     this->vk_entity_vertices = this->device_memory_pool->allocate_buffer_h(n_vertices * sizeof(glm::vec4), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
     Buffer vk_entity_vertices = this->device_memory_pool->deref_buffer(this->vk_entity_vertices);
 
+    // The render context still points to the old buffers, so it has to be recorded again
+    this->context.recorded = false;
+
     // Prepare a suite of the GPU-related structures to pass to GPU-enabled functions as necessary
     Compute::Suite suite = this->get_suite();
 
+    // Make sure there's a staging ring to upload the entities pre-rendered on the CPU through
+    this->prepare_ring();
+
     // Prepare two temporary Array structures to pre-render on the CPU in
     Tools::Array<GFace> entity_faces;
     Tools::Array<glm::vec4> entity_vertices;
@@ -301,6 +614,8 @@ void VulkanRenderer::prerender(const Tools::Array<ECS::RenderEntity*>& entities)
     // Next, loop through all entities to render them
     uint32_t faces_offset = 0, vertex_offset = 0;
     for (size_t i = 0; i < entities.size(); i++) {
+        auto entity_start = std::chrono::steady_clock::now();
+
         // Select the proper pre-render mode
         if (entities[i]->pre_render_mode & EntityPreRenderModeFlags::eprmf_gpu) {
             // Determine the type of pre-rendering operation we need to do
@@ -363,17 +678,17 @@ void VulkanRenderer::prerender(const Tools::Array<ECS::RenderEntity*>& entities)
             switch (entities[i]->pre_render_operation) {
                 case EntityPreRenderOperation::epro_generate_triangle:
                     /* Call the generate triangle CPU function. */
-                    cpu_pre_render_triangle(entity_faces, entity_vertices, (Triangle*) entities[i]);
+                    cpu_pre_render_triangle(entity_faces.wdata(), entity_vertices.wdata(), 0, (Triangle*) entities[i]);
                     break;
 
                 case EntityPreRenderOperation::epro_generate_sphere:
                     /* Call the generate sphere CPU function. */
-                    cpu_pre_render_sphere(entity_faces, entity_vertices, (Sphere*) entities[i]);
+                    cpu_pre_render_sphere(entity_faces.wdata(), entity_vertices.wdata(), 0, (Sphere*) entities[i]);
                     break;
                 
                 case EntityPreRenderOperation::epro_load_object_file:
                     /* Call the load object file CPU function. */
-                    cpu_pre_render_object(entity_faces, entity_vertices, (Object*) entities[i]);
+                    cpu_pre_render_object(entity_faces.wdata(), entity_vertices.wdata(), 0, (Object*) entities[i]);
                     break;
 
                 default:
@@ -381,8 +696,8 @@ void VulkanRenderer::prerender(const Tools::Array<ECS::RenderEntity*>& entities)
 
             }
 
-            // Once done, use the internal function to copy them to the CPU
-            this->transfer_entity(vk_entity_faces, faces_offset, vk_entity_vertices, vertex_offset, entity_faces, entity_vertices, suite);
+            // Once done, use the internal function to copy them to the GPU. This only waits if the staging ring is full, so we can already pre-render the next entity while they're copied
+            this->transfer_entity(vk_entity_faces, faces_offset, vk_entity_vertices, vertex_offset, entity_faces, entity_vertices);
             faces_offset += entities[i]->pre_render_faces;
             vertex_offset += entities[i]->pre_render_vertices;
 
@@ -391,8 +706,18 @@ void VulkanRenderer::prerender(const Tools::Array<ECS::RenderEntity*>& entities)
         }
 
         // Inserting is now handled by either the function itself or the CPU-specific function, so we're done!
+        ++this->stats.prerender_entities[entities[i]->type];
+        this->stats.prerender_faces[entities[i]->type] += entities[i]->pre_render_faces;
+        this->stats.threads[0].prerender_time[entities[i]->type] += seconds_since(entity_start);
     }
 
+    // Wait until the last uploads have arrived before anything renders with the buffers
+    this->flush_ring();
+    this->stats.prerender_time += seconds_since(start);
+
+    // Report how much of the device memory we use now
+    DLOG(auxillary, "Device memory: " + Tools::bytes_to_string(this->device_memory_pool->used()) + " used by " + std::to_string(this->device_memory_pool->allocations()) + " buffers (peak " + Tools::bytes_to_string(this->device_memory_pool->high_water_mark()) + "), " + std::to_string((int) (this->device_memory_pool->fragmentation() * 100.0)) + "% of free memory fragmented");
+
     // We're done! We pre-rendered all objects!
     DDEDENT;
     DRETURN;
@@ -400,7 +725,8 @@ void VulkanRenderer::prerender(const Tools::Array<ECS::RenderEntity*>& entities)
 
 /* Renders the internal list of vertices to a frame using the given camera position. */
 void VulkanRenderer::render(Camera& cam) const {
-    DENTER("VulkanRenderer::render");
+    PENTER("VulkanRenderer::render");
+    auto start = std::chrono::steady_clock::now();
 
     // Print some info
     DLOG(info, "Rendering for camera:");
@@ -411,113 +737,54 @@ void VulkanRenderer::render(Camera& cam) const {
     DLOG(auxillary, "Camera lower_left_corner : (" + std::to_string(cam.lower_left_corner.x) + "," + std::to_string(cam.lower_left_corner.y) + "," + std::to_string(cam.lower_left_corner.z) + ")");
     DDEDENT;
     
-    /* Step 1: Camera buffer initialization. */
-    DLOG(info, "Transferring camera to GPU...");
-    
-    // First, allocate buffers for the frame and the camera data
+    /* Step 1: Context preparation. */
     uint32_t width = cam.w(), height = cam.h();
-    size_t camera_size = sizeof(GCameraData);
-    size_t frame_size = width * height * sizeof(uint32_t);
-    Buffer camera = this->device_memory_pool->allocate_buffer(camera_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
-    Buffer frame = this->device_memory_pool->allocate_buffer(frame_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-
-    // Next, get a staging buffer for the camera only
-    Buffer camera_staging = this->stage_memory_pool->allocate_buffer(camera_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-
-    // Map the staging buffer to host-reachable memory
-    void* camera_staging_map;
-    camera_staging.map(*this->gpu, &camera_staging_map);
-
-    // Populate the data. For the camera this is rather manual
-    ((GCameraData*) camera_staging_map)->origin = cam.origin;
-    ((GCameraData*) camera_staging_map)->horizontal = cam.horizontal;
-    ((GCameraData*) camera_staging_map)->vertical = cam.vertical;
-    ((GCameraData*) camera_staging_map)->lower_left_corner = cam.lower_left_corner;
-
-    // Flush & unmap the staging buffer
-    camera_staging.flush(*this->gpu);
-    camera_staging.unmap(*this->gpu);
+    this->prepare_context(width, height);
 
-    // Next, we schedule the copies of the staging buffer to the real buffer
-    CommandBuffer staging_cb = (*this->memory_command_pool)[this->staging_cb_h];
-    camera_staging.copyto(staging_cb, this->gpu->memory_queue(), camera);
 
-    // Once that's done, deallocate the staging buffer for the camera.
-    this->stage_memory_pool->deallocate(camera_staging);
 
+    /* Step 2: Camera update. */
+    DLOG(info, "Updating camera...");
 
+    // The host buffer is mapped and coherent, so we can write the camera data right into it
+    GCameraData* camera_data = (GCameraData*) this->context.host_map;
+    camera_data->origin = cam.origin;
+    camera_data->horizontal = cam.horizontal;
+    camera_data->vertical = cam.vertical;
+    camera_data->lower_left_corner = cam.lower_left_corner;
 
-    /* Step 3: Descriptor set initialization. */
-    DLOG(info, "Creating descriptor set...");
-
-    // Fetch the internal handles as buffers
-    Buffer vk_entity_faces = this->device_memory_pool->deref_buffer(this->vk_entity_faces);
-    Buffer vk_entity_vertices = this->device_memory_pool->deref_buffer(this->vk_entity_vertices);
-
-    // Allocate a DescriptorSet & set all bindings
-    DescriptorSet descriptor_set = this->descriptor_pool->allocate(*this->raytrace_dsl);
-    descriptor_set.set(*this->gpu, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, Tools::Array<Buffer>({ frame }));
-    descriptor_set.set(*this->gpu, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, Tools::Array<Buffer>({ camera }));
-    descriptor_set.set(*this->gpu, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, Tools::Array<Buffer>({ vk_entity_faces }));
-    descriptor_set.set(*this->gpu, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3, Tools::Array<Buffer>({ vk_entity_vertices }));
 
 
-
-    /* Step 4: Render the frame. */
-    DLOG(info, "Preparing pipeline...");
-    
-    // Initialize a new pipeline using the new layout
-    DINDENT;
-    Pipeline pipeline(
-        *this->gpu,
-        Shader(*this->gpu, Tools::get_executable_path() + "/shaders/raytracer_v3.spv"),
-        Tools::Array<DescriptorSetLayout>({ *this->raytrace_dsl }),
-        std::unordered_map<uint32_t, std::tuple<uint32_t, void*>>({ { 0, std::make_tuple((uint32_t) sizeof(uint32_t), (void*) &width) }, { 1, std::make_tuple((uint32_t) sizeof(uint32_t), (void*) &height) } })
-    );
-    DDEDENT;
-    
-    // Next, start recording the compute command buffer
-    DLOG(info, "Recording command buffer...");
-    CommandBuffer cb_compute = this->compute_command_pool->allocate();
-    cb_compute.begin();
-    pipeline.bind(cb_compute);
-    descriptor_set.bind(cb_compute, pipeline.layout());
-    vkCmdDispatch(cb_compute, (width / 32) + 1, (height / 32) + 1, 1);
-    cb_compute.end();
-
-    // With the buffer recorded, submit it to the given queue
+    /* Step 3: Render the frame. */
     DLOG(info, "Rendering...");
+    auto trace_start = std::chrono::steady_clock::now();
+    CommandBuffer cb_compute = (*this->compute_command_pool)[this->context.cb_h];
     VkResult vk_result;
     VkSubmitInfo submit_info = cb_compute.get_submit_info();
     if ((vk_result = vkQueueSubmit(this->gpu->compute_queue(), 1, &submit_info, VK_NULL_HANDLE)) != VK_SUCCESS) {
         DLOG(fatal, "Could not submit command buffer to queue: " + vk_error_map[vk_result]);
     }
 
-    // Finally, wait until the rendering is done
+    // Finally, wait until the rendering (and the copy back) is done
     if ((vk_result = vkQueueWaitIdle(this->gpu->compute_queue())) != VK_SUCCESS) {
         DLOG(fatal, "Could not wait for queue to become idle: " + vk_error_map[vk_result]);
     }
+    this->stats.threads[0].busy_time += seconds_since(trace_start);
 
 
 
     /* Step 4: Frame retrieval. */
     DLOG(info, "Retrieving frame...");
-    
-    // Get a staging buffer for the frame
-    Buffer frame_staging = this->stage_memory_pool->allocate_buffer(frame_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
-
-    // Copy the contents of the frame buffer back to the CPU
-    frame.copyto(staging_cb, this->gpu->memory_queue(), frame_staging);
 
-    // Next, map the staging buffer's memory to host-accessible memory
-    void* frame_staging_map;
-    frame_staging.map(*this->gpu, &frame_staging_map);
+    // The frame was copied to the host buffer, right after the camera
+    const uint32_t* frame_map = (const uint32_t*) ((const uint8_t*) this->context.host_map + sizeof(GCameraData));
 
     // Copy the integer over, but apply some swizzling to correct for the incorrect GPU format (little endian + BGRA instead of RGBA)
-    for (size_t i = 0; i < width * height; i++) {
+    Frame& result = cam.get_frame();
+    for (size_t i = 0; i < (size_t) width * (size_t) height; i++) {
         // Get the raw value as an IPixel
         IPixel gp;
-        gp.raw = ((uint32_t*) frame_staging_map)[i];
+        gp.raw = frame_map[i];
 
         // Now, swizzle the pixel to the CPU-expected format
         IPixel cp;
@@ -527,30 +794,14 @@ void VulkanRenderer::render(Camera& cam) const {
         cp.pixel.a = gp.pixel.b;
 
         // Store in the camera, swizzled to the correct order
-        cam.get_frame().d()[i] = cp.raw;
+        result.d()[result.index((uint32_t) (i % width), (uint32_t) (i / width))] = cp.raw;
     }
-   
-    // When done, flush and unmap
-    frame_staging.flush(*this->gpu);
-    frame_staging.unmap(*this->gpu);
 
-    // Once we're done, we can clean the frame staging buffer
-    this->stage_memory_pool->deallocate(frame_staging);
-    
-
-
-    /* Step 5: Cleanup. */
-    DLOG(info, "Finishing up...");
-
-    // Cleanup the command buffer
-    this->compute_command_pool->deallocate(cb_compute);
-
-    // Cleanup the descriptor set
-    this->descriptor_pool->deallocate(descriptor_set);
-
-    // Cleanup the GPU buffers
-    this->device_memory_pool->deallocate(frame);
-    this->device_memory_pool->deallocate(camera);
+    // The shader traces one ray per pixel, but doesn't count its tests
+    ++this->stats.frames;
+    this->stats.pixels += (uint64_t) width * height;
+    this->stats.threads[0].rays += (uint64_t) width * height;
+    this->stats.render_time += seconds_since(start);
 
     // Done!
     DRETURN;
@@ -580,6 +831,9 @@ void RayTracer::swap(VulkanRenderer& r1, VulkanRenderer& r2) {
     swap(r1.vk_entity_faces, r2.vk_entity_faces);
     swap(r1.vk_entity_vertices, r2.vk_entity_vertices);
 
+    swap(r1.context, r2.context);
+    swap(r1.ring, r2.ring);
+
     // Done
 }
 
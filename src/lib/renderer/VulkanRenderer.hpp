@@ -4,7 +4,7 @@
  * Created:
  *   30/04/2021, 13:34:28
  * Last edited:
- *   21/05/2021, 16:19:25
+ *   16/10/2026, 01:22:26
  * Auto updated?
  *   Yes
  *
@@ -22,6 +22,8 @@
 #include "compute/MemoryPool.hpp"
 #include "compute/DescriptorPool.hpp"
 #include "compute/CommandPool.hpp"
+#include "compute/Shader.hpp"
+#include "compute/Pipeline.hpp"
 #include "compute/Suite.hpp"
 
 #include "Vertex.hpp"
@@ -41,14 +43,18 @@ namespace RayTracer {
     /* The VulkanRenderer class, which implements the standard Renderer using Vulkan compute shaders. */
     class VulkanRenderer: public Renderer {
     public:
-        /* Constant that determines the pool size of the device-local memory. */
-        static const constexpr VkDeviceSize device_memory_size = 1024 * 1024 * 1024;
-        /* Constant that determines the pool size of the transfer memory. */
-        static const constexpr VkDeviceSize stage_memory_size = 1024 * 1024 * 1024;
+        /* Constant that determines the size of the chunks that the pool of device-local memory starts with and grows by. */
+        static const constexpr VkDeviceSize device_chunk_size = 64 * 1024 * 1024;
+        /* Constant that determines the size of the chunks that the pool of transfer memory starts with and grows by. */
+        static const constexpr VkDeviceSize stage_chunk_size = 32 * 1024 * 1024;
         /* The maximum number of descriptors per set in the desriptor pool. */
         static const constexpr uint32_t max_descriptors = 4;
-        /* The maximum number of descriptor sets in the desriptor pool. */
-        static const constexpr uint32_t max_descriptor_sets = 1;
+        /* The maximum number of descriptor sets in the desriptor pool. One is kept by the render context, the other is used while pre-rendering. */
+        static const constexpr uint32_t max_descriptor_sets = 2;
+        /* The size of the persistently mapped ring that the entities pre-rendered on the CPU are uploaded through. */
+        static const constexpr VkDeviceSize staging_ring_size = 16 * 1024 * 1024;
+        /* The number of batches the staging ring is split in. Each is submitted with a fence of its own, so the CPU can fill one while the others are copied. */
+        static const constexpr uint32_t staging_ring_batches = 4;
 
     protected:
         /* The instance used to select the GPU from. */
@@ -79,12 +85,87 @@ namespace RayTracer {
         /* GPU-side buffer that stores all the pre-rendered vertices from all entities, ready for rendering. */
         Compute::BufferHandle vk_entity_vertices;
 
+        /* The RenderContext struct, which keeps everything that render() needs alive between calls. Rendering again at the same resolution then only updates the camera, submits and reads back. */
+        struct RenderContext {
+            /* The width of the frames the context is created for, or 0 if it isn't created yet. */
+            uint32_t width = 0;
+            /* The height of the frames the context is created for, or 0 if it isn't created yet. */
+            uint32_t height = 0;
+
+            /* The raytrace shader, which is loaded on the first render. */
+            Compute::Shader* shader = nullptr;
+            /* The raytrace pipeline, which is specialized for the width & height. */
+            Compute::Pipeline* pipeline = nullptr;
+
+            /* GPU-side uniform buffer with the camera data. */
+            Compute::BufferHandle camera = Compute::MemoryPool::NullHandle;
+            /* GPU-side buffer that the frame is rendered to. */
+            Compute::BufferHandle frame = Compute::MemoryPool::NullHandle;
+            /* Host-visible, coherent memory pool of the host buffer alone, so that buffer can stay mapped for as long as the context lives. */
+            Compute::MemoryPool* host_memory_pool = nullptr;
+            /* Host-side buffer with the camera data at the start, followed by the rendered frame. */
+            Compute::BufferHandle host = Compute::MemoryPool::NullHandle;
+            /* The host buffer, mapped to host memory for as long as the context lives. */
+            void* host_map = nullptr;
+
+            /* The descriptor set that binds the frame, camera & entity buffers. */
+            Compute::DescriptorSet* descriptor_set = nullptr;
+            /* The command buffer that copies the camera, renders and copies the frame back. */
+            Compute::CommandBufferHandle cb_h = 0;
+            /* Whether the descriptor set & command buffer are up-to-date with the current buffers. */
+            bool recorded = false;
+        };
+        /* The resources kept alive between calls to render(). Mutable, since render() is const but (re)creates them lazily. */
+        mutable RenderContext context;
+
+        /* The StagingRing struct, which keeps a persistently mapped buffer that uploads are packed into, in batches that are copied to the GPU asynchronously. */
+        struct StagingRing {
+            /* Host-visible, coherent memory pool for the ring, which is separate from the staging pool so it can stay mapped. */
+            Compute::MemoryPool* memory_pool = nullptr;
+            /* The buffer that the uploads are packed into. */
+            Compute::BufferHandle buffer = Compute::MemoryPool::NullHandle;
+            /* The buffer, mapped to host memory for as long as the ring lives. */
+            uint8_t* map = nullptr;
+
+            /* The command buffer that every batch records its copies in. */
+            Compute::CommandBufferHandle cb_h[staging_ring_batches] = {};
+            /* The fence of every batch, which is signalled once its copies are done. */
+            VkFence fences[staging_ring_batches] = {};
+            /* Whether every batch is submitted but not yet waited for. */
+            bool in_flight[staging_ring_batches] = {};
+
+            /* The batch that is currently being filled. */
+            uint32_t batch = 0;
+            /* The number of bytes used in the current batch. */
+            VkDeviceSize used = 0;
+            /* Whether the command buffer of the current batch is being recorded. */
+            bool recording = false;
+        };
+        /* The ring that prerender() uploads the entities pre-rendered on the CPU through. */
+        StagingRing ring;
+
 
         /* Constructor that accepts a boolean. Regardless of its value, does not initialize any vulkan objects. */
         VulkanRenderer(bool dont_init_vulkan);
 
-        /* Helper function that takes a GPU-allocated faces & vertex buffer and inserts the data from the CPU-side faces & vertex at the given offsets. */
-        void transfer_entity(const Compute::Buffer& vk_faces_buffer, uint32_t vk_faces_offset, const Compute::Buffer& vk_vertex_buffer, uint32_t vk_vertex_offset, const Tools::Array<GFace>& faces_buffer, const Tools::Array<glm::vec4>& vertex_buffer, Compute::Suite& suite);
+        /* Makes sure the render context is created for frames of the given size, and that its descriptor set & command buffer point to the current entity buffers. */
+        void prepare_context(uint32_t width, uint32_t height) const;
+        /* Destroys the size-dependent parts of the render context (or all of it if full is true). */
+        void release_context(bool full) const;
+
+        /* Creates the staging ring if it doesn't exist yet. */
+        void prepare_ring();
+        /* Waits until the staging ring is idle and destroys it. */
+        void release_ring();
+        /* Reserves room for (a part of) an upload of n_bytes to the given offset in the destination in the staging ring, and schedules its copy. The room is a multiple of unit bytes, which n_staged is set to; returns where to write it. */
+        void* stage_upload(const Compute::Buffer& destination, VkDeviceSize offset, VkDeviceSize n_bytes, VkDeviceSize unit, VkDeviceSize& n_staged);
+        /* Submits the batch that's currently being filled, if any, and moves on to the next one. */
+        void submit_batch();
+        /* Submits whatever is still in the staging ring and waits until all its copies are done. */
+        void flush_ring();
+
+        /* Helper function that takes a GPU-allocated faces & vertex buffer and inserts the data from the CPU-side faces & vertex at the given offsets (in faces & vertices, respectively). The data is copied asynchronously; call flush_ring() before using the buffers. */
+        void transfer_entity(const Compute::Buffer& vk_faces_buffer, uint32_t vk_faces_offset, const Compute::Buffer& vk_vertex_buffer, uint32_t vk_vertex_offset, const Tools::Array<GFace>& faces_buffer, const Tools::Array<glm::vec4>& vertex_buffer);
 
     public:
         /* Constructor for the VulkanRenderer class. */
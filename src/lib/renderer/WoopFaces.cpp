@@ -0,0 +1,99 @@
+/* WOOP FACES.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   15/10/2026, 17:05:48
+ * Last edited:
+ *   16/10/2026, 03:08:07
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the WoopFaces class, which stores the pre-rendered faces of a
+ *   scene in the form the CPU backends intersect them in. Instead of
+ *   indices into the vertex buffer and a normal, it stores for each face
+ *   the affine transformation that maps it onto the unit triangle, which
+ *   is all Woop's intersection test needs. The transformation of a face
+ *   is a single 48-byte record, so testing a face only touches that.
+**/
+
+#include <CppDebugger.hpp>
+
+#include "tools/Common.hpp"
+#include "tools/Profiler.hpp"
+
+#include "WoopFaces.hpp"
+
+using namespace std;
+using namespace RayTracer;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** WOOPFACES CLASS *****/
+/* Default constructor for the WoopFaces class, which initializes it to empty. */
+WoopFaces::WoopFaces() {}
+
+
+
+/* Computes the transformation of the given face and stores it at the given index. Returns false if the face is degenerate, in which case it's stored such that it's never hit. */
+bool WoopFaces::store(size_t i, const GFace& face, const Tools::Array<glm::vec4>& vertices) {
+    // The face is the unit triangle in the space spanned by its edges and normal, with its first vertex as origin
+    glm::vec3 p1 = vertices[face.v1];
+    glm::vec3 e1 = glm::vec3(vertices[face.v2]) - p1;
+    glm::vec3 e2 = glm::vec3(vertices[face.v3]) - p1;
+    glm::vec3 n = glm::cross(e1, e2);
+
+    // Invert that space's basis. Its determinant is the squared length of the normal, so it's only singular for degenerate faces
+    float det = glm::dot(n, n);
+    WoopFace& result = this->faces[i];
+    if (det > 0.0f) {
+        glm::vec3 row_u = glm::cross(e2, n) / det;
+        glm::vec3 row_v = glm::cross(n, e1) / det;
+        glm::vec3 row_n = n / det;
+        result.u = glm::vec4(row_u, -glm::dot(row_u, p1));
+        result.v = glm::vec4(row_v, -glm::dot(row_v, p1));
+        result.n = glm::vec4(row_n, -glm::dot(row_n, p1));
+    } else {
+        // All-zero rows make the plane test produce NaNs, which never count as a hit
+        result.u = glm::vec4(0.0f);
+        result.v = glm::vec4(0.0f);
+        result.n = glm::vec4(0.0f);
+    }
+    return det > 0.0f;
+}
+
+
+
+/* Fills the list with the given faces, in the same order. Degenerate faces are stored such that they are never hit. */
+void WoopFaces::build(const Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices) {
+    PENTER("WoopFaces::build");
+
+    // Make sure the list is large enough
+    this->faces.resize(faces.size());
+
+    // Compute the transformation per face
+    uint32_t n_degenerate = 0;
+    for (size_t i = 0; i < faces.size(); i++) {
+        if (!this->store(i, faces[i], vertices)) { ++n_degenerate; }
+    }
+
+    DLOG(auxillary, "Stored " + std::to_string(faces.size()) + " faces as unit-triangle transformations (" + Tools::bytes_to_string(this->bytes()) + ", " + std::to_string(n_degenerate) + " degenerate)");
+
+    DRETURN;
+}
+
+/* Recomputes the given range of faces, after they have moved or have been re-ordered. Only touches that range, so disjoint ranges may be updated in parallel. */
+void WoopFaces::update(const Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, size_t first, size_t count) {
+    for (size_t i = first; i < first + count; i++) {
+        this->store(i, faces[i], vertices);
+    }
+}
+
+/* Clears the list. */
+void WoopFaces::clear() {
+    DENTER("WoopFaces::clear");
+
+    this->faces.clear();
+
+    DRETURN;
+}
@@ -0,0 +1,129 @@
+/* WOOP FACES.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   15/10/2026, 17:05:51
+ * Last edited:
+ *   16/10/2026, 03:08:07
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the WoopFaces class, which stores the pre-rendered faces of a
+ *   scene in the form the CPU backends intersect them in. Instead of
+ *   indices into the vertex buffer and a normal, it stores for each face
+ *   the affine transformation that maps it onto the unit triangle, which
+ *   is all Woop's intersection test needs. The transformation of a face
+ *   is a single 48-byte record, so testing a face only touches that.
+**/
+
+#ifndef RENDERER_WOOP_FACES_HPP
+#define RENDERER_WOOP_FACES_HPP
+
+#include <cstdint>
+
+#include "glm/glm.hpp"
+
+#include "tools/Array.hpp"
+
+#include "Vertex.hpp"
+#include "RayPacket.hpp"
+
+namespace RayTracer {
+    /* The WoopFace struct, which holds the transformation of a single face onto the unit triangle. Each row has an x, y, z and offset (w) component. */
+    struct alignas(16) WoopFace {
+        /* The row that maps a point to its distance from the face's plane (in units of the face's normal). Comes first, since it's the only one needed to reject most faces. */
+        glm::vec4 n;
+        /* The row that maps a point to its u-coordinate. */
+        glm::vec4 u;
+        /* The row that maps a point to its v-coordinate. */
+        glm::vec4 v;
+    };
+    static_assert(sizeof(WoopFace) == 48, "WoopFace should be exactly twelve floats");
+
+
+
+    /* The WoopFaces class, which stores a list of faces as their unit-triangle transformations. */
+    class WoopFaces {
+    private:
+        /* The transformations, one per face. */
+        Tools::Array<WoopFace> faces;
+
+        /* Computes the transformation of the given face and stores it at the given index. Returns false if the face is degenerate, in which case it's stored such that it's never hit. */
+        bool store(size_t i, const GFace& face, const Tools::Array<glm::vec4>& vertices);
+
+    public:
+        /* Default constructor for the WoopFaces class, which initializes it to empty. */
+        WoopFaces();
+
+        /* Fills the list with the given faces, in the same order. Degenerate faces are stored such that they are never hit. */
+        void build(const Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices);
+        /* Recomputes the given range of faces, after they have moved or have been re-ordered. Only touches that range, so disjoint ranges may be updated in parallel. */
+        void update(const Tools::Array<GFace>& faces, const Tools::Array<glm::vec4>& vertices, size_t first, size_t count);
+        /* Clears the list. */
+        void clear();
+
+        /* Computes the distance along the given ray where it hits the face with the given index, or a negative value if it doesn't hit before min_t. */
+        inline float hit(uint32_t i, const glm::vec3& origin, const glm::vec3& direction, float min_t) const;
+        #if PACKET_SIZE > 1
+        /* Computes for all rays in the given packet whether they hit the face with the given index closer than anything they hit before, and if so, updates their closest hit. */
+        inline void hit(uint32_t i, RayPacket& packet) const;
+        #endif
+
+        /* Returns the number of faces stored. */
+        inline size_t size() const { return this->faces.size(); }
+        /* Returns the number of bytes taken up by the transformations. */
+        inline size_t bytes() const { return this->faces.size() * sizeof(WoopFace); }
+
+    };
+
+
+
+    /* Computes the distance along the given ray where it hits the face with the given index, or a negative value if it doesn't hit before min_t. */
+    inline float WoopFaces::hit(uint32_t i, const glm::vec3& origin, const glm::vec3& direction, float min_t) const {
+        const WoopFace& f = this->faces[i];
+
+        // First, find where the ray crosses the face's plane, which rejects most faces already
+        float oz = f.n.x * origin.x + f.n.y * origin.y + f.n.z * origin.z + f.n.w;
+        float dz = f.n.x * direction.x + f.n.y * direction.y + f.n.z * direction.z;
+        float t = -oz / dz;
+        if (!(t >= 0.0f && t < min_t)) { return -1.0f; }
+
+        // Then compute the barycentric coordinates of that point, one at a time
+        float u = f.u.x * origin.x + f.u.y * origin.y + f.u.z * origin.z + f.u.w + t * (f.u.x * direction.x + f.u.y * direction.y + f.u.z * direction.z);
+        if (u < 0.0f || u > 1.0f) { return -1.0f; }
+        float v = f.v.x * origin.x + f.v.y * origin.y + f.v.z * origin.z + f.v.w + t * (f.v.x * direction.x + f.v.y * direction.y + f.v.z * direction.z);
+        if (v < 0.0f || u + v > 1.0f) { return -1.0f; }
+
+        // It's a hit!
+        return t;
+    }
+
+    #if PACKET_SIZE > 1
+    /* Computes for all rays in the given packet whether they hit the face with the given index closer than anything they hit before, and if so, updates their closest hit. */
+    inline void WoopFaces::hit(uint32_t i, RayPacket& packet) const {
+        const WoopFace& f = this->faces[i];
+        const glm::vec3& o = packet.origin;
+
+        // Find where the rays cross the face's plane. The origin is shared, so its transformation is the same for all rays
+        float oz = f.n.x * o.x + f.n.y * o.y + f.n.z * o.z + f.n.w;
+        floatp dz = f.n.x * packet.dx + f.n.y * packet.dy + f.n.z * packet.dz;
+        floatp t = -oz / dz;
+        intp mask = (t >= 0.0f) & (t < packet.min_t);
+        if (!any(mask)) { return; }
+
+        // Compute the barycentric coordinates of those points
+        float ou = f.u.x * o.x + f.u.y * o.y + f.u.z * o.z + f.u.w;
+        float ov = f.v.x * o.x + f.v.y * o.y + f.v.z * o.z + f.v.w;
+        floatp u = ou + t * (f.u.x * packet.dx + f.u.y * packet.dy + f.u.z * packet.dz);
+        floatp v = ov + t * (f.v.x * packet.dx + f.v.y * packet.dy + f.v.z * packet.dz);
+        mask &= (u >= 0.0f) & (v >= 0.0f) & (u + v <= 1.0f);
+
+        // Store the hits for the rays that had any
+        packet.min_t = select(mask, t, packet.min_t);
+        packet.hit = select(mask, broadcast((int32_t) i), packet.hit);
+    }
+    #endif
+}
+
+#endif
@@ -0,0 +1,211 @@
+/* ARENA.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 10:48:25
+ * Last edited:
+ *   16/10/2026, 10:48:25
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the Arena class, which hands out memory by simply bumping a
+ *   pointer through large blocks, and which frees everything at once
+ *   when it's reset. This makes it ideal for data that lives exactly as
+ *   long as a scene or a frame. Also contains the ArenaAllocator, which
+ *   lets a Tools::Array allocate its elements in an Arena.
+**/
+
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "Arena.hpp"
+
+using namespace std;
+using namespace Tools;
+
+
+/***** HELPER FUNCTIONS *****/
+/* Returns the given address rounded up to the given alignment, which must be a power of two. */
+static inline uintptr_t align_address(uintptr_t address, size_t alignment) {
+    return (address + alignment - 1) & ~((uintptr_t) alignment - 1);
+}
+
+
+
+
+
+/***** ARENA CLASS *****/
+/* Constructor for the Arena class, which takes the minimum size of the blocks it allocates. No memory is allocated until the first allocation. */
+Arena::Arena(size_t min_block_size) :
+    head(nullptr),
+    head_used(0),
+    last(nullptr),
+    finalizers(nullptr),
+    min_block_size(min_block_size),
+    n_used(0),
+    n_high_water(0)
+{}
+
+/* Move constructor for the Arena class. */
+Arena::Arena(Arena&& other) :
+    head(other.head),
+    head_used(other.head_used),
+    last(other.last),
+    finalizers(other.finalizers),
+    min_block_size(other.min_block_size),
+    n_used(other.n_used),
+    n_high_water(other.n_high_water)
+{
+    // Make sure the other doesn't free anything
+    other.head = nullptr;
+    other.head_used = 0;
+    other.last = nullptr;
+    other.finalizers = nullptr;
+    other.n_used = 0;
+}
+
+/* Destructor for the Arena class, which destroys all objects created in it and frees all memory. */
+Arena::~Arena() {
+    this->finalize();
+    this->free_blocks();
+}
+
+
+
+/* Adds a new block that can hold at least the given number of bytes with the given alignment. */
+void Arena::add_block(size_t n_bytes, size_t alignment) {
+    // Make it at least as large as the minimum, and large enough to align the allocation within it
+    size_t size = std::max(this->min_block_size, n_bytes + (alignment > alignof(Block) ? alignment : 0));
+    Block* block = (Block*) malloc(sizeof(Block) + size);
+    if (block == nullptr) { throw std::bad_alloc(); }
+
+    // Put it in front of the others
+    block->next = this->head;
+    block->size = size;
+    this->head = block;
+    this->head_used = 0;
+    this->last = nullptr;
+}
+
+/* Runs all finalizers, latest first. */
+void Arena::finalize() {
+    while (this->finalizers != nullptr) {
+        Finalizer* finalizer = this->finalizers;
+        this->finalizers = finalizer->next;
+        finalizer->destroy(finalizer->object);
+    }
+}
+
+/* Frees all blocks. */
+void Arena::free_blocks() {
+    while (this->head != nullptr) {
+        Block* block = this->head;
+        this->head = block->next;
+        free(block);
+    }
+    this->head_used = 0;
+    this->last = nullptr;
+}
+
+
+
+/* Allocates the given number of bytes with the given alignment (which must be a power of two). Throws std::bad_alloc if that failed. */
+void* Arena::allocate(size_t n_bytes, size_t alignment) {
+    // Try to fit it in the current block first
+    if (this->head != nullptr) {
+        char* data = (char*) (this->head + 1);
+        uintptr_t start = align_address((uintptr_t) (data + this->head_used), alignment);
+        if (start + n_bytes <= (uintptr_t) (data + this->head->size)) {
+            this->n_used += n_bytes;
+            this->n_high_water = std::max(this->n_high_water, this->n_used);
+            this->head_used = (size_t) (start + n_bytes - (uintptr_t) data);
+            this->last = (void*) start;
+            return (void*) start;
+        }
+    }
+
+    // Otherwise, start a new block and try again (which will fit)
+    this->add_block(n_bytes, alignment);
+    return this->allocate(n_bytes, alignment);
+}
+
+/* Resizes the given allocation of old_n_bytes to new_n_bytes. It is grown in-place if it was the last allocation, and copied to a new allocation otherwise. */
+void* Arena::reallocate(void* block, size_t old_n_bytes, size_t new_n_bytes, size_t alignment) {
+    if (block == nullptr) { return this->allocate(new_n_bytes, alignment); }
+
+    // If it's the last allocation and it still fits in the block, simply move the end
+    if (block == this->last) {
+        char* data = (char*) (this->head + 1);
+        size_t offset = (size_t) ((char*) block - data);
+        if (offset + new_n_bytes <= this->head->size) {
+            this->n_used = this->n_used - old_n_bytes + new_n_bytes;
+            this->n_high_water = std::max(this->n_high_water, this->n_used);
+            this->head_used = offset + new_n_bytes;
+            return block;
+        }
+    }
+
+    // Otherwise, copy it to a new allocation
+    void* result = this->allocate(new_n_bytes, alignment);
+    memcpy(result, block, std::min(old_n_bytes, new_n_bytes));
+    this->n_used -= old_n_bytes;
+    return result;
+}
+
+/* Frees the given allocation of n_bytes. The memory is only reused before the next reset if it was the last allocation. */
+void Arena::deallocate(void* block, size_t n_bytes) {
+    if (block == nullptr) { return; }
+
+    // Give the memory back to the block if it was the last thing we allocated
+    if (block == this->last) {
+        this->head_used = (size_t) ((char*) block - (char*) (this->head + 1));
+        this->last = nullptr;
+    }
+    this->n_used -= n_bytes;
+}
+
+
+
+/* Destroys all objects created in the arena and frees all its memory at once, which invalidates all pointers to it. The memory is kept for the next round; if it spanned multiple blocks, they're merged into one large block. */
+void Arena::reset() {
+    this->finalize();
+
+    // If we needed more than one block, replace them with one that would've fit everything, so the next round doesn't have to add blocks anymore
+    if (this->head != nullptr && this->head->next != nullptr) {
+        size_t total = this->capacity();
+        this->free_blocks();
+        this->add_block(total, alignof(Block));
+    }
+
+    // Start at the beginning of the block again
+    this->head_used = 0;
+    this->last = nullptr;
+    this->n_used = 0;
+}
+
+/* Returns the total number of bytes in the blocks of this arena. */
+size_t Arena::capacity() const {
+    size_t result = 0;
+    for (Block* block = this->head; block != nullptr; block = block->next) {
+        result += block->size;
+    }
+    return result;
+}
+
+
+
+/* Swap operator for the Arena class. */
+void Tools::swap(Arena& a1, Arena& a2) {
+    using std::swap;
+
+    // Simply swap all fields
+    swap(a1.head, a2.head);
+    swap(a1.head_used, a2.head_used);
+    swap(a1.last, a2.last);
+    swap(a1.finalizers, a2.finalizers);
+    swap(a1.min_block_size, a2.min_block_size);
+    swap(a1.n_used, a2.n_used);
+    swap(a1.n_high_water, a2.n_high_water);
+}
@@ -0,0 +1,168 @@
+/* ARENA.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 10:48:21
+ * Last edited:
+ *   16/10/2026, 10:48:21
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the Arena class, which hands out memory by simply bumping a
+ *   pointer through large blocks, and which frees everything at once
+ *   when it's reset. This makes it ideal for data that lives exactly as
+ *   long as a scene or a frame. Also contains the ArenaAllocator, which
+ *   lets a Tools::Array allocate its elements in an Arena.
+**/
+
+#ifndef TOOLS_ARENA_HPP
+#define TOOLS_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Tools {
+    /* The Arena class, which allocates memory by bumping a pointer and frees it all at once. Note that it isn't thread-safe. */
+    class Arena {
+    private:
+        /* The Block struct, which is the header of a single block of memory. The memory itself follows directly after it. */
+        struct alignas(16) Block {
+            /* The previous block in the arena, or nullptr if this is the first one. */
+            Block* next;
+            /* The number of bytes in this block (excluding the header). */
+            size_t size;
+        };
+
+        /* The Finalizer struct, which remembers how to destroy an object that was created in the arena. */
+        struct Finalizer {
+            /* The finalizer that was registered before this one, or nullptr if this is the first one. */
+            Finalizer* next;
+            /* The function that destroys the object. */
+            void (*destroy)(void*);
+            /* The object to destroy. */
+            void* object;
+        };
+
+        /* The block we currently allocate from, which links to all older blocks. */
+        Block* head;
+        /* The number of bytes already used in the head block. */
+        size_t head_used;
+        /* The last allocation, which can still be grown or freed in-place. */
+        void* last;
+        /* The objects that have to be destroyed when the arena is reset, latest first. */
+        Finalizer* finalizers;
+
+        /* The minimum size of new blocks. */
+        size_t min_block_size;
+        /* The number of bytes handed out since the last reset. */
+        size_t n_used;
+        /* The largest number of bytes ever handed out between two resets. */
+        size_t n_high_water;
+
+        /* Adds a new block that can hold at least the given number of bytes with the given alignment. */
+        void add_block(size_t n_bytes, size_t alignment);
+        /* Runs all finalizers, latest first. */
+        void finalize();
+        /* Frees all blocks. */
+        void free_blocks();
+
+    public:
+        /* The default minimum size of the blocks in an arena. */
+        static const constexpr size_t default_block_size = 64 * 1024;
+        /* The default alignment of allocations, which is enough for any of the vector types we use. */
+        static const constexpr size_t default_alignment = 16;
+
+        /* Constructor for the Arena class, which takes the minimum size of the blocks it allocates. No memory is allocated until the first allocation. */
+        Arena(size_t min_block_size = Arena::default_block_size);
+        /* Copy constructor for the Arena class, which is deleted as the memory can't be shared. */
+        Arena(const Arena& other) = delete;
+        /* Move constructor for the Arena class. */
+        Arena(Arena&& other);
+        /* Destructor for the Arena class, which destroys all objects created in it and frees all memory. */
+        ~Arena();
+
+        /* Allocates the given number of bytes with the given alignment (which must be a power of two). Throws std::bad_alloc if that failed. */
+        void* allocate(size_t n_bytes, size_t alignment = Arena::default_alignment);
+        /* Resizes the given allocation of old_n_bytes to new_n_bytes. It is grown in-place if it was the last allocation, and copied to a new allocation otherwise. */
+        void* reallocate(void* block, size_t old_n_bytes, size_t new_n_bytes, size_t alignment = Arena::default_alignment);
+        /* Frees the given allocation of n_bytes. The memory is only reused before the next reset if it was the last allocation. */
+        void deallocate(void* block, size_t n_bytes);
+        /* Creates a new object of type T in the arena using the given constructor arguments. If it has a non-trivial destructor, it is destroyed when the arena is reset. */
+        template <class T, class... Args>
+        T* create(Args&&... args);
+
+        /* Destroys all objects created in the arena and frees all its memory at once, which invalidates all pointers to it. The memory is kept for the next round; if it spanned multiple blocks, they're merged into one large block. */
+        void reset();
+
+        /* Returns the number of bytes handed out since the last reset. */
+        inline size_t used() const { return this->n_used; }
+        /* Returns the largest number of bytes ever handed out between two resets. */
+        inline size_t high_water_mark() const { return this->n_high_water; }
+        /* Returns the total number of bytes in the blocks of this arena. */
+        size_t capacity() const;
+
+        /* Copy assignment operator for the Arena class, which is deleted. */
+        Arena& operator=(const Arena& other) = delete;
+        /* Move assignment operator for the Arena class. */
+        inline Arena& operator=(Arena&& other) { if (this != &other) { swap(*this, other); } return *this; }
+        /* Swap operator for the Arena class. */
+        friend void swap(Arena& a1, Arena& a2);
+
+    };
+
+    /* Swap operator for the Arena class. */
+    void swap(Arena& a1, Arena& a2);
+
+
+
+    /* The ArenaAllocator class, which lets a Tools::Array allocate its elements in an Arena (e.g., Tools::Array<T, Tools::ArenaAllocator>). Note that the Array should not outlive the next reset of the arena. */
+    class ArenaAllocator {
+    private:
+        /* The arena we allocate from. */
+        Arena* arena;
+
+    public:
+        /* Constructor for the ArenaAllocator class, which takes the arena to allocate from. */
+        ArenaAllocator(Arena& arena): arena(&arena) {}
+
+        /* Allocates a new block of the given number of bytes in the arena. */
+        inline void* allocate(size_t n_bytes) { return this->arena->allocate(n_bytes); }
+        /* Resizes the given block of old_n_bytes to new_n_bytes, in-place if it was the last thing allocated in the arena. */
+        inline void* reallocate(void* block, size_t old_n_bytes, size_t new_n_bytes) { return this->arena->reallocate(block, old_n_bytes, new_n_bytes); }
+        /* Deallocates the given block of n_bytes, which only reuses the memory if it was the last thing allocated in the arena. */
+        inline void deallocate(void* block, size_t n_bytes) { this->arena->deallocate(block, n_bytes); }
+    };
+
+
+
+
+
+    /***** TEMPLATE IMPLEMENTATIONS *****/
+    /* Creates a new object of type T in the arena using the given constructor arguments. If it has a non-trivial destructor, it is destroyed when the arena is reset. */
+    template <class T, class... Args>
+    T* Arena::create(Args&&... args) {
+        // Allocate the finalizer first, so we never construct an object we can't destroy
+        Finalizer* finalizer = nullptr;
+        if constexpr (!std::is_trivially_destructible<T>::value) {
+            finalizer = (Finalizer*) this->allocate(sizeof(Finalizer), alignof(Finalizer));
+        }
+
+        // Construct the object itself
+        T* result = new(this->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+        // Register it for destruction if needed
+        if constexpr (!std::is_trivially_destructible<T>::value) {
+            finalizer->next = this->finalizers;
+            finalizer->destroy = [](void* object) { ((T*) object)->~T(); };
+            finalizer->object = (void*) result;
+            this->finalizers = finalizer;
+        }
+        return result;
+    }
+}
+
+#endif
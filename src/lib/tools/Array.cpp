@@ -4,7 +4,7 @@
  * Created:
  *   12/22/2020, 4:59:25 PM
  * Last edited:
- *   1/14/2021, 12:36:20 PM
+ *   16/10/2026, 00:07:58
  * Auto updated?
  *   Yes
  *
@@ -26,24 +26,33 @@ using namespace Tools;
 
 /***** ARRAY CLASS ****/
 /* Default constructor for the Array class, which initializes it to zero. */
-template<class T, bool D, bool C, bool M> Array<T, D, C, M>::Array() :
+template<class T, class A, bool D, bool C, bool M> Array<T, A, D, C, M>::Array() :
     elements(nullptr),
     length(0),
-    max_length(0)
+    max_length(0),
+    allocator()
 {}
 
-/* Constructor for the Array class, which takes an initial amount to size to. Each element will thus be uninitialized. */
-template<class T, bool D, bool C, bool M> Array<T, D, C, M>::Array(size_t initial_size) :
+/* Constructor for the Array class, which initializes it to zero but takes the allocator to allocate the elements with. */
+template<class T, class A, bool D, bool C, bool M> Array<T, A, D, C, M>::Array(const A& allocator) :
+    elements(nullptr),
+    length(0),
+    max_length(0),
+    allocator(allocator)
+{}
+
+/* Constructor for the Array class, which takes an initial amount to size to and optionally the allocator to use. Each element will thus be uninitialized. */
+template<class T, class A, bool D, bool C, bool M> Array<T, A, D, C, M>::Array(size_t initial_size, const A& allocator) :
     length(0),
-    max_length(initial_size)
+    max_length(initial_size),
+    allocator(allocator)
 {
     // Allocate enough space
-    this->elements = (T*) malloc(sizeof(T) * this->max_length);
-    if (this->elements == nullptr) { throw std::bad_alloc(); }
+    this->elements = this->allocate(this->max_length);
 }
 
 /* Constructor for the Array class, which takes an initializer_list to initialize the Array with. Makes use of the element's copy constructor. */
-template<class T, bool D, bool C, bool M> Array<T, D, C, M>::Array(const std::initializer_list<T>& list) :
+template<class T, class A, bool D, bool C, bool M> Array<T, A, D, C, M>::Array(const std::initializer_list<T>& list) :
     Array(list.size())
 {
     // Overwrite the length to the list's size
@@ -59,60 +68,75 @@ template<class T, bool D, bool C, bool M> Array<T, D, C, M>::Array(const std::in
 }
 
 /* Constructor for the Array class, which takes a raw C-style vector to copy elements from and its size. Note that the Array's element type must have a copy custructor defined. */
-template<class T, bool D, bool C, bool M> Array<T, D, C, M>::Array(T* list, size_t list_size) :
+template<class T, class A, bool D, bool C, bool M> Array<T, A, D, C, M>::Array(T* list, size_t list_size) :
     Array(list_size)
 {
     // Overwrite the length to the list's size
     this->length = list_size;
 
     // Copy all the elements over
-    for (size_t i = 0; i < list_size; i++) {
-        // Use the placement new to call T's copy constructor
-        new(this->elements + i) T(list[i]);
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        if (list_size > 0) { memcpy((void*) this->elements, (const void*) list, sizeof(T) * list_size); }
+    } else {
+        for (size_t i = 0; i < list_size; i++) {
+            // Use the placement new to call T's copy constructor
+            new(this->elements + i) T(list[i]);
+        }
     }
 }
 
 /* Constructor for the Array class, which takes a C++-style vector. Note that the Array's element type must have a copy custructor defined. */
-template<class T, bool D, bool C, bool M> Array<T, D, C, M>::Array(const std::vector<T>& list) :
+template<class T, class A, bool D, bool C, bool M> Array<T, A, D, C, M>::Array(const std::vector<T>& list) :
     Array(list.size())
 {
     // Overwrite the length to the list's size
     this->length = list.size();
 
     // Copy all the elements over
-    for (size_t i = 0; i < list.size(); i++) {
-        // Use the placement new to call T's copy constructor
-        new(this->elements + i) T(list[i]);
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        if (list.size() > 0) { memcpy((void*) this->elements, (const void*) list.data(), sizeof(T) * list.size()); }
+    } else {
+        for (size_t i = 0; i < list.size(); i++) {
+            // Use the placement new to call T's copy constructor
+            new(this->elements + i) T(list[i]);
+        }
     }
 }
 
 /* Copy constructor for the Array class. Note that this only works if the Array's element has a copy constructor defined. */
-template<class T, bool D, bool C, bool M> Array<T, D, C, M>::Array(const Array& other) :
+template<class T, class A, bool D, bool C, bool M> Array<T, A, D, C, M>::Array(const Array& other) :
     length(other.length),
-    max_length(other.max_length)
+    max_length(other.max_length),
+    allocator(other.allocator)
 {
     // Allocate a new list of T's
-    this->elements = (T*) malloc(sizeof(T) * other.max_length);
-    if (this->elements == nullptr) { throw std::bad_alloc(); }
+    this->elements = this->allocate(other.max_length);
 
     // Copy each element over
-    for (size_t i = 0; i < other.length; i++) {
-        new(this->elements + i) T(other.elements[i]);
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        if (other.length > 0) { memcpy((void*) this->elements, (const void*) other.elements, sizeof(T) * other.length); }
+    } else {
+        for (size_t i = 0; i < other.length; i++) {
+            new(this->elements + i) T(other.elements[i]);
+        }
     }
 }
 
 /* Move constructor for the Array class. */
-template<class T, bool D, bool C, bool M> Array<T, D, C, M>::Array(Array&& other) :
+template<class T, class A, bool D, bool C, bool M> Array<T, A, D, C, M>::Array(Array&& other) :
     elements(other.elements),
     length(other.length),
-    max_length(other.max_length)
+    max_length(other.max_length),
+    allocator(std::move(other.allocator))
 {
     // Tell the other one that it's over
     other.elements = nullptr;
+    other.length = 0;
+    other.max_length = 0;
 }
 
 /* Destructor for the Array class. */
-template<class T, bool D, bool C, bool M> Array<T, D, C, M>::~Array() {
+template<class T, class A, bool D, bool C, bool M> Array<T, A, D, C, M>::~Array() {
     // Only deallocate everything if not a nullptr
     if (this->elements != nullptr) {
         // First deallocate all elements if the element needs that
@@ -122,22 +146,58 @@ template<class T, bool D, bool C, bool M> Array<T, D, C, M>::~Array() {
             }
         }
         // Now, free the list itself
-        free(this->elements);
+        this->allocator.deallocate((void*) this->elements, sizeof(T) * this->max_length);
+    }
+}
+
+
+
+/* Allocates space for the given number of elements (without initializing them) using our allocator. Throws std::bad_alloc if that failed. */
+template<class T, class A, bool D, bool C, bool M> T* Array<T, A, D, C, M>::allocate(size_t n_elements) {
+    // Some allocators return nullptr for empty allocations, so don't bother them with it
+    if (n_elements == 0) { return nullptr; }
+
+    T* result = (T*) this->allocator.allocate(sizeof(T) * n_elements);
+    if (result == nullptr) { throw std::bad_alloc(); }
+    return result;
+}
+
+/* Moves the given number of elements from the source to the (uninitialized) destination, leaving the source uninitialized. The two may overlap as long as the destination comes first. Trivially copyable types are simply copied, other types are moved if they can be without throwing and copied bytewise otherwise. */
+template<class T, class A, bool D, bool C, bool M> void Array<T, A, D, C, M>::relocate(T* dest, T* source, size_t n_elements) {
+    if (n_elements == 0) { return; }
+
+    if constexpr (std::is_trivially_copyable<T>::value || !std::is_nothrow_move_constructible<T>::value) {
+        // Either we're allowed to or we have no other choice (which the Array has always done for such types anyway)
+        memmove((void*) dest, (const void*) source, sizeof(T) * n_elements);
+    } else {
+        for (size_t i = 0; i < n_elements; i++) {
+            new(dest + i) T(std::move(source[i]));
+            source[i].~T();
+        }
     }
 }
 
+/* Makes sure the internal array can hold at least the given number of elements. If it has to grow, it at least doubles in size so that appending is amortised constant time. */
+template<class T, class A, bool D, bool C, bool M> void Array<T, A, D, C, M>::grow(size_t min_size) {
+    if (min_size <= this->max_length) { return; }
+    this->reserve(std::max(min_size, std::max(this->max_length * 2, (size_t) 16)));
+}
+
 
 
 /* Adds a whole array worth of new elements to the array, copying them. Note that this requires the elements to be copy constructible. */
-template <class T, bool D, bool C, bool M> Array<T>& Array<T, D, C, M>::operator+=(const Array<T>& elems) {
+template <class T, class A, bool D, bool C, bool M> Array<T, A>& Array<T, A, D, C, M>::operator+=(const Array<T, A>& elems) {
     // Make sure that the array has enough size
-    if (this->length + elems.length > this->max_length) {
-        this->reserve(this->length + elems.length);
-    }
+    this->grow(this->length + elems.length);
 
     // Add the new elements to the end of the array
-    for (size_t i = 0; i < elems.size(); i++) {
-        new(this->elements + this->length++) T(elems.elements[i]);
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        if (elems.length > 0) { memcpy((void*) (this->elements + this->length), (const void*) elems.elements, sizeof(T) * elems.length); }
+        this->length += elems.length;
+    } else {
+        for (size_t i = 0; i < elems.size(); i++) {
+            new(this->elements + this->length++) T(elems.elements[i]);
+        }
     }
 
     // When done, return ourselves
@@ -145,20 +205,22 @@ template <class T, bool D, bool C, bool M> Array<T>& Array<T, D, C, M>::operator
 }
 
 /* Adds a whole array worth of new elements to the array, leaving the original array in an unused state (moving it). Note that this does not require the elements to be move constructible. */
-template <class T, bool D, bool C, bool M> Array<T>& Array<T, D, C, M>::operator+=(Array<T>&& elems) {
+template <class T, class A, bool D, bool C, bool M> Array<T, A>& Array<T, A, D, C, M>::operator+=(Array<T, A>&& elems) {
     // For this one, early quit if the other's size is 0
     if (elems.length == 0) { return *this; }
 
-    // Otherwise, resize ourselves to the correct size
-    this->reserve(this->length + elems.length);
+    // Otherwise, make sure we have enough space
+    this->grow(this->length + elems.length);
 
-    // Copy the elements over quick 'n' dirty
-    memmove(this->elements + this->length, elems.elements, elems.length * sizeof(T));
+    // Move the elements over
+    relocate(this->elements + this->length, elems.elements, elems.length);
     this->length += elems.length;
 
-    // Already deallocate the other's list without destroying the elements, to prevent deallocation
-    free(elems.elements);
+    // Already deallocate the other's list without destroying the elements, since they are ours now
+    elems.allocator.deallocate((void*) elems.elements, sizeof(T) * elems.max_length);
     elems.elements = nullptr;
+    elems.length = 0;
+    elems.max_length = 0;
 
     // When done, return ourselves
     return *this;
@@ -166,30 +228,41 @@ template <class T, bool D, bool C, bool M> Array<T>& Array<T, D, C, M>::operator
 
 
 
-/* Adds a new element of type T to the array, copying it. Note that this requires the element to be copy constructible. */
-template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::push_back(const T& elem) {
-    // Make sure that the array has enough size
-    if (this->length >= this->max_length) {
-        this->reserve(this->length + 1);
+/* Adds a new element of type T to the array, constructing it in-place with the given arguments. Returns a reference to the new element. */
+template<class T, class A, bool D, bool C, bool M> template <class... Args> T& Array<T, A, D, C, M>::emplace_back(Args&&... args) {
+    // If there is space, we can simply construct it at the end
+    if (this->length < this->max_length) {
+        new(this->elements + this->length) T(std::forward<Args>(args)...);
+        return this->elements[this->length++];
     }
 
-    // Add the element at the end of the array
-    new(this->elements + this->length++) T(elem);
-}
+    // Otherwise, we have to grow. Note that the arguments may refer to our own elements, so we have to construct the new one before the old array is released
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        // Construct it on the stack, which is cheap for these types and lets us realloc() the array in-place
+        T elem(std::forward<Args>(args)...);
+        this->grow(this->length + 1);
+        memcpy((void*) (this->elements + this->length), (const void*) &elem, sizeof(T));
+    } else {
+        // Construct it in the new array, then move the old elements in front of it
+        size_t new_size = std::max(this->length + 1, std::max(this->max_length * 2, (size_t) 16));
+        T* new_elements = this->allocate(new_size);
+        try {
+            new(new_elements + this->length) T(std::forward<Args>(args)...);
+        } catch (...) {
+            this->allocator.deallocate((void*) new_elements, sizeof(T) * new_size);
+            throw;
+        }
+        relocate(new_elements, this->elements, this->length);
+        if (this->elements != nullptr) { this->allocator.deallocate((void*) this->elements, sizeof(T) * this->max_length); }
 
-/* Adds a new element of type T to the array, leaving it in an usused state (moving it). Note that this requires the element to be move constructible. */
-template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::push_back(T&& elem) {
-    // Make sure that the array has enough size
-    if (this->length >= this->max_length) {
-        this->reserve(this->length + 1);
+        this->elements = new_elements;
+        this->max_length = new_size;
     }
-
-    // Add the element at the end of the array
-    new(this->elements + this->length++) T(std::move(elem));
+    return this->elements[this->length++];
 }
 
 /* Removes the last element from the array. */
-template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::pop_back() {
+template<class T, class A, bool D, bool C, bool M> void Array<T, A, D, C, M>::pop_back() {
     // Check if there are any elements
     if (this->length == 0) { return; }
 
@@ -205,7 +278,7 @@ template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::pop_back() {
 
 
 /* Erases an element with the given index from the array. Does nothing if the index is out-of-bounds. */
-template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::erase(size_t index) {
+template<class T, class A, bool D, bool C, bool M> void Array<T, A, D, C, M>::erase(size_t index) {
     // Check if in bounds
     if (index >= this->length) { return; }
 
@@ -215,14 +288,14 @@ template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::erase(size_t i
     }
 
     // Move all elements following it one back
-    memmove(this->elements + index, this->elements + index + 1, sizeof(T) * (this->length - 1 - index));
+    relocate(this->elements + index, this->elements + index + 1, this->length - 1 - index);
 
     // Decrease the length
     --this->length;
 }
 
 /* Erases multiple elements in the given (inclusive) range from the array. Does nothing if the any index is out-of-bounds or if the start_index is larger than the stop_index. */
-template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::erase(size_t start_index, size_t stop_index) {
+template<class T, class A, bool D, bool C, bool M> void Array<T, A, D, C, M>::erase(size_t start_index, size_t stop_index) {
     // Check if in bounds
     if (start_index >= this->length || stop_index >= this->length || start_index > stop_index) { return; }
 
@@ -234,21 +307,21 @@ template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::erase(size_t s
     }
 
     // Move all elements following it back
-    memmove(this->elements + start_index, this->elements + stop_index + 1, sizeof(T) * (this->length - 1 - stop_index));
+    relocate(this->elements + start_index, this->elements + stop_index + 1, this->length - 1 - stop_index);
 
     // Decrease the length
     this->length -= 1 + stop_index - start_index;
 }
 
 /* Erases everything from the array, even removing the internal allocated array. */
-template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::clear() {
+template<class T, class A, bool D, bool C, bool M> void Array<T, A, D, C, M>::clear() {
     // Delete everything currently in the array if needed
     if (std::is_destructible<T>::value) {
         for (size_t i = 0; i < this->length; i++) {
             this->elements[i].~T();
         }
     }
-    free(this->elements);
+    if (this->elements != nullptr) { this->allocator.deallocate((void*) this->elements, sizeof(T) * this->max_length); }
 
     // Set the new values
     this->elements = nullptr;
@@ -259,37 +332,44 @@ template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::clear() {
 
 
 /* Re-allocates the internal array to the given size. Any leftover elements will be left unitialized, and elements that won't fit will be deallocated. */
-template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::reserve(size_t new_size) {
+template<class T, class A, bool D, bool C, bool M> void Array<T, A, D, C, M>::reserve(size_t new_size) {
     // Do only something if the size is different from what it is now
     if (new_size == this->max_length) {
         // Do nothing
         return;
     }
 
-    // Start by allocating space for a new array
-    T* new_elements = (T*) malloc(sizeof(T) * new_size);
-    if (new_elements == nullptr) { throw std::bad_alloc(); }
-
-    // Determine how many elements to move over; either new_size or the length of the array, whichever is smaller
-    size_t n_to_copy = std::min(new_size, this->length);
-    memmove(new_elements, this->elements, sizeof(T) * n_to_copy);
-    
-    // Deallocate any elements that are leftover (if needed), then delete the old array
+    // Deallocate any elements that won't fit anymore (if needed)
+    size_t n_to_keep = std::min(new_size, this->length);
     if (std::is_destructible<T>::value) {
-        for (size_t i = new_size; i < this->length; i++) {
+        for (size_t i = n_to_keep; i < this->length; i++) {
             this->elements[i].~T();
         }
     }
-    free(this->elements);
+
+    // Move the elements to an array of the new size
+    T* new_elements;
+    if (new_size == 0) {
+        new_elements = nullptr;
+        if (this->elements != nullptr) { this->allocator.deallocate((void*) this->elements, sizeof(T) * this->max_length); }
+    } else if (std::is_trivially_copyable<T>::value && this->elements != nullptr) {
+        // We can let the allocator do it, which may not even have to copy anything
+        new_elements = (T*) this->allocator.reallocate((void*) this->elements, sizeof(T) * this->max_length, sizeof(T) * new_size);
+        if (new_elements == nullptr) { this->length = n_to_keep; throw std::bad_alloc(); }
+    } else {
+        new_elements = this->allocate(new_size);
+        relocate(new_elements, this->elements, n_to_keep);
+        if (this->elements != nullptr) { this->allocator.deallocate((void*) this->elements, sizeof(T) * this->max_length); }
+    }
 
     // Re-populate the struct with the correct elements
     this->elements = new_elements;
-    this->length = n_to_copy;
+    this->length = n_to_keep;
     this->max_length = new_size;
 }
 
 /* Resizes the array to the given size. Any leftover elements will be initialized with their default constructor, and elements that won't fit will be deallocated. If the same size is given as the vector, can be used to initialize a whole array to default constructor. */
-template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::resize(size_t new_size) {
+template<class T, class A, bool D, bool C, bool M> void Array<T, A, D, C, M>::resize(size_t new_size) {
     // Simply reserve the required space
     this->reserve(new_size);
 
@@ -305,13 +385,13 @@ template<class T, bool D, bool C, bool M> void Array<T, D, C, M>::resize(size_t
 
 
 /* Returns a muteable reference to the element at the given index. Performs in-of-bounds checks before accessing the element. */
-template<class T, bool D, bool C, bool M> T& Array<T, D, C, M>::at(size_t index) {
+template<class T, class A, bool D, bool C, bool M> T& Array<T, A, D, C, M>::at(size_t index) {
     if (index >= this->length) { throw std::out_of_range("Index " + std::to_string(index) + " is out-of-bounds for Array with size " + std::to_string(this->length)); }
     return this->elements[index];
 }
 
 /* Returns a constant reference to the element at the given index. Performs in-of-bounds checks before accessing the element. */
-template<class T, bool D, bool C, bool M> const T& Array<T, D, C, M>::at(size_t index) const {
+template<class T, class A, bool D, bool C, bool M> const T& Array<T, A, D, C, M>::at(size_t index) const {
     if (index >= this->length) { throw std::out_of_range("Index " + std::to_string(index) + " is out-of-bounds for Array with size " + std::to_string(this->length)); }
     return this->elements[index];
 }
@@ -319,7 +399,7 @@ template<class T, bool D, bool C, bool M> const T& Array<T, D, C, M>::at(size_t
 
 
 /* Returns a muteable pointer to the internal data struct. Use this to fill the array using C-libraries, but beware that the array needs to have enough space reserved. Also note that object put here will still be deallocated by the Array using ~T(). The optional new_size parameter is used to update the size() value of the array, so it knows what is initialized and what is not. Leave it at numeric_limits<size_t>::max() to leave the array size unchanged. */
-template<class T, bool D, bool C, bool M> T* Array<T, D, C, M>::wdata(size_t new_size) {
+template<class T, class A, bool D, bool C, bool M> T* Array<T, A, D, C, M>::wdata(size_t new_size) {
     // Update the size if it's not the max already
     if (new_size != std::numeric_limits<size_t>::max()) { this->length = new_size; }
     // Return the pointer
@@ -329,7 +409,7 @@ template<class T, bool D, bool C, bool M> T* Array<T, D, C, M>::wdata(size_t new
 
 
 /* Move assignment operator for the Array class. */
-template<class T, bool D, bool C, bool M> Array<T, D, C, M>& Array<T, D, C, M>::operator=(Array<T, D, C, M>&& other) {
+template<class T, class A, bool D, bool C, bool M> Array<T, A, D, C, M>& Array<T, A, D, C, M>::operator=(Array<T, A, D, C, M>&& other) {
     if (this != &other) { swap(*this, other); }
     return *this;
 }
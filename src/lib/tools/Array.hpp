@@ -4,7 +4,7 @@
  * Created:
  *   12/22/2020, 5:00:01 PM
  * Last edited:
- *   1/14/2021, 3:11:16 PM
+ *   16/10/2026, 00:07:58
  * Auto updated?
  *   Yes
  *
@@ -18,14 +18,30 @@
 
 /***** HEADER *****/
 #include <cstddef>
+#include <cstdlib>
 #include <vector>
 #include <initializer_list>
+#include <type_traits>
+#include <utility>
 #include <limits>
 #include <cstdio>
 
 namespace Tools {
-    /* The Array class, which can be used as a container for many things. It's optimized to work for containers that rarely (but still sometimes) have to resize. */
-    template <class T, bool D = std::is_default_constructible<T>::value, bool C = std::is_copy_constructible<T>::value, bool M = std::is_move_constructible<T>::value>
+    /* The default allocator for the Array class, which simply allocates its memory on the heap. Custom allocators should implement the same three functions. */
+    class HeapAllocator {
+    public:
+        /* Allocates a new block of (at least) the given number of bytes. Returns nullptr if that failed. */
+        inline void* allocate(size_t n_bytes) { return malloc(n_bytes); }
+        /* Resizes the given block of old_n_bytes to (at least) new_n_bytes, which may move it. The contents are preserved up to the smallest of the two sizes. Returns nullptr (and leaves the old block alone) if that failed. */
+        inline void* reallocate(void* block, size_t old_n_bytes, size_t new_n_bytes) { (void) old_n_bytes; return realloc(block, new_n_bytes); }
+        /* Deallocates the given block of n_bytes. */
+        inline void deallocate(void* block, size_t n_bytes) { (void) n_bytes; free(block); }
+    };
+
+
+
+    /* The Array class, which can be used as a container for many things. It's optimized to work for containers that rarely (but still sometimes) have to resize, but appending to it is amortised constant time. */
+    template <class T, class A = HeapAllocator, bool D = std::is_default_constructible<T>::value, bool C = std::is_copy_constructible<T>::value, bool M = std::is_move_constructible<T>::value>
     class Array {
     protected:
         /* The internal data. */
@@ -34,12 +50,23 @@ namespace Tools {
         size_t length;
         /* The maximum number of elements we allocated for. */
         size_t max_length;
+        /* The allocator used to allocate the internal data. */
+        A allocator;
+
+        /* Allocates space for the given number of elements (without initializing them) using our allocator. Throws std::bad_alloc if that failed. */
+        T* allocate(size_t n_elements);
+        /* Moves the given number of elements from the source to the (uninitialized) destination, leaving the source uninitialized. The two may overlap as long as the destination comes first. Trivially copyable types are simply copied, other types are moved if they can be without throwing and copied bytewise otherwise. */
+        static void relocate(T* dest, T* source, size_t n_elements);
+        /* Makes sure the internal array can hold at least the given number of elements. If it has to grow, it at least doubles in size so that appending is amortised constant time. */
+        void grow(size_t min_size);
 
     public:
         /* Default constructor for the Array class, which initializes it to zero. */
         Array();
-        /* Constructor for the Array class, which takes an initial amount to size to. Each element will thus be uninitialized. */
-        Array(size_t initial_size);
+        /* Constructor for the Array class, which initializes it to zero but takes the allocator to allocate the elements with. */
+        explicit Array(const A& allocator);
+        /* Constructor for the Array class, which takes an initial amount to size to and optionally the allocator to use. Each element will thus be uninitialized. */
+        Array(size_t initial_size, const A& allocator = A());
         /* Constructor for the Array class, which takes an initializer_list to initialize the Array with. Makes use of the element's copy constructor. */
         Array(const std::initializer_list<T>& list);
         /* Constructor for the Array class, which takes a raw C-style vector to copy elements from and its size. Note that the Array's element type must have a copy custructor defined. */
@@ -54,18 +81,20 @@ namespace Tools {
         virtual ~Array();
 
         /* Creates a new array that is a copy of this array with the elements in the given array copied and appended to them. Note that this requires the elements to be copy constructible. */
-        inline Array<T> operator+(const Array<T>& elems) const { return Array<T>(*this).operator+=(elems); }
+        inline Array<T, A> operator+(const Array<T, A>& elems) const { return Array<T, A>(*this).operator+=(elems); }
         /* Creates a new array that is a copy of this array with the elements in the given array appended to them (moved). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T> operator+(Array<T>&& elems) const { return Array<T>(*this).operator+=(std::move(elems)); }
+        inline Array<T, A> operator+(Array<T, A>&& elems) const { return Array<T, A>(*this).operator+=(std::move(elems)); }
         /* Adds a whole array worth of new elements to the array, copying them. Note that this requires the elements to be copy constructible. */
-        Array<T>& operator+=(const Array<T>& elems);
+        Array<T, A>& operator+=(const Array<T, A>& elems);
         /* Adds a whole array worth of new elements to the array, leaving the original array in an unused state (moving it). Note that this does not require the elements to be move constructible due to clever haxx. */
-        Array<T>& operator+=(Array<T>&& elems);
+        Array<T, A>& operator+=(Array<T, A>&& elems);
 
         /* Adds a new element of type T to the array, copying it. Note that this requires the element to be copy constructible. */
-        void push_back(const T& elem);
+        inline void push_back(const T& elem) { this->emplace_back(elem); }
         /* Adds a new element of type T to the array, leaving it in an usused state (moving it). Note that this requires the element to be move constructible. */
-        void push_back(T&& elem);
+        inline void push_back(T&& elem) { this->emplace_back(std::move(elem)); }
+        /* Adds a new element of type T to the array, constructing it in-place with the given arguments. Returns a reference to the new element. */
+        template <class... Args> T& emplace_back(Args&&... args);
         /* Removes the last element from the array. */
         void pop_back();
         
@@ -100,18 +129,21 @@ namespace Tools {
         inline size_t size() const { return this->length; }
         /* Returns the number of elements this Array can store before resizing. */
         inline size_t capacity() const { return this->max_length; }
+        /* Returns the allocator this Array allocates its elements with. */
+        inline const A& get_allocator() const { return this->allocator; }
 
         /* Copy assignment operator for the Array class. Depends on Array's copy constructor, and therefore requires the Array's type to be copy constructible. */
-        inline Array<T, D, C, M>& operator=(const Array<T, D, C, M>& other) { return *this = Array<T, D, C, M>(other); }
+        inline Array<T, A, D, C, M>& operator=(const Array<T, A, D, C, M>& other) { return *this = Array<T, A, D, C, M>(other); }
         /* Move assignment operator for the Array class. */
-        Array<T, D, C, M>& operator=(Array<T, D, C, M>&& other);
+        Array<T, A, D, C, M>& operator=(Array<T, A, D, C, M>&& other);
         /* Swap operator for the Array class. */
-        friend void swap(Array<T, D, C, M>& a1, Array<T, D, C, M>& a2) {
+        friend void swap(Array<T, A, D, C, M>& a1, Array<T, A, D, C, M>& a2) {
             using std::swap;
 
             swap(a1.elements, a2.elements);
             swap(a1.length, a2.length);
             swap(a1.max_length, a2.max_length);
+            swap(a1.allocator, a2.allocator);
         }
     };
 
@@ -120,23 +152,25 @@ namespace Tools {
     /* The Array class, which can be used as a container for many things. It's optimized to work for containers that rarely (but still sometimes) have to resize.
      * This class specialization is for when the contained type is copy constructible and move constructible, but not default constructible.
      */
-    template <class T>
-    class Array<T, false, true, true>: public Array<T, true, true, true> {
+    template <class T, class A>
+    class Array<T, A, false, true, true>: public Array<T, A, true, true, true> {
     public:
         /* Default constructor for the Array class, which initializes it to zero. */
-        Array(): Array<T, true, true, true>() {}
-        /* Constructor for the Array class, which takes an initial amount to size to. Each element will thus be uninitialized. */
-        Array(size_t initial_size): Array<T, true, true, true>(initial_size) {}
+        Array(): Array<T, A, true, true, true>() {}
+        /* Constructor for the Array class, which initializes it to zero but takes the allocator to allocate the elements with. */
+        explicit Array(const A& allocator): Array<T, A, true, true, true>(allocator) {}
+        /* Constructor for the Array class, which takes an initial amount to size to and optionally the allocator to use. Each element will thus be uninitialized. */
+        Array(size_t initial_size, const A& allocator = A()): Array<T, A, true, true, true>(initial_size, allocator) {}
         /* Constructor for the Array class, which takes an initializer_list to initialize the Array with. Makes use of the element's copy constructor. */
-        Array(const std::initializer_list<T>& list): Array<T, true, true, true>(list) {}
+        Array(const std::initializer_list<T>& list): Array<T, A, true, true, true>(list) {}
         /* Constructor for the Array class, which takes a raw C-style vector to copy elements from and its size. Note that the Array's element type must have a copy custructor defined. */
-        Array(T* list, size_t list_size): Array<T, true, true, true>(list, list_size) {}
+        Array(T* list, size_t list_size): Array<T, A, true, true, true>(list, list_size) {}
         /* Constructor for the Array class, which takes a C++-style vector. Note that the Array's element type must have a copy custructor defined. */
-        Array(const std::vector<T>& list): Array<T, true, true, true>(list) {}
+        Array(const std::vector<T>& list): Array<T, A, true, true, true>(list) {}
         /* Copy constructor for the Array class. Note that this only works if the Array's element has a copy constructor defined. */
-        Array(const Array& other): Array<T, true, true>(other) {}
+        Array(const Array& other): Array<T, A, true, true, true>(other) {}
         /* Move constructor for the Array class. */
-        Array(Array&& other): Array<T, true, true, true>(std::move(other)) {};
+        Array(Array&& other): Array<T, A, true, true, true>(std::move(other)) {};
         /* Destructor for the Array class. */
         ~Array() {}
 
@@ -148,82 +182,86 @@ namespace Tools {
         /* Move assignment operator for the Array class. */
         inline Array& operator=(Array&& other) { if (this != &other) { swap(*this, other); }; return *this; }
         /* Swap operator for the Array class. */
-        friend inline void swap(Array& a1, Array& a2) { return swap((Array<T, true, true, true>&) a1, (Array<T, true, true, true>&) a2); }
+        friend inline void swap(Array& a1, Array& a2) { return swap((Array<T, A, true, true, true>&) a1, (Array<T, A, true, true, true>&) a2); }
     };
     
     /* The Array class, which can be used as a container for many things. It's optimized to work for containers that rarely (but still sometimes) have to resize.
      * This class specialization is for when the contained type is default constructible and move constructible, but not copy constructible.
      */
-    template <class T>
-    class Array<T, true, false, true>: public Array<T, true, true, true> {
+    template <class T, class A>
+    class Array<T, A, true, false, true>: public Array<T, A, true, true, true> {
     public:
         /* Default constructor for the Array class, which initializes it to zero. */
-        Array(): Array<T, true, true, true>() {}
-        /* Constructor for the Array class, which takes an initial amount to size to. Each element will thus be uninitialized. */
-        Array(size_t initial_size): Array<T, true, true, true>(initial_size) {}
+        Array(): Array<T, A, true, true, true>() {}
+        /* Constructor for the Array class, which initializes it to zero but takes the allocator to allocate the elements with. */
+        explicit Array(const A& allocator): Array<T, A, true, true, true>(allocator) {}
+        /* Constructor for the Array class, which takes an initial amount to size to and optionally the allocator to use. Each element will thus be uninitialized. */
+        Array(size_t initial_size, const A& allocator = A()): Array<T, A, true, true, true>(initial_size, allocator) {}
         /* Copy constructor for the Array class. Deleted, since the chosen type does not support copy constructing. */
         Array(const Array& other) = delete;
         /* Move constructor for the Array class. */
-        Array(Array&& other): Array<T, true, true, true>(std::move(other)) {};
+        Array(Array&& other): Array<T, A, true, true, true>(std::move(other)) {};
         /* Destructor for the Array class. */
         ~Array() {}
 
         /* Creates a new array that is a copy of this array with the elements in the given array copied and appended to them. Note that this requires the elements to be copy constructible. */
-        Array<T> operator+(const Array<T>& elems) const = delete;
+        Array<T, A> operator+(const Array<T, A>& elems) const = delete;
         /* Creates a new array that is a copy of this array with the elements in the given array appended to them (moved). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T> operator+(Array<T>&& elems) const { return Array<T, true, true, true>::operator+(std::move(elems)); }
+        inline Array<T, A> operator+(Array<T, A>&& elems) const { return Array<T, A, true, true, true>::operator+(std::move(elems)); }
         /* Adds a whole array worth of new elements to the array, copying them. Note that this requires the elements to be copy constructible. */
-        Array<T>& operator+=(const Array<T>& elems) = delete;
+        Array<T, A>& operator+=(const Array<T, A>& elems) = delete;
         /* Adds a whole array worth of new elements to the array, leaving the original array in an unused state (moving it). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T>& operator+=(Array<T>&& elems) { return Array<T, true, true, true>::operator+=(std::move(elems)); }
+        inline Array<T, A>& operator+=(Array<T, A>&& elems) { return Array<T, A, true, true, true>::operator+=(std::move(elems)); }
         
         /* Adds a new element of type T to the array, copying it. Note that this requires the element to be copy constructible. */
         void push_back(const T& elem) = delete;
         /* Adds a new element of type T to the array, leaving it in an usused state (moving it). Note that this requires the element to be move constructible. */
-        inline void push_back(T&& elem) { return Array<T, true, true, true>::push_back(std::move(elem)); }
+        inline void push_back(T&& elem) { return Array<T, A, true, true, true>::push_back(std::move(elem)); }
 
         /* Copy assignment operator for the Array class. Depends on Array's copy constructor, and therefore requires the Array's type to be copy constructible. */
         inline Array& operator=(const Array& other) = delete;
         /* Move assignment operator for the Array class. */
         inline Array& operator=(Array&& other) { if (this != &other) { swap(*this, other); }; return *this; }
         /* Swap operator for the Array class. */
-        friend inline void swap(Array& a1, Array& a2) { swap((Array<T, true, true, true>&) a1, (Array<T, true, true, true>&) a2); }
+        friend inline void swap(Array& a1, Array& a2) { swap((Array<T, A, true, true, true>&) a1, (Array<T, A, true, true, true>&) a2); }
     };
     
     /* The Array class, which can be used as a container for many things. It's optimized to work for containers that rarely (but still sometimes) have to resize.
      * This class specialization is for when the contained type is default constructible and copy constructible, but not move constructible.
      */
-    template <class T>
-    class Array<T, true, true, false>: public Array<T, true, true, true> {
+    template <class T, class A>
+    class Array<T, A, true, true, false>: public Array<T, A, true, true, true> {
     public:
         /* Default constructor for the Array class, which initializes it to zero. */
-        Array(): Array<T, true, true, true>() {}
-        /* Constructor for the Array class, which takes an initial amount to size to. Each element will thus be uninitialized. */
-        Array(size_t initial_size): Array<T, true, true, true>(initial_size) {}
+        Array(): Array<T, A, true, true, true>() {}
+        /* Constructor for the Array class, which initializes it to zero but takes the allocator to allocate the elements with. */
+        explicit Array(const A& allocator): Array<T, A, true, true, true>(allocator) {}
+        /* Constructor for the Array class, which takes an initial amount to size to and optionally the allocator to use. Each element will thus be uninitialized. */
+        Array(size_t initial_size, const A& allocator = A()): Array<T, A, true, true, true>(initial_size, allocator) {}
         /* Constructor for the Array class, which takes an initializer_list to initialize the Array with. Makes use of the element's copy constructor. */
-        Array(const std::initializer_list<T>& list): Array<T, true, true, true>(list) {}
+        Array(const std::initializer_list<T>& list): Array<T, A, true, true, true>(list) {}
         /* Constructor for the Array class, which takes a raw C-style vector to copy elements from and its size. Note that the Array's element type must have a copy custructor defined. */
-        Array(T* list, size_t list_size): Array<T, true, true, true>(list, list_size) {}
+        Array(T* list, size_t list_size): Array<T, A, true, true, true>(list, list_size) {}
         /* Constructor for the Array class, which takes a C++-style vector. Note that the Array's element type must have a copy custructor defined. */
-        Array(const std::vector<T>& list): Array<T, true, true, true>(list) {}
+        Array(const std::vector<T>& list): Array<T, A, true, true, true>(list) {}
         /* Copy constructor for the Array class. Note that this only works if the Array's element has a copy constructor defined. */
-        Array(const Array& other): Array<T, true, true>(other) {}
+        Array(const Array& other): Array<T, A, true, true, true>(other) {}
         /* Move constructor for the Array class. */
-        Array(Array&& other): Array<T, true, true, true>(std::move(other)) {};
+        Array(Array&& other): Array<T, A, true, true, true>(std::move(other)) {};
         /* Destructor for the Array class. */
         ~Array() {}
 
         /* Creates a new array that is a copy of this array with the elements in the given array copied and appended to them. Note that this requires the elements to be copy constructible. */
-        inline Array<T> operator+(const Array<T>& elems) const { return Array<T, true, true, true>::operator+(elems); }
+        inline Array<T, A> operator+(const Array<T, A>& elems) const { return Array<T, A, true, true, true>::operator+(elems); }
         /* Creates a new array that is a copy of this array with the elements in the given array appended to them (moved). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T> operator+(Array<T>&& elems) const { return Array<T, true, true, true>::operator+(std::move(elems)); }
+        inline Array<T, A> operator+(Array<T, A>&& elems) const { return Array<T, A, true, true, true>::operator+(std::move(elems)); }
         /* Adds a whole array worth of new elements to the array, copying them. Note that this requires the elements to be copy constructible. */
-        inline Array<T>& operator+=(const Array<T>& elems) { return Array<T, true, true, true>::operator+=(elems); }
+        inline Array<T, A>& operator+=(const Array<T, A>& elems) { return Array<T, A, true, true, true>::operator+=(elems); }
         /* Adds a whole array worth of new elements to the array, leaving the original array in an unused state (moving it). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T>& operator+=(Array<T>&& elems) { return Array<T, true, true, true>::operator+=(std::move(elems)); }
+        inline Array<T, A>& operator+=(Array<T, A>&& elems) { return Array<T, A, true, true, true>::operator+=(std::move(elems)); }
 
         /* Adds a new element of type T to the array, copying it. Note that this requires the element to be copy constructible. */
-        inline void push_back(const T& elem) { return Array<T, true, true, true>::push_back(elem); }
+        inline void push_back(const T& elem) { return Array<T, A, true, true, true>::push_back(elem); }
         /* Adds a new element of type T to the array, leaving it in an usused state (moving it). Note that this requires the element to be move constructible. */
         void push_back(T&& elem) = delete;
 
@@ -232,39 +270,41 @@ namespace Tools {
         /* Move assignment operator for the Array class. */
         inline Array& operator=(Array&& other) { if (this != &other) { swap(*this, other); }; return *this; }
         /* Swap operator for the Array class. */
-        friend inline void swap(Array& a1, Array& a2) { swap((Array<T, true, true, true>&) a1, (Array<T, true, true, true>&) a2); }
+        friend inline void swap(Array& a1, Array& a2) { swap((Array<T, A, true, true, true>&) a1, (Array<T, A, true, true, true>&) a2); }
     };
     
     /* The Array class, which can be used as a container for many things. It's optimized to work for containers that rarely (but still sometimes) have to resize.
      * This class specialization is for when the contained type is neither default constructible nor copy constructible, but is move constructible.
      */
-    template <class T>
-    class Array<T, false, false, true>: public Array<T, true, true, true> {
+    template <class T, class A>
+    class Array<T, A, false, false, true>: public Array<T, A, true, true, true> {
     public:
         /* Default constructor for the Array class, which initializes it to zero. */
-        Array(): Array<T, true, true, true>() {}
-        /* Constructor for the Array class, which takes an initial amount to size to. Each element will thus be uninitialized. */
-        Array(size_t initial_size): Array<T, true, true, true>(initial_size) {}
+        Array(): Array<T, A, true, true, true>() {}
+        /* Constructor for the Array class, which initializes it to zero but takes the allocator to allocate the elements with. */
+        explicit Array(const A& allocator): Array<T, A, true, true, true>(allocator) {}
+        /* Constructor for the Array class, which takes an initial amount to size to and optionally the allocator to use. Each element will thus be uninitialized. */
+        Array(size_t initial_size, const A& allocator = A()): Array<T, A, true, true, true>(initial_size, allocator) {}
         /* Copy constructor for the Array class. Note that this only works if the Array's element has a copy constructor defined. */
         Array(const Array& other) = delete;
         /* Move constructor for the Array class. */
-        Array(Array&& other): Array<T, true, true, true>(std::move(other)) {};
+        Array(Array&& other): Array<T, A, true, true, true>(std::move(other)) {};
         /* Destructor for the Array class. */
         ~Array() {}
 
         /* Creates a new array that is a copy of this array with the elements in the given array copied and appended to them. Note that this requires the elements to be copy constructible. */
-        Array<T> operator+(const Array<T>& elems) const = delete;
+        Array<T, A> operator+(const Array<T, A>& elems) const = delete;
         /* Creates a new array that is a copy of this array with the elements in the given array appended to them (moved). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T> operator+(Array<T>&& elems) const { return Array<T, true, true, true>::operator+(std::move(elems)); }
+        inline Array<T, A> operator+(Array<T, A>&& elems) const { return Array<T, A, true, true, true>::operator+(std::move(elems)); }
         /* Adds a whole array worth of new elements to the array, copying them. Note that this requires the elements to be copy constructible. */
-        Array<T>& operator+=(const Array<T>& elems) = delete;
+        Array<T, A>& operator+=(const Array<T, A>& elems) = delete;
         /* Adds a whole array worth of new elements to the array, leaving the original array in an unused state (moving it). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T>& operator+=(Array<T>&& elems) { return Array<T, true, true, true>::operator+=(std::move(elems)); }
+        inline Array<T, A>& operator+=(Array<T, A>&& elems) { return Array<T, A, true, true, true>::operator+=(std::move(elems)); }
 
         /* Adds a new element of type T to the array, copying it. Note that this requires the element to be copy constructible. */
         void push_back(const T& elem) = delete;
         /* Adds a new element of type T to the array, leaving it in an usused state (moving it). Note that this requires the element to be move constructible. */
-        inline void push_back(T&& elem) { return Array<T, true, true, true>::push_back(std::move(elem)); }
+        inline void push_back(T&& elem) { return Array<T, A, true, true, true>::push_back(std::move(elem)); }
 
         /* Resizes the array to the given size. Any leftover elements will be initialized with their default constructor, and elements that won't fit will be deallocated. */
         void resize(size_t new_size) = delete;
@@ -274,43 +314,45 @@ namespace Tools {
         /* Move assignment operator for the Array class. */
         inline Array& operator=(Array&& other) { if (this != &other) { swap(*this, other); }; return *this; }
         /* Swap operator for the Array class. */
-        friend inline void swap(Array& a1, Array& a2) { swap((Array<T, true, true, true>&) a1, (Array<T, true, true, true>&) a2); }
+        friend inline void swap(Array& a1, Array& a2) { swap((Array<T, A, true, true, true>&) a1, (Array<T, A, true, true, true>&) a2); }
     };
 
     /* The Array class, which can be used as a container for many things. It's optimized to work for containers that rarely (but still sometimes) have to resize.
      * This class specialization is for when the contained type is neither default constructible nor move constructible, but is copy constructible.
      */
-    template <class T>
-    class Array<T, false, true, false>: public Array<T, true, true, true> {
+    template <class T, class A>
+    class Array<T, A, false, true, false>: public Array<T, A, true, true, true> {
     public:
         /* Default constructor for the Array class, which initializes it to zero. */
-        Array(): Array<T, true, true, true>() {}
-        /* Constructor for the Array class, which takes an initial amount to size to. Each element will thus be uninitialized. */
-        Array(size_t initial_size): Array<T, true, true, true>(initial_size) {}
+        Array(): Array<T, A, true, true, true>() {}
+        /* Constructor for the Array class, which initializes it to zero but takes the allocator to allocate the elements with. */
+        explicit Array(const A& allocator): Array<T, A, true, true, true>(allocator) {}
+        /* Constructor for the Array class, which takes an initial amount to size to and optionally the allocator to use. Each element will thus be uninitialized. */
+        Array(size_t initial_size, const A& allocator = A()): Array<T, A, true, true, true>(initial_size, allocator) {}
         /* Constructor for the Array class, which takes an initializer_list to initialize the Array with. Makes use of the element's copy constructor. */
-        Array(const std::initializer_list<T>& list): Array<T, true, true, true>(list) {}
+        Array(const std::initializer_list<T>& list): Array<T, A, true, true, true>(list) {}
         /* Constructor for the Array class, which takes a raw C-style vector to copy elements from and its size. Note that the Array's element type must have a copy custructor defined. */
-        Array(T* list, size_t list_size): Array<T, true, true, true>(list, list_size) {}
+        Array(T* list, size_t list_size): Array<T, A, true, true, true>(list, list_size) {}
         /* Constructor for the Array class, which takes a C++-style vector. Note that the Array's element type must have a copy custructor defined. */
-        Array(const std::vector<T>& list): Array<T, true, true, true>(list) {}
+        Array(const std::vector<T>& list): Array<T, A, true, true, true>(list) {}
         /* Copy constructor for the Array class. Note that this only works if the Array's element has a copy constructor defined. */
-        Array(const Array& other): Array<T, true, true>(other) {}
+        Array(const Array& other): Array<T, A, true, true, true>(other) {}
         /* Move constructor for the Array class. */
-        Array(Array&& other): Array<T, true, true, true>(std::move(other)) {};
+        Array(Array&& other): Array<T, A, true, true, true>(std::move(other)) {};
         /* Destructor for the Array class. */
         ~Array() {}
 
         /* Creates a new array that is a copy of this array with the elements in the given array copied and appended to them. Note that this requires the elements to be copy constructible. */
-        inline Array<T> operator+(const Array<T>& elems) const { return Array<T, true, true, true>::operator+(elems); }
+        inline Array<T, A> operator+(const Array<T, A>& elems) const { return Array<T, A, true, true, true>::operator+(elems); }
         /* Creates a new array that is a copy of this array with the elements in the given array appended to them (moved). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T> operator+(Array<T>&& elems) const { return Array<T, true, true, true>::operator+(std::move(elems)); }
+        inline Array<T, A> operator+(Array<T, A>&& elems) const { return Array<T, A, true, true, true>::operator+(std::move(elems)); }
         /* Adds a whole array worth of new elements to the array, copying them. Note that this requires the elements to be copy constructible. */
-        inline Array<T>& operator+=(const Array<T>& elems) { return Array<T, true, true, true>::operator+=(elems); }
+        inline Array<T, A>& operator+=(const Array<T, A>& elems) { return Array<T, A, true, true, true>::operator+=(elems); }
         /* Adds a whole array worth of new elements to the array, leaving the original array in an unused state (moving it). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T>& operator+=(Array<T>&& elems) { return Array<T, true, true, true>::operator+=(std::move(elems)); }
+        inline Array<T, A>& operator+=(Array<T, A>&& elems) { return Array<T, A, true, true, true>::operator+=(std::move(elems)); }
 
         /* Adds a new element of type T to the array, copying it. Note that this requires the element to be copy constructible. */
-        inline void push_back(const T& elem) { return Array<T, true, true, true>::push_back(elem); }
+        inline void push_back(const T& elem) { return Array<T, A, true, true, true>::push_back(elem); }
         /* Adds a new element of type T to the array, leaving it in an usused state (moving it). Note that this requires the element to be move constructible. */
         void push_back(T&& elem) = delete;
 
@@ -322,34 +364,36 @@ namespace Tools {
         /* Move assignment operator for the Array class. */
         inline Array& operator=(Array&& other) { if (this != &other) { swap(*this, other); }; return *this; }
         /* Swap operator for the Array class. */
-        friend inline void swap(Array& a1, Array& a2) { swap((Array<T, true, true, true>&) a1, (Array<T, true, true, true>&) a2); }
+        friend inline void swap(Array& a1, Array& a2) { swap((Array<T, A, true, true, true>&) a1, (Array<T, A, true, true, true>&) a2); }
     };
 
     /* The Array class, which can be used as a container for many things. It's optimized to work for containers that rarely (but still sometimes) have to resize.
      * This class specialization is for when the contained type is neither copy constructible nor move constructible, but is default constructible.
      */
-    template <class T>
-    class Array<T, true, false, false>: public Array<T, true, true, true> {
+    template <class T, class A>
+    class Array<T, A, true, false, false>: public Array<T, A, true, true, true> {
     public:
         /* Default constructor for the Array class, which initializes it to zero. */
-        Array(): Array<T, true, true, true>() {}
-        /* Constructor for the Array class, which takes an initial amount to size to. Each element will thus be uninitialized. */
-        Array(size_t initial_size): Array<T, true, true, true>(initial_size) {}
+        Array(): Array<T, A, true, true, true>() {}
+        /* Constructor for the Array class, which initializes it to zero but takes the allocator to allocate the elements with. */
+        explicit Array(const A& allocator): Array<T, A, true, true, true>(allocator) {}
+        /* Constructor for the Array class, which takes an initial amount to size to and optionally the allocator to use. Each element will thus be uninitialized. */
+        Array(size_t initial_size, const A& allocator = A()): Array<T, A, true, true, true>(initial_size, allocator) {}
         /* Copy constructor for the Array class. Note that this only works if the Array's element has a copy constructor defined. */
         Array(const Array& other) = delete;
         /* Move constructor for the Array class. */
-        Array(Array&& other): Array<T, true, true, true>(std::move(other)) {}
+        Array(Array&& other): Array<T, A, true, true, true>(std::move(other)) {}
         /* Destructor for the Array class. */
         ~Array() {}
 
         /* Creates a new array that is a copy of this array with the elements in the given array copied and appended to them. Note that this requires the elements to be copy constructible. */
-        Array<T> operator+(const Array<T>& elems) const = delete;
+        Array<T, A> operator+(const Array<T, A>& elems) const = delete;
         /* Creates a new array that is a copy of this array with the elements in the given array appended to them (moved). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T> operator+(Array<T>&& elems) const { return Array<T, true, true, true>::operator+(std::move(elems)); }
+        inline Array<T, A> operator+(Array<T, A>&& elems) const { return Array<T, A, true, true, true>::operator+(std::move(elems)); }
         /* Adds a whole array worth of new elements to the array, copying them. Note that this requires the elements to be copy constructible. */
-        Array<T>& operator+=(const Array<T>& elems) = delete;
+        Array<T, A>& operator+=(const Array<T, A>& elems) = delete;
         /* Adds a whole array worth of new elements to the array, leaving the original array in an unused state (moving it). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T>& operator+=(Array<T>&& elems) { return Array<T, true, true, true>::operator+=(std::move(elems)); }
+        inline Array<T, A>& operator+=(Array<T, A>&& elems) { return Array<T, A, true, true, true>::operator+=(std::move(elems)); }
 
         /* Adds a new element of type T to the array, copying it. Note that this requires the element to be copy constructible. */
         void push_back(const T& elem) = delete;
@@ -361,34 +405,36 @@ namespace Tools {
         /* Move assignment operator for the Array class. */
         inline Array& operator=(Array&& other) { if (this != &other) { swap(*this, other); }; return *this; }
         /* Swap operator for the Array class. */
-        friend inline void swap(Array& a1, Array& a2) { swap((Array<T, true, true, true>&) a1, (Array<T, true, true, true>&) a2); }
+        friend inline void swap(Array& a1, Array& a2) { swap((Array<T, A, true, true, true>&) a1, (Array<T, A, true, true, true>&) a2); }
     };
 
     /* The Array class, which can be used as a container for many things. It's optimized to work for containers that rarely (but still sometimes) have to resize.
      * This class specialization is for when the contained type is neither default constructible, copy constructible nor move constructibl.
      */
-    template <class T>
-    class Array<T, false, false, false>: public Array<T, true, true, true> {
+    template <class T, class A>
+    class Array<T, A, false, false, false>: public Array<T, A, true, true, true> {
     public:
         /* Default constructor for the Array class, which initializes it to zero. */
-        Array(): Array<T, true, true, true>() {}
-        /* Constructor for the Array class, which takes an initial amount to size to. Each element will thus be uninitialized. */
-        Array(size_t initial_size): Array<T, true, true, true>(initial_size) {}
+        Array(): Array<T, A, true, true, true>() {}
+        /* Constructor for the Array class, which initializes it to zero but takes the allocator to allocate the elements with. */
+        explicit Array(const A& allocator): Array<T, A, true, true, true>(allocator) {}
+        /* Constructor for the Array class, which takes an initial amount to size to and optionally the allocator to use. Each element will thus be uninitialized. */
+        Array(size_t initial_size, const A& allocator = A()): Array<T, A, true, true, true>(initial_size, allocator) {}
         /* Copy constructor for the Array class. Note that this only works if the Array's element has a copy constructor defined. */
         Array(const Array& other) = delete;
         /* Move constructor for the Array class. */
-        Array(Array&& other): Array<T, true, true, true>(std::move(other)) {}
+        Array(Array&& other): Array<T, A, true, true, true>(std::move(other)) {}
         /* Destructor for the Array class. */
         ~Array() {}
 
         /* Creates a new array that is a copy of this array with the elements in the given array copied and appended to them. Note that this requires the elements to be copy constructible. */
-        Array<T> operator+(const Array<T>& elems) const = delete;
+        Array<T, A> operator+(const Array<T, A>& elems) const = delete;
         /* Creates a new array that is a copy of this array with the elements in the given array appended to them (moved). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T> operator+(Array<T>&& elems) const { return Array<T, true, true, true>::operator+(std::move(elems)); }
+        inline Array<T, A> operator+(Array<T, A>&& elems) const { return Array<T, A, true, true, true>::operator+(std::move(elems)); }
         /* Adds a whole array worth of new elements to the array, copying them. Note that this requires the elements to be copy constructible. */
-        Array<T>& operator+=(const Array<T>& elems) = delete;
+        Array<T, A>& operator+=(const Array<T, A>& elems) = delete;
         /* Adds a whole array worth of new elements to the array, leaving the original array in an unused state (moving it). Note that this does not require the elements to be move constructible due to clever haxx. */
-        inline Array<T>& operator+=(Array<T>&& elems) { return Array<T, true, true, true>::operator+=(std::move(elems)); }
+        inline Array<T, A>& operator+=(Array<T, A>&& elems) { return Array<T, A, true, true, true>::operator+=(std::move(elems)); }
 
         /* Adds a new element of type T to the array, copying it. Note that this requires the element to be copy constructible. */
         void push_back(const T& elem) = delete;
@@ -403,7 +449,7 @@ namespace Tools {
         /* Move assignment operator for the Array class. */
         inline Array& operator=(Array&& other) { if (this != &other) { swap(*this, other); }; return *this; }
         /* Swap operator for the Array class. */
-        friend inline void swap(Array& a1, Array& a2) { swap((Array<T, true, true, true>&) a1, (Array<T, true, true, true>&) a2); }
+        friend inline void swap(Array& a1, Array& a2) { swap((Array<T, A, true, true, true>&) a1, (Array<T, A, true, true, true>&) a2); }
     };
 }
 
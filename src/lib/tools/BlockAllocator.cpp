@@ -0,0 +1,271 @@
+/* BLOCK ALLOCATOR.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 18:02:15
+ * Last edited:
+ *   16/10/2026, 18:02:15
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the BlockAllocator class, which hands out ranges of some
+ *   externally owned memory (like a VkDeviceMemory) using a two-level
+ *   segregated fit (TLSF) scheme. Both allocating and freeing take
+ *   constant time, no matter how many ranges are handed out.
+**/
+
+#include <algorithm>
+
+#include "BlockAllocator.hpp"
+
+using namespace std;
+using namespace Tools;
+
+
+/***** HELPER FUNCTIONS *****/
+/* Returns the index of the most significant bit set in the given (non-zero) value. */
+static inline uint32_t msb(uint64_t value) {
+    return 63 - (uint32_t) __builtin_clzll(value);
+}
+
+/* Returns the index of the least significant bit set in the given (non-zero) value. */
+static inline uint32_t lsb(uint64_t value) {
+    return (uint32_t) __builtin_ctzll(value);
+}
+
+/* @brief Computes the size class that the given size belongs to. Sizes below sl_count get a class each; above that, every power of two is split into sl_count classes.
+ * @param size The size to compute the class of.
+ * @param fl Will be set to the first-level class.
+ * @param sl Will be set to the second-level class.
+ */
+static inline void size_class(uint64_t size, uint32_t& fl, uint32_t& sl) {
+    if (size < BlockAllocator::sl_count) {
+        fl = 0;
+        sl = (uint32_t) size;
+    } else {
+        uint32_t m = msb(size);
+        fl = m - BlockAllocator::sl_log2 + 1;
+        sl = (uint32_t) (size >> (m - BlockAllocator::sl_log2)) ^ BlockAllocator::sl_count;
+    }
+}
+
+/* Returns the given offset rounded up to the given alignment, which must be a power of two. */
+static inline uint64_t align_offset(uint64_t offset, uint64_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+
+
+
+
+/***** BLOCKALLOCATOR CLASS *****/
+/* Constructor for the BlockAllocator class, which takes the size (in bytes) of the memory to manage. */
+BlockAllocator::BlockAllocator(uint64_t capacity) :
+    n_capacity(capacity),
+    n_high_water(0)
+{
+    this->reset();
+}
+
+
+
+/* Returns a node that doesn't describe a range yet. */
+BlockAllocator::Range BlockAllocator::new_node() {
+    if (!this->unused_nodes.empty()) {
+        Range result = this->unused_nodes.back();
+        this->unused_nodes.pop_back();
+        return result;
+    }
+    this->nodes.push_back(Node{});
+    return (Range) (this->nodes.size() - 1);
+}
+
+/* Adds the given free node to the free list of its size class. */
+void BlockAllocator::insert_free(Range node) {
+    uint32_t fl, sl;
+    size_class(this->nodes[node].size, fl, sl);
+
+    // Push it at the front of the list
+    Range head = this->heads[fl][sl];
+    this->nodes[node].free = true;
+    this->nodes[node].prev_free = NullRange;
+    this->nodes[node].next_free = head;
+    if (head != NullRange) { this->nodes[head].prev_free = node; }
+    this->heads[fl][sl] = node;
+
+    // Mark the class as non-empty
+    this->fl_bitmap |= (uint64_t) 1 << fl;
+    this->sl_bitmaps[fl] |= (uint32_t) 1 << sl;
+    ++this->n_free_ranges;
+}
+
+/* Removes the given free node from the free list of its size class. */
+void BlockAllocator::remove_free(Range node) {
+    uint32_t fl, sl;
+    size_class(this->nodes[node].size, fl, sl);
+
+    // Unlink it
+    Node& n = this->nodes[node];
+    if (n.prev_free != NullRange) { this->nodes[n.prev_free].next_free = n.next_free; }
+    else { this->heads[fl][sl] = n.next_free; }
+    if (n.next_free != NullRange) { this->nodes[n.next_free].prev_free = n.prev_free; }
+    n.free = false;
+
+    // Mark the class as empty if it was the last one
+    if (this->heads[fl][sl] == NullRange) {
+        this->sl_bitmaps[fl] &= ~((uint32_t) 1 << sl);
+        if (this->sl_bitmaps[fl] == 0) { this->fl_bitmap &= ~((uint64_t) 1 << fl); }
+    }
+    --this->n_free_ranges;
+}
+
+
+
+/* Hands out a range of the given number of bytes, starting at an offset that is a multiple of the given alignment (which must be a power of two). Returns NullRange if there is no free range large enough. */
+BlockAllocator::Range BlockAllocator::allocate(uint64_t n_bytes, uint64_t alignment) {
+    if (n_bytes == 0) { n_bytes = 1; }
+    if (alignment == 0) { alignment = 1; }
+
+    // Look for a range that fits even in the worst case alignment, and round up to the next class so any range in it is large enough
+    uint64_t search_size = n_bytes + alignment - 1;
+    if (search_size >= sl_count) {
+        search_size += ((uint64_t) 1 << (msb(search_size) - sl_log2)) - 1;
+    }
+    uint32_t fl, sl;
+    size_class(search_size, fl, sl);
+
+    // Find the first non-empty class at or above that, which are just a few bit operations
+    uint32_t sl_map = fl < fl_count ? this->sl_bitmaps[fl] & (~(uint32_t) 0 << sl) : 0;
+    if (sl_map == 0) {
+        uint64_t fl_map = fl + 1 < fl_count ? this->fl_bitmap & (~(uint64_t) 0 << (fl + 1)) : 0;
+        if (fl_map == 0) { return NullRange; }
+        fl = lsb(fl_map);
+        sl_map = this->sl_bitmaps[fl];
+    }
+    sl = lsb(sl_map);
+    Range result = this->heads[fl][sl];
+    this->remove_free(result);
+
+    // Split off whatever the alignment skips as a free range of its own. Its predecessor can't be free, since free ranges are always merged
+    uint64_t start = this->nodes[result].offset;
+    uint64_t padding = align_offset(start, alignment) - start;
+    if (padding > 0) {
+        Range front = this->new_node();
+        Node& r = this->nodes[result];
+        Node& f = this->nodes[front];
+        f.offset = start;
+        f.size = padding;
+        f.prev_phys = r.prev_phys;
+        f.next_phys = result;
+        if (r.prev_phys != NullRange) { this->nodes[r.prev_phys].next_phys = front; }
+        r.prev_phys = front;
+        r.offset += padding;
+        r.size -= padding;
+        this->insert_free(front);
+    }
+
+    // Split off what remains at the end as another free range
+    if (this->nodes[result].size > n_bytes) {
+        Range back = this->new_node();
+        Node& r = this->nodes[result];
+        Node& b = this->nodes[back];
+        b.offset = r.offset + n_bytes;
+        b.size = r.size - n_bytes;
+        b.prev_phys = result;
+        b.next_phys = r.next_phys;
+        if (r.next_phys != NullRange) { this->nodes[r.next_phys].prev_phys = back; }
+        r.next_phys = back;
+        r.size = n_bytes;
+        this->insert_free(back);
+    }
+
+    // Update the statistics
+    this->n_used += n_bytes;
+    this->n_high_water = std::max(this->n_high_water, this->n_used);
+    ++this->n_allocations;
+    return result;
+}
+
+/* Returns the given range to the allocator, merging it with any free neighbours. */
+void BlockAllocator::deallocate(Range range) {
+    this->n_used -= this->nodes[range].size;
+    --this->n_allocations;
+
+    // Merge with the previous range if that's free
+    Range prev = this->nodes[range].prev_phys;
+    if (prev != NullRange && this->nodes[prev].free) {
+        this->remove_free(prev);
+        Node& r = this->nodes[range];
+        Node& p = this->nodes[prev];
+        p.size += r.size;
+        p.next_phys = r.next_phys;
+        if (r.next_phys != NullRange) { this->nodes[r.next_phys].prev_phys = prev; }
+        this->unused_nodes.push_back(range);
+        range = prev;
+    }
+
+    // Merge with the next range if that's free
+    Range next = this->nodes[range].next_phys;
+    if (next != NullRange && this->nodes[next].free) {
+        this->remove_free(next);
+        Node& r = this->nodes[range];
+        Node& n = this->nodes[next];
+        r.size += n.size;
+        r.next_phys = n.next_phys;
+        if (n.next_phys != NullRange) { this->nodes[n.next_phys].prev_phys = range; }
+        this->unused_nodes.push_back(next);
+    }
+
+    // Add what remains to the free lists
+    this->insert_free(range);
+}
+
+/* Returns all ranges to the allocator at once, which invalidates their handles. The high-water mark is kept. */
+void BlockAllocator::reset() {
+    this->nodes.clear();
+    this->unused_nodes.clear();
+    for (uint32_t fl = 0; fl < fl_count; fl++) {
+        for (uint32_t sl = 0; sl < sl_count; sl++) {
+            this->heads[fl][sl] = NullRange;
+        }
+        this->sl_bitmaps[fl] = 0;
+    }
+    this->fl_bitmap = 0;
+    this->n_used = 0;
+    this->n_allocations = 0;
+    this->n_free_ranges = 0;
+
+    // All memory starts as a single free range
+    if (this->n_capacity > 0) {
+        Range all = this->new_node();
+        this->nodes[all].offset = 0;
+        this->nodes[all].size = this->n_capacity;
+        this->nodes[all].prev_phys = NullRange;
+        this->nodes[all].next_phys = NullRange;
+        this->insert_free(all);
+    }
+}
+
+
+
+/* Returns the size of the largest free range. */
+uint64_t BlockAllocator::largest_free_range() const {
+    if (this->fl_bitmap == 0) { return 0; }
+
+    // The largest range is in the highest non-empty class, but that class still spans some sizes
+    uint32_t fl = msb(this->fl_bitmap);
+    uint32_t sl = msb(this->sl_bitmaps[fl]);
+    uint64_t result = 0;
+    for (Range node = this->heads[fl][sl]; node != NullRange; node = this->nodes[node].next_free) {
+        result = std::max(result, this->nodes[node].size);
+    }
+    return result;
+}
+
+/* Returns how fragmented the free memory is, as the fraction of it that is not in the largest free range. 0 means all free memory is in one piece. */
+double BlockAllocator::fragmentation() const {
+    uint64_t n_free = this->n_capacity - this->n_used;
+    if (n_free == 0) { return 0.0; }
+    return 1.0 - (double) this->largest_free_range() / (double) n_free;
+}
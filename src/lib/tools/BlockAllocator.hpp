@@ -0,0 +1,124 @@
+/* BLOCK ALLOCATOR.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 18:02:11
+ * Last edited:
+ *   16/10/2026, 18:02:11
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the BlockAllocator class, which hands out ranges of some
+ *   externally owned memory (like a VkDeviceMemory) using a two-level
+ *   segregated fit (TLSF) scheme. Both allocating and freeing take
+ *   constant time, no matter how many ranges are handed out.
+**/
+
+#ifndef TOOLS_BLOCK_ALLOCATOR_HPP
+#define TOOLS_BLOCK_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Tools {
+    /* The BlockAllocator class, which manages the ranges of a block of memory of a fixed size. It never touches the memory itself, so it only works with offsets. Note that it isn't thread-safe. */
+    class BlockAllocator {
+    public:
+        /* Handle for ranges handed out by the BlockAllocator. */
+        using Range = uint32_t;
+
+        /* The null range, which is returned if an allocation doesn't fit. */
+        static const constexpr Range NullRange = UINT32_MAX;
+        /* The log2 of the number of second-level size classes per power of two. */
+        static const constexpr uint32_t sl_log2 = 4;
+        /* The number of second-level size classes per power of two. */
+        static const constexpr uint32_t sl_count = 1 << sl_log2;
+        /* The number of first-level size classes, which is enough for any 64-bit size. */
+        static const constexpr uint32_t fl_count = 64;
+
+    private:
+        /* The Node struct, which describes a single physical range of the memory, either free or in use. */
+        struct Node {
+            /* The offset of the range in the memory. */
+            uint64_t offset;
+            /* The size of the range, in bytes. */
+            uint64_t size;
+            /* The node of the range right before this one in memory, or NullRange if this is the first. */
+            Range prev_phys;
+            /* The node of the range right after this one in memory, or NullRange if this is the last. */
+            Range next_phys;
+            /* The previous node in the same free list, if this range is free. */
+            Range prev_free;
+            /* The next node in the same free list, if this range is free. */
+            Range next_free;
+            /* Whether this range is free. */
+            bool free;
+        };
+
+        /* All nodes, both of ranges in use and of free ranges. */
+        std::vector<Node> nodes;
+        /* The indices of nodes that don't describe any range and can be reused. */
+        std::vector<Range> unused_nodes;
+
+        /* The first free node of every size class. */
+        Range heads[fl_count][sl_count];
+        /* Bitmap of the first-level classes that have at least one free range. */
+        uint64_t fl_bitmap;
+        /* Per first-level class, a bitmap of the second-level classes that have at least one free range. */
+        uint32_t sl_bitmaps[fl_count];
+
+        /* The size of the memory we manage. */
+        uint64_t n_capacity;
+        /* The number of bytes currently handed out. */
+        uint64_t n_used;
+        /* The largest number of bytes ever handed out at once. */
+        uint64_t n_high_water;
+        /* The number of ranges currently handed out. */
+        uint32_t n_allocations;
+        /* The number of free ranges. */
+        uint32_t n_free_ranges;
+
+        /* Returns a node that doesn't describe a range yet. */
+        Range new_node();
+        /* Adds the given free node to the free list of its size class. */
+        void insert_free(Range node);
+        /* Removes the given free node from the free list of its size class. */
+        void remove_free(Range node);
+
+    public:
+        /* Constructor for the BlockAllocator class, which takes the size (in bytes) of the memory to manage. */
+        BlockAllocator(uint64_t capacity = 0);
+
+        /* Hands out a range of the given number of bytes, starting at an offset that is a multiple of the given alignment (which must be a power of two). Returns NullRange if there is no free range large enough. */
+        Range allocate(uint64_t n_bytes, uint64_t alignment = 1);
+        /* Returns the given range to the allocator, merging it with any free neighbours. */
+        void deallocate(Range range);
+        /* Returns all ranges to the allocator at once, which invalidates their handles. The high-water mark is kept. */
+        void reset();
+
+        /* Returns the offset of the given range in the memory. */
+        inline uint64_t offset(Range range) const { return this->nodes[range].offset; }
+        /* Returns the size of the given range, in bytes. */
+        inline uint64_t size(Range range) const { return this->nodes[range].size; }
+
+        /* Returns the size of the memory we manage. */
+        inline uint64_t capacity() const { return this->n_capacity; }
+        /* Returns the number of bytes currently handed out, excluding padding for alignment. */
+        inline uint64_t used() const { return this->n_used; }
+        /* Returns the largest number of bytes ever handed out at once. */
+        inline uint64_t high_water_mark() const { return this->n_high_water; }
+        /* Returns the number of ranges currently handed out. */
+        inline uint32_t allocations() const { return this->n_allocations; }
+        /* Returns the number of free ranges the free memory is split in. */
+        inline uint32_t free_ranges() const { return this->n_free_ranges; }
+        /* Returns the size of the largest free range. */
+        uint64_t largest_free_range() const;
+        /* Returns how fragmented the free memory is, as the fraction of it that is not in the largest free range. 0 means all free memory is in one piece. */
+        double fragmentation() const;
+
+    };
+}
+
+#endif
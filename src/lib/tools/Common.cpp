@@ -4,7 +4,7 @@
  * Created:
  *   02/05/2021, 17:12:29
  * Last edited:
- *   25/05/2021, 18:14:13
+ *   16/10/2026, 01:05:57
  * Auto updated?
  *   Yes
  *
@@ -14,11 +14,18 @@
 
 #ifdef _WIN32
 #include <windows.h>
+#include <direct.h>
+#include <process.h>
 #else
 #include <libgen.h>
 #include <unistd.h>
 #include <linux/limits.h>
 #endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <cerrno>
+#include <atomic>
 #include <sstream>
 #include <CppDebugger.hpp>
 
@@ -98,3 +105,75 @@ std::string Tools::bytes_to_string(size_t n_bytes) {
     // Done, return
     DRETURN sstr.str();
 }
+
+
+
+/* Function that returns a 64-bit hash of the given bytes. It is fast rather than cryptographically strong, and meant to detect changed files. */
+uint64_t Tools::hash_bytes(const void* data, size_t n_bytes) {
+    DENTER("Tools::hash_bytes");
+
+    // FNV-1a, but over eight bytes at a time to keep up with the disk
+    const constexpr uint64_t prime = 0x100000001b3ULL;
+    uint64_t hash = 0xcbf29ce484222325ULL ^ (uint64_t) n_bytes;
+    const char* bytes = (const char*) data;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= n_bytes; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(uint64_t));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+    for (; i < n_bytes; i++) {
+        hash = (hash ^ (uint64_t) (unsigned char) bytes[i]) * prime;
+    }
+
+    // Done
+    DRETURN hash;
+}
+
+/* Function that gets the size (in bytes) and last modification time (in nanoseconds since the epoch) of the file at the given path. Returns false if the file doesn't exist or can't be examined. */
+bool Tools::get_file_info(const std::string& file_path, uint64_t& size, int64_t& mtime) {
+    DENTER("Tools::get_file_info");
+
+    #ifdef _WIN32
+    struct _stat64 info;
+    if (_stat64(file_path.c_str(), &info) != 0) { DRETURN false; }
+    size = (uint64_t) info.st_size;
+    mtime = (int64_t) info.st_mtime * 1000000000LL;
+    #else
+    struct stat info;
+    if (stat(file_path.c_str(), &info) != 0) { DRETURN false; }
+    size = (uint64_t) info.st_size;
+    mtime = (int64_t) info.st_mtim.tv_sec * 1000000000LL + (int64_t) info.st_mtim.tv_nsec;
+    #endif
+
+    DRETURN true;
+}
+
+/* Function that creates the directory at the given path, if it doesn't exist already. Its parent directory should exist. Returns false if the directory doesn't exist and couldn't be created. */
+bool Tools::make_directory(const std::string& path) {
+    DENTER("Tools::make_directory");
+
+    #ifdef _WIN32
+    int result = _mkdir(path.c_str());
+    #else
+    int result = mkdir(path.c_str(), 0755);
+    #endif
+
+    DRETURN result == 0 || errno == EEXIST;
+}
+
+/* Function that returns a path next to the given one that no other process or thread uses at the same time, to write a file to before renaming it over the given path. */
+std::string Tools::unique_temp_path(const std::string& path) {
+    DENTER("Tools::unique_temp_path");
+
+    // The process ID tells processes apart, and the counter tells the threads (and repeated calls) within this process apart
+    static std::atomic<uint64_t> counter(0);
+    #ifdef _WIN32
+    uint64_t pid = (uint64_t) _getpid();
+    #else
+    uint64_t pid = (uint64_t) getpid();
+    #endif
+
+    DRETURN path + "." + std::to_string(pid) + "." + std::to_string(counter++) + ".tmp";
+}
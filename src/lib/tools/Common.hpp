@@ -4,7 +4,7 @@
  * Created:
  *   02/05/2021, 17:12:22
  * Last edited:
- *   21/05/2021, 15:20:52
+ *   16/10/2026, 01:05:57
  * Auto updated?
  *   Yes
  *
@@ -16,6 +16,8 @@
 #define TOOLS_COMMON_HPP
 
 #include <string>
+#include <cstddef>
+#include <cstdint>
 
 namespace Tools {
     /* Function that returns the path of the folder of the executable. */
@@ -23,6 +25,15 @@ namespace Tools {
 
     /* Function that returns a string more compactly describing the given number of bytes. */
     std::string bytes_to_string(size_t n_bytes);
+
+    /* Function that returns a 64-bit hash of the given bytes. It is fast rather than cryptographically strong, and meant to detect changed files. */
+    uint64_t hash_bytes(const void* data, size_t n_bytes);
+    /* Function that gets the size (in bytes) and last modification time (in nanoseconds since the epoch) of the file at the given path. Returns false if the file doesn't exist or can't be examined. */
+    bool get_file_info(const std::string& file_path, uint64_t& size, int64_t& mtime);
+    /* Function that creates the directory at the given path, if it doesn't exist already. Its parent directory should exist. Returns false if the directory doesn't exist and couldn't be created. */
+    bool make_directory(const std::string& path);
+    /* Function that returns a path next to the given one that no other process or thread uses at the same time, to write a file to before renaming it over the given path. */
+    std::string unique_temp_path(const std::string& path);
 }
 
 #endif
@@ -0,0 +1,256 @@
+/* MAPPED FILE.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 00:21:52
+ * Last edited:
+ *   16/10/2026, 00:25:49
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the MappedFile class, which maps a file into memory for as
+ *   long as the object lives. This lets loaders parse (parts of) large
+ *   files directly from the page cache, without copying them into a
+ *   buffer or going through the line-by-line stream machinery first. It
+ *   can also create a new file of a given size to write to directly,
+ *   leaving it to the OS to page the data out.
+**/
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+#include <cerrno>
+#include <CppDebugger.hpp>
+
+#include "MappedFile.hpp"
+
+using namespace std;
+using namespace Tools;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** HELPER FUNCTIONS *****/
+/* Returns a string describing the last error that occurred in a system call. */
+static std::string last_error() {
+    #ifdef _WIN32
+    return "error code " + std::to_string(GetLastError());
+    #else
+    return std::string(strerror(errno));
+    #endif
+}
+
+
+
+
+
+/***** MAPPEDFILE CLASS *****/
+/* Constructor for the MappedFile class, which takes the path of the file to map. Throws a fatal error if the file could not be opened or mapped. */
+MappedFile::MappedFile(const std::string& file_path) :
+    file_path(file_path),
+    file_data(nullptr),
+    file_size(0),
+    file_writable(false)
+{
+    DENTER("Tools::MappedFile::MappedFile");
+
+    #ifdef _WIN32
+    this->file_handle = nullptr;
+    this->mapping_handle = nullptr;
+
+    // Open the file and get its size
+    HANDLE h = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (h == INVALID_HANDLE_VALUE) {
+        DLOG(fatal, "Could not open file '" + file_path + "': " + last_error());
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(h, &size)) {
+        std::string error = last_error();
+        CloseHandle(h);
+        DLOG(fatal, "Could not get size of file '" + file_path + "': " + error);
+    }
+    this->file_handle = (void*) h;
+    this->file_size = (size_t) size.QuadPart;
+
+    // Map it (empty files can't be mapped, but then there's nothing to read anyway)
+    if (this->file_size > 0) {
+        HANDLE m = CreateFileMappingA(h, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m == NULL) {
+            std::string error = last_error();
+            CloseHandle(h);
+            DLOG(fatal, "Could not map file '" + file_path + "': " + error);
+        }
+        this->mapping_handle = (void*) m;
+        this->file_data = (const char*) MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+        if (this->file_data == nullptr) {
+            std::string error = last_error();
+            CloseHandle(m);
+            CloseHandle(h);
+            DLOG(fatal, "Could not map file '" + file_path + "': " + error);
+        }
+    }
+
+    #else
+    // Open the file and get its size
+    int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        DLOG(fatal, "Could not open file '" + file_path + "': " + last_error());
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        std::string error = last_error();
+        close(fd);
+        DLOG(fatal, "Could not get size of file '" + file_path + "': " + error);
+    }
+    this->file_size = (size_t) info.st_size;
+
+    // Map it (empty files can't be mapped, but then there's nothing to read anyway). The mapping stays valid after closing the descriptor.
+    if (this->file_size > 0) {
+        void* data = mmap(nullptr, this->file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            std::string error = last_error();
+            close(fd);
+            DLOG(fatal, "Could not map file '" + file_path + "': " + error);
+        }
+        madvise(data, this->file_size, MADV_WILLNEED);
+        this->file_data = (const char*) data;
+    }
+    close(fd);
+
+    #endif
+
+    DLEAVE;
+}
+
+/* Constructor for the MappedFile class, which creates (or truncates) the file at the given path with the given size and maps it read-write. Throws a fatal error if the file could not be created or mapped. */
+MappedFile::MappedFile(const std::string& file_path, size_t size) :
+    file_path(file_path),
+    file_data(nullptr),
+    file_size(size),
+    file_writable(true)
+{
+    DENTER("Tools::MappedFile::MappedFile(create)");
+
+    #ifdef _WIN32
+    this->file_handle = nullptr;
+    this->mapping_handle = nullptr;
+
+    // Create the file and give it the proper size
+    HANDLE h = CreateFileA(file_path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) {
+        DLOG(fatal, "Could not create file '" + file_path + "': " + last_error());
+    }
+    LARGE_INTEGER end;
+    end.QuadPart = (LONGLONG) size;
+    if (!SetFilePointerEx(h, end, NULL, FILE_BEGIN) || !SetEndOfFile(h)) {
+        std::string error = last_error();
+        CloseHandle(h);
+        DLOG(fatal, "Could not resize file '" + file_path + "' to " + std::to_string(size) + " bytes: " + error);
+    }
+    this->file_handle = (void*) h;
+
+    // Map it
+    if (size > 0) {
+        HANDLE m = CreateFileMappingA(h, NULL, PAGE_READWRITE, (DWORD) ((uint64_t) size >> 32), (DWORD) size, NULL);
+        if (m == NULL) {
+            std::string error = last_error();
+            CloseHandle(h);
+            DLOG(fatal, "Could not map file '" + file_path + "': " + error);
+        }
+        this->mapping_handle = (void*) m;
+        this->file_data = (const char*) MapViewOfFile(m, FILE_MAP_WRITE, 0, 0, 0);
+        if (this->file_data == nullptr) {
+            std::string error = last_error();
+            CloseHandle(m);
+            CloseHandle(h);
+            DLOG(fatal, "Could not map file '" + file_path + "': " + error);
+        }
+    }
+
+    #else
+    // Create the file and give it the proper size
+    int fd = open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        DLOG(fatal, "Could not create file '" + file_path + "': " + last_error());
+    }
+    if (ftruncate(fd, (off_t) size) < 0) {
+        std::string error = last_error();
+        close(fd);
+        DLOG(fatal, "Could not resize file '" + file_path + "' to " + std::to_string(size) + " bytes: " + error);
+    }
+
+    // Map it as shared, so the writes end up in the file. The mapping stays valid after closing the descriptor.
+    if (size > 0) {
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            std::string error = last_error();
+            close(fd);
+            DLOG(fatal, "Could not map file '" + file_path + "': " + error);
+        }
+        this->file_data = (const char*) data;
+    }
+    close(fd);
+
+    #endif
+
+    DLEAVE;
+}
+
+/* Move constructor for the MappedFile class. */
+MappedFile::MappedFile(MappedFile&& other) :
+    file_path(std::move(other.file_path)),
+    file_data(other.file_data),
+    file_size(other.file_size),
+    file_writable(other.file_writable)
+{
+    #ifdef _WIN32
+    this->file_handle = other.file_handle;
+    this->mapping_handle = other.mapping_handle;
+    other.file_handle = nullptr;
+    other.mapping_handle = nullptr;
+    #endif
+
+    // Make sure the other doesn't unmap anything
+    other.file_data = nullptr;
+    other.file_size = 0;
+}
+
+/* Destructor for the MappedFile class. */
+MappedFile::~MappedFile() {
+    DENTER("Tools::MappedFile::~MappedFile");
+
+    #ifdef _WIN32
+    if (this->file_data != nullptr) { UnmapViewOfFile((LPCVOID) this->file_data); }
+    if (this->mapping_handle != nullptr) { CloseHandle((HANDLE) this->mapping_handle); }
+    if (this->file_handle != nullptr) { CloseHandle((HANDLE) this->file_handle); }
+    #else
+    if (this->file_data != nullptr) { munmap((void*) this->file_data, this->file_size); }
+    #endif
+
+    DLEAVE;
+}
+
+
+
+/* Writes any changes in the mapping back to the file, and returns once they are on disk. Does nothing for read-only mappings. */
+void MappedFile::flush() {
+    DENTER("Tools::MappedFile::flush");
+    if (!this->file_writable || this->file_data == nullptr) { DRETURN; }
+
+    #ifdef _WIN32
+    bool success = FlushViewOfFile((LPCVOID) this->file_data, 0) && FlushFileBuffers((HANDLE) this->file_handle);
+    #else
+    bool success = msync((void*) this->file_data, this->file_size, MS_SYNC) == 0;
+    #endif
+    if (!success) {
+        DLOG(fatal, "Could not write file '" + this->file_path + "' to disk: " + last_error());
+    }
+
+    DRETURN;
+}
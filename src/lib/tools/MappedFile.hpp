@@ -0,0 +1,80 @@
+/* MAPPED FILE.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 00:21:48
+ * Last edited:
+ *   16/10/2026, 00:25:49
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the MappedFile class, which maps a file into memory for as
+ *   long as the object lives. This lets loaders parse (parts of) large
+ *   files directly from the page cache, without copying them into a
+ *   buffer or going through the line-by-line stream machinery first. It
+ *   can also create a new file of a given size to write to directly,
+ *   leaving it to the OS to page the data out.
+**/
+
+#ifndef TOOLS_MAPPED_FILE_HPP
+#define TOOLS_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace Tools {
+    /* The MappedFile class, which maps a file into memory, either read-only or (for new files) read-write. */
+    class MappedFile {
+    private:
+        /* The path of the mapped file. */
+        std::string file_path;
+        /* Pointer to the start of the mapped file. Is nullptr if the file is empty. */
+        const char* file_data;
+        /* The size of the mapped file, in bytes. */
+        size_t file_size;
+        /* Whether the mapping may be written to. */
+        bool file_writable;
+
+        #ifdef _WIN32
+        /* Handle to the file itself. */
+        void* file_handle;
+        /* Handle to the mapping of the file. */
+        void* mapping_handle;
+        #endif
+
+    public:
+        /* Constructor for the MappedFile class, which takes the path of the file to map. Throws a fatal error if the file could not be opened or mapped. */
+        MappedFile(const std::string& file_path);
+        /* Constructor for the MappedFile class, which creates (or truncates) the file at the given path with the given size and maps it read-write. Throws a fatal error if the file could not be created or mapped. */
+        MappedFile(const std::string& file_path, size_t size);
+        /* Copy constructor for the MappedFile class, which is deleted as a mapping can't be shared. */
+        MappedFile(const MappedFile& other) = delete;
+        /* Move constructor for the MappedFile class. */
+        MappedFile(MappedFile&& other);
+        /* Destructor for the MappedFile class. */
+        ~MappedFile();
+
+        /* Returns the path of the mapped file. */
+        inline const std::string& path() const { return this->file_path; }
+        /* Returns a pointer to the start of the mapped file. Note that it is not null-terminated. */
+        inline const char* data() const { return this->file_data; }
+        /* Returns a writable pointer to the start of the mapped file, or nullptr if it was mapped read-only. Writes end up in the file itself. */
+        inline char* writable_data() const { return this->file_writable ? (char*) this->file_data : nullptr; }
+        /* Returns the size of the mapped file, in bytes. */
+        inline size_t size() const { return this->file_size; }
+        /* Returns whether the mapping may be written to. */
+        inline bool writable() const { return this->file_writable; }
+
+        /* Writes any changes in the mapping back to the file, and returns once they are on disk. Does nothing for read-only mappings. */
+        void flush();
+
+        /* Copy assignment operator for the MappedFile class, which is deleted. */
+        MappedFile& operator=(const MappedFile& other) = delete;
+        /* Move assignment operator for the MappedFile class, which is deleted. */
+        MappedFile& operator=(MappedFile&& other) = delete;
+
+    };
+}
+
+#endif
@@ -0,0 +1,279 @@
+/* PROFILER.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 16:52:14
+ * Last edited:
+ *   16/10/2026, 16:52:14
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the sampling profiler, which periodically snapshots the call
+ *   stack of whatever thread is running and writes them as collapsed
+ *   stacks that flamegraph tools can read. Functions mark themselves with
+ *   PENTER instead of DENTER to appear on the sampled stacks; if the
+ *   project isn't compiled with ENABLE_PROFILER, PENTER is just DENTER.
+**/
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sys/time.h>
+#include <CppDebugger.hpp>
+
+#include "Profiler.hpp"
+
+using namespace std;
+using namespace Tools;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** TYPES *****/
+/* The ThreadSamples struct, which holds the samples of a single thread. Only the signal handler running on that thread writes to it, so it needs no locking. */
+struct Profiler::ThreadSamples {
+    /* The samples so far, each stored as its count, its depth and then the names of its frames. */
+    uintptr_t* data;
+    /* The number of words in the data buffer. */
+    size_t capacity;
+    /* The number of words used in the data buffer. */
+    size_t size;
+    /* The index of the last sample in the data buffer, so repeated samples of the same stack only bump its count. */
+    size_t last;
+    /* The number of samples that didn't fit in the buffer. */
+    uint64_t dropped;
+
+    /* The buffer of the next thread. */
+    ThreadSamples* next;
+};
+
+
+
+
+
+/***** GLOBALS *****/
+/* The call stack of the current thread. */
+thread_local Profiler::CallStack Profiler::call_stack;
+/* Whether the profiler is currently taking samples. */
+std::atomic<bool> Profiler::running(false);
+/* The current generation of the profiler, which is bumped every time it's started. */
+std::atomic<uint32_t> Profiler::generation(0);
+
+/* The buffers of all threads that registered themselves in the current generation, as a lock-free list. */
+static std::atomic<Profiler::ThreadSamples*> thread_samples(nullptr);
+/* The number of words every thread may use to store its samples in. */
+static size_t samples_capacity = 0;
+/* The number of samples that hit a thread without any (registered) frames. */
+static std::atomic<uint64_t> n_unattributed(0);
+/* Whether the signal handler is installed. It's never removed again, since a SIGPROF that's still underway would otherwise kill the process. */
+static bool handler_installed = false;
+
+
+
+
+
+/***** HELPER FUNCTIONS *****/
+/* @brief The signal handler for SIGPROF, which stores the call stack of the thread it interrupts. Only touches thread-local state and lock-free atomics, and doesn't allocate.
+ * @param signal The signal caught (always SIGPROF).
+ */
+static void take_sample(int signal) {
+    (void) signal;
+    if (!Profiler::running.load(std::memory_order_relaxed)) { return; }
+
+    // Samples of threads that haven't registered (or that are outside any frame) can't be attributed to anything
+    Profiler::CallStack& stack = Profiler::call_stack;
+    std::sig_atomic_t depth = stack.depth;
+    if (stack.generation != Profiler::generation.load(std::memory_order_relaxed) || depth <= 0) {
+        n_unattributed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    std::atomic_signal_fence(std::memory_order_acquire);
+    size_t n_frames = depth < (std::sig_atomic_t) Profiler::max_depth ? (size_t) depth : Profiler::max_depth;
+
+    // If the stack is the same as the last sample, just count that one again
+    Profiler::ThreadSamples* samples = stack.samples;
+    if (samples->size > 0) {
+        uintptr_t* last = samples->data + samples->last;
+        bool same = last[1] == n_frames;
+        for (size_t i = 0; same && i < n_frames; i++) {
+            same = last[2 + i] == (uintptr_t) stack.frames[i];
+        }
+        if (same) {
+            ++last[0];
+            return;
+        }
+    }
+
+    // Otherwise, append it as a new sample
+    if (samples->size + 2 + n_frames > samples->capacity) {
+        ++samples->dropped;
+        return;
+    }
+    uintptr_t* sample = samples->data + samples->size;
+    sample[0] = 1;
+    sample[1] = n_frames;
+    for (size_t i = 0; i < n_frames; i++) {
+        sample[2 + i] = (uintptr_t) stack.frames[i];
+    }
+    samples->last = samples->size;
+    samples->size += 2 + n_frames;
+}
+
+/* @brief Frees the sample buffers of all threads. Should only be called while the profiler isn't running.
+ */
+static void free_samples() {
+    Profiler::ThreadSamples* samples = thread_samples.exchange(nullptr);
+    while (samples != nullptr) {
+        Profiler::ThreadSamples* next = samples->next;
+        delete[] samples->data;
+        delete samples;
+        samples = next;
+    }
+}
+
+
+
+
+
+/***** PROFILER FUNCTIONS *****/
+/* Gives the current thread a buffer to store its samples in. Called automatically when a thread pushes a frame while the profiler is running. */
+void Profiler::register_thread() {
+    // Prepare an empty buffer
+    ThreadSamples* samples = new ThreadSamples;
+    samples->data = new uintptr_t[samples_capacity];
+    samples->capacity = samples_capacity;
+    samples->size = 0;
+    samples->last = 0;
+    samples->dropped = 0;
+
+    // Add it to the list of buffers without taking a lock
+    samples->next = thread_samples.load(std::memory_order_relaxed);
+    while (!thread_samples.compare_exchange_weak(samples->next, samples, std::memory_order_release, std::memory_order_relaxed)) {}
+
+    // Only mark it as current once it's there, since the signal handler may interrupt us at any time
+    call_stack.samples = samples;
+    std::atomic_signal_fence(std::memory_order_release);
+    call_stack.generation = generation.load(std::memory_order_relaxed);
+}
+
+
+
+/* Starts sampling the running threads the given number of times per second of CPU time. Every thread may store up to the given number of words of (run-length encoded) samples; samples that don't fit are dropped. Any samples of a previous run are thrown away. */
+void Profiler::start(uint32_t frequency, size_t capacity) {
+    DENTER("Tools::Profiler::start");
+
+    if (running.load()) {
+        DLOG(fatal, "Cannot start the profiler while it's already running");
+    }
+    if (frequency == 0) {
+        DLOG(fatal, "Cannot sample zero times per second");
+    }
+
+    // Throw away the last run, and make sure every thread registers anew
+    free_samples();
+    generation.fetch_add(1);
+    n_unattributed.store(0);
+    samples_capacity = capacity;
+
+    // Install the signal handler if we haven't already
+    if (!handler_installed) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(struct sigaction));
+        action.sa_handler = take_sample;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, nullptr) != 0) {
+            DLOG(fatal, std::string("Could not install the profiler's signal handler: ") + strerror(errno));
+        }
+        handler_installed = true;
+    }
+
+    // Register the calling thread already, since it's probably deep in a stack it won't push to for a while
+    register_thread();
+
+    // Start the timer, which fires after every so much CPU time of any of our threads
+    running.store(true);
+    struct itimerval timer;
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = frequency >= 1000000 ? 1 : 1000000 / frequency;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        running.store(false);
+        DLOG(fatal, std::string("Could not start the profiler's timer: ") + strerror(errno));
+    }
+
+    DRETURN;
+}
+
+/* Stops sampling. The samples are kept until the profiler is started again. */
+void Profiler::stop() {
+    DENTER("Tools::Profiler::stop");
+
+    if (!running.load()) { DRETURN; }
+
+    // Stop the timer first, and only then tell the handler to ignore whatever's still underway
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(struct itimerval));
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    running.store(false);
+
+    DRETURN;
+}
+
+
+
+/* Writes the samples of the last run as collapsed stacks ('<frame>;<frame>;... <count>' per line) to the given stream. Returns the number of samples written. */
+uint64_t Profiler::write_collapsed(std::ostream& os) {
+    DENTER("Tools::Profiler::write_collapsed");
+
+    if (running.load()) {
+        DLOG(fatal, "Cannot write the samples while the profiler is running");
+    }
+
+    // Merge the samples of all threads, sorted by stack so flamegraph tools get them in a stable order
+    std::map<std::string, uint64_t> stacks;
+    uint64_t n_dropped = 0;
+    for (ThreadSamples* samples = thread_samples.load(std::memory_order_acquire); samples != nullptr; samples = samples->next) {
+        size_t i = 0;
+        while (i < samples->size) {
+            uintptr_t* sample = samples->data + i;
+            std::string key;
+            for (size_t f = 0; f < sample[1]; f++) {
+                if (f > 0) { key += ';'; }
+                key += (const char*) sample[2 + f];
+            }
+            stacks[key] += sample[0];
+            i += 2 + sample[1];
+        }
+        n_dropped += samples->dropped;
+    }
+    if (n_unattributed.load() > 0) { stacks["[unknown]"] += n_unattributed.load(); }
+    if (n_dropped > 0) {
+        DLOG(warning, "Dropped " + std::to_string(n_dropped) + " samples that didn't fit in the profiler's buffers");
+        stacks["[dropped]"] += n_dropped;
+    }
+
+    // Write them
+    uint64_t n_samples = 0;
+    for (const std::pair<const std::string, uint64_t>& stack : stacks) {
+        os << stack.first << ' ' << stack.second << '\n';
+        n_samples += stack.second;
+    }
+
+    DRETURN n_samples;
+}
+
+/* Writes the samples of the last run as collapsed stacks to the file at the given path. Returns the number of samples written. */
+uint64_t Profiler::write_collapsed(const std::string& path) {
+    DENTER("Tools::Profiler::write_collapsed(path)");
+
+    std::ofstream h(path);
+    if (!h.is_open()) {
+        DLOG(fatal, "Could not open '" + path + "' to write the profile to");
+    }
+    uint64_t n_samples = write_collapsed(h);
+    h.close();
+
+    DRETURN n_samples;
+}
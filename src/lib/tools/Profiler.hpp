@@ -0,0 +1,121 @@
+/* PROFILER.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   16/10/2026, 16:52:10
+ * Last edited:
+ *   16/10/2026, 16:52:10
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the sampling profiler, which periodically snapshots the call
+ *   stack of whatever thread is running and writes them as collapsed
+ *   stacks that flamegraph tools can read. Functions mark themselves with
+ *   PENTER instead of DENTER to appear on the sampled stacks; if the
+ *   project isn't compiled with ENABLE_PROFILER, PENTER is just DENTER.
+**/
+
+#ifndef TOOLS_PROFILER_HPP
+#define TOOLS_PROFILER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <csignal>
+#include <atomic>
+#include <string>
+#include <ostream>
+#include <CppDebugger.hpp>
+
+namespace Tools::Profiler {
+    /* The maximum depth of the stacks the profiler keeps track of. Deeper frames are sampled as their deepest ancestor that fits. */
+    static const constexpr uint32_t max_depth = 64;
+
+    /* Forward declaration of the buffer that a single thread stores its samples in. */
+    struct ThreadSamples;
+
+    /* The CallStack struct, which mirrors the PENTER frames of a single thread in a form that can be read from a signal handler. It's plain data, so no thread ever has to initialize it. */
+    struct CallStack {
+        /* The names of the frames on the stack, outermost first. */
+        const char* frames[max_depth];
+        /* The number of frames on the stack, which may be more than fit in the frames array. */
+        volatile std::sig_atomic_t depth;
+        /* The generation of the profiler that this thread registered its samples buffer with. */
+        volatile uint32_t generation;
+        /* The buffer that the samples of this thread are written to, if the generation is current. */
+        ThreadSamples* samples;
+    };
+
+    /* The call stack of the current thread. */
+    extern thread_local CallStack call_stack;
+    /* Whether the profiler is currently taking samples. */
+    extern std::atomic<bool> running;
+    /* The current generation of the profiler, which is bumped every time it's started. */
+    extern std::atomic<uint32_t> generation;
+
+    /* Gives the current thread a buffer to store its samples in. Called automatically when a thread pushes a frame while the profiler is running. */
+    void register_thread();
+
+    /* Pushes a frame with the given name on the call stack of the current thread. The name is kept as a pointer, so it should be a string literal. */
+    inline void push(const char* name) {
+        CallStack& stack = call_stack;
+        if (stack.generation != generation.load(std::memory_order_relaxed) && running.load(std::memory_order_relaxed)) {
+            register_thread();
+        }
+        std::sig_atomic_t depth = stack.depth;
+        if (depth < (std::sig_atomic_t) max_depth) { stack.frames[depth] = name; }
+        // Make sure the name is there before a signal handler on this thread can see it
+        std::atomic_signal_fence(std::memory_order_release);
+        stack.depth = depth + 1;
+    }
+    /* Pops the innermost frame from the call stack of the current thread. */
+    inline void pop() {
+        CallStack& stack = call_stack;
+        stack.depth = stack.depth - 1;
+    }
+
+    /* The Frame class, which keeps a frame on the call stack of the current thread for as long as it lives. */
+    class Frame {
+    public:
+        /* Constructor for the Frame class, which takes the name of the frame (as a string literal). */
+        Frame(const char* name) { push(name); }
+        /* Copy constructor for the Frame class, which is deleted. */
+        Frame(const Frame& other) = delete;
+        /* Destructor for the Frame class. */
+        ~Frame() { pop(); }
+
+        /* Copy assignment operator for the Frame class, which is deleted. */
+        Frame& operator=(const Frame& other) = delete;
+    };
+
+
+
+    /* Starts sampling the running threads the given number of times per second of CPU time. Every thread may store up to the given number of words of (run-length encoded) samples; samples that don't fit are dropped. Any samples of a previous run are thrown away. */
+    void start(uint32_t frequency = 1000, size_t capacity = 1 << 18);
+    /* Stops sampling. The samples are kept until the profiler is started again. */
+    void stop();
+
+    /* Writes the samples of the last run as collapsed stacks ('<frame>;<frame>;... <count>' per line) to the given stream. Returns the number of samples written. */
+    uint64_t write_collapsed(std::ostream& os);
+    /* Writes the samples of the last run as collapsed stacks to the file at the given path. Returns the number of samples written. */
+    uint64_t write_collapsed(const std::string& path);
+}
+
+
+
+#ifdef ENABLE_PROFILER
+/* Registers the given function on the call stack of the debugger and on that of the profiler. The profiler frame is popped when the enclosing scope ends. */
+#define PENTER(FUNC) \
+    DENTER(FUNC); Tools::Profiler::Frame _profiler_frame(FUNC)
+/* Registers the given scope (but not with the debugger) on the call stack of the profiler until the scope ends. */
+#define PSCOPE(NAME) \
+    Tools::Profiler::Frame _profiler_frame(NAME)
+#else
+/* Registers the given function on the call stack of the debugger. The profiler is compiled out, since ENABLE_PROFILER isn't defined. */
+#define PENTER(FUNC) \
+    DENTER(FUNC)
+/* Registers the given scope on the call stack of the profiler. Compiled out, since ENABLE_PROFILER isn't defined. */
+#define PSCOPE(NAME)
+#endif
+
+#endif
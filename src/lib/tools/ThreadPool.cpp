@@ -0,0 +1,194 @@
+/* THREAD POOL.cpp
+ *   by Lut99
+ *
+ * Created:
+ *   15/10/2026, 15:10:39
+ * Last edited:
+ *   16/10/2026, 01:02:51
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the ThreadPool class, which keeps a set of worker threads
+ *   alive that can run batches of jobs. Every worker has its own deque of
+ *   jobs, and workers that run out of work steal from the others, so
+ *   batches of jobs with very different costs still keep all cores busy.
+**/
+
+#include <string>
+#include <CppDebugger.hpp>
+
+#include "Profiler.hpp"
+#include "ThreadPool.hpp"
+
+using namespace std;
+using namespace Tools;
+using namespace CppDebugger::SeverityValues;
+
+
+/***** THREADPOOL CLASS *****/
+/* Constructor for the ThreadPool class, which takes the number of worker threads to start. If 0, uses one thread per hardware thread. */
+ThreadPool::ThreadPool(uint32_t n_threads) :
+    job(nullptr),
+    generation(0),
+    remaining(0),
+    active(0),
+    stop(false)
+{
+    DENTER("Tools::ThreadPool::ThreadPool");
+
+    // Determine the number of threads to use
+    if (n_threads == 0) {
+        n_threads = std::thread::hardware_concurrency();
+        if (n_threads == 0) { n_threads = 1; }
+    }
+    this->n_workers = n_threads;
+
+    // Prepare the queues, then launch the threads that use them
+    this->workers = new Worker[this->n_workers];
+    this->threads.reserve(this->n_workers);
+    for (uint32_t i = 0; i < this->n_workers; i++) {
+        this->threads.push_back(std::thread(&ThreadPool::work, this, i));
+    }
+
+    DLEAVE;
+}
+
+/* Destructor for the ThreadPool class. */
+ThreadPool::~ThreadPool() {
+    DENTER("Tools::ThreadPool::~ThreadPool");
+
+    // Tell the workers to stop, and wait until they did
+    {
+        std::unique_lock<std::mutex> lock(this->state_lock);
+        this->stop = true;
+    }
+    this->start_cond.notify_all();
+    for (size_t i = 0; i < this->threads.size(); i++) {
+        this->threads[i].join();
+    }
+
+    delete[] this->workers;
+
+    DLEAVE;
+}
+
+
+
+/* Tries to get a job for the given worker, first from its own queue and then by stealing from the others. Returns false if there is no work left. */
+bool ThreadPool::get_job(uint32_t worker_i, size_t& job_i) {
+    // First, try our own queue (from the back, as that's what we've been working on last)
+    {
+        Worker& self = this->workers[worker_i];
+        std::unique_lock<std::mutex> lock(self.lock);
+        if (!self.jobs.empty()) {
+            job_i = self.jobs.back();
+            self.jobs.pop_back();
+            return true;
+        }
+    }
+
+    // Otherwise, go round the other workers and steal from the front of their queue
+    for (uint32_t i = 1; i < this->n_workers; i++) {
+        Worker& victim = this->workers[(worker_i + i) % this->n_workers];
+        std::unique_lock<std::mutex> lock(victim.lock);
+        if (!victim.jobs.empty()) {
+            job_i = victim.jobs.front();
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+
+    // Nothing left
+    return false;
+}
+
+/* The function run by each of the worker threads. */
+void ThreadPool::work(uint32_t worker_i) {
+    DSTART("worker " + std::to_string(worker_i)); PENTER("Tools::ThreadPool::work");
+
+    uint64_t seen_generation = 0;
+    while (true) {
+        // Wait until there's a new batch or we have to stop
+        const Job* batch_job;
+        {
+            std::unique_lock<std::mutex> lock(this->state_lock);
+            this->start_cond.wait(lock, [this, seen_generation]() { return this->stop || this->generation != seen_generation; });
+            if (this->stop) { break; }
+            seen_generation = this->generation;
+            batch_job = this->job;
+
+            // If we woke up too late and the batch is already over, go back to sleep
+            if (batch_job == nullptr) { continue; }
+            this->active++;
+        }
+
+        // Keep doing jobs until there are none left anywhere. Since all jobs are queued before the batch starts, no new ones can appear once we run out.
+        size_t job_i;
+        while (this->get_job(worker_i, job_i)) {
+            try {
+                (*batch_job)(job_i, worker_i);
+            } catch (...) {
+                std::unique_lock<std::mutex> lock(this->state_lock);
+                if (!this->error) { this->error = std::current_exception(); }
+            }
+
+            this->remaining--;
+        }
+
+        // Leave the batch, waking the caller if we were the last one in it
+        {
+            std::unique_lock<std::mutex> lock(this->state_lock);
+            this->active--;
+            if (this->active == 0) { this->done_cond.notify_all(); }
+        }
+    }
+
+    DLEAVE;
+}
+
+
+
+/* Runs the given function once for every job index in [0, n_jobs), and blocks until all of them are done. The jobs are initially divided in contiguous blocks over the workers, after which idle workers steal from busy ones. If any job throws, the first exception is re-thrown here once the batch is done. May be called from several threads at once, but not from within a job of this pool. */
+void ThreadPool::run(size_t n_jobs, const Job& job) {
+    PENTER("Tools::ThreadPool::run");
+    if (n_jobs == 0) { DRETURN; }
+
+    // Wait for any batch that another thread started first
+    std::unique_lock<std::mutex> batch_lock(this->batch_lock);
+
+    // Everything happens under the state lock, so no worker can see the new jobs before the batch has officially started
+    std::unique_lock<std::mutex> lock(this->state_lock);
+
+    // Divide the jobs over the workers in contiguous blocks, so neighbouring jobs (e.g., tiles) end up on the same core unless they get stolen
+    for (uint32_t i = 0; i < this->n_workers; i++) {
+        size_t first = n_jobs * i / this->n_workers;
+        size_t last = n_jobs * (i + 1) / this->n_workers;
+
+        // The owner pops from the back, so push in reverse to have it start at the front of its block
+        Worker& worker = this->workers[i];
+        std::unique_lock<std::mutex> worker_lock(worker.lock);
+        for (size_t j = last; j-- > first; ) {
+            worker.jobs.push_back(j);
+        }
+    }
+
+    // Start the batch
+    this->job = &job;
+    this->remaining.store(n_jobs);
+    this->error = nullptr;
+    this->generation++;
+    this->start_cond.notify_all();
+
+    // Wait until all jobs are done and every worker has left the batch, so none of them can still be holding on to the job function
+    this->done_cond.wait(lock, [this]() { return this->remaining.load() == 0 && this->active == 0; });
+    this->job = nullptr;
+    std::exception_ptr error = this->error;
+    this->error = nullptr;
+    lock.unlock();
+
+    // Pass any errors on to the caller
+    if (error) { std::rethrow_exception(error); }
+
+    DRETURN;
+}
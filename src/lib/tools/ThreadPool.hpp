@@ -0,0 +1,106 @@
+/* THREAD POOL.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   15/10/2026, 15:10:42
+ * Last edited:
+ *   15/10/2026, 15:10:42
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the ThreadPool class, which keeps a set of worker threads
+ *   alive that can run batches of jobs. Every worker has its own deque of
+ *   jobs, and workers that run out of work steal from the others, so
+ *   batches of jobs with very different costs still keep all cores busy.
+**/
+
+#ifndef TOOLS_THREAD_POOL_HPP
+#define TOOLS_THREAD_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+namespace Tools {
+    /* The ThreadPool class, which runs batches of jobs on a fixed set of worker threads using work stealing. */
+    class ThreadPool {
+    public:
+        /* The type of the functions that can be run by the pool. The first argument is the index of the job, the second the index of the worker thread it runs on. */
+        using Job = std::function<void(size_t, uint32_t)>;
+
+    private:
+        /* The Worker struct, which keeps track of the queue of a single worker. Is aligned to a cache line to avoid false sharing between workers. */
+        struct alignas(64) Worker {
+            /* Lock for the deque of this worker. */
+            std::mutex lock;
+            /* The indices of the jobs that this worker still has to do. The worker itself pops from the back, thieves take from the front. */
+            std::deque<size_t> jobs;
+        };
+
+        /* The worker threads. */
+        std::vector<std::thread> threads;
+        /* The queues of the workers, one per thread. */
+        Worker* workers;
+        /* The number of workers in the pool. */
+        uint32_t n_workers;
+
+        /* Lock that is held for an entire batch, so the pool can be shared by several threads; their batches simply run one after another. */
+        std::mutex batch_lock;
+        /* Lock for the state of the current batch. */
+        std::mutex state_lock;
+        /* Condition variable that wakes the workers up when there is a new batch (or when they have to stop). */
+        std::condition_variable start_cond;
+        /* Condition variable that wakes the caller up when the batch is done. */
+        std::condition_variable done_cond;
+
+        /* The function that is run for the current batch of jobs. */
+        const Job* job;
+        /* Counts the batches run so far, which is how the workers know there is a new batch. */
+        uint64_t generation;
+        /* The number of jobs in the current batch that are not yet done. */
+        std::atomic<size_t> remaining;
+        /* The number of workers that are currently working on the batch. */
+        uint32_t active;
+        /* The first exception thrown by any job in the current batch, if any. */
+        std::exception_ptr error;
+        /* If true, the workers should quit. */
+        bool stop;
+
+        /* Tries to get a job for the given worker, first from its own queue and then by stealing from the others. Returns false if there is no work left. */
+        bool get_job(uint32_t worker_i, size_t& job_i);
+        /* The function run by each of the worker threads. */
+        void work(uint32_t worker_i);
+
+    public:
+        /* Constructor for the ThreadPool class, which takes the number of worker threads to start. If 0, uses one thread per hardware thread. */
+        ThreadPool(uint32_t n_threads = 0);
+        /* Copy constructor for the ThreadPool class, which is deleted as we can't copy threads. */
+        ThreadPool(const ThreadPool& other) = delete;
+        /* Move constructor for the ThreadPool class, which is deleted as the threads refer to the pool. */
+        ThreadPool(ThreadPool&& other) = delete;
+        /* Destructor for the ThreadPool class. */
+        ~ThreadPool();
+
+        /* Runs the given function once for every job index in [0, n_jobs), and blocks until all of them are done. The jobs are initially divided in contiguous blocks over the workers, after which idle workers steal from busy ones. If any job throws, the first exception is re-thrown here once the batch is done. May be called from several threads at once, but not from within a job of this pool. */
+        void run(size_t n_jobs, const Job& job);
+
+        /* Returns the number of worker threads in the pool. */
+        inline uint32_t size() const { return this->n_workers; }
+
+        /* Copy assignment operator for the ThreadPool class, which is deleted. */
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+        /* Move assignment operator for the ThreadPool class, which is deleted. */
+        ThreadPool& operator=(ThreadPool&& other) = delete;
+
+    };
+}
+
+#endif
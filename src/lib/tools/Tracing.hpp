@@ -0,0 +1,44 @@
+/* TRACING.hpp
+ *   by Lut99
+ *
+ * Created:
+ *   15/10/2026, 18:02:37
+ * Last edited:
+ *   15/10/2026, 18:02:37
+ * Auto updated?
+ *   Yes
+ *
+ * Description:
+ *   Contains the kernel variants of the CppDebugger macros. They behave
+ *   exactly like DENTER, DRETURN, DLEAVE and DLOG if TRACE_KERNELS is
+ *   defined, but compile to nothing (or a plain return) otherwise. Use
+ *   them in functions that run per ray, per vertex or per node, and keep
+ *   the normal macros for the coarse stages around them.
+**/
+
+#ifndef TOOLS_TRACING_HPP
+#define TOOLS_TRACING_HPP
+
+#include <CppDebugger.hpp>
+
+#ifdef TRACE_KERNELS
+/* Registers the given function on the (thread-local) call stack of the debugger. */
+#define KENTER(FUNC) DENTER(FUNC)
+/* Pops the current function from the call stack of the debugger and returns. */
+#define KRETURN DRETURN
+/* Pops the current function from the call stack of the debugger without returning. */
+#define KLEAVE DLEAVE
+/* Logs the given message with the given severity. */
+#define KLOG(SEVERITY, MESSAGE) DLOG(SEVERITY, MESSAGE)
+#else
+/* Registers the given function on the (thread-local) call stack of the debugger. Compiled out, since TRACE_KERNELS isn't defined. */
+#define KENTER(FUNC)
+/* Pops the current function from the call stack of the debugger and returns. Compiled out to a plain return, since TRACE_KERNELS isn't defined. */
+#define KRETURN return
+/* Pops the current function from the call stack of the debugger without returning. Compiled out, since TRACE_KERNELS isn't defined. */
+#define KLEAVE
+/* Logs the given message with the given severity. Compiled out, since TRACE_KERNELS isn't defined; note that this means fatal kernel messages won't throw either, so only use it for informative messages. */
+#define KLOG(SEVERITY, MESSAGE)
+#endif
+
+#endif